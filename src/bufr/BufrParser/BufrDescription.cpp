@@ -21,7 +21,17 @@ namespace
         const char* Filename = "obsdatain";
         const char* TablePath = "tablepath";
         const char* Exports = "exports";
+        const char* MessageCache = "messageCache";
+        const char* NarrowIntegers = "narrowIntegers";
+
+        namespace Cache
+        {
+            const char* Directory = "directory";
+            const char* MaxSizeMB = "maxSizeMB";
+        }  // namespace Cache
     }  // namespace ConfKeys
+
+    const size_t DefaultCacheSizeMB = 1024;
 }  // namespace
 
 namespace Ingester
@@ -39,5 +49,28 @@ namespace Ingester
         {
             setTablepath("");
         }
+
+        if (conf.has(ConfKeys::MessageCache))
+        {
+            auto cacheConf = conf.getSubConfiguration(ConfKeys::MessageCache);
+            if (!cacheConf.has(ConfKeys::Cache::Directory))
+            {
+                throw eckit::BadParameter("messageCache needs a directory.");
+            }
+
+            size_t maxSizeMB = DefaultCacheSizeMB;
+            if (cacheConf.has(ConfKeys::Cache::MaxSizeMB))
+            {
+                maxSizeMB = static_cast<size_t>(cacheConf.getInt(ConfKeys::Cache::MaxSizeMB));
+            }
+
+            setCacheDirectory(cacheConf.getString(ConfKeys::Cache::Directory));
+            setCacheMaxBytes(maxSizeMB * 1024 * 1024);
+        }
+
+        if (conf.has(ConfKeys::NarrowIntegers))
+        {
+            setNarrowIntegers(conf.getBool(ConfKeys::NarrowIntegers));
+        }
     }
 }  // namespace Ingester
@@ -35,11 +35,17 @@ namespace Ingester
         inline void setFilepath(const std::string& filepath) { filepath_ = filepath; }
         inline void setTablepath(const std::string& tablepath) { tablepath_ = tablepath; }
         inline void setExport(const Export& newExport) { export_ = newExport; }
+        inline void setCacheDirectory(const std::string& dir) { cacheDirectory_ = dir; }
+        inline void setCacheMaxBytes(size_t maxBytes) { cacheMaxBytes_ = maxBytes; }
+        inline void setNarrowIntegers(bool narrow) { narrowIntegers_ = narrow; }
 
         // Getters
         inline std::string filepath() const { return filepath_; }
         inline std::string tablepath() const { return tablepath_; }
         inline Export getExport() const { return export_; }
+        inline std::string cacheDirectory() const { return cacheDirectory_; }
+        inline size_t cacheMaxBytes() const { return cacheMaxBytes_; }
+        inline bool narrowIntegers() const { return narrowIntegers_; }
 
      private:
         /// \brief Specifies the relative path to the BUFR file to read.
@@ -50,5 +56,15 @@ namespace Ingester
 
         /// \brief Map of export strings to Variable classes.
         Export export_;
+
+        /// \brief Directory for the message cache (no cache if empty).
+        std::string cacheDirectory_;
+
+        /// \brief Maximum size of the message cache directory.
+        size_t cacheMaxBytes_ = 0;
+
+        /// \brief Store the integer fields without a type in the narrowest integer type that
+        ///        holds their values (int8, int16 or int32).
+        bool narrowIntegers_ = false;
     };
 }  // namespace Ingester
@@ -16,9 +16,9 @@
 
 #include "DataContainer.h"
 #include "DataObject.h"
-#include "Exports/Export.h"
-#include "Exports/Splits/Split.h"
 
+#include "Query/Constants.h"
+#include "Query/ParallelFor.h"
 #include "Query/QuerySet.h"
 
 
@@ -30,6 +30,8 @@ namespace Ingester {
     {
         // print message
         oops::Log::info() << "BufrParser: Parsing file " << description_.filepath() << std::endl;
+
+        initMessageCache();
     }
 
     BufrParser::BufrParser(const eckit::LocalConfiguration &conf) :
@@ -39,6 +41,8 @@ namespace Ingester {
     {
         // print message
         oops::Log::info() << "BufrParser: Parsing file " << description_.filepath() << std::endl;
+
+        initMessageCache();
     }
 
     BufrParser::~BufrParser()
@@ -49,6 +53,7 @@ namespace Ingester {
     std::shared_ptr<DataContainer> BufrParser::parse(const size_t maxMsgsToParse)
     {
         auto startTime = std::chrono::steady_clock::now();
+        bufr::TaskScheduler::Scope schedulerScope(scheduler_);
 
         auto querySet = bufr::QuerySet(description_.getExport().getSubsets());
 
@@ -63,19 +68,49 @@ namespace Ingester {
         oops::Log::info() << "Executing Queries" << std::endl;
         const auto resultSet = file_.execute(querySet, maxMsgsToParse);
 
+        if (messageCache_ != nullptr)
+        {
+            oops::Log::info() << "Message cache: " << messageCache_->hits() << " hits, "
+                              << messageCache_->misses() << " misses" << std::endl;
+        }
+
         oops::Log::info() << "Building Bufr Data" << std::endl;
-        auto srcData = BufrDataMap();
+        std::vector<QueryInfo> queryInfos;
         for (const auto& var : description_.getExport().getVariables())
         {
             for (const auto& queryInfo : var->getQueryList())
             {
-                srcData[queryInfo.name] = resultSet.get(
-                    queryInfo.name, queryInfo.groupByField, queryInfo.type);
+                queryInfos.push_back(queryInfo);
             }
         }
 
+        // The fields are independent, so materialize them concurrently (each one splits its
+        // frames into more tasks on the same scheduler)
+        std::vector<std::shared_ptr<DataObjectBase>> fields(queryInfos.size());
+        bufr::parallelFor(queryInfos.size(), 1, [&](size_t fieldBegin, size_t fieldEnd)
+        {
+            for (size_t fieldIdx = fieldBegin; fieldIdx < fieldEnd; ++fieldIdx)
+            {
+                const auto& queryInfo = queryInfos[fieldIdx];
+
+                auto type = queryInfo.type;
+                if (type.empty() && description_.narrowIntegers())
+                {
+                    type = bufr::NarrowestType;
+                }
+
+                fields[fieldIdx] = resultSet.get(queryInfo.name, queryInfo.groupByField, type);
+            }
+        });
+
+        auto srcData = BufrDataMap();
+        for (size_t fieldIdx = 0; fieldIdx < queryInfos.size(); ++fieldIdx)
+        {
+            srcData[queryInfos[fieldIdx].name] = fields[fieldIdx];
+        }
+
         oops::Log::info()  << "Exporting Data" << std::endl;
-        auto exportedData = exportData(srcData);
+        auto exportedData = exportData(description_.getExport(), srcData);
 
         auto timeElapsed = std::chrono::steady_clock::now() - startTime;
         auto timeElapsedDuration = std::chrono::duration_cast<std::chrono::milliseconds>
@@ -87,75 +122,13 @@ namespace Ingester {
         return exportedData;
     }
 
-    std::shared_ptr<DataContainer> BufrParser::exportData(const BufrDataMap &srcData) {
-        auto exportDescription = description_.getExport();
-
-        auto filters = exportDescription.getFilters();
-        auto splits = exportDescription.getSplits();
-        auto vars = exportDescription.getVariables();
-
-        // Filter
-        BufrDataMap dataCopy = srcData;  // make mutable copy
-        for (const auto &filter : filters)
-        {
-            filter->apply(dataCopy);
-        }
-
-        // Split
-        CategoryMap catMap;
-        for (const auto &split : splits)
-        {
-            std::ostringstream catName;
-            catName << "splits/" << split->getName();
-            catMap.insert({catName.str(), split->subCategories(dataCopy)});
-        }
-
-        BufrParser::CatDataMap splitDataMaps;
-        splitDataMaps.insert({std::vector<std::string>(), dataCopy});
-        for (const auto &split : splits)
-        {
-            splitDataMaps = splitData(splitDataMaps, *split);
-        }
-
-        // Export
-        auto exportData = std::make_shared<Ingester::DataContainer>(catMap);
-        for (const auto &dataPair : splitDataMaps)
-        {
-            for (const auto &var : vars)
-            {
-                std::ostringstream pathStr;
-                pathStr << "variables/" << var->getExportName();
-
-                std::string ovar;
-                ovar = var->getExportName();
-                oops::Log::debug() << "Exporting variable = " << ovar << std::endl;
-
-                exportData->add(pathStr.str(),
-                                var->exportData(dataPair.second),
-                                dataPair.first);
-            }
-        }
-
-        return exportData;
-    }
-
-    BufrParser::CatDataMap BufrParser::splitData(BufrParser::CatDataMap &splitMaps, Split &split)
+    void BufrParser::initMessageCache()
     {
-        CatDataMap splitDataMap;
-
-        for (const auto &splitMapPair : splitMaps)
-        {
-            auto newData = split.split(splitMapPair.second);
-
-            for (const auto &newDataPair : newData)
-            {
-                auto catVect = splitMapPair.first;
-                catVect.push_back(newDataPair.first);
-                splitDataMap.insert({catVect, newDataPair.second});
-            }
-        }
+        if (description_.cacheDirectory().empty()) return;
 
-        return splitDataMap;
+        messageCache_ = std::make_shared<bufr::MessageCache>(description_.cacheDirectory(),
+                                                             description_.cacheMaxBytes());
+        file_.setMessageCache(messageCache_);
     }
 
     void BufrParser::reset()
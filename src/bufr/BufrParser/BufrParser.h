@@ -41,24 +41,17 @@ namespace Ingester {
         void reset() final;
 
      private:
-        typedef std::map<std::vector<std::string>, BufrDataMap> CatDataMap;
-
         /// \brief The description the defines what to parse from the BUFR file
         BufrDescription description_;
 
         /// \brief The Bufr file object we are working with
         bufr::File file_;
 
-        /// \brief Exports collected data into a DataContainer
-        /// \param srcData Data to export
-        std::shared_ptr<DataContainer> exportData(const BufrDataMap& srcData);
+        /// \brief Message cache shared across parse calls (null if not configured)
+        std::shared_ptr<bufr::MessageCache> messageCache_;
 
-        /// \brief Function responsible for dividing the data into subcategories.
-        /// \details This function is intended to be called over and over for each specified Split
-        ///          object, sub-splitting the data given into all the possible subcategories.
-        /// \param splitMaps Pre-split map of data.
-        /// \param split Object that knows how to split data.
-        CatDataMap splitData(CatDataMap& splitMaps, Split& split);
+        /// \brief Sets up the message cache if the description asks for one.
+        void initMessageCache();
 
         /// \brief Opens a BUFR file using the Fortran BUFR interface.
         /// \param filepath Path to bufr file.
@@ -13,6 +13,7 @@
 #include "eckit/exception/Exceptions.h"
 
 #include "Filters/BoundingFilter.h"
+#include "Filters/RegionFilter.h"
 #include "Splits/CategorySplit.h"
 #include "Variables/QueryVariable.h"
 #include "Variables/DatetimeVariable.h"
@@ -22,6 +23,11 @@
 #include "Variables/TimeoffsetVariable.h"
 #include "Variables/SensorScanAngleVariable.h"
 #include "Variables/SensorScanPositionVariable.h"
+#include "Variables/GnssroCombinedFrequencyVariable.h"
+#include "Variables/GnssroImpactHeightVariable.h"
+#include "Variables/GnssroQualityFlagsVariable.h"
+#include "Variables/BackusGilbertRemapVariable.h"
+#include "Variables/VerticalResampleVariable.h"
 #include "ObjectFactory.h"
 
 
@@ -44,6 +50,11 @@ namespace
             const char* AircraftAltitude = "aircraftAltitude";
             const char* SensorScanAngle = "sensorScanAngle";
             const char* SensorScanPosition = "sensorScanPosition";
+            const char* GnssroCombinedFrequency = "gnssroCombinedFrequency";
+            const char* GnssroImpactHeight = "gnssroImpactHeight";
+            const char* GnssroQualityFlags = "gnssroQualityFlags";
+            const char* BackusGilbertRemap = "backusGilbertRemap";
+            const char* VerticalResample = "verticalResample";
             const char* Query = "query";
         }  // namespace Variable
 
@@ -55,6 +66,7 @@ namespace
         namespace Filter
         {
             const char* Bounding = "bounding";
+            const char* Region = "region";
         }
     }  // namespace ConfKeys
 }  // namespace
@@ -136,6 +148,16 @@ namespace Ingester
             (ConfKeys::Variable::SensorScanAngle);
         variableFactory.registerObject<SensorScanPositionVariable>
             (ConfKeys::Variable::SensorScanPosition);
+        variableFactory.registerObject<GnssroCombinedFrequencyVariable>
+            (ConfKeys::Variable::GnssroCombinedFrequency);
+        variableFactory.registerObject<GnssroImpactHeightVariable>
+            (ConfKeys::Variable::GnssroImpactHeight);
+        variableFactory.registerObject<GnssroQualityFlagsVariable>
+            (ConfKeys::Variable::GnssroQualityFlags);
+        variableFactory.registerObject<BackusGilbertRemapVariable>
+            (ConfKeys::Variable::BackusGilbertRemap);
+        variableFactory.registerObject<VerticalResampleVariable>
+            (ConfKeys::Variable::VerticalResample);
 
         if (conf.keys().size() == 0)
         {
@@ -201,6 +223,7 @@ namespace Ingester
 
         FilterFactory filterFactory;
         filterFactory.registerObject<BoundingFilter>(ConfKeys::Filter::Bounding);
+        filterFactory.registerObject<RegionFilter>(ConfKeys::Filter::Region);
 
         auto subConfs = conf.getSubConfigurations();
         if (subConfs.size() == 0)
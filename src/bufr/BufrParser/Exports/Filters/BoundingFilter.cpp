@@ -8,6 +8,7 @@
 #include "BoundingFilter.h"
 
 #include <ostream>
+#include <vector>
 
 #include "eckit/exception/Exceptions.h"
 
@@ -29,7 +30,7 @@ namespace
 
 namespace Ingester
 {
-    typedef Eigen::Array<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> EigArray;
+    typedef Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> EigArray;
 
     BoundingFilter::BoundingFilter(const eckit::LocalConfiguration& conf) :
       Filter(conf),
@@ -37,12 +38,12 @@ namespace Ingester
     {
         if (conf.has(ConfKeys::LowerBound))
         {
-            lowerBound_ = std::make_shared<float>(conf.getFloat(ConfKeys::LowerBound));
+            lowerBound_ = std::make_shared<double>(conf.getDouble(ConfKeys::LowerBound));
         }
 
         if (conf.has(ConfKeys::UpperBound))
         {
-            upperBound_ = std::make_shared<float>(conf.getFloat(ConfKeys::UpperBound));
+            upperBound_ = std::make_shared<double>(conf.getDouble(ConfKeys::UpperBound));
         }
 
         if (!upperBound_ && !lowerBound_)
@@ -70,7 +71,8 @@ namespace Ingester
             throw eckit::BadParameter(errStr.str());
         }
 
-        if (const auto& var = std::dynamic_pointer_cast<DataObject<float>>(dataMap.at(variable_)))
+        const auto& var = dataMap.at(variable_);
+        if (std::dynamic_pointer_cast<DataObject<std::string>>(var) == nullptr)
         {
             auto dims = var->getDims();
             size_t extraDims = 1;
@@ -80,24 +82,41 @@ namespace Ingester
                 extraDims *= dims[dimIdx];
             }
 
-            // Make local copy otherwise you get weird memory corruption issue.
-            auto rawData = var->getRawData();
+            // Make local copy (as doubles, so any numeric type compares exactly) otherwise you
+            // get weird memory corruption issue.
+            std::vector<double> rawData(var->size());
+            for (size_t idx = 0; idx < rawData.size(); ++idx)
+            {
+                rawData[idx] = var->getAsDouble(idx);
+            }
+
             auto array = Eigen::Map<EigArray> (rawData.data(), dims[0], extraDims);
 
+            // Float data is compared against the bounds as floats (like the float yaml values
+            // the filter used to read), so data equal to a bound stays in.
+            const bool isFloat = std::dynamic_pointer_cast<DataObject<float>>(var) != nullptr;
+            const auto bound = [isFloat](const std::shared_ptr<double>& value)
+            {
+                return isFloat ? static_cast<double>(static_cast<float>(*value)) : *value;
+            };
+
+            const double lowerBound = lowerBound_ ? bound(lowerBound_) : 0.0;
+            const double upperBound = upperBound_ ? bound(upperBound_) : 0.0;
+
             for (auto rowIdx = 0; rowIdx < dims[0]; rowIdx++)
             {
                 if (lowerBound_ && upperBound_)
                 {
-                    if ((array.row(rowIdx) >= *lowerBound_).all() &&
-                        (array.row(rowIdx) <= *upperBound_).all())
+                    if ((array.row(rowIdx) >= lowerBound).all() &&
+                        (array.row(rowIdx) <= upperBound).all())
                     {
                         validRows.push_back(rowIdx);
                     }
                 }
                 else
                 {
-                    if ((lowerBound_ && (array.row(rowIdx) >= *lowerBound_).all()) ||
-                        (upperBound_ && (array.row(rowIdx) <= *upperBound_).all()))
+                    if ((lowerBound_ && (array.row(rowIdx) >= lowerBound).all()) ||
+                        (upperBound_ && (array.row(rowIdx) <= upperBound).all()))
                     {
                         validRows.push_back(rowIdx);
                     }
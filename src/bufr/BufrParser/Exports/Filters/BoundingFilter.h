@@ -31,7 +31,7 @@ namespace Ingester
         /// \param dataMap Map to modify by filtering out rel
      private:
          const std::string variable_;
-         std::shared_ptr<float> lowerBound_;
-         std::shared_ptr<float> upperBound_;
+         std::shared_ptr<double> lowerBound_;
+         std::shared_ptr<double> upperBound_;
     };
 }  // namespace Ingester
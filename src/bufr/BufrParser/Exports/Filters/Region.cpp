@@ -0,0 +1,552 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include "Region.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "eckit/exception/Exceptions.h"
+#include "eckit/parser/YAMLParser.h"
+#include "eckit/value/Value.h"
+
+
+namespace
+{
+    // Fraction of a grid cell the cells are grown by when looking for the edges that touch
+    // them, so that rounding can't put a point in a cell that an edge was missed for.
+    const double CellPadding = 1e-6;
+
+    /// \brief Get a member of a GeoJSON object that must be a list.
+    eckit::Value listMember(const eckit::Value& object, const char* name)
+    {
+        if (!object.contains(name) || !object[name].isList())
+        {
+            std::ostringstream errStr;
+            errStr << "Invalid GeoJSON (" << name << " must be an array).";
+            throw eckit::BadParameter(errStr.str());
+        }
+
+        return object[name];
+    }
+
+    Ingester::Region::Ring jsonToRing(const eckit::Value& positions)
+    {
+        if (!positions.isList())
+        {
+            throw eckit::BadParameter("Invalid GeoJSON (a ring must be an array of positions).");
+        }
+
+        Ingester::Region::Ring ring;
+        for (size_t idx = 0; idx < positions.size(); ++idx)
+        {
+            const auto position = positions[static_cast<int>(idx)];
+            if (!position.isList() || position.size() < 2 ||
+                !(position[0].isNumber() || position[0].isDouble()) ||
+                !(position[1].isNumber() || position[1].isDouble()))
+            {
+                throw eckit::BadParameter("Invalid GeoJSON position (need [x, y]).");
+            }
+
+            ring.push_back({static_cast<double>(position[0]), static_cast<double>(position[1])});
+        }
+
+        return ring;
+    }
+
+    Ingester::Region::Polygon jsonToPolygon(const eckit::Value& rings)
+    {
+        if (!rings.isList())
+        {
+            throw eckit::BadParameter("Invalid GeoJSON (a polygon must be an array of rings).");
+        }
+
+        Ingester::Region::Polygon polygon;
+        for (size_t idx = 0; idx < rings.size(); ++idx)
+        {
+            polygon.push_back(jsonToRing(rings[static_cast<int>(idx)]));
+        }
+
+        return polygon;
+    }
+
+    void collectGeoJson(const eckit::Value& value, std::vector<Ingester::Region::Polygon>& polygons)
+    {
+        if (!value.isMap() || !value.contains("type") || !value["type"].isString())
+        {
+            throw eckit::BadParameter("Invalid GeoJSON (object without a type).");
+        }
+
+        const auto type = static_cast<std::string>(value["type"]);
+        if (type == "FeatureCollection")
+        {
+            const auto features = listMember(value, "features");
+            for (size_t idx = 0; idx < features.size(); ++idx)
+            {
+                collectGeoJson(features[static_cast<int>(idx)], polygons);
+            }
+        }
+        else if (type == "Feature")
+        {
+            // Features without a geometry have a null one
+            if (value.contains("geometry") && value["geometry"].isMap())
+            {
+                collectGeoJson(value["geometry"], polygons);
+            }
+        }
+        else if (type == "GeometryCollection")
+        {
+            const auto geometries = listMember(value, "geometries");
+            for (size_t idx = 0; idx < geometries.size(); ++idx)
+            {
+                collectGeoJson(geometries[static_cast<int>(idx)], polygons);
+            }
+        }
+        else if (type == "Polygon")
+        {
+            polygons.push_back(jsonToPolygon(listMember(value, "coordinates")));
+        }
+        else if (type == "MultiPolygon")
+        {
+            const auto coordinates = listMember(value, "coordinates");
+            for (size_t idx = 0; idx < coordinates.size(); ++idx)
+            {
+                polygons.push_back(jsonToPolygon(coordinates[static_cast<int>(idx)]));
+            }
+        }
+        else
+        {
+            std::ostringstream errStr;
+            errStr << "GeoJSON geometry " << type << " is not a polygon.";
+            throw eckit::BadParameter(errStr.str());
+        }
+    }
+
+    /// \brief Reads the POLYGON and MULTIPOLYGON geometries out of WKT (or EWKT) text.
+    class WktReader
+    {
+     public:
+        explicit WktReader(const std::string& text) : text_(text) {}
+
+        std::vector<Ingester::Region::Polygon> read()
+        {
+            std::vector<Ingester::Region::Polygon> polygons;
+            while (true)
+            {
+                auto word = readWord();
+                if (word.empty())
+                {
+                    skipSpace();
+                    if (pos_ >= text_.size()) break;
+                    if (text_[pos_] == ';' || text_[pos_] == ',')
+                    {
+                        pos_++;  // separators between geometries or after an EWKT SRID
+                        continue;
+                    }
+
+                    error("expected a geometry type");
+                }
+
+                if (word.compare(0, 5, "SRID=") == 0) continue;
+
+                if (word == "GEOMETRYCOLLECTION")
+                {
+                    skipDimension();
+                    if (!readEmpty())
+                    {
+                        expect('(');  // the geometries inside are read as top level ones
+                        depth_++;
+                    }
+                }
+                else if (word == "POLYGON")
+                {
+                    skipDimension();
+                    if (!readEmpty()) polygons.push_back(readPolygon());
+                }
+                else if (word == "MULTIPOLYGON")
+                {
+                    skipDimension();
+                    if (readEmpty()) continue;
+
+                    expect('(');
+                    do
+                    {
+                        polygons.push_back(readPolygon());
+                    } while (readSeparator());
+                }
+                else
+                {
+                    std::ostringstream errStr;
+                    errStr << "WKT geometry " << word << " is not a polygon.";
+                    throw eckit::BadParameter(errStr.str());
+                }
+
+                // Close the geometry collections that end here
+                while (depth_ > 0 && peek() == ')')
+                {
+                    pos_++;
+                    depth_--;
+                }
+            }
+
+            if (depth_ != 0) error("unbalanced parentheses");
+            return polygons;
+        }
+
+     private:
+        const std::string& text_;
+        size_t pos_ = 0;
+        size_t depth_ = 0;
+
+        [[noreturn]] void error(const std::string& msg) const
+        {
+            std::ostringstream errStr;
+            errStr << "Invalid WKT (" << msg << ") at character " << pos_ << ".";
+            throw eckit::BadParameter(errStr.str());
+        }
+
+        void skipSpace()
+        {
+            while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_])))
+            {
+                pos_++;
+            }
+        }
+
+        char peek()
+        {
+            skipSpace();
+            return pos_ < text_.size() ? text_[pos_] : '\0';
+        }
+
+        void expect(char c)
+        {
+            if (peek() != c) error(std::string("expected '") + c + "'");
+            pos_++;
+        }
+
+        std::string readWord()
+        {
+            skipSpace();
+            std::string word;
+            while (pos_ < text_.size() &&
+                   (std::isalnum(static_cast<unsigned char>(text_[pos_])) ||
+                    (!word.empty() && text_[pos_] == '=')))
+            {
+                word += static_cast<char>(std::toupper(static_cast<unsigned char>(text_[pos_])));
+                pos_++;
+            }
+
+            return word;
+        }
+
+        void skipDimension()
+        {
+            const auto start = pos_;
+            const auto word = readWord();
+            if (word != "Z" && word != "M" && word != "ZM") pos_ = start;
+        }
+
+        bool readEmpty()
+        {
+            const auto start = pos_;
+            if (readWord() == "EMPTY") return true;
+            pos_ = start;
+            return false;
+        }
+
+        /// \brief Read a ',' (returns true) or a ')' (returns false).
+        bool readSeparator()
+        {
+            const char c = peek();
+            pos_++;
+            if (c == ',') return true;
+            if (c != ')') error("expected ',' or ')'");
+            return false;
+        }
+
+        double readNumber()
+        {
+            skipSpace();
+            const char* start = text_.c_str() + pos_;
+            char* end = nullptr;
+            const double value = std::strtod(start, &end);
+            if (end == start) error("expected a number");
+            pos_ += end - start;
+            return value;
+        }
+
+        Ingester::Region::Ring readRing()
+        {
+            Ingester::Region::Ring ring;
+            expect('(');
+            do
+            {
+                const double x = readNumber();
+                const double y = readNumber();
+                while (peek() != ',' && peek() != ')') readNumber();  // z and m
+                ring.push_back({x, y});
+            } while (readSeparator());
+
+            return ring;
+        }
+
+        Ingester::Region::Polygon readPolygon()
+        {
+            Ingester::Region::Polygon polygon;
+            expect('(');
+            do
+            {
+                polygon.push_back(readRing());
+            } while (readSeparator());
+
+            return polygon;
+        }
+    };
+}  // namespace
+
+
+namespace Ingester
+{
+    void Region::addPolygon(const Polygon& polygon)
+    {
+        if (polygon.empty())
+        {
+            throw eckit::BadParameter("Region polygons must have at least one ring.");
+        }
+
+        for (const auto& ring : polygon)
+        {
+            if (ring.size() < 3)
+            {
+                throw eckit::BadParameter("Region polygon rings must have at least 3 vertices.");
+            }
+
+            for (size_t pointIdx = 0; pointIdx < ring.size(); ++pointIdx)
+            {
+                const auto& point = ring[pointIdx];
+                if (!std::isfinite(point.x) || !std::isfinite(point.y))
+                {
+                    throw eckit::BadParameter("Region polygon vertices must be finite.");
+                }
+
+                if (edges_.empty() && pointIdx == 0)
+                {
+                    minX_ = maxX_ = point.x;
+                    minY_ = maxY_ = point.y;
+                }
+
+                minX_ = std::min(minX_, point.x);
+                maxX_ = std::max(maxX_, point.x);
+                minY_ = std::min(minY_, point.y);
+                maxY_ = std::max(maxY_, point.y);
+
+                edges_.push_back({point, ring[(pointIdx + 1) % ring.size()], numPolygons_});
+            }
+        }
+
+        numPolygons_++;
+        cells_.clear();
+    }
+
+    void Region::addGeoJson(const std::string& text)
+    {
+        // JSON is valid YAML. The coordinates are nested lists of numbers, which the
+        // Configuration getters can't return, so the parsed value is read directly.
+        std::vector<Polygon> polygons;
+        collectGeoJson(eckit::YAMLParser::decodeString(text), polygons);
+        for (const auto& polygon : polygons)
+        {
+            addPolygon(polygon);
+        }
+    }
+
+    void Region::addWkt(const std::string& text)
+    {
+        for (const auto& polygon : WktReader(text).read())
+        {
+            addPolygon(polygon);
+        }
+    }
+
+    void Region::addFile(const std::string& path)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            std::ostringstream errStr;
+            errStr << "Could not open the region file " << path << ".";
+            throw eckit::BadParameter(errStr.str());
+        }
+
+        std::stringstream text;
+        text << file.rdbuf();
+
+        const auto str = text.str();
+        const auto firstChar = str.find_first_not_of(" \t\r\n");
+        if (firstChar != std::string::npos && str[firstChar] == '{')
+        {
+            addGeoJson(str);
+        }
+        else
+        {
+            addWkt(str);
+        }
+    }
+
+    void Region::buildGrid(size_t gridSize)
+    {
+        if (edges_.empty())
+        {
+            throw eckit::BadParameter("Region has no polygons.");
+        }
+
+        gridSize_ = std::max<size_t>(1, gridSize);
+        cellWidth_ = maxX_ > minX_ ? (maxX_ - minX_) / gridSize_ : 1.0;
+        cellHeight_ = maxY_ > minY_ ? (maxY_ - minY_) / gridSize_ : 1.0;
+
+        const double padX = cellWidth_ * CellPadding;
+        const double padY = cellHeight_ * CellPadding;
+
+        rowEdges_.assign(gridSize_, {});
+        std::vector<uint8_t> isBoundary(gridSize_ * gridSize_, 0);
+        for (size_t edgeIdx = 0; edgeIdx < edges_.size(); ++edgeIdx)
+        {
+            const auto& edge = edges_[edgeIdx];
+            const double edgeMinY = std::min(edge.start.y, edge.end.y);
+            const double edgeMaxY = std::max(edge.start.y, edge.end.y);
+
+            const size_t firstRow = gridIdx(edgeMinY - padY, minY_, cellHeight_);
+            const size_t lastRow = gridIdx(edgeMaxY + padY, minY_, cellHeight_);
+            for (size_t row = firstRow; row <= lastRow; ++row)
+            {
+                rowEdges_[row].push_back(edgeIdx);
+
+                // X extent of the part of the edge that is inside the (padded) row
+                double x0 = edge.start.x;
+                double x1 = edge.end.x;
+                if (edge.end.y != edge.start.y)
+                {
+                    const double rowMinY = std::max(edgeMinY, minY_ + row * cellHeight_ - padY);
+                    const double rowMaxY = std::min(edgeMaxY,
+                                                    minY_ + (row + 1) * cellHeight_ + padY);
+                    const double slope = (edge.end.x - edge.start.x) / (edge.end.y - edge.start.y);
+                    x0 = edge.start.x + (rowMinY - edge.start.y) * slope;
+                    x1 = edge.start.x + (rowMaxY - edge.start.y) * slope;
+                }
+
+                const size_t firstCol = gridIdx(std::min(x0, x1) - padX, minX_, cellWidth_);
+                const size_t lastCol = gridIdx(std::max(x0, x1) + padX, minX_, cellWidth_);
+                std::fill(isBoundary.begin() + row * gridSize_ + firstCol,
+                          isBoundary.begin() + row * gridSize_ + lastCol + 1,
+                          1);
+            }
+        }
+
+        // The cells between two boundary cells of a row are all inside or all outside, so only
+        // the first cell of each run needs a point in polygon test.
+        cells_.assign(gridSize_ * gridSize_, CellState::Outside);
+        for (size_t row = 0; row < gridSize_; ++row)
+        {
+            const double centerY = minY_ + (row + 0.5) * cellHeight_;
+            CellState runState = CellState::Outside;
+            bool newRun = true;
+            for (size_t col = 0; col < gridSize_; ++col)
+            {
+                const size_t cellIdx = row * gridSize_ + col;
+                if (isBoundary[cellIdx])
+                {
+                    cells_[cellIdx] = CellState::Boundary;
+                    newRun = true;
+                    continue;
+                }
+
+                if (newRun)
+                {
+                    const double centerX = minX_ + (col + 0.5) * cellWidth_;
+                    runState = crossingTest(centerX, centerY, row) ? CellState::Inside
+                                                                   : CellState::Outside;
+                    newRun = false;
+                }
+
+                cells_[cellIdx] = runState;
+            }
+        }
+    }
+
+    bool Region::contains(double x, double y) const
+    {
+        if (cells_.empty())
+        {
+            throw eckit::BadParameter("Region::buildGrid must be called before contains.");
+        }
+
+        // Also rejects NaN
+        if (!(x >= minX_ && x <= maxX_ && y >= minY_ && y <= maxY_)) return false;
+
+        const size_t row = gridIdx(y, minY_, cellHeight_);
+        const auto state = cells_[row * gridSize_ + gridIdx(x, minX_, cellWidth_)];
+        if (state != CellState::Boundary) return state == CellState::Inside;
+
+        return crossingTest(x, y, row);
+    }
+
+    void Region::contains(const std::vector<double>& xs,
+                          const std::vector<double>& ys,
+                          std::vector<uint8_t>& inside) const
+    {
+        if (xs.size() != ys.size())
+        {
+            throw eckit::BadParameter("Region::contains needs as many x as y coordinates.");
+        }
+
+        inside.resize(xs.size());
+        for (size_t idx = 0; idx < xs.size(); ++idx)
+        {
+            inside[idx] = contains(xs[idx], ys[idx]) ? 1 : 0;
+        }
+    }
+
+    size_t Region::gridIdx(double value, double min, double cellSize) const
+    {
+        const double idx = std::floor((value - min) / cellSize);
+        if (idx <= 0) return 0;
+        return std::min(static_cast<size_t>(idx), gridSize_ - 1);
+    }
+
+    bool Region::crossingTest(double x, double y, size_t row) const
+    {
+        // The edges of a row are in polygon order, so the parity of each polygon is complete
+        // when the next polygon starts.
+        bool inside = false;
+        size_t polygon = 0;
+        for (const auto edgeIdx : rowEdges_[row])
+        {
+            const auto& edge = edges_[edgeIdx];
+            if (edge.polygon != polygon)
+            {
+                if (inside) return true;
+                polygon = edge.polygon;
+            }
+
+            if ((edge.start.y > y) != (edge.end.y > y) &&
+                x < edge.start.x + (y - edge.start.y) * (edge.end.x - edge.start.x) /
+                                   (edge.end.y - edge.start.y))
+            {
+                inside = !inside;
+            }
+        }
+
+        return inside;
+    }
+}  // namespace Ingester
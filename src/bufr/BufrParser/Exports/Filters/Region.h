@@ -0,0 +1,118 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace Ingester
+{
+    /// \brief A region made of one or more polygons (with optional holes) in the plane. Each
+    ///        polygon is tested with the even-odd rule and the polygons are combined by union.
+    ///        After all the polygons are added, buildGrid precomputes a uniform grid over the
+    ///        bounding box whose cells are classified as inside, outside or boundary. Only the
+    ///        points that land in a boundary cell need to be tested against the polygon edges, and
+    ///        then only against the edges that cross the grid row of the point.
+    class Region
+    {
+     public:
+        struct Point
+        {
+            double x;
+            double y;
+        };
+
+        /// \brief A closed ring of vertices (the last vertex connects back to the first).
+        typedef std::vector<Point> Ring;
+
+        /// \brief Outer ring followed by the holes.
+        typedef std::vector<Ring> Polygon;
+
+        Region() = default;
+
+        /// \brief Add a polygon.
+        /// \param polygon The outer ring followed by any holes.
+        void addPolygon(const Polygon& polygon);
+
+        /// \brief Add the Polygon and MultiPolygon geometries of a GeoJSON document (Feature,
+        ///        FeatureCollection, GeometryCollection or a bare geometry).
+        /// \param text The GeoJSON text.
+        void addGeoJson(const std::string& text);
+
+        /// \brief Add the POLYGON and MULTIPOLYGON geometries in a WKT string (there can be
+        ///        several of them).
+        /// \param text The WKT text.
+        void addWkt(const std::string& text);
+
+        /// \brief Add the polygons in a GeoJSON or WKT file (GeoJSON if the file starts with a
+        ///        '{').
+        /// \param path Path of the file.
+        void addFile(const std::string& path);
+
+        /// \brief Build the acceleration grid. Must be called after the last polygon is added
+        ///        and before contains.
+        /// \param gridSize Number of grid cells along each side of the bounding box.
+        void buildGrid(size_t gridSize = 256);
+
+        /// \brief Is the point inside the region?
+        bool contains(double x, double y) const;
+
+        /// \brief Test many points.
+        /// \param xs X coordinates.
+        /// \param ys Y coordinates.
+        /// \param inside Set to 1 for the points inside the region and 0 otherwise.
+        void contains(const std::vector<double>& xs,
+                      const std::vector<double>& ys,
+                      std::vector<uint8_t>& inside) const;
+
+        /// \brief Is there any polygon in the region?
+        inline bool empty() const { return edges_.empty(); }
+
+        /// \brief Bounding box of the region.
+        inline double minX() const { return minX_; }
+        inline double maxX() const { return maxX_; }
+        inline double minY() const { return minY_; }
+        inline double maxY() const { return maxY_; }
+
+     private:
+        enum class CellState : uint8_t
+        {
+            Outside,
+            Inside,
+            Boundary
+        };
+
+        struct Edge
+        {
+            Point start;
+            Point end;
+            size_t polygon;
+        };
+
+        std::vector<Edge> edges_;
+        size_t numPolygons_ = 0;
+        double minX_ = 0;
+        double maxX_ = 0;
+        double minY_ = 0;
+        double maxY_ = 0;
+
+        size_t gridSize_ = 0;
+        double cellWidth_ = 0;
+        double cellHeight_ = 0;
+        std::vector<CellState> cells_;
+        std::vector<std::vector<size_t>> rowEdges_;  ///< Edges overlapping each grid row
+
+        /// \brief Grid row (or column) of a coordinate, clamped to the grid.
+        size_t gridIdx(double value, double min, double cellSize) const;
+
+        /// \brief Even-odd test against the edges that overlap a grid row.
+        bool crossingTest(double x, double y, size_t row) const;
+    };
+}  // namespace Ingester
@@ -0,0 +1,194 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include "RegionFilter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <ostream>
+#include <vector>
+
+#include "eckit/exception/Exceptions.h"
+
+#include "DataObject.h"
+
+
+namespace
+{
+    namespace ConfKeys
+    {
+        const char* Latitude = "latitude";
+        const char* Longitude = "longitude";
+        const char* Polygons = "polygons";
+        const char* Wkt = "wkt";
+        const char* File = "file";
+        const char* GridSize = "gridSize";
+        const char* Exclude = "exclude";
+        const char* KeepMissing = "keepMissing";
+    }  // namespace ConfKeys
+
+    const char* DefaultLatitude = "latitude";
+    const char* DefaultLongitude = "longitude";
+    const int DefaultGridSize = 256;
+}  // namespace
+
+
+namespace Ingester
+{
+    RegionFilter::RegionFilter(const eckit::LocalConfiguration& conf) :
+      Filter(conf),
+      latitude_(conf.getString(ConfKeys::Latitude, DefaultLatitude)),
+      longitude_(conf.getString(ConfKeys::Longitude, DefaultLongitude)),
+      exclude_(conf.getBool(ConfKeys::Exclude, false)),
+      keepMissing_(conf.getBool(ConfKeys::KeepMissing, false))
+    {
+        if (conf.has(ConfKeys::Polygons))
+        {
+            for (const auto& polygonConf : conf.getSubConfigurations(ConfKeys::Polygons))
+            {
+                const auto lons = polygonConf.getDoubleVector(ConfKeys::Longitude);
+                const auto lats = polygonConf.getDoubleVector(ConfKeys::Latitude);
+                if (lons.size() != lats.size())
+                {
+                    std::ostringstream errStr;
+                    errStr << "RegionFilter polygons must have as many longitudes as latitudes.";
+                    throw eckit::BadParameter(errStr.str());
+                }
+
+                Region::Ring ring;
+                for (size_t idx = 0; idx < lons.size(); ++idx)
+                {
+                    ring.push_back({lons[idx], lats[idx]});
+                }
+
+                region_.addPolygon({ring});
+            }
+        }
+
+        if (conf.has(ConfKeys::Wkt))
+        {
+            region_.addWkt(conf.getString(ConfKeys::Wkt));
+        }
+
+        if (conf.has(ConfKeys::File))
+        {
+            region_.addFile(conf.getString(ConfKeys::File));
+        }
+
+        if (region_.empty())
+        {
+            std::ostringstream errStr;
+            errStr << "RegionFilter must contain polygons, wkt or a file with at least one ";
+            errStr << "polygon.";
+            throw eckit::BadParameter(errStr.str());
+        }
+
+        const int gridSize = conf.getInt(ConfKeys::GridSize, DefaultGridSize);
+        if (gridSize < 1)
+        {
+            std::ostringstream errStr;
+            errStr << "RegionFilter gridSize must be positive.";
+            throw eckit::BadParameter(errStr.str());
+        }
+
+        region_.buildGrid(static_cast<size_t>(gridSize));
+    }
+
+    void RegionFilter::apply(BufrDataMap& dataMap)
+    {
+        for (const auto& name : {latitude_, longitude_})
+        {
+            if (dataMap.find(name) == dataMap.end())
+            {
+                std::ostringstream errStr;
+                errStr << "Unknown variable " << name << " found in region filter.";
+                throw eckit::BadParameter(errStr.str());
+            }
+        }
+
+        const auto& lat = dataMap.at(latitude_);
+        const auto& lon = dataMap.at(longitude_);
+        if (lat->getDims().empty() || lat->getDims() != lon->getDims())
+        {
+            std::ostringstream errStr;
+            errStr << "RegionFilter variables " << latitude_ << " and " << longitude_;
+            errStr << " must have the same dimensions.";
+            throw eckit::BadParameter(errStr.str());
+        }
+
+        // Missing (or NaN) coordinates are neither inside nor outside the region, so their rows
+        // are only kept with keepMissing (in both the include and the exclude mode).
+        std::vector<double> lons(lat->size());
+        std::vector<double> lats(lat->size());
+        std::vector<uint8_t> isMissing(lat->size(), 0);
+        for (size_t idx = 0; idx < lats.size(); ++idx)
+        {
+            if (!lat->isMissing(idx) && !lon->isMissing(idx))
+            {
+                lons[idx] = wrapLongitude(lon->getAsFloat(idx));
+                lats[idx] = lat->getAsFloat(idx);
+            }
+
+            if (lat->isMissing(idx) || lon->isMissing(idx) ||
+                std::isnan(lats[idx]) || std::isnan(lons[idx]))
+            {
+                lons[idx] = std::numeric_limits<double>::quiet_NaN();
+                lats[idx] = std::numeric_limits<double>::quiet_NaN();
+                isMissing[idx] = 1;
+            }
+        }
+
+        std::vector<uint8_t> inside;
+        region_.contains(lons, lats, inside);
+
+        // A row is in the region when all its elements are.
+        const size_t numRows = lat->getDims()[0];
+        const size_t rowLength = numRows > 0 ? lats.size() / numRows : 0;
+        std::vector<size_t> validRows;
+        validRows.reserve(numRows);
+        for (size_t rowIdx = 0; rowIdx < numRows; ++rowIdx)
+        {
+            const auto rowBegin = rowIdx * rowLength;
+            const auto rowEnd = rowBegin + rowLength;
+            const bool rowMissing = std::any_of(isMissing.begin() + rowBegin,
+                                                isMissing.begin() + rowEnd,
+                                                [](uint8_t val) { return val != 0; });
+
+            bool keepRow = keepMissing_;
+            if (!rowMissing)
+            {
+                const bool rowInside = std::all_of(inside.begin() + rowBegin,
+                                                   inside.begin() + rowEnd,
+                                                   [](uint8_t val) { return val != 0; });
+                keepRow = rowInside != exclude_;
+            }
+
+            if (keepRow)
+            {
+                validRows.push_back(rowIdx);
+            }
+        }
+
+        if (validRows.size() != numRows)
+        {
+            for (const auto& dataPair : dataMap)
+            {
+                dataMap[dataPair.first] = dataPair.second->slice(validRows);
+            }
+        }
+    }
+
+    double RegionFilter::wrapLongitude(double lon) const
+    {
+        if (lon >= region_.minX() && lon < region_.minX() + 360.0) return lon;
+
+        double wrapped = std::fmod(lon - region_.minX(), 360.0);
+        if (wrapped < 0) wrapped += 360.0;
+        return region_.minX() + wrapped;
+    }
+}  // namespace Ingester
@@ -0,0 +1,49 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include "Filter.h"
+#include "Region.h"
+
+#include <string>
+
+
+namespace Ingester
+{
+    /// \brief Keeps the locations whose longitude and latitude are inside (or with exclude,
+    ///        outside) a region made of polygons. The polygons can be given inline as lists of
+    ///        vertices, as WKT, or loaded from GeoJSON or WKT files, and are combined by union.
+    ///        Polygon vertices are (longitude, latitude) pairs in degrees and their edges are
+    ///        straight lines in longitude/latitude space. Longitudes are compared modulo 360, so
+    ///        regions can extend past the dateline (ex: from 170 to 230). Locations with missing
+    ///        coordinates are dropped unless keepMissing is set.
+    class RegionFilter : public Filter
+    {
+     public:
+        /// \brief Constructor
+        /// \param conf The configuration for this filter
+        explicit RegionFilter(const eckit::LocalConfiguration& conf);
+
+        virtual ~RegionFilter() = default;
+
+        /// \brief Apply the filter to the data
+        /// \param dataMap Map to modify by filtering out relevant data.
+        void apply(BufrDataMap& dataMap) final;
+
+     private:
+        const std::string latitude_;
+        const std::string longitude_;
+        const bool exclude_;
+        const bool keepMissing_;
+        Region region_;
+
+        /// \brief Shift the longitude by a multiple of 360 so it is in [minLon, minLon + 360) of
+        ///        the region.
+        double wrapLongitude(double lon) const;
+    };
+}  // namespace Ingester
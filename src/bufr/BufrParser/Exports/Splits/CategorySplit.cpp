@@ -7,6 +7,8 @@
 
 #include "CategorySplit.h"
 
+#include <cstdint>
+#include <memory>
 #include <ostream>
 
 #include "eckit/exception/Exceptions.h"
@@ -18,6 +20,14 @@ namespace
         const char* NameMap = "map";
         const char* Variable = "variable";
     }  // namespace ConfKeys
+
+    /// \brief Is the data made of integers that fit in an int (int8, int16 or int32)?
+    bool hasIntValues(const std::shared_ptr<Ingester::DataObjectBase>& dataObject)
+    {
+        return std::dynamic_pointer_cast<Ingester::DataObject<int8_t>>(dataObject) != nullptr ||
+               std::dynamic_pointer_cast<Ingester::DataObject<int16_t>>(dataObject) != nullptr ||
+               std::dynamic_pointer_cast<Ingester::DataObject<int32_t>>(dataObject) != nullptr;
+    }
 }  // namespace
 
 namespace Ingester
@@ -92,23 +102,21 @@ namespace Ingester
         if (nameMap_.empty())
         {
             const auto& dataObject = dataMap.at(variable_);
+            if (!hasIntValues(dataObject))
+            {
+                std::stringstream errStr;
+                errStr << "Can't turn " << variable_ << " into a category as it contains ";
+                errStr << "non-integer values.";
+                throw eckit::BadParameter(errStr.str());
+            }
+
             for (auto rowIdx = 0; rowIdx < dataObject->getDims()[0]; rowIdx++)
             {
                 auto location = Location(dataObject->getDims().size(), 0);
                 location[0] = rowIdx;
 
-                if (auto dat = std::dynamic_pointer_cast<DataObject<int>> (dataObject))
-                {
-                    auto itemVal = dat->get(location);
-                    nameMap_.insert({itemVal, std::to_string(itemVal)});
-                }
-                else
-                {
-                    std::stringstream errStr;
-                    errStr << "Can't turn " << variable_ << " into a category as it contains ";
-                    errStr << "non-integer values.";
-                    throw eckit::BadParameter(errStr.str());
-                }
+                auto itemVal = dataObject->getAsInt(location);
+                nameMap_.insert({itemVal, std::to_string(itemVal)});
             }
         }
 
@@ -0,0 +1,325 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include "BackusGilbertRemapVariable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <ostream>
+#include <sstream>
+#include <vector>
+
+#include "eckit/exception/Exceptions.h"
+#include "ioda/Engines/HH.h"
+#include "oops/util/Logger.h"
+
+#include "DataObject.h"
+
+
+namespace
+{
+    namespace ConfKeys
+    {
+        const char* FieldOfViewNumber = "fieldOfViewNumber";
+        const char* SensorChannelNumber = "sensorChannelNumber";
+        const char* BrightnessTemperature = "brightnessTemperature";
+        const char* ScanLineNumber = "scanLineNumber";
+        const char* ObsTime = "obsTime";
+        const char* ScanInterval = "scanInterval";
+        const char* Coefficients = "coefficients";
+        const char* Channels = "channels";
+        const char* Threads = "threads";
+    }  // namespace ConfKeys
+
+    const char* TypeName = "backusGilbertRemap";
+
+    namespace CoefficientNames
+    {
+        const char* WindowSize = "windowSize";
+        const char* Alpha = "alpha";
+        const char* WindowIndex = "windowIndex";
+        const char* IndexSrc = "indexSrc";
+    }  // namespace CoefficientNames
+
+    const std::vector<std::string> FieldNames = {ConfKeys::FieldOfViewNumber,
+                                                 ConfKeys::SensorChannelNumber,
+                                                 ConfKeys::BrightnessTemperature,
+                                                 ConfKeys::ScanLineNumber};
+
+    const std::vector<std::string> RequiredFieldNames = {ConfKeys::FieldOfViewNumber,
+                                                         ConfKeys::SensorChannelNumber,
+                                                         ConfKeys::BrightnessTemperature};
+
+    const int64_t UnknownScan = std::numeric_limits<int64_t>::min();
+
+    /// \brief Load the remapping coefficients (ex: atms_BGremap_coeffs_ch1ch2.nc).
+    std::shared_ptr<Ingester::BackusGilbertRemap> loadCoefficients(const std::string& path)
+    {
+        auto file = ioda::Engines::HH::openFile(path, ioda::Engines::BackendOpenModes::Read_Only);
+
+        for (const auto& name : {CoefficientNames::WindowSize,
+                                 CoefficientNames::Alpha,
+                                 CoefficientNames::WindowIndex,
+                                 CoefficientNames::IndexSrc})
+        {
+            if (!file.vars.exists(name))
+            {
+                std::ostringstream errMsg;
+                errMsg << "Backus-Gilbert coefficients file " << path << " has no " << name;
+                errMsg << " variable.";
+                throw eckit::BadParameter(errMsg.str());
+            }
+        }
+
+        std::vector<int> windowSizes;
+        std::vector<double> weights;
+        std::vector<int> windowIndices;
+        std::vector<int> centerIndices;
+
+        file.vars.open(CoefficientNames::WindowSize).read<int>(windowSizes);
+        file.vars.open(CoefficientNames::WindowIndex).read<int>(windowIndices);
+        file.vars.open(CoefficientNames::IndexSrc).read<int>(centerIndices);
+
+        auto alphaVar = file.vars.open(CoefficientNames::Alpha);
+        alphaVar.read<double>(weights);
+        auto alphaDims = alphaVar.getDimensions().dimsCur;
+        if (alphaDims.size() != 2)
+        {
+            throw eckit::BadParameter("Backus-Gilbert coefficient alpha must be (fov, window).");
+        }
+
+        return std::make_shared<Ingester::BackusGilbertRemap>(windowSizes,
+                                                              weights,
+                                                              windowIndices,
+                                                              centerIndices,
+                                                              alphaDims[1]);
+    }
+}  // namespace
+
+
+namespace Ingester
+{
+    BackusGilbertRemapVariable::BackusGilbertRemapVariable(const std::string& exportName,
+                                                           const std::string& groupByField,
+                                                           const eckit::LocalConfiguration &conf) :
+      Variable(exportName, groupByField, conf)
+    {
+        if (!conf_.has(ConfKeys::Coefficients) || !conf_.has(ConfKeys::Channels))
+        {
+            throw eckit::BadParameter("backusGilbertRemap needs the coefficients file and the "
+                                      "list of channels to remap.");
+        }
+
+        remap_ = loadCoefficients(conf_.getString(ConfKeys::Coefficients));
+        channels_ = conf_.getIntVector(ConfKeys::Channels);
+
+        if (conf_.has(ConfKeys::ObsTime))
+        {
+            if (!conf_.has(ConfKeys::ScanInterval) || conf_.getDouble(ConfKeys::ScanInterval) <= 0)
+            {
+                throw eckit::BadParameter("backusGilbertRemap needs a positive scanInterval to "
+                                          "find the scans from the obsTime.");
+            }
+
+            scanInterval_ = conf_.getDouble(ConfKeys::ScanInterval);
+            obsTime_ = std::make_unique<DatetimeVariable>(exportName,
+                                                          groupByField,
+                                                          conf_.getSubConfiguration(
+                                                              ConfKeys::ObsTime));
+        }
+
+        initQueryMap();
+    }
+
+    std::shared_ptr<DataObjectBase> BackusGilbertRemapVariable::exportData(const BufrDataMap& map)
+    {
+        checkFieldKeys(map, FieldNames, TypeName);
+
+        auto& radObj = map.at(getExportKey(ConfKeys::BrightnessTemperature));
+        auto& sensorChanObj = map.at(getExportKey(ConfKeys::SensorChannelNumber));
+        auto& fovnObj = map.at(getExportKey(ConfKeys::FieldOfViewNumber));
+
+        if (radObj->getDims().size() != 2)
+        {
+            std::ostringstream errStr;
+            errStr << "The brightness temperature for " << getExportName();
+            errStr << " must have 2 dimensions (location, channel).";
+            throw eckit::BadParameter(errStr.str());
+        }
+
+        const auto numLocs = static_cast<size_t>(radObj->getDims()[0]);
+        const auto numChans = static_cast<size_t>(radObj->getDims()[1]);
+        const auto numFov = remap_->numFov();
+
+        std::vector<float> btobs(radObj->size());
+        for (size_t idx = 0; idx < radObj->size(); idx++)
+        {
+            btobs[idx] = radObj->isMissing(idx) ? DataObject<float>::missingValue() :
+                                                  radObj->getAsFloat(idx);
+        }
+
+        // Put the locations on the (scan x fov) grid. The locations are in scan order. A new
+        // scan starts when the scan number changes or the fov number doesn't increase. Missing
+        // scans are added for skipped scan numbers so the windows don't reach across the gap.
+        const auto scanNumbers = getScanNumbers(map, numLocs);
+        const auto maxScanGap = remap_->maxScanOffset();
+        const size_t Unmapped = std::numeric_limits<size_t>::max();
+        std::vector<size_t> gridIdxs(numLocs, Unmapped);
+        size_t numScans = 0;
+        int prevFov = std::numeric_limits<int>::max();
+        int64_t prevScanNumber = UnknownScan;
+        for (size_t locIdx = 0; locIdx < numLocs; ++locIdx)
+        {
+            if (fovnObj->isMissing(locIdx)) continue;
+
+            const int fov = fovnObj->getAsInt(locIdx);
+            const auto scanNumber = scanNumbers.empty() ? UnknownScan : scanNumbers[locIdx];
+
+            size_t scanStep = (fov <= prevFov) ? 1 : 0;
+            if (scanNumber != UnknownScan)
+            {
+                if (prevScanNumber != UnknownScan && scanNumber != prevScanNumber)
+                {
+                    const auto skipped = scanNumber - prevScanNumber - 1;
+                    scanStep = 1 + ((skipped >= 0) ?
+                        std::min(static_cast<size_t>(skipped), maxScanGap) : maxScanGap);
+                }
+
+                prevScanNumber = scanNumber;
+            }
+
+            if (numScans == 0) scanStep = 1;
+            numScans += scanStep;
+            prevFov = fov;
+
+            if (fov >= 1 && static_cast<size_t>(fov) <= numFov)
+            {
+                gridIdxs[locIdx] = (numScans - 1) * numFov + static_cast<size_t>(fov - 1);
+            }
+        }
+
+        size_t numThreads = 0;
+        if (conf_.has(ConfKeys::Threads))
+        {
+            numThreads = static_cast<size_t>(conf_.getInt(ConfKeys::Threads));
+        }
+
+        std::vector<float> image(numScans * numFov);
+        std::vector<float> remapped(numScans * numFov);
+        for (const auto channel : channels_)
+        {
+            size_t chanIdx = 0;
+            for (; chanIdx < numChans; ++chanIdx)
+            {
+                if (!sensorChanObj->isMissing(chanIdx) &&
+                    sensorChanObj->getAsInt(chanIdx) == channel) break;
+            }
+
+            if (chanIdx == numChans)
+            {
+                oops::Log::warning() << "BackusGilbertRemap: Channel " << channel
+                                     << " not found in the data." << std::endl;
+                continue;
+            }
+
+            std::fill(image.begin(), image.end(), DataObject<float>::missingValue());
+            for (size_t locIdx = 0; locIdx < numLocs; ++locIdx)
+            {
+                if (gridIdxs[locIdx] != Unmapped)
+                {
+                    image[gridIdxs[locIdx]] = btobs[locIdx * numChans + chanIdx];
+                }
+            }
+
+            remap_->apply(image.data(),
+                          numScans,
+                          DataObject<float>::missingValue(),
+                          remapped.data(),
+                          numThreads);
+
+            for (size_t locIdx = 0; locIdx < numLocs; ++locIdx)
+            {
+                btobs[locIdx * numChans + chanIdx] = gridIdxs[locIdx] != Unmapped ? \
+                    remapped[gridIdxs[locIdx]] : DataObject<float>::missingValue();
+            }
+        }
+
+        return std::make_shared<DataObject<float>>(btobs,
+                                                   getExportName(),
+                                                   groupByField_,
+                                                   radObj->getDims(),
+                                                   radObj->getPath(),
+                                                   radObj->getDimPaths());
+    }
+
+    std::vector<int64_t> BackusGilbertRemapVariable::getScanNumbers(const BufrDataMap& map,
+                                                                    size_t numLocs)
+    {
+        std::vector<int64_t> scanNumbers;
+        if (conf_.has(ConfKeys::ScanLineNumber))
+        {
+            const auto& scanLineObj = map.at(getExportKey(ConfKeys::ScanLineNumber));
+            if (scanLineObj->size() != numLocs)
+            {
+                throw eckit::BadParameter("The scanLineNumber of " + getExportName() +
+                                          " must have one value per location.");
+            }
+
+            scanNumbers.resize(numLocs, UnknownScan);
+            for (size_t locIdx = 0; locIdx < numLocs; ++locIdx)
+            {
+                if (!scanLineObj->isMissing(locIdx))
+                {
+                    scanNumbers[locIdx] = scanLineObj->getAsInt(locIdx);
+                }
+            }
+        }
+        else if (obsTime_)
+        {
+            auto timeObj = std::dynamic_pointer_cast<DataObject<int64_t>>(
+                obsTime_->exportData(map));
+            if (timeObj == nullptr || timeObj->size() != numLocs)
+            {
+                throw eckit::BadParameter("The obsTime of " + getExportName() +
+                                          " must have one value per location.");
+            }
+
+            // The scan number is the number of scan intervals since the first scan
+            const auto& times = timeObj->rawData();
+            int64_t minTime = std::numeric_limits<int64_t>::max();
+            for (size_t locIdx = 0; locIdx < numLocs; ++locIdx)
+            {
+                if (!timeObj->isMissing(locIdx)) minTime = std::min(minTime, times[locIdx]);
+            }
+
+            scanNumbers.resize(numLocs, UnknownScan);
+            for (size_t locIdx = 0; locIdx < numLocs; ++locIdx)
+            {
+                if (!timeObj->isMissing(locIdx))
+                {
+                    scanNumbers[locIdx] = std::llround(
+                        static_cast<double>(times[locIdx] - minTime) / scanInterval_);
+                }
+            }
+        }
+
+        return scanNumbers;
+    }
+
+    QueryList BackusGilbertRemapVariable::makeQueryList() const
+    {
+        auto queries = makeFieldQueryList(FieldNames, RequiredFieldNames, TypeName);
+        if (obsTime_)
+        {
+            auto timeQueries = obsTime_->makeQueryList();
+            queries.insert(queries.end(), timeQueries.begin(), timeQueries.end());
+        }
+
+        return queries;
+    }
+}  // namespace Ingester
@@ -0,0 +1,62 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "eckit/config/LocalConfiguration.h"
+
+#include "DatetimeVariable.h"
+#include "Transforms/atms/BackusGilbertRemap.h"
+#include "Variable.h"
+
+
+namespace Ingester
+{
+    /// \brief Exports brightness temperatures with the configured channels remapped with the
+    ///        Backus-Gilbert coefficients in the given coefficients file.
+    class BackusGilbertRemapVariable final : public Variable
+    {
+     public:
+        BackusGilbertRemapVariable() = delete;
+        BackusGilbertRemapVariable(const std::string& exportName,
+                                   const std::string& groupByField,
+                                   const eckit::LocalConfiguration& conf);
+
+        ~BackusGilbertRemapVariable() final = default;
+
+        /// \brief Get the configured queries and turn them into remapped brightness temperatures
+        /// \param map BufrDataMap that contains the parsed data for each query
+        std::shared_ptr<DataObjectBase> exportData(const BufrDataMap& map) final;
+
+        /// \brief Get a list of queries for this variable
+        QueryList makeQueryList() const final;
+
+     private:
+        /// \brief The remapping engine (coefficients are loaded once in the constructor)
+        std::shared_ptr<BackusGilbertRemap> remap_;
+
+        /// \brief The channels to remap
+        std::vector<int> channels_;
+
+        /// \brief The observation time (optional, used to find the scans)
+        std::unique_ptr<DatetimeVariable> obsTime_;
+
+        /// \brief The time between two scans in seconds (used with the observation time)
+        double scanInterval_ = 0.0;
+
+        /// \brief Get the scan number of each location, from the scan line number or from the
+        ///        observation time. Empty if neither is configured.
+        /// \param map BufrDataMap that contains the parsed data for each query
+        /// \param numLocs The number of locations
+        std::vector<int64_t> getScanNumbers(const BufrDataMap& map, size_t numLocs);
+    };
+}  // namespace Ingester
@@ -0,0 +1,126 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include "GnssroCombinedFrequencyVariable.h"
+
+#include <ostream>
+#include <vector>
+
+#include "eckit/exception/Exceptions.h"
+
+#include "DataObject.h"
+
+
+namespace
+{
+    namespace ConfKeys
+    {
+        const char* Value = "value";
+        const char* MeanFrequency = "meanFrequency";
+    }  // namespace ConfKeys
+
+    const char* TypeName = "gnssroCombinedFrequency";
+
+    const std::vector<std::string> FieldNames = {ConfKeys::Value,
+                                                 ConfKeys::MeanFrequency};
+}  // namespace
+
+
+namespace Ingester
+{
+    GnssroCombinedFrequencyVariable::GnssroCombinedFrequencyVariable(
+                                                    const std::string& exportName,
+                                                    const std::string& groupByField,
+                                                    const eckit::LocalConfiguration &conf) :
+      Variable(exportName, groupByField, conf)
+    {
+        initQueryMap();
+    }
+
+    std::shared_ptr<DataObjectBase>
+        GnssroCombinedFrequencyVariable::exportData(const BufrDataMap& map)
+    {
+        checkFieldKeys(map, FieldNames, TypeName);
+
+        auto values = map.at(getExportKey(ConfKeys::Value));
+
+        std::shared_ptr<DataObjectBase> meanFrequency = nullptr;
+        if (conf_.has(ConfKeys::MeanFrequency))
+        {
+            meanFrequency = map.at(getExportKey(ConfKeys::MeanFrequency));
+        }
+
+        return std::make_shared<DataObject<float>>(selectCombined(values, meanFrequency),
+                                                   getExportName(),
+                                                   groupByField_,
+                                                   Dimensions{values->getDims()[0]},
+                                                   values->getPath(),
+                                                   std::vector<bufr::Query>{
+                                                       values->getDimPaths()[0]});
+    }
+
+    std::vector<float> GnssroCombinedFrequencyVariable::selectCombined(
+        const std::shared_ptr<DataObjectBase>& values,
+        const std::shared_ptr<DataObjectBase>& meanFrequency)
+    {
+        if (meanFrequency && meanFrequency->getDims() != values->getDims())
+        {
+            std::ostringstream errStr;
+            errStr << "GNSS-RO mean frequency data for " << values->getFieldName();
+            errStr << " must have the same dimensions as the values.";
+            throw eckit::BadParameter(errStr.str());
+        }
+
+        const auto numRows = static_cast<size_t>(values->getDims()[0]);
+        const auto numFreqs = numRows > 0 ? values->size() / numRows : 0;
+
+        std::vector<float> combined(numRows, DataObject<float>::missingValue());
+        for (size_t rowIdx = 0; rowIdx < numRows; ++rowIdx)
+        {
+            const size_t rowStart = rowIdx * numFreqs;
+
+            // Prefer the value whose mean frequency is 0 (the combined frequency)
+            bool found = false;
+            if (meanFrequency)
+            {
+                for (size_t freqIdx = 0; freqIdx < numFreqs; ++freqIdx)
+                {
+                    const auto idx = rowStart + freqIdx;
+                    if (!meanFrequency->isMissing(idx) &&
+                        meanFrequency->getAsFloat(idx) == 0.0f &&
+                        !values->isMissing(idx))
+                    {
+                        combined[rowIdx] = values->getAsFloat(idx);
+                        found = true;
+                        break;
+                    }
+                }
+            }
+
+            // Otherwise the combined value is the last one that was reported
+            if (!found)
+            {
+                for (size_t freqIdx = numFreqs; freqIdx > 0; --freqIdx)
+                {
+                    const auto idx = rowStart + freqIdx - 1;
+                    if (!values->isMissing(idx))
+                    {
+                        combined[rowIdx] = values->getAsFloat(idx);
+                        break;
+                    }
+                }
+            }
+        }
+
+        return combined;
+    }
+
+    QueryList GnssroCombinedFrequencyVariable::makeQueryList() const
+    {
+        return makeFieldQueryList(FieldNames, {ConfKeys::Value}, TypeName);
+    }
+}  // namespace Ingester
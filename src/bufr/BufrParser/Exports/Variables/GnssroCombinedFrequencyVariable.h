@@ -0,0 +1,53 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "eckit/config/LocalConfiguration.h"
+
+#include "Variable.h"
+
+
+namespace Ingester
+{
+    /// \brief Exports the combined (ionosphere corrected) frequency values of GNSS-RO bending
+    ///        angle sequences. The BUFR data can hold L1, L2 and combined values for each level
+    ///        (or only the combined values), this picks the combined one for every level.
+    class GnssroCombinedFrequencyVariable final : public Variable
+    {
+     public:
+        GnssroCombinedFrequencyVariable() = delete;
+        GnssroCombinedFrequencyVariable(const std::string& exportName,
+                                        const std::string& groupByField,
+                                        const eckit::LocalConfiguration& conf);
+
+        ~GnssroCombinedFrequencyVariable() final = default;
+
+        /// \brief Get the configured queries and select the combined frequency values.
+        /// \param map BufrDataMap that contains the parsed data for each query
+        std::shared_ptr<DataObjectBase> exportData(const BufrDataMap& map) final;
+
+        /// \brief Get a list of queries for this variable
+        QueryList makeQueryList() const final;
+
+        /// \brief Only reads the parsed fields (safe to export concurrently).
+        bool isThreadSafe() const final { return true; }
+
+        /// \brief Select the combined frequency value of each row.
+        /// \details The combined value is the one whose mean frequency is 0. If there is no mean
+        ///          frequency data the last non missing value of the row is used instead.
+        /// \param values Data with the dimensions (rows, frequencies) or (rows).
+        /// \param meanFrequency Mean frequency data with the same dimensions (can be null).
+        static std::vector<float> selectCombined(
+            const std::shared_ptr<DataObjectBase>& values,
+            const std::shared_ptr<DataObjectBase>& meanFrequency);
+    };
+}  // namespace Ingester
@@ -0,0 +1,109 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include "GnssroImpactHeightVariable.h"
+
+#include <ostream>
+#include <vector>
+
+#include "eckit/exception/Exceptions.h"
+
+#include "DataObject.h"
+#include "GnssroCombinedFrequencyVariable.h"
+
+
+namespace
+{
+    namespace ConfKeys
+    {
+        const char* ImpactParameter = "impactParameter";
+        const char* MeanFrequency = "meanFrequency";
+        const char* GeoidUndulation = "geoidUndulation";
+        const char* EarthRadiusCurvature = "earthRadiusCurvature";
+    }  // namespace ConfKeys
+
+    const char* TypeName = "gnssroImpactHeight";
+
+    const std::vector<std::string> FieldNames = {ConfKeys::ImpactParameter,
+                                                 ConfKeys::MeanFrequency,
+                                                 ConfKeys::GeoidUndulation,
+                                                 ConfKeys::EarthRadiusCurvature};
+
+    const std::vector<std::string> RequiredFieldNames = {ConfKeys::ImpactParameter,
+                                                         ConfKeys::GeoidUndulation,
+                                                         ConfKeys::EarthRadiusCurvature};
+}  // namespace
+
+
+namespace Ingester
+{
+    GnssroImpactHeightVariable::GnssroImpactHeightVariable(const std::string& exportName,
+                                                           const std::string& groupByField,
+                                                           const eckit::LocalConfiguration &conf) :
+      Variable(exportName, groupByField, conf)
+    {
+        initQueryMap();
+    }
+
+    std::shared_ptr<DataObjectBase> GnssroImpactHeightVariable::exportData(const BufrDataMap& map)
+    {
+        checkFieldKeys(map, FieldNames, TypeName);
+
+        auto impactParam = map.at(getExportKey(ConfKeys::ImpactParameter));
+        auto geoidUndulation = map.at(getExportKey(ConfKeys::GeoidUndulation));
+        auto radiusCurvature = map.at(getExportKey(ConfKeys::EarthRadiusCurvature));
+
+        std::shared_ptr<DataObjectBase> meanFrequency = nullptr;
+        if (conf_.has(ConfKeys::MeanFrequency))
+        {
+            meanFrequency = map.at(getExportKey(ConfKeys::MeanFrequency));
+        }
+
+        // Validation: the profile data must line up with the levels
+        const auto numRows = impactParam->getDims()[0];
+        if (geoidUndulation->getDims()[0] != numRows || radiusCurvature->getDims()[0] != numRows)
+        {
+            std::ostringstream errStr;
+            errStr << "Inconsistent dimensions found in source data for " << getExportName();
+            errStr << ". Make sure the data is grouped by a level field.";
+            throw eckit::BadParameter(errStr.str());
+        }
+
+        auto impactHeights = GnssroCombinedFrequencyVariable::selectCombined(impactParam,
+                                                                             meanFrequency);
+
+        const size_t geoidStride = numRows > 0 ? geoidUndulation->size() / numRows : 0;
+        const size_t radiusStride = numRows > 0 ? radiusCurvature->size() / numRows : 0;
+        for (size_t rowIdx = 0; rowIdx < impactHeights.size(); ++rowIdx)
+        {
+            if (impactHeights[rowIdx] == DataObject<float>::missingValue() ||
+                geoidUndulation->isMissing(rowIdx * geoidStride) ||
+                radiusCurvature->isMissing(rowIdx * radiusStride))
+            {
+                impactHeights[rowIdx] = DataObject<float>::missingValue();
+                continue;
+            }
+
+            impactHeights[rowIdx] = impactHeights[rowIdx]
+                                    - geoidUndulation->getAsFloat(rowIdx * geoidStride)
+                                    - radiusCurvature->getAsFloat(rowIdx * radiusStride);
+        }
+
+        return std::make_shared<DataObject<float>>(impactHeights,
+                                                   getExportName(),
+                                                   groupByField_,
+                                                   Dimensions{numRows},
+                                                   impactParam->getPath(),
+                                                   std::vector<bufr::Query>{
+                                                       impactParam->getDimPaths()[0]});
+    }
+
+    QueryList GnssroImpactHeightVariable::makeQueryList() const
+    {
+        return makeFieldQueryList(FieldNames, RequiredFieldNames, TypeName);
+    }
+}  // namespace Ingester
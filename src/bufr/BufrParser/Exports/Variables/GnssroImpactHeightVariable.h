@@ -0,0 +1,43 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "eckit/config/LocalConfiguration.h"
+
+#include "Variable.h"
+
+
+namespace Ingester
+{
+    /// \brief Exports the GNSS-RO impact height (impact parameter - geoid undulation - local
+    ///        radius of curvature) of every level.
+    class GnssroImpactHeightVariable final : public Variable
+    {
+     public:
+        GnssroImpactHeightVariable() = delete;
+        GnssroImpactHeightVariable(const std::string& exportName,
+                                   const std::string& groupByField,
+                                   const eckit::LocalConfiguration& conf);
+
+        ~GnssroImpactHeightVariable() final = default;
+
+        /// \brief Get the configured queries and turn them into impact heights.
+        /// \param map BufrDataMap that contains the parsed data for each query
+        std::shared_ptr<DataObjectBase> exportData(const BufrDataMap& map) final;
+
+        /// \brief Get a list of queries for this variable
+        QueryList makeQueryList() const final;
+
+        /// \brief Only reads the parsed fields (safe to export concurrently).
+        bool isThreadSafe() const final { return true; }
+    };
+}  // namespace Ingester
@@ -0,0 +1,217 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include "GnssroQualityFlagsVariable.h"
+
+#include <cmath>
+#include <map>
+#include <ostream>
+#include <vector>
+
+#include "eckit/exception/Exceptions.h"
+
+#include "DataObject.h"
+
+
+namespace
+{
+    namespace ConfKeys
+    {
+        const char* QualityFlags = "qualityFlags";
+        const char* GeoidUndulation = "geoidUndulation";
+        const char* EarthRadiusCurvature = "earthRadiusCurvature";
+        const char* Height = "height";
+        const char* Latitude = "latitude";
+        const char* Longitude = "longitude";
+        const char* Flag = "flag";
+    }  // namespace ConfKeys
+
+    const char* TypeName = "gnssroQualityFlags";
+
+    namespace Flags
+    {
+        const char* NonNominal = "nonNominal";
+        const char* RisingOccultation = "risingOccultation";
+        const char* ExcessPhaseNonNominal = "excessPhaseNonNominal";
+        const char* BendingAngleNonNominal = "bendingAngleNonNominal";
+        const char* PreQc = "preQc";
+    }  // namespace Flags
+
+    const std::vector<std::string> FieldNames = {ConfKeys::QualityFlags,
+                                                 ConfKeys::GeoidUndulation,
+                                                 ConfKeys::EarthRadiusCurvature,
+                                                 ConfKeys::Height,
+                                                 ConfKeys::Latitude,
+                                                 ConfKeys::Longitude};
+
+    const std::vector<std::string> LevelFieldNames = {ConfKeys::Height,
+                                                      ConfKeys::Latitude,
+                                                      ConfKeys::Longitude};
+
+    /// \brief The WMO bit numbers (bit 1 is the most significant bit of the 16 bit QFRO value).
+    const std::map<std::string, int> FlagBits = {{Flags::NonNominal, 1},
+                                                 {Flags::RisingOccultation, 3},
+                                                 {Flags::ExcessPhaseNonNominal, 4},
+                                                 {Flags::BendingAngleNonNominal, 5}};
+
+    const int QualityFlagsWidth = 16;
+
+    // Limits for the profile reality checks
+    const float MinEarthRadiusCurvature = 6250000.0f;
+    const float MaxEarthRadiusCurvature = 6450000.0f;
+    const float MaxGeoidUndulation = 200.0f;
+
+    // Limits for the level reality checks
+    const float MaxHeight = 100000.0f;
+    const float MaxAbsLatitude = 90.0f;
+    const float MaxAbsLongitude = 360.0f;
+
+    int wmoBit(int value, int bitNumber)
+    {
+        return (value >> (QualityFlagsWidth - bitNumber)) & 1;
+    }
+}  // namespace
+
+
+namespace Ingester
+{
+    GnssroQualityFlagsVariable::GnssroQualityFlagsVariable(const std::string& exportName,
+                                                           const std::string& groupByField,
+                                                           const eckit::LocalConfiguration &conf) :
+      Variable(exportName, groupByField, conf)
+    {
+        initQueryMap();
+
+        const auto flag = conf_.getString(ConfKeys::Flag);
+        if (flag != Flags::PreQc && FlagBits.find(flag) == FlagBits.end())
+        {
+            std::ostringstream errStr;
+            errStr << "gnssroQualityFlags: Unknown flag " << flag << ".";
+            throw eckit::BadParameter(errStr.str());
+        }
+    }
+
+    std::shared_ptr<DataObjectBase> GnssroQualityFlagsVariable::exportData(const BufrDataMap& map)
+    {
+        checkFieldKeys(map, FieldNames, TypeName);
+
+        auto qualityFlags = map.at(getExportKey(ConfKeys::QualityFlags));
+        const auto numRows = qualityFlags->getDims()[0];
+        const size_t stride = numRows > 0 ? qualityFlags->size() / numRows : 0;
+
+        // The optional queries of the reality checks (nullptr if not configured)
+        auto optionalField = [this, &map](const char* fieldName)
+        {
+            return conf_.has(fieldName) ? map.at(getExportKey(fieldName)) : nullptr;
+        };
+
+        const auto geoidUndulation = optionalField(ConfKeys::GeoidUndulation);
+        const auto radiusCurvature = optionalField(ConfKeys::EarthRadiusCurvature);
+        const auto height = optionalField(ConfKeys::Height);
+        const auto latitude = optionalField(ConfKeys::Latitude);
+        const auto longitude = optionalField(ConfKeys::Longitude);
+
+        for (const auto& obj : {geoidUndulation, radiusCurvature})
+        {
+            if (obj && obj->getDims()[0] != numRows)
+            {
+                std::ostringstream errStr;
+                errStr << "Inconsistent dimensions found in source data for " << getExportName();
+                errStr << ".";
+                throw eckit::BadParameter(errStr.str());
+            }
+        }
+
+        for (const auto& obj : {height, latitude, longitude})
+        {
+            if (obj && obj->size() != static_cast<size_t>(numRows))
+            {
+                std::ostringstream errStr;
+                errStr << "The level fields of " << getExportName() << " (height, latitude and ";
+                errStr << "longitude) must have one value per location.";
+                throw eckit::BadParameter(errStr.str());
+            }
+        }
+
+        // A check fails when the value is missing or is out of [minValue, maxValue]
+        auto fails = [numRows](const std::shared_ptr<DataObjectBase>& obj,
+                               size_t rowIdx,
+                               float minValue,
+                               float maxValue)
+        {
+            if (!obj) return false;
+
+            const size_t idx = rowIdx * (obj->size() / numRows);
+            return obj->isMissing(idx) ||
+                   obj->getAsFloat(idx) < minValue ||
+                   obj->getAsFloat(idx) > maxValue;
+        };
+
+        const auto flag = conf_.getString(ConfKeys::Flag);
+        std::vector<int> flags(numRows, DataObject<int>::missingValue());
+        for (size_t rowIdx = 0; rowIdx < static_cast<size_t>(numRows); ++rowIdx)
+        {
+            if (qualityFlags->isMissing(rowIdx * stride)) continue;
+
+            const int value = qualityFlags->getAsInt(rowIdx * stride);
+            if (flag != Flags::PreQc)
+            {
+                flags[rowIdx] = wmoBit(value, FlagBits.at(flag));
+                continue;
+            }
+
+            // Usable profiles are nominal and pass the geometry reality checks
+            bool isBad = wmoBit(value, FlagBits.at(Flags::NonNominal)) ||
+                         wmoBit(value, FlagBits.at(Flags::ExcessPhaseNonNominal)) ||
+                         wmoBit(value, FlagBits.at(Flags::BendingAngleNonNominal));
+
+            isBad = isBad ||
+                    fails(radiusCurvature, rowIdx, MinEarthRadiusCurvature,
+                          MaxEarthRadiusCurvature) ||
+                    fails(geoidUndulation, rowIdx, -MaxGeoidUndulation, MaxGeoidUndulation);
+
+            // Usable levels have a height in (0, 100000) m and a valid location
+            if (height && !isBad)
+            {
+                isBad = height->isMissing(rowIdx) ||
+                        height->getAsFloat(rowIdx) <= 0.0f ||
+                        height->getAsFloat(rowIdx) >= MaxHeight;
+            }
+
+            isBad = isBad ||
+                    fails(latitude, rowIdx, -MaxAbsLatitude, MaxAbsLatitude) ||
+                    fails(longitude, rowIdx, -MaxAbsLongitude, MaxAbsLongitude);
+
+            flags[rowIdx] = isBad ? 1 : 0;
+        }
+
+        return std::make_shared<DataObject<int>>(flags,
+                                                 getExportName(),
+                                                 groupByField_,
+                                                 Dimensions{numRows},
+                                                 qualityFlags->getPath(),
+                                                 std::vector<bufr::Query>{
+                                                     qualityFlags->getDimPaths()[0]});
+    }
+
+    QueryList GnssroQualityFlagsVariable::makeQueryList() const
+    {
+        auto queries = makeFieldQueryList(FieldNames, {ConfKeys::QualityFlags}, TypeName);
+
+        // The level fields can come from another sequence than the group by field (ex: the
+        // heights in */ROSEQ3), so they are read without group by (one value per location).
+        for (auto& info : queries)
+        {
+            for (const auto& fieldName : LevelFieldNames)
+            {
+                if (info.name == getExportKey(fieldName)) info.groupByField = "";
+            }
+        }
+
+        return queries;
+    }
+}  // namespace Ingester
@@ -38,5 +38,9 @@ namespace Ingester
 
         /// \brief Get a list of queries for this variable
         QueryList makeQueryList() const final;
+
+        /// \brief The transforms only touch the data of this variable, so it can be exported
+        ///        concurrently.
+        bool isThreadSafe() const final { return true; }
     };
 }  // namespace Ingester
@@ -36,6 +36,9 @@ namespace Ingester
         /// \brief Get a list of queries for this variable
         QueryList makeQueryList() const final;
 
+        /// \brief Only reads the parsed fields (safe to export concurrently).
+        bool isThreadSafe() const final { return true; }
+
      private:
         /// \brief makes sure the bufr data map has all the required keys.
         void checkKeys(const BufrDataMap& map);
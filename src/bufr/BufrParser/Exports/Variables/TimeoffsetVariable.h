@@ -35,6 +35,9 @@ namespace Ingester
         /// \brief Get a list of queries for this variable
         QueryList makeQueryList() const final;
 
+        /// \brief Uses timegm (no time zone state), so it can be exported concurrently.
+        bool isThreadSafe() const final { return true; }
+
      private:
         /// \brief makes sure the bufr data map has all the required keys.
         void checkKeys(const BufrDataMap& map);
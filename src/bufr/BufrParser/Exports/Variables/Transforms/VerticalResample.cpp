@@ -0,0 +1,265 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include "VerticalResample.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <utility>
+
+#include "eckit/exception/Exceptions.h"
+
+#include "BufrParser/Query/ParallelFor.h"
+
+
+namespace
+{
+    // Profiles handed to a thread at a time (small so profiles of very different lengths
+    // still balance across the threads).
+    const size_t ProfilesPerTask = 64;
+
+    namespace MethodNames
+    {
+        const char* LogLinear = "logLinear";
+        const char* Linear = "linear";
+        const char* Nearest = "nearest";
+        const char* LayerMean = "layerMean";
+    }  // namespace MethodNames
+}  // namespace
+
+
+namespace Ingester
+{
+    VerticalResample::VerticalResample(const std::vector<double>& targets, Method method) :
+      method_(method)
+    {
+        if (targets.empty())
+        {
+            throw eckit::BadParameter("VerticalResample needs at least one target level.");
+        }
+
+        targetIdxs_.resize(targets.size());
+        std::iota(targetIdxs_.begin(), targetIdxs_.end(), 0);
+        std::stable_sort(targetIdxs_.begin(), targetIdxs_.end(), [&targets](size_t a, size_t b)
+        {
+            return targets[a] < targets[b];
+        });
+
+        for (const auto targetIdx : targetIdxs_)
+        {
+            targets_.push_back(transform(targets[targetIdx]));
+            if (!std::isfinite(targets_.back()))
+            {
+                throw eckit::BadParameter("VerticalResample target levels must be finite (and "
+                                          "positive for log interpolation).");
+            }
+        }
+
+        if (method_ == Method::LayerMean)
+        {
+            layerBounds_.resize(targets_.size() + 1);
+            layerBounds_.front() = -std::numeric_limits<double>::infinity();
+            layerBounds_.back() = std::numeric_limits<double>::infinity();
+            for (size_t idx = 1; idx < targets_.size(); ++idx)
+            {
+                layerBounds_[idx] = 0.5 * (targets_[idx - 1] + targets_[idx]);
+            }
+
+            if (targets_.size() > 1)
+            {
+                layerBounds_.front() = targets_.front() - (layerBounds_[1] - targets_.front());
+                layerBounds_.back() = targets_.back() +
+                                      (targets_.back() - layerBounds_[targets_.size() - 1]);
+            }
+        }
+    }
+
+    VerticalResample::Method VerticalResample::methodFromName(const std::string& name)
+    {
+        if (name == MethodNames::LogLinear) return Method::LogLinear;
+        if (name == MethodNames::Linear) return Method::Linear;
+        if (name == MethodNames::Nearest) return Method::Nearest;
+        if (name == MethodNames::LayerMean) return Method::LayerMean;
+
+        std::ostringstream errStr;
+        errStr << "VerticalResample method " << name << " is unknown (use ";
+        errStr << MethodNames::LogLinear << ", " << MethodNames::Linear << ", ";
+        errStr << MethodNames::Nearest << " or " << MethodNames::LayerMean << ").";
+        throw eckit::BadParameter(errStr.str());
+    }
+
+    template<typename T>
+    void VerticalResample::apply(const T* coords,
+                                 const T* values,
+                                 size_t numProfiles,
+                                 size_t numLevels,
+                                 T missingValue,
+                                 T* output,
+                                 size_t numThreads) const
+    {
+        bufr::parallelFor(numProfiles,
+                          ProfilesPerTask,
+                          [&](size_t beginProfile, size_t endProfile)
+                          {
+                              applyProfiles(coords,
+                                            values,
+                                            beginProfile,
+                                            endProfile,
+                                            numLevels,
+                                            missingValue,
+                                            output);
+                          },
+                          numThreads);
+    }
+
+    double VerticalResample::transform(double coord) const
+    {
+        if (method_ == Method::LogLinear)
+        {
+            return coord > 0 ? std::log(coord) : std::numeric_limits<double>::quiet_NaN();
+        }
+
+        return coord;
+    }
+
+    template<typename T>
+    void VerticalResample::applyProfiles(const T* coords,
+                                         const T* values,
+                                         size_t beginProfile,
+                                         size_t endProfile,
+                                         size_t numLevels,
+                                         T missingValue,
+                                         T* output) const
+    {
+        const size_t numTargets = targets_.size();
+
+        // (transformed coordinate, value) of the valid levels of a profile
+        std::vector<std::pair<double, double>> levels;
+        levels.reserve(numLevels);
+        std::vector<double> sums(numTargets);
+        std::vector<size_t> counts(numTargets);
+
+        for (size_t profileIdx = beginProfile; profileIdx < endProfile; ++profileIdx)
+        {
+            const T* profileCoords = coords + profileIdx * numLevels;
+            const T* profileValues = values + profileIdx * numLevels;
+            T* profileOutput = output + profileIdx * numTargets;
+            std::fill(profileOutput, profileOutput + numTargets, missingValue);
+
+            levels.clear();
+            for (size_t levelIdx = 0; levelIdx < numLevels; ++levelIdx)
+            {
+                const T coord = profileCoords[levelIdx];
+                const T value = profileValues[levelIdx];
+                if (coord == missingValue || value == missingValue || !std::isfinite(value))
+                {
+                    continue;
+                }
+
+                const double transformed = transform(coord);
+                if (std::isfinite(transformed)) levels.emplace_back(transformed, value);
+            }
+
+            if (levels.empty()) continue;
+
+            std::stable_sort(levels.begin(), levels.end(),
+                             [](const std::pair<double, double>& a,
+                                const std::pair<double, double>& b)
+                             {
+                                 return a.first < b.first;
+                             });
+
+            // The targets are sorted too, so each method is a single sweep over both.
+            if (method_ == Method::LayerMean)
+            {
+                std::fill(sums.begin(), sums.end(), 0.0);
+                std::fill(counts.begin(), counts.end(), 0);
+
+                size_t layerIdx = 0;
+                for (const auto& level : levels)
+                {
+                    if (level.first < layerBounds_.front()) continue;
+                    while (layerIdx < numTargets && level.first >= layerBounds_[layerIdx + 1] &&
+                           !(layerIdx + 1 == numTargets && level.first == layerBounds_.back()))
+                    {
+                        layerIdx++;
+                    }
+
+                    if (layerIdx == numTargets) break;
+
+                    sums[layerIdx] += level.second;
+                    counts[layerIdx]++;
+                }
+
+                for (size_t idx = 0; idx < numTargets; ++idx)
+                {
+                    if (counts[idx] > 0)
+                    {
+                        profileOutput[targetIdxs_[idx]] =
+                            static_cast<T>(sums[idx] / static_cast<double>(counts[idx]));
+                    }
+                }
+
+                continue;
+            }
+
+            size_t levelIdx = 0;
+            for (size_t idx = 0; idx < numTargets; ++idx)
+            {
+                const double target = targets_[idx];
+                if (target < levels.front().first || target > levels.back().first) continue;
+
+                // Find the levels around the target: levels[levelIdx] <= target < levels[+1]
+                while (levelIdx + 1 < levels.size() && levels[levelIdx + 1].first <= target)
+                {
+                    levelIdx++;
+                }
+
+                const auto& below = levels[levelIdx];
+                if (below.first == target || levelIdx + 1 == levels.size())
+                {
+                    profileOutput[targetIdxs_[idx]] = static_cast<T>(below.second);
+                    continue;
+                }
+
+                const auto& above = levels[levelIdx + 1];
+                double value;
+                if (method_ == Method::Nearest)
+                {
+                    value = (target - below.first <= above.first - target) ? below.second
+                                                                             : above.second;
+                }
+                else
+                {
+                    const double weight = (target - below.first) / (above.first - below.first);
+                    value = below.second + weight * (above.second - below.second);
+                }
+
+                profileOutput[targetIdxs_[idx]] = static_cast<T>(value);
+            }
+        }
+    }
+
+    template void VerticalResample::apply<float>(const float* coords,
+                                                 const float* values,
+                                                 size_t numProfiles,
+                                                 size_t numLevels,
+                                                 float missingValue,
+                                                 float* output,
+                                                 size_t numThreads) const;
+
+    template void VerticalResample::apply<double>(const double* coords,
+                                                  const double* values,
+                                                  size_t numProfiles,
+                                                  size_t numLevels,
+                                                  double missingValue,
+                                                  double* output,
+                                                  size_t numThreads) const;
+}  // namespace Ingester
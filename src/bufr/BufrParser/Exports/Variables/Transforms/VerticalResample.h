@@ -0,0 +1,92 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+namespace Ingester
+{
+    /// \brief Resamples vertical profiles (ex: radiosonde levels) onto a fixed list of target
+    ///        levels of the vertical coordinate (ex: pressure or height). The levels of a profile
+    ///        don't have to be sorted and can contain missing values. Targets outside of the range
+    ///        of a profile are never extrapolated (they are set to missing).
+    class VerticalResample
+    {
+     public:
+        enum class Method
+        {
+            LogLinear,  ///< Linear interpolation in log(coordinate) (ex: log-p)
+            Linear,     ///< Linear interpolation in the coordinate
+            Nearest,    ///< Value of the closest level
+            LayerMean   ///< Mean of the levels in the layer around the target (the layer bounds
+                        ///< are half way to the neighbouring targets)
+        };
+
+        VerticalResample() = delete;
+
+        /// \brief Constructor
+        /// \param targets The levels to resample to (in the output order)
+        /// \param method The resampling method
+        VerticalResample(const std::vector<double>& targets, Method method);
+
+        /// \brief Get the method from its configuration name (logLinear, linear, nearest or
+        ///        layerMean).
+        static Method methodFromName(const std::string& name);
+
+        /// \brief Resample profiles (T is float or double).
+        /// \param coords The vertical coordinate [numProfiles x numLevels] (row major)
+        /// \param values The values to resample [numProfiles x numLevels] (row major)
+        /// \param numProfiles Number of profiles
+        /// \param numLevels Number of levels of each profile
+        /// \param missingValue The value that marks missing data (non finite values are missing
+        ///                     too)
+        /// \param output The resampled values [numProfiles x numTargets] (row major)
+        /// \param numThreads Max number of threads to use (0 means all the threads of the
+        ///                   task scheduler)
+        template<typename T>
+        void apply(const T* coords,
+                   const T* values,
+                   size_t numProfiles,
+                   size_t numLevels,
+                   T missingValue,
+                   T* output,
+                   size_t numThreads = 0) const;
+
+        /// \brief Number of target levels
+        size_t numTargets() const { return targets_.size(); }
+
+     private:
+        const Method method_;
+
+        /// \brief Target levels (in the transformed coordinate) sorted in increasing order
+        std::vector<double> targets_;
+
+        /// \brief Output index of each sorted target
+        std::vector<size_t> targetIdxs_;
+
+        /// \brief Layer bounds of the sorted targets (LayerMean only) [numTargets + 1]
+        std::vector<double> layerBounds_;
+
+        /// \brief Transform a coordinate for the method (log for LogLinear). Returns NaN when
+        ///        the coordinate can't be used.
+        double transform(double coord) const;
+
+        /// \brief Resample the profiles [beginProfile, endProfile).
+        template<typename T>
+        void applyProfiles(const T* coords,
+                           const T* values,
+                           size_t beginProfile,
+                           size_t endProfile,
+                           size_t numLevels,
+                           T missingValue,
+                           T* output) const;
+    };
+}  // namespace Ingester
@@ -0,0 +1,147 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include "BackusGilbertRemap.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+#include "eckit/exception/Exceptions.h"
+
+#include "BufrParser/Query/ParallelFor.h"
+
+
+namespace
+{
+    // Scans remapped by each task (don't bother splitting up small images)
+    const size_t ScansPerTask = 16;
+}  // namespace
+
+namespace Ingester
+{
+    BackusGilbertRemap::BackusGilbertRemap(const std::vector<int>& windowSizes,
+                                           const std::vector<double>& weights,
+                                           const std::vector<int>& windowIndices,
+                                           const std::vector<int>& centerIndices,
+                                           size_t maxWindowSize)
+    {
+        const size_t numFov = windowSizes.size();
+        if (centerIndices.size() != numFov ||
+            weights.size() != numFov * maxWindowSize ||
+            windowIndices.size() != numFov * maxWindowSize * 2)
+        {
+            throw eckit::BadParameter("BackusGilbertRemap: Inconsistent coefficient sizes.");
+        }
+
+        windowStart_.reserve(numFov + 1);
+        windowStart_.push_back(0);
+        for (size_t fovIdx = 0; fovIdx < numFov; ++fovIdx)
+        {
+            const auto windowSize = static_cast<size_t>(windowSizes[fovIdx]);
+            const auto centerIdx = static_cast<size_t>(centerIndices[fovIdx] - 1);
+            if (windowSize > maxWindowSize || centerIdx >= windowSize)
+            {
+                std::ostringstream errMsg;
+                errMsg << "BackusGilbertRemap: Bad window for field of view " << fovIdx + 1;
+                errMsg << " (size " << windowSize << ", center " << centerIdx + 1 << ").";
+                throw eckit::BadParameter(errMsg.str());
+            }
+
+            const auto* window = &windowIndices[fovIdx * maxWindowSize * 2];
+            const auto* alpha = &weights[fovIdx * maxWindowSize];
+
+            double alphaSum = 0.0;
+            for (size_t winIdx = 0; winIdx < windowSize; ++winIdx)
+            {
+                alphaSum += alpha[winIdx];
+            }
+
+            // Offsets are relative to the center element so the window can slide along the scans
+            for (size_t winIdx = 0; winIdx < windowSize; ++winIdx)
+            {
+                scanOffsets_.push_back(window[winIdx * 2] - window[centerIdx * 2]);
+                fovOffsets_.push_back(window[winIdx * 2 + 1] - window[centerIdx * 2 + 1]);
+                weights_.push_back(alpha[winIdx] / alphaSum);
+            }
+
+            windowStart_.push_back(weights_.size());
+        }
+    }
+
+    size_t BackusGilbertRemap::maxScanOffset() const
+    {
+        size_t maxOffset = 0;
+        for (const auto scanOffset : scanOffsets_)
+        {
+            maxOffset = std::max(maxOffset, static_cast<size_t>(std::abs(scanOffset)));
+        }
+
+        return maxOffset;
+    }
+
+    void BackusGilbertRemap::apply(const float* image,
+                                   size_t numScans,
+                                   float missingValue,
+                                   float* output,
+                                   size_t numThreads) const
+    {
+        // The scans are independent, so hand them out in blocks
+        bufr::parallelFor(numScans,
+                          ScansPerTask,
+                          [&](size_t beginScan, size_t endScan)
+                          {
+                              applyScans(image, numScans, beginScan, endScan, missingValue,
+                                         output);
+                          },
+                          numThreads);
+    }
+
+    void BackusGilbertRemap::applyScans(const float* image,
+                                        size_t numScans,
+                                        size_t beginScan,
+                                        size_t endScan,
+                                        float missingValue,
+                                        float* output) const
+    {
+        const auto numFovs = static_cast<int>(numFov());
+        const auto scanCount = static_cast<int>(numScans);
+
+        for (auto scanIdx = static_cast<int>(beginScan); scanIdx < static_cast<int>(endScan);
+             ++scanIdx)
+        {
+            for (int fovIdx = 0; fovIdx < numFovs; ++fovIdx)
+            {
+                double value = 0.0;
+                bool isValid = true;
+                for (size_t winIdx = windowStart_[fovIdx]; winIdx < windowStart_[fovIdx + 1];
+                     ++winIdx)
+                {
+                    const int srcScan = scanIdx + scanOffsets_[winIdx];
+                    const int srcFov = fovIdx + fovOffsets_[winIdx];
+                    if (srcScan < 0 || srcScan >= scanCount || srcFov < 0 || srcFov >= numFovs)
+                    {
+                        isValid = false;
+                        break;
+                    }
+
+                    const float srcValue = image[srcScan * numFovs + srcFov];
+                    if (srcValue == missingValue)
+                    {
+                        isValid = false;
+                        break;
+                    }
+
+                    value += weights_[winIdx] * srcValue;
+                }
+
+                output[scanIdx * numFovs + fovIdx] = isValid ? static_cast<float>(value) :
+                                                               missingValue;
+            }
+        }
+    }
+}  // namespace Ingester
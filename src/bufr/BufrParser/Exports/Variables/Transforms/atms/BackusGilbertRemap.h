@@ -0,0 +1,74 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+
+namespace Ingester
+{
+    /// \brief Backus-Gilbert remapping of a (scan x field of view) image (ex: ATMS channels 1
+    ///        and 2 to the beam width of channel 3). See Zhou et al., IEEE TGRS vol. 60, 2022.
+    ///        The window of every field of view is stored in CSR form: windowStart_[fov] to
+    ///        windowStart_[fov + 1] indexes its scan/fov offsets (relative to the fov itself)
+    ///        and its normalized weights.
+    class BackusGilbertRemap
+    {
+     public:
+        BackusGilbertRemap() = delete;
+
+        /// \brief Constructor (uses the layout of the atms_BGremap_coeffs file).
+        /// \param windowSizes Number of window elements of each field of view [numFov]
+        /// \param weights Window weights (alpha) [numFov x maxWindowSize]
+        /// \param windowIndices Scan and fov index of each window element
+        ///                      [numFov x maxWindowSize x 2]
+        /// \param centerIndices 1 based index of the window element that is the field of view
+        ///                      itself [numFov]
+        /// \param maxWindowSize The size of the window dimension of weights and windowIndices
+        BackusGilbertRemap(const std::vector<int>& windowSizes,
+                           const std::vector<double>& weights,
+                           const std::vector<int>& windowIndices,
+                           const std::vector<int>& centerIndices,
+                           size_t maxWindowSize);
+
+        /// \brief Remap an image. Output elements whose window reaches outside of the image
+        ///        or contains missing data are set to missing.
+        /// \param image Input image [numScans x numFov] (row major)
+        /// \param numScans Number of scans in the image
+        /// \param missingValue The value that marks missing data
+        /// \param output Remapped image [numScans x numFov] (row major)
+        /// \param numThreads Max number of threads to use (0 means all the threads of the
+        ///                   task scheduler)
+        void apply(const float* image,
+                   size_t numScans,
+                   float missingValue,
+                   float* output,
+                   size_t numThreads = 0) const;
+
+        /// \brief Number of fields of view (the width of the image)
+        size_t numFov() const { return windowStart_.size() - 1; }
+
+        /// \brief Largest number of scans a window reaches away from its field of view
+        size_t maxScanOffset() const;
+
+     private:
+        std::vector<size_t> windowStart_;
+        std::vector<int> scanOffsets_;
+        std::vector<int> fovOffsets_;
+        std::vector<double> weights_;
+
+        /// \brief Remap the scans [beginScan, endScan) of the image.
+        void applyScans(const float* image,
+                        size_t numScans,
+                        size_t beginScan,
+                        size_t endScan,
+                        float missingValue,
+                        float* output) const;
+    };
+}  // namespace Ingester
@@ -6,6 +6,7 @@ module atms_spatial_average_c_interface_mod
 
   private
   public:: ATMS_Spatial_Average_c
+  public:: Flush_Fortran_Output_c
 
 contains
 
@@ -39,4 +40,13 @@ contains
 
   end subroutine ATMS_Spatial_Average_c
 
+  ! Flush the buffered output of the Fortran units written by the ingester (the log units of
+  ! NCEPLIB-bufr and of the ATMS spatial average) without waiting for the program to end.
+  subroutine Flush_Fortran_Output_c() bind(C, name='Flush_Fortran_Output_f')
+
+    flush(6)
+    flush(0)
+
+  end subroutine Flush_Fortran_Output_c
+
 end module atms_spatial_average_c_interface_mod
@@ -23,6 +23,8 @@ extern "C" {
   void ATMS_Spatial_Average_f(int num_loc, int nchanl, void* time, void* fov, void* channel,
                               void* btobs, void* scanline, int* error_status);
 
+  void Flush_Fortran_Output_f();
+
 #ifdef __cplusplus
 }
 #endif
@@ -11,6 +11,8 @@
 #include <string>
 #include <memory>
 
+#include "eckit/exception/Exceptions.h"
+
 #include "IngesterTypes.h"
 #include "DataObject.h"
 
@@ -46,6 +48,11 @@ namespace Ingester
         /// \brief Variable data objects for previously parsed data from BufrDataMap.
         virtual std::shared_ptr<DataObjectBase> exportData(const BufrDataMap& dataMap) = 0;
 
+        /// \brief Can exportData run at the same time as the exportData of other variables?
+        ///        Variables that use Fortran (its units and globals), the environment (ex: TZ) or
+        ///        other process wide state must not, so this is false unless a variable says so.
+        virtual bool isThreadSafe() const { return false; }
+
         /// \brief Get Query List
         inline QueryList getQueryList() { return queryList_; }
 
@@ -65,6 +72,65 @@ namespace Ingester
         /// \brief Make a map of name and queries
         virtual QueryList makeQueryList() const = 0;
 
+        /// \brief Get the key of one of the queries of this variable in the BufrDataMap.
+        /// \param name The config key of the query.
+        inline std::string getExportKey(const std::string& name) const
+        {
+            return exportName_ + "_" + name;
+        }
+
+        /// \brief Make the query list of the fields (queries) that are in the configuration.
+        /// \param fieldNames The config keys of all the queries the variable can use.
+        /// \param requiredFieldNames The config keys that must be in the configuration.
+        /// \param typeName The name of the variable type (used in the error messages).
+        QueryList makeFieldQueryList(const std::vector<std::string>& fieldNames,
+                                     const std::vector<std::string>& requiredFieldNames,
+                                     const std::string& typeName) const
+        {
+            for (const auto& fieldName : requiredFieldNames)
+            {
+                if (!conf_.has(fieldName))
+                {
+                    throw eckit::BadParameter(typeName + " is missing the required query "
+                                              + fieldName + ".");
+                }
+            }
+
+            auto queries = QueryList();
+            for (const auto& fieldName : fieldNames)
+            {
+                if (conf_.has(fieldName))
+                {
+                    QueryInfo info;
+                    info.name = getExportKey(fieldName);
+                    info.query = conf_.getString(fieldName);
+                    info.groupByField = groupByField_;
+                    queries.push_back(info);
+                }
+            }
+
+            return queries;
+        }
+
+        /// \brief Make sure the BufrDataMap has the data of every configured field.
+        /// \param map The parsed data.
+        /// \param fieldNames The config keys of all the queries the variable can use.
+        /// \param typeName The name of the variable type (used in the error messages).
+        void checkFieldKeys(const BufrDataMap& map,
+                            const std::vector<std::string>& fieldNames,
+                            const std::string& typeName) const
+        {
+            for (const auto& fieldName : fieldNames)
+            {
+                if (conf_.has(fieldName) && map.find(getExportKey(fieldName)) == map.end())
+                {
+                    throw eckit::BadParameter("Query " + getExportKey(fieldName) +
+                                              " could not be found during export of " +
+                                              typeName + ".");
+                }
+            }
+        }
+
      private:
         /// \brief Name used to export this variable
         std::string exportName_;
@@ -0,0 +1,161 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include "VerticalResampleVariable.h"
+
+#include <ostream>
+#include <sstream>
+#include <vector>
+
+#include "eckit/exception/Exceptions.h"
+
+#include "DataObject.h"
+
+
+namespace
+{
+    namespace ConfKeys
+    {
+        const char* Coordinate = "coordinate";
+        const char* Value = "value";
+        const char* Levels = "levels";
+        const char* Method = "method";
+        const char* DimensionPath = "dimensionPath";
+        const char* Threads = "threads";
+    }  // namespace ConfKeys
+
+    const char* TypeName = "verticalResample";
+
+    const std::vector<std::string> FieldNames = {ConfKeys::Coordinate, ConfKeys::Value};
+
+    /// \brief Get the data of an object as T with the missing values set to the missing value
+    ///        of DataObject<T> (doubles are read directly so they keep their precision).
+    template<typename T>
+    std::vector<T> getProfileData(const std::shared_ptr<Ingester::DataObjectBase>& obj)
+    {
+        const auto doubleObj = std::dynamic_pointer_cast<Ingester::DataObject<double>>(obj);
+
+        std::vector<T> data(obj->size());
+        for (size_t idx = 0; idx < data.size(); idx++)
+        {
+            if (obj->isMissing(idx))
+            {
+                data[idx] = Ingester::DataObject<T>::missingValue();
+            }
+            else if (doubleObj)
+            {
+                data[idx] = static_cast<T>(doubleObj->rawData()[idx]);
+            }
+            else
+            {
+                data[idx] = static_cast<T>(obj->getAsFloat(idx));
+            }
+        }
+
+        return data;
+    }
+}  // namespace
+
+
+namespace Ingester
+{
+    VerticalResampleVariable::VerticalResampleVariable(const std::string& exportName,
+                                                       const std::string& groupByField,
+                                                       const eckit::LocalConfiguration &conf) :
+      Variable(exportName, groupByField, conf)
+    {
+        if (!conf_.has(ConfKeys::Levels))
+        {
+            throw eckit::BadParameter("verticalResample needs the list of target levels.");
+        }
+
+        auto method = VerticalResample::Method::LogLinear;
+        if (conf_.has(ConfKeys::Method))
+        {
+            method = VerticalResample::methodFromName(conf_.getString(ConfKeys::Method));
+        }
+
+        resample_ = std::make_shared<VerticalResample>(conf_.getDoubleVector(ConfKeys::Levels),
+                                                       method);
+
+        initQueryMap();
+    }
+
+    std::shared_ptr<DataObjectBase> VerticalResampleVariable::exportData(const BufrDataMap& map)
+    {
+        checkFieldKeys(map, FieldNames, TypeName);
+
+        auto& coordObj = map.at(getExportKey(ConfKeys::Coordinate));
+        auto& valueObj = map.at(getExportKey(ConfKeys::Value));
+
+        if (coordObj->getDims().size() != 2 || coordObj->getDims() != valueObj->getDims())
+        {
+            std::ostringstream errStr;
+            errStr << "The coordinate and value of " << getExportName() << " must have the same";
+            errStr << " 2 dimensions (location, level). Profiles can't be resampled when they";
+            errStr << " are flattened with group_by_variable.";
+            throw eckit::BadParameter(errStr.str());
+        }
+
+        // Doubles stay doubles, everything else (floats and integers) is resampled as float.
+        if (std::dynamic_pointer_cast<DataObject<double>>(valueObj))
+        {
+            return resample<double>(coordObj, valueObj);
+        }
+
+        return resample<float>(coordObj, valueObj);
+    }
+
+    template<typename T>
+    std::shared_ptr<DataObjectBase> VerticalResampleVariable::resample(
+                                            const std::shared_ptr<DataObjectBase>& coordObj,
+                                            const std::shared_ptr<DataObjectBase>& valueObj)
+    {
+        const auto numProfiles = static_cast<size_t>(coordObj->getDims()[0]);
+        const auto numLevels = static_cast<size_t>(coordObj->getDims()[1]);
+
+        const auto coords = getProfileData<T>(coordObj);
+        const auto values = getProfileData<T>(valueObj);
+
+        size_t numThreads = 0;
+        if (conf_.has(ConfKeys::Threads))
+        {
+            numThreads = static_cast<size_t>(conf_.getInt(ConfKeys::Threads));
+        }
+
+        std::vector<T> resampled(numProfiles * resample_->numTargets());
+        resample_->apply(coords.data(),
+                         values.data(),
+                         numProfiles,
+                         numLevels,
+                         DataObject<T>::missingValue(),
+                         resampled.data(),
+                         numThreads);
+
+        // The levels dimension gets its own path so it is not confused with the (longer) level
+        // dimension of the profiles.
+        const auto levelPath = conf_.getString(ConfKeys::DimensionPath,
+                                               conf_.getString(ConfKeys::Coordinate));
+        auto dimPaths = valueObj->getDimPaths();
+        dimPaths.resize(1);
+        dimPaths.push_back(bufr::QueryParser::parse(levelPath)[0]);
+
+        return std::make_shared<DataObject<T>>(
+            resampled,
+            getExportName(),
+            groupByField_,
+            Dimensions {static_cast<int>(numProfiles),
+                        static_cast<int>(resample_->numTargets())},
+            valueObj->getPath(),
+            dimPaths);
+    }
+
+    QueryList VerticalResampleVariable::makeQueryList() const
+    {
+        return makeFieldQueryList(FieldNames, FieldNames, TypeName);
+    }
+}  // namespace Ingester
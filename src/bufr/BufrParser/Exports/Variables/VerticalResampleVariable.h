@@ -0,0 +1,55 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "eckit/config/LocalConfiguration.h"
+
+#include "Transforms/VerticalResample.h"
+#include "Variable.h"
+
+
+namespace Ingester
+{
+    /// \brief Exports a vertical profile variable (ex: radiosonde temperature) resampled onto a
+    ///        fixed list of levels of a vertical coordinate (ex: pressure), so every location
+    ///        gets the same (small) number of levels instead of being padded to the longest
+    ///        profile.
+    class VerticalResampleVariable final : public Variable
+    {
+     public:
+        VerticalResampleVariable() = delete;
+        VerticalResampleVariable(const std::string& exportName,
+                                 const std::string& groupByField,
+                                 const eckit::LocalConfiguration& conf);
+
+        ~VerticalResampleVariable() final = default;
+
+        /// \brief Get the profiles and resample them onto the target levels
+        /// \param map BufrDataMap that contains the parsed data for each query
+        std::shared_ptr<DataObjectBase> exportData(const BufrDataMap& map) final;
+
+        /// \brief Get a list of queries for this variable
+        QueryList makeQueryList() const final;
+
+        /// \brief The resampling kernel is const, so it can be exported concurrently.
+        bool isThreadSafe() const final { return true; }
+
+     private:
+        /// \brief The resampling kernel (holds the sorted target levels)
+        std::shared_ptr<VerticalResample> resample_;
+
+        /// \brief Resample the profiles in T (float, or double when the value is a double) and
+        ///        make the DataObject<T> with the resampled values.
+        template<typename T>
+        std::shared_ptr<DataObjectBase> resample(const std::shared_ptr<DataObjectBase>& coordObj,
+                                                 const std::shared_ptr<DataObjectBase>& valueObj);
+    };
+}  // namespace Ingester
@@ -0,0 +1,235 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include "CompressedInput.h"
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#ifdef HAVE_ZLIB
+    #include <zlib.h>
+#endif
+
+#ifdef HAVE_BZIP2
+    #include <bzlib.h>
+#endif
+
+#ifdef HAVE_ZSTD
+    #include <zstd.h>
+#endif
+
+#include "eckit/exception/Exceptions.h"
+
+
+namespace
+{
+    const size_t ChunkSize = 1 << 20;
+
+    std::string compressionName(Ingester::bufr::Compression compression)
+    {
+        switch (compression)
+        {
+            case Ingester::bufr::Compression::Gzip: return "gzip";
+            case Ingester::bufr::Compression::Bzip2: return "bzip2";
+            case Ingester::bufr::Compression::Zstd: return "zstd";
+            default: return "none";
+        }
+    }
+
+#ifdef HAVE_ZLIB
+    void gunzip(const std::string& filePath, Ingester::bufr::MemoryFile& memoryFile)
+    {
+        gzFile file = gzopen(filePath.c_str(), "rb");
+        if (file == nullptr)
+        {
+            throw eckit::BadParameter("Could not open " + filePath + ".");
+        }
+
+        gzbuffer(file, ChunkSize);
+
+        std::vector<char> buffer(ChunkSize);
+        int size;
+        while ((size = gzread(file, buffer.data(), static_cast<unsigned>(buffer.size()))) > 0)
+        {
+            memoryFile.append(buffer.data(), static_cast<size_t>(size));
+        }
+
+        int errNum = Z_OK;
+        const std::string errMsg = (size < 0) ? gzerror(file, &errNum) : "";
+        gzclose(file);
+
+        if (size < 0)
+        {
+            throw eckit::BadParameter("Could not decompress " + filePath + ": " + errMsg);
+        }
+    }
+#endif
+
+#ifdef HAVE_BZIP2
+    void bunzip2(const std::string& filePath, Ingester::bufr::MemoryFile& memoryFile)
+    {
+        std::unique_ptr<FILE, decltype(&fclose)> file(fopen(filePath.c_str(), "rb"), &fclose);
+        if (file == nullptr)
+        {
+            throw eckit::BadParameter("Could not open " + filePath + ".");
+        }
+
+        std::vector<char> buffer(ChunkSize);
+        std::vector<char> unused;
+        int bzError = BZ_OK;
+
+        // bzip2 files can be made of several concatenated streams (ex: pbzip2)
+        bool isDone = false;
+        while (!isDone)
+        {
+            BZFILE* bzFile = BZ2_bzReadOpen(&bzError,
+                                            file.get(),
+                                            0,
+                                            0,
+                                            unused.data(),
+                                            static_cast<int>(unused.size()));
+
+            while (bzError == BZ_OK)
+            {
+                const int size = BZ2_bzRead(&bzError,
+                                            bzFile,
+                                            buffer.data(),
+                                            static_cast<int>(buffer.size()));
+
+                if (bzError == BZ_OK || bzError == BZ_STREAM_END)
+                {
+                    memoryFile.append(buffer.data(), static_cast<size_t>(size));
+                }
+            }
+
+            if (bzError != BZ_STREAM_END)
+            {
+                BZ2_bzReadClose(&bzError, bzFile);
+                throw eckit::BadParameter("Could not decompress " + filePath + ".");
+            }
+
+            void* unusedPtr = nullptr;
+            int numUnused = 0;
+            BZ2_bzReadGetUnused(&bzError, bzFile, &unusedPtr, &numUnused);
+            unused.assign(static_cast<char*>(unusedPtr),
+                          static_cast<char*>(unusedPtr) + numUnused);
+            BZ2_bzReadClose(&bzError, bzFile);
+
+            if (unused.empty())
+            {
+                const int nextChar = std::fgetc(file.get());
+                isDone = (nextChar == EOF);
+                if (!isDone) std::ungetc(nextChar, file.get());
+            }
+        }
+    }
+#endif
+
+#ifdef HAVE_ZSTD
+    void unzstd(const std::string& filePath, Ingester::bufr::MemoryFile& memoryFile)
+    {
+        std::unique_ptr<FILE, decltype(&fclose)> file(fopen(filePath.c_str(), "rb"), &fclose);
+        if (file == nullptr)
+        {
+            throw eckit::BadParameter("Could not open " + filePath + ".");
+        }
+
+        std::unique_ptr<ZSTD_DStream, decltype(&ZSTD_freeDStream)> stream(ZSTD_createDStream(),
+                                                                          &ZSTD_freeDStream);
+        ZSTD_initDStream(stream.get());
+
+        std::vector<char> inBuffer(ZSTD_DStreamInSize());
+        std::vector<char> outBuffer(ZSTD_DStreamOutSize());
+
+        size_t readSize;
+        size_t lastResult = 0;
+        while ((readSize = fread(inBuffer.data(), 1, inBuffer.size(), file.get())) > 0)
+        {
+            ZSTD_inBuffer input = {inBuffer.data(), readSize, 0};
+            while (input.pos < input.size)
+            {
+                ZSTD_outBuffer output = {outBuffer.data(), outBuffer.size(), 0};
+                lastResult = ZSTD_decompressStream(stream.get(), &output, &input);
+                if (ZSTD_isError(lastResult))
+                {
+                    throw eckit::BadParameter("Could not decompress " + filePath + ": " +
+                                              ZSTD_getErrorName(lastResult));
+                }
+
+                memoryFile.append(outBuffer.data(), output.pos);
+            }
+        }
+
+        if (lastResult != 0)
+        {
+            throw eckit::BadParameter("Could not decompress " + filePath + ": truncated file.");
+        }
+    }
+#endif
+}  // namespace
+
+namespace Ingester {
+namespace bufr {
+
+    CompressedInput::CompressedInput(const std::string& filePath) :
+        filePath_(filePath),
+        compression_(detect(filePath))
+    {
+        decompress();
+    }
+
+    Compression CompressedInput::detect(const std::string& filePath)
+    {
+        unsigned char magic[4] = {0, 0, 0, 0};
+        std::ifstream file(filePath, std::ios::binary);
+        file.read(reinterpret_cast<char*>(magic), sizeof(magic));
+
+        if (magic[0] == 0x1f && magic[1] == 0x8b)
+        {
+            return Compression::Gzip;
+        }
+        else if (magic[0] == 'B' && magic[1] == 'Z' && magic[2] == 'h')
+        {
+            return Compression::Bzip2;
+        }
+        else if (magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd)
+        {
+            return Compression::Zstd;
+        }
+
+        return Compression::None;
+    }
+
+    void CompressedInput::decompress()
+    {
+        switch (compression_)
+        {
+#ifdef HAVE_ZLIB
+            case Compression::Gzip:
+                gunzip(filePath_, memoryFile_);
+                break;
+#endif
+#ifdef HAVE_BZIP2
+            case Compression::Bzip2:
+                bunzip2(filePath_, memoryFile_);
+                break;
+#endif
+#ifdef HAVE_ZSTD
+            case Compression::Zstd:
+                unzstd(filePath_, memoryFile_);
+                break;
+#endif
+            default:
+                throw eckit::BadParameter("Reading " + compressionName(compression_) +
+                                          " compressed files is not supported by this "
+                                          "build (" + filePath_ + ").");
+        }
+    }
+}  // namespace bufr
+}  // namespace Ingester
@@ -0,0 +1,59 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "MemoryFile.h"
+
+
+namespace Ingester {
+namespace bufr {
+
+    /// \brief Compression formats of input files (detected from the magic bytes).
+    enum class Compression
+    {
+        None,
+        Gzip,
+        Bzip2,
+        Zstd
+    };
+
+    /// \brief Decompresses a compressed BUFR file into a MemoryFile (no scratch disk is used)
+    ///        that can be opened by NCEPLIB-bufr. NCEPLIB-bufr opens the data by path and may
+    ///        rewind it (and the message cache reads it a second time), so the data can't be
+    ///        streamed: the whole decompressed file is held in memory, once for all the readers.
+    class CompressedInput
+    {
+     public:
+        CompressedInput() = delete;
+        CompressedInput(const CompressedInput&) = delete;
+        CompressedInput& operator=(const CompressedInput&) = delete;
+
+        /// \brief Constructor. Decompresses the file.
+        /// \param filePath Path to the compressed file.
+        /// \throws eckit::BadParameter if the file could not be decompressed.
+        explicit CompressedInput(const std::string& filePath);
+
+        /// \brief Detect the compression of a file from its first bytes.
+        /// \param filePath Path to the file.
+        static Compression detect(const std::string& filePath);
+
+        /// \brief Get a path to the decompressed data.
+        inline std::string path() const { return memoryFile_.path(); }
+
+     private:
+        const std::string filePath_;
+        const Compression compression_;
+        MemoryFile memoryFile_;
+
+        /// \brief Decompress the file into memoryFile_.
+        void decompress();
+    };
+}  // namespace bufr
+}  // namespace Ingester
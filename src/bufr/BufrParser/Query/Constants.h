@@ -10,5 +10,9 @@ namespace Ingester {
 namespace bufr {
     /// \brief The missing data value for all BUFR data.
     const double MissingValue = 10.0e10;
+
+    /// \brief Override type that picks the narrowest integer type (int8, int16 or int32) that can
+    ///        hold the values of integer elements (other elements keep their usual type).
+    const char* const NarrowestType = "narrowest";
 }  // Ingester
 }  // bufr
@@ -20,7 +20,8 @@ namespace bufr {
     void DataProvider::run(const QuerySet& querySet,
                            const std::function<void()> processSubset,
                            const std::function<void()> processMsg,
-                           const std::function<bool()> continueProcessing)
+                           const std::function<bool()> continueProcessing,
+                           const std::function<bool()> beginMsg)
     {
         if (!isOpen_)
         {
@@ -39,15 +40,37 @@ namespace bufr {
         bool foundBufrMsg = false;
         bool foundBufrSubset = false;
 
+        if (useRawMessages_ && rawMessageReader_ == nullptr)
+        {
+            rawMessageReader_ = std::make_shared<RawMessageReader>(inputPath());
+        }
+
         while (ireadmg_f(FileUnit, subsetChars, &iddate, SubsetLen) == 0)
         {
             foundBufrMsg = true;
             subset_ = std::string(subsetChars);
             subset_.erase(std::remove_if(subset_.begin(), subset_.end(), isspace), subset_.end());
+            isVariantBound_ = false;
+
+            // Keep the raw messages in step with ireadmg (once out of step they stay off)
+            hasRawMessage_ = rawMessageReader_ != nullptr && rawMessageReader_->next();
+            if (rawMessageReader_ != nullptr && !hasRawMessage_)
+            {
+                enableRawMessages(false);
+            }
 
             if (querySet.includesSubset(subset_))
             {
-                while (ireadsb_f(FileUnit) == 0)
+                bool readSubsets = true;
+                if (beginMsg)
+                {
+                    status_f(FileUnit, &bufrLoc, &il, &im);
+                    updateData(bufrLoc);
+                    readSubsets = beginMsg();
+                    if (!readSubsets) foundBufrSubset = true;
+                }
+
+                while (readSubsets && ireadsb_f(FileUnit) == 0)
                 {
                     foundBufrSubset = true;
                     status_f(FileUnit, &bufrLoc, &il, &im);
@@ -95,6 +118,16 @@ namespace bufr {
 
         updateTableData(subset_);
 
+        // All the subsets in a message normally share the same variant, so only resolve the
+        // handle again when the message or the table changes.
+        auto tableData = getTableData();
+        if (!isVariantBound_ || tableData != variantTableData_)
+        {
+            variantHandle_ = internSubsetVariant();
+            variantTableData_ = tableData;
+            isVariantBound_ = true;
+        }
+
         get_val_f(bufrLoc, &dataPtr, &size);
         val_ = gsl::span<const double>(dataPtr, size);
 
@@ -102,6 +135,36 @@ namespace bufr {
         inv_ = gsl::span<const int>(intPtr, size);
     }
 
+    std::string DataProvider::inputPath()
+    {
+        if (compressedInput_ == nullptr &&
+            CompressedInput::detect(filePath_) != Compression::None)
+        {
+            compressedInput_ = std::make_shared<CompressedInput>(filePath_);
+        }
+
+        return compressedInput_ != nullptr ? compressedInput_->path() : filePath_;
+    }
+
+    SubsetVariantHandle DataProvider::internSubsetVariant()
+    {
+        auto variant = getSubsetVariant();
+
+        auto handleIt = variantHandles_.find(variant);
+        if (handleIt != variantHandles_.end())
+        {
+            // More variants of the subset may have been found since it was added.
+            variants_[handleIt->second].otherVariantsExist = variant.otherVariantsExist;
+            return handleIt->second;
+        }
+
+        const SubsetVariantHandle handle = variants_.size();
+        variants_.push_back(variant);
+        variantHandles_.insert({variant, handle});
+
+        return handle;
+    }
+
     TypeInfo DataProvider::getTypeInfo(FortranIdx idx) const
     {
         static const unsigned int UNIT_STR_LEN = 24;
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <functional>
 #include <set>
 #include <string>
@@ -17,6 +18,8 @@
 #include <unordered_map>
 
 #include "bufr_interface.h"
+#include "../CompressedInput.h"
+#include "../MessageCache.h"
 #include "../QuerySet.h"
 #include "SubsetVariant.h"
 
@@ -91,6 +94,21 @@ namespace bufr {
 
             return is64Bit;
         }
+
+        /// \brief Size in bytes of the narrowest signed integer type (1, 2, 4 or 8) that holds
+        ///        every value of the element (integers only) and still has its max value free to
+        ///        mark the missing values.
+        size_t integerBytes() const
+        {
+            // value = (raw + reference) * 10^-scale, the raw value with all the bits set is missing
+            const double factor = pow(10, -scale);
+            const double minValue = reference * factor;
+            const double maxValue = (pow(2, bits) - 2 + reference) * factor;
+
+            if (minValue >= INT8_MIN && maxValue < INT8_MAX) return 1;
+            if (minValue >= INT16_MIN && maxValue < INT16_MAX) return 2;
+            return is64Bit() ? 8 : 4;
+        }
     };
 
     /// \brief Table to hold subset table meta data
@@ -110,6 +128,9 @@ namespace bufr {
     class DataProvider;
     typedef std::shared_ptr<DataProvider> DataProviderType;
 
+    /// \brief Small integer that identifies a subset variant (see DataProvider).
+    typedef size_t SubsetVariantHandle;
+
     /// \brief Responsible for exposing the data found in a BUFR file.
     class DataProvider
     {
@@ -129,10 +150,13 @@ namespace bufr {
         /// \param processMsg (Optional) Function to call when finish processing a message.
         /// \param continueProcessing (Optional) Function to call to figure out if we should keep
         ///                           running or not.
+        /// \param beginMsg (Optional) Function to call when a message we want is read (before its
+        ///                 subsets). Return false to skip reading the subsets of the message.
         void run(const QuerySet& querySet,
                  const std::function<void()> processSubset,
                  const std::function<void()> processMsg = [](){},
-                 const std::function<bool()> continueProcessing = [](){ return true; });
+                 const std::function<bool()> continueProcessing = [](){ return true; },
+                 const std::function<bool()> beginMsg = nullptr);
 
         /// \brief Open the BUFR file with NCEPLIB-bufr
         virtual void open() = 0;
@@ -143,6 +167,7 @@ namespace bufr {
             closbf_f(FileUnit);
             close_f(FileUnit);
             isOpen_ = false;
+            rawMessageReader_ = nullptr;
         }
 
         /// \brief Rewind the current BUFR file (start over from the beginning).
@@ -165,6 +190,37 @@ namespace bufr {
             return SubsetVariant(subset_, variantId(), hasVariants());
         }
 
+        /// \brief Get the handle of the current active subset variant. Subset variants are
+        ///        interned as they are encountered, so the handles are consecutive integers
+        ///        (starting at 0) that stay valid for the life of the provider. Cheap to call for
+        ///        every subset (no string work).
+        inline SubsetVariantHandle getSubsetVariantHandle() const { return variantHandle_; }
+
+        /// \brief Get the subset variant that corresponds to a handle.
+        /// \param handle A handle returned by getSubsetVariantHandle.
+        inline const SubsetVariant& getSubsetVariant(SubsetVariantHandle handle) const
+        {
+            return variants_[handle];
+        }
+
+        /// \brief Get the number of subset variants interned so far.
+        inline size_t numSubsetVariants() const { return variants_.size(); }
+
+        /// \brief Read the raw bytes of the messages (in step with ireadmg) while running. Should
+        ///        be set before the first run.
+        inline void enableRawMessages(bool enable)
+        {
+            useRawMessages_ = enable;
+            if (!enable) rawMessageReader_ = nullptr;
+        }
+
+        /// \brief Get the raw message (bytes and subset count) for the current message.
+        ///        Returns nullptr if raw messages aren't enabled or couldn't be read.
+        inline const RawMessageReader* getRawMessage() const
+        {
+            return hasRawMessage_ ? rawMessageReader_.get() : nullptr;
+        }
+
         /// \brief Get the filepath for the currently open BUFR file.
         std::string getFilepath() const { return filePath_; }
 
@@ -220,6 +276,13 @@ namespace bufr {
         /// \param idx BUFR table node index
         inline std::string getTag(FortranIdx idx) const { return getTableData()->tag[idx - 1]; }
 
+        /// \brief Get the table data of the currently loaded subset. The type info (see
+        ///        getTypeInfo) of the nodes stays the same as long as the table data does.
+        inline std::shared_ptr<const TableData> getCurrentTableData() const
+        {
+            return getTableData();
+        }
+
         /// \brief Gets the variant number for the currently loaded subset.
         virtual size_t variantId() const = 0;
 
@@ -246,6 +309,25 @@ namespace bufr {
         gsl::span<const double> val_;
         gsl::span<const int> inv_;
 
+        // Interned subset variants (see getSubsetVariantHandle)
+        std::vector<SubsetVariant> variants_;
+        std::unordered_map<SubsetVariant, SubsetVariantHandle> variantHandles_;
+        SubsetVariantHandle variantHandle_ = 0;
+        bool isVariantBound_ = false;
+        std::shared_ptr<TableData> variantTableData_;
+
+        // Raw messages (see enableRawMessages)
+        bool useRawMessages_ = false;
+        bool hasRawMessage_ = false;
+        std::shared_ptr<RawMessageReader> rawMessageReader_;
+
+        /// \brief Decompressed data for compressed files (kept across rewinds).
+        std::shared_ptr<CompressedInput> compressedInput_;
+
+        /// \brief Get the path of the data to open. This is filePath_ unless the file is
+        ///        compressed, in which case it is the path to the decompressed data.
+        std::string inputPath();
+
         /// \brief Update the table data for the currently loaded subset.
         /// \param subset The subset string.
         virtual void updateTableData(const std::string& subset) = 0;
@@ -255,6 +337,9 @@ namespace bufr {
         ////// \param bufrLoc The Fortran idx for the subset we need to read.
         void updateData(int bufrLoc);
 
+        /// \brief Get the handle for the current subset variant (adds it if its new).
+        SubsetVariantHandle internSubsetVariant();
+
      private:
         /// \brief Get the currently valid subset table data
         virtual std::shared_ptr<TableData> getTableData() const = 0;
@@ -21,7 +21,7 @@ namespace bufr {
 
     void NcepDataProvider::open()
     {
-        open_f(FileUnit, filePath_.c_str());
+        open_f(FileUnit, inputPath().c_str());
         openbf_f(FileUnit, "IN", FileUnit);
 
         isOpen_ = true;
@@ -29,7 +29,7 @@ namespace bufr {
 
     void WmoDataProvider::open()
     {
-        open_f(FileUnit, filePath_.c_str());
+        open_f(FileUnit, inputPath().c_str());
         openbf_f(FileUnit, "SEC3", FileUnit);
         mtinfo_f(tableFilePath_.c_str(), FileUnitTable1, FileUnitTable2);
 
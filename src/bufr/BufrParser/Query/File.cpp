@@ -7,7 +7,16 @@
 
 #include "File.h"
 
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <algorithm>
+#include <iostream>
+#include <string>
+
+#ifdef BUILD_IODA_BINDING
+    #include "oops/util/Logger.h"
+#endif
 
 #include "bufr_interface.h"
 
@@ -18,23 +27,63 @@
 #include "DataProvider/WmoDataProvider.h"
 
 
+namespace
+{
+    const char* StdinFilename = "-";
+}  // namespace
+
 namespace Ingester {
 namespace bufr {
     File::File(const std::string &filename, const std::string &wmoTablePath)
     {
+        init(filename == StdinFilename ? pathForFd(STDIN_FILENO) : filename, wmoTablePath);
+    }
+
+    File::File(const void* data, size_t size, const std::string &wmoTablePath)
+    {
+        memoryFile_ = std::make_shared<MemoryFile>();
+        memoryFile_->append(data, size);
+        init(memoryFile_->path(), wmoTablePath);
+    }
+
+    File::File(int fd, const std::string &wmoTablePath)
+    {
+        init(pathForFd(fd), wmoTablePath);
+    }
+
+    void File::init(const std::string &path, const std::string &wmoTablePath)
+    {
+        isWmo_ = !wmoTablePath.empty();
         if (wmoTablePath.empty())
         {
-            dataProvider_ = std::make_shared<Ingester::bufr::NcepDataProvider>(filename);
+            dataProvider_ = std::make_shared<Ingester::bufr::NcepDataProvider>(path);
         }
         else
         {
-            dataProvider_ = std::make_shared<Ingester::bufr::WmoDataProvider>(filename,
+            dataProvider_ = std::make_shared<Ingester::bufr::WmoDataProvider>(path,
                                                                              wmoTablePath);
         }
 
         dataProvider_->open();
     }
 
+    std::string File::pathForFd(int fd)
+    {
+        // The decoder opens (and may rewind) the data by path, so only regular files can be read
+        // in place (through /proc, so Linux only). Pipes, sockets, etc... are read into memory.
+#ifdef __linux__
+        struct stat info;
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode))
+        {
+            return "/proc/self/fd/" + std::to_string(fd);
+        }
+#endif
+
+        memoryFile_ = std::make_shared<MemoryFile>();
+        memoryFile_->appendFrom(fd);
+        return memoryFile_->path();
+    }
+
     void File::close()
     {
         dataProvider_->close();
@@ -45,15 +94,118 @@ namespace bufr {
         dataProvider_->rewind();
     }
 
+    void File::setMessageCache(const std::shared_ptr<MessageCache>& cache)
+    {
+        if (cache != nullptr && isWmo_)
+        {
+#ifdef BUILD_IODA_BINDING
+            oops::Log::warning() << "Warning: The message cache is not supported for WMO BUFR ";
+            oops::Log::warning() << "files and will not be used." << std::endl;
+#endif
+
+#ifndef BUILD_IODA_BINDING
+            std::cout << "Warning: The message cache is not supported for WMO BUFR ";
+            std::cout << "files and will not be used." << std::endl;
+#endif
+            return;
+        }
+
+        messageCache_ = cache;
+        dataProvider_->enableRawMessages(cache != nullptr);
+    }
+
     ResultSet File::execute(const QuerySet &querySet, size_t next)
+    {
+        return executeQueries(querySet, nullptr, next);
+    }
+
+    ResultSet File::execute(const PreparedQuery &query, size_t next)
+    {
+        return executeQueries(query.querySet(), &query, next);
+    }
+
+    ResultSet File::executeQueries(const QuerySet &querySet,
+                                   const PreparedQuery* preparedQuery,
+                                   size_t next)
     {
         size_t msgCnt = 0;
         auto resultSet = ResultSet(querySet.names());
-        auto queryRunner = QueryRunner(querySet, resultSet, dataProvider_);
+        auto queryRunner = QueryRunner(querySet, resultSet, dataProvider_, preparedQuery);
+
+        const size_t numFields = querySet.names().size();
+        uint64_t fingerprint = 0;
+        if (messageCache_ != nullptr)
+        {
+            fingerprint = preparedQuery != nullptr ? preparedQuery->messageCacheFingerprint()
+                                                   : MessageCache::fingerprint(querySet);
+        }
+        std::string msgKey;
+        size_t msgStartFrame = 0;
+
+        auto beginMsg = [&]() -> bool
+        {
+            msgKey.clear();
+
+            const auto rawMessage = dataProvider_->getRawMessage();
+            if (messageCache_ == nullptr || rawMessage == nullptr) return true;
+
+            const auto key = MessageCache::makeKey(rawMessage->message(),
+                                                   rawMessage->tableHash(),
+                                                   fingerprint);
+
+            CachedMessage cached;
+            if (messageCache_->load(key, cached) &&
+                cached.size() == rawMessage->numSubsets() &&
+                (cached.empty() || cached.front().size() == numFields))
+            {
+                queryRunner.accumulateCached(cached);
+                return false;
+            }
+
+            msgKey = key;
+            msgStartFrame = resultSet.numFrames();
+            return true;
+        };
 
-        auto processMsg = [&msgCnt] () mutable
+        auto processMsg = [&]() mutable
         {
             msgCnt++;
+
+            if (msgKey.empty()) return;
+
+            const auto rawMessage = dataProvider_->getRawMessage();
+            const size_t numFrames = resultSet.numFrames() - msgStartFrame;
+            if (rawMessage == nullptr || numFrames != rawMessage->numSubsets())
+            {
+                // The raw messages are out of step with the BUFR library, so we can't trust the
+                // keys anymore.
+#ifdef BUILD_IODA_BINDING
+                oops::Log::warning() << "Warning: Could not match the raw BUFR messages to the ";
+                oops::Log::warning() << "decoded ones. Turning the message cache off.";
+                oops::Log::warning() << std::endl;
+#endif
+
+#ifndef BUILD_IODA_BINDING
+                std::cout << "Warning: Could not match the raw BUFR messages to the ";
+                std::cout << "decoded ones. Turning the message cache off." << std::endl;
+#endif
+                setMessageCache(nullptr);
+                return;
+            }
+
+            CachedMessage message(numFrames);
+            for (size_t frameIdx = 0; frameIdx < numFrames; ++frameIdx)
+            {
+                const auto& dataFrame = resultSet.frameAt(msgStartFrame + frameIdx);
+                message[frameIdx].reserve(numFields);
+                for (size_t fieldIdx = 0; fieldIdx < numFields; ++fieldIdx)
+                {
+                    const auto& dataField = dataFrame.fieldAtIdx(fieldIdx);
+                    message[frameIdx].push_back({dataField.data, dataField.seqCounts});
+                }
+            }
+
+            messageCache_->store(msgKey, message);
         };
 
         auto processSubset = [&queryRunner]() mutable
@@ -71,10 +223,23 @@ namespace bufr {
             return true;
         };
 
-        dataProvider_->run(querySet,
-                           processSubset,
-                           processMsg,
-                           continueProcessing);
+        if (messageCache_ != nullptr)
+        {
+            dataProvider_->run(querySet,
+                               processSubset,
+                               processMsg,
+                               continueProcessing,
+                               beginMsg);
+        }
+        else
+        {
+            dataProvider_->run(querySet,
+                               processSubset,
+                               processMsg,
+                               continueProcessing);
+        }
+
+        resultSet.trackMemory();
 
         return resultSet;
     }
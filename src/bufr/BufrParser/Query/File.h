@@ -7,8 +7,12 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 
+#include "MemoryFile.h"
+#include "MessageCache.h"
+#include "PreparedQuery.h"
 #include "QuerySet.h"
 #include "ResultSet.h"
 
@@ -21,9 +25,26 @@ namespace bufr {
      public:
         File() = delete;
 
+        /// \brief Open a BUFR file. The filename "-" reads the BUFR data from stdin.
         File(const std::string& filename,
              const std::string& wmoTablePath = "");
 
+        /// \brief Open BUFR data held in memory (ex: received over a message queue). The data is
+        ///        copied once into an in-memory file (see MemoryFile), on Linux nothing is
+        ///        written to the filesystem.
+        /// \param data Pointer to the BUFR data (may be compressed, see CompressedInput).
+        /// \param size Size of the data in bytes.
+        File(const void* data,
+             size_t size,
+             const std::string& wmoTablePath = "");
+
+        /// \brief Open BUFR data read from a file descriptor (ex: a pipe or socket). Regular files
+        ///        are read in place on Linux, anything else is read until EOF into an in-memory
+        ///        file.
+        /// \param fd The file descriptor (not closed by File).
+        File(int fd,
+             const std::string& wmoTablePath = "");
+
         /// \brief Execute the queries given in the query set over the BUFR file and accumulate the
         /// resulting data in the ResultSet.
         /// \param query_set The queryset object that contains the collection of desired queries
@@ -31,14 +52,45 @@ namespace bufr {
         /// file.
         ResultSet execute(const QuerySet& query_set, size_t next = 0);
 
+        /// \brief Execute a prepared query. Works like the QuerySet version, but the targets
+        /// resolved for each subset are shared with every other file the query runs on, so files
+        /// with the same tables skip resolving the queries.
+        /// \param query The prepared query
+        /// \param next The number of messages worth of data to run. 0 reads all messages in the
+        /// file.
+        ResultSet execute(const PreparedQuery& query, size_t next = 0);
+
         /// \brief Close the currently opened BUFR file.
         void close();
 
         /// \brief Rewind the currently opened BUFR file to the beginning.
         void rewind();
 
+        /// \brief Use a message cache so the data of messages that were already read (by this or
+        ///        another job with the same queries) isn't decoded again. Only supported for NCEP
+        ///        files (WMO files may change tables between messages). Set before execute.
+        /// \param cache The cache to use (nullptr turns the cache off).
+        void setMessageCache(const std::shared_ptr<MessageCache>& cache);
+
      private:
+        std::shared_ptr<MemoryFile> memoryFile_;
         std::shared_ptr<DataProvider> dataProvider_;
+        std::shared_ptr<MessageCache> messageCache_;
+        bool isWmo_ = false;
+
+        /// \brief Create the data provider for the file at path and open it.
+        void init(const std::string& path, const std::string& wmoTablePath);
+
+        /// \brief Get a path that reads from the file descriptor.
+        std::string pathForFd(int fd);
+
+        /// \brief Execute the queries (see execute).
+        /// \param querySet The queries.
+        /// \param preparedQuery The prepared query that owns querySet (or nullptr).
+        /// \param next The number of messages worth of data to run (0 for all).
+        ResultSet executeQueries(const QuerySet& querySet,
+                                 const PreparedQuery* preparedQuery,
+                                 size_t next);
     };
 }  // namespace bufr
 }  // namespace Ingester
@@ -0,0 +1,101 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include "MemoryFile.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "eckit/exception/Exceptions.h"
+
+
+namespace
+{
+    const size_t ChunkSize = 1 << 20;
+}  // namespace
+
+namespace Ingester {
+namespace bufr {
+
+    MemoryFile::MemoryFile() :
+        fd_(-1)
+    {
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+        fd_ = memfd_create("bufr", MFD_CLOEXEC);
+#endif
+
+        // No memfd (or an old kernel), fall back to a temporary file
+        if (fd_ < 0)
+        {
+            const char* tmpDir = std::getenv("TMPDIR");
+            tmpPath_ = std::string(tmpDir != nullptr && *tmpDir != '\0' ? tmpDir : "/tmp") +
+                       "/bufrXXXXXX";
+            fd_ = mkstemp(&tmpPath_[0]);
+        }
+
+        if (fd_ < 0)
+        {
+            throw eckit::BadParameter("Could not create an in-memory file for the BUFR data.");
+        }
+    }
+
+    MemoryFile::~MemoryFile()
+    {
+        close(fd_);
+
+        if (!tmpPath_.empty())
+        {
+            std::remove(tmpPath_.c_str());
+        }
+    }
+
+    void MemoryFile::append(const void* data, size_t size)
+    {
+        auto bytes = static_cast<const char*>(data);
+        while (size > 0)
+        {
+            const auto written = write(fd_, bytes, size);
+            if (written < 0)
+            {
+                if (errno == EINTR) continue;
+                throw eckit::BadParameter("Could not write to the in-memory BUFR file.");
+            }
+
+            bytes += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+
+    void MemoryFile::appendFrom(int fd)
+    {
+        std::vector<char> buffer(ChunkSize);
+        while (true)
+        {
+            const auto numRead = read(fd, buffer.data(), buffer.size());
+            if (numRead == 0) break;
+            if (numRead < 0)
+            {
+                if (errno == EINTR) continue;
+                throw eckit::BadParameter("Could not read the BUFR data from file descriptor " +
+                                          std::to_string(fd) + ".");
+            }
+
+            append(buffer.data(), static_cast<size_t>(numRead));
+        }
+    }
+
+    std::string MemoryFile::path() const
+    {
+        return tmpPath_.empty() ? "/proc/self/fd/" + std::to_string(fd_) : tmpPath_;
+    }
+}  // namespace bufr
+}  // namespace Ingester
@@ -0,0 +1,50 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <string>
+
+
+namespace Ingester {
+namespace bufr {
+
+    /// \brief Anonymous in-memory file (memfd) with a path that NCEPLIB-bufr can open. Used to
+    ///        hand data that doesn't live in a regular file (buffers, pipes, decompressed data)
+    ///        to the decoder without touching the filesystem. The file is seekable, which the
+    ///        decoder needs, and lives as long as the object. Where memfd_create isn't available
+    ///        (non Linux systems) a temporary file in $TMPDIR (or /tmp) is used instead, it is
+    ///        removed by the destructor.
+    class MemoryFile
+    {
+     public:
+        MemoryFile();
+        MemoryFile(const MemoryFile&) = delete;
+        MemoryFile& operator=(const MemoryFile&) = delete;
+
+        ~MemoryFile();
+
+        /// \brief Append data to the end of the file.
+        /// \param data Pointer to the data.
+        /// \param size Size of the data in bytes.
+        void append(const void* data, size_t size);
+
+        /// \brief Append everything that can be read from a file descriptor (until EOF).
+        /// \param fd The file descriptor (ex: 0 for stdin). It is not closed.
+        void appendFrom(int fd);
+
+        /// \brief Get the path to the file.
+        std::string path() const;
+
+     private:
+        int fd_;
+
+        /// \brief Path of the temporary file (empty for a memfd).
+        std::string tmpPath_;
+    };
+}  // namespace bufr
+}  // namespace Ingester
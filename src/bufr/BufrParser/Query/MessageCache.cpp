@@ -0,0 +1,394 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include "MessageCache.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+
+#include "eckit/exception/Exceptions.h"
+
+
+namespace
+{
+    const char* CacheFileMagic = "BUFRMC01";
+    const char* CacheFileExtension = ".msg";
+    const unsigned char DictionaryCategory = 11;
+
+    // When the cache is over its bound evict down to this fraction of it, so we don't have to scan
+    // the directory on every store.
+    const double EvictionTarget = 0.9;
+
+    const uint64_t FnvOffset = 14695981039346656037ULL;
+    const uint64_t FnvPrime = 1099511628211ULL;
+
+    uint64_t fnv1a(const unsigned char* data, size_t size, uint64_t hash = FnvOffset)
+    {
+        for (size_t idx = 0; idx < size; ++idx)
+        {
+            hash ^= data[idx];
+            hash *= FnvPrime;
+        }
+
+        return hash;
+    }
+
+    uint64_t fnv1a(const std::string& str, uint64_t hash = FnvOffset)
+    {
+        return fnv1a(reinterpret_cast<const unsigned char*>(str.data()), str.size() + 1, hash);
+    }
+
+    template<typename T>
+    void writeValue(std::ostream& stream, const T& value)
+    {
+        stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template<typename T>
+    void writeVector(std::ostream& stream, const std::vector<T>& values)
+    {
+        writeValue<uint64_t>(stream, values.size());
+        stream.write(reinterpret_cast<const char*>(values.data()), sizeof(T) * values.size());
+    }
+
+    template<typename T>
+    bool readValue(std::istream& stream, T& value)
+    {
+        return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+
+    template<typename T>
+    bool readVector(std::istream& stream, std::vector<T>& values)
+    {
+        uint64_t size;
+        if (!readValue(stream, size)) return false;
+
+        values.resize(size);
+        return static_cast<bool>(stream.read(reinterpret_cast<char*>(values.data()),
+                                             sizeof(T) * size));
+    }
+
+    /// \brief Make the directory (and its parents) if it doesn't exist.
+    void makeDirectories(const std::string& path)
+    {
+        for (size_t pos = path.find('/', 1); ; pos = path.find('/', pos + 1))
+        {
+            const auto dir = path.substr(0, pos);
+            if (!dir.empty() && mkdir(dir.c_str(), 0775) != 0 && errno != EEXIST)
+            {
+                throw eckit::BadParameter("MessageCache: Could not create directory " + dir + ".");
+            }
+
+            if (pos == std::string::npos) break;
+        }
+    }
+
+    struct CacheEntry
+    {
+        std::string path;
+        time_t lastUsed;
+        size_t size;
+    };
+
+    /// \brief List the cache files in the directory.
+    std::vector<CacheEntry> listEntries(const std::string& directory)
+    {
+        std::vector<CacheEntry> entries;
+
+        DIR* dir = opendir(directory.c_str());
+        if (dir == nullptr) return entries;
+
+        const std::string extension = CacheFileExtension;
+        while (auto* dirEntry = readdir(dir))
+        {
+            const std::string name = dirEntry->d_name;
+            if (name.size() <= extension.size() ||
+                name.compare(name.size() - extension.size(), extension.size(), extension) != 0)
+            {
+                continue;
+            }
+
+            struct stat info;
+            const auto path = directory + "/" + name;
+            if (stat(path.c_str(), &info) == 0)
+            {
+                entries.push_back({path, info.st_mtime, static_cast<size_t>(info.st_size)});
+            }
+        }
+
+        closedir(dir);
+        return entries;
+    }
+}  // namespace
+
+namespace Ingester {
+namespace bufr {
+
+    RawMessageReader::RawMessageReader(const std::string& filePath) :
+        file_(filePath, std::ios::binary)
+    {
+    }
+
+    bool RawMessageReader::next()
+    {
+        const char* Magic = "BUFR";
+
+        while (file_)
+        {
+            // Find the start of the next message (skips any record markers between messages)
+            int matched = 0;
+            int byte;
+            while (matched < 4 && (byte = file_.get()) != std::char_traits<char>::eof())
+            {
+                matched = (byte == Magic[matched]) ? matched + 1 : (byte == Magic[0] ? 1 : 0);
+            }
+
+            if (matched < 4) return false;
+
+            unsigned char section0[8] = {'B', 'U', 'F', 'R'};
+            if (!file_.read(reinterpret_cast<char*>(section0 + 4), 4)) return false;
+
+            const size_t length = (section0[4] << 16) | (section0[5] << 8) | section0[6];
+            const int edition = section0[7];
+            if (edition < 2 || length < 8 + 18) return false;  // Editions 0 and 1 unsupported
+
+            message_.resize(length);
+            std::copy(section0, section0 + 8, message_.begin());
+            if (!file_.read(reinterpret_cast<char*>(message_.data() + 8), length - 8))
+            {
+                return false;
+            }
+
+            auto read3 = [this](size_t pos)
+            {
+                return static_cast<size_t>((message_[pos] << 16) |
+                                           (message_[pos + 1] << 8) |
+                                           message_[pos + 2]);
+            };
+
+            const size_t section1 = 8;
+            const bool hasSection2 = message_[section1 + (edition >= 4 ? 9 : 7)] & 0x80;
+            const auto category = message_[section1 + (edition >= 4 ? 10 : 8)];
+
+            size_t section3 = section1 + read3(section1);
+            if (hasSection2 && section3 + 3 <= length) section3 += read3(section3);
+            if (section3 + 7 > length) return false;
+
+            // NCEPLIB-bufr reads the (embedded table) dictionary messages internally. Every run
+            // of them replaces the table, hash their sections 3 and 4 (section 1 has the date).
+            if (category == DictionaryCategory)
+            {
+                if (!inDictionary_) tableHash_ = FnvOffset;
+                inDictionary_ = true;
+                tableHash_ = fnv1a(message_.data() + section3, length - section3, tableHash_);
+                continue;
+            }
+
+            inDictionary_ = false;
+
+            numSubsets_ = static_cast<size_t>((message_[section3 + 4] << 8) |
+                                              message_[section3 + 5]);
+            return true;
+        }
+
+        return false;
+    }
+
+    MessageCache::MessageCache(const std::string& directory, size_t maxBytes) :
+        directory_(directory),
+        maxBytes_(maxBytes)
+    {
+        makeDirectories(directory_);
+
+        for (const auto& entry : listEntries(directory_))
+        {
+            currentBytes_ += entry.size;
+        }
+    }
+
+    uint64_t MessageCache::fingerprint(const QuerySet& querySet)
+    {
+        uint64_t hash = fnv1a(CacheFileMagic);
+        for (const auto& name : querySet.names())
+        {
+            hash = fnv1a(name, hash);
+            for (const auto& query : querySet.queriesFor(name))
+            {
+                hash = fnv1a(query.str(), hash);
+            }
+        }
+
+        return hash;
+    }
+
+    std::string MessageCache::makeKey(const std::vector<unsigned char>& message,
+                                      uint64_t tableHash,
+                                      uint64_t fingerprint)
+    {
+        std::ostringstream key;
+        key << std::hex << std::setfill('0');
+        key << std::setw(16) << fnv1a(message.data(), message.size());
+        key << "_" << std::setw(16) << tableHash;
+        key << "_" << std::setw(16) << fingerprint;
+        key << std::dec << "_" << message.size();
+
+        return key.str();
+    }
+
+    bool MessageCache::load(const std::string& key, CachedMessage& message)
+    {
+        const auto path = pathFor(key);
+        std::ifstream file(path, std::ios::binary);
+
+        char magic[8];
+        uint64_t numFrames = 0;
+        uint64_t numFields = 0;
+        bool isValid = file.read(magic, sizeof(magic)) &&
+                       std::string(magic, sizeof(magic)) == CacheFileMagic &&
+                       readValue(file, numFrames) &&
+                       readValue(file, numFields);
+
+        if (isValid)
+        {
+            message.assign(numFrames, std::vector<CachedField>(numFields));
+            for (auto& frame : message)
+            {
+                for (auto& field : frame)
+                {
+                    uint64_t numCounts = 0;
+                    isValid = isValid &&
+                              readVector(file, field.data) &&
+                              readValue(file, numCounts);
+
+                    field.seqCounts.resize(isValid ? numCounts : 0);
+                    for (auto& counts : field.seqCounts)
+                    {
+                        isValid = isValid && readVector(file, counts);
+                    }
+                }
+            }
+        }
+
+        if (!isValid)
+        {
+            message.clear();
+            misses_++;
+            return false;
+        }
+
+        // Mark the entry as recently used
+        utime(path.c_str(), nullptr);
+        hits_++;
+        return true;
+    }
+
+    void MessageCache::store(const std::string& key, const CachedMessage& message)
+    {
+        const auto path = pathFor(key);
+
+        // Write to a unique temporary file first so other jobs (or threads) never see a partial
+        // entry
+        std::string tmpPath = path + ".tmpXXXXXX";
+        const int tmpFd = mkstemp(&tmpPath[0]);
+        if (tmpFd < 0) return;
+        ::close(tmpFd);
+
+        size_t entryBytes = 0;
+        {
+            std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+            file.write(CacheFileMagic, 8);
+            writeValue<uint64_t>(file, message.size());
+            writeValue<uint64_t>(file, message.empty() ? 0 : message.front().size());
+            for (const auto& frame : message)
+            {
+                for (const auto& field : frame)
+                {
+                    writeVector(file, field.data);
+                    writeValue<uint64_t>(file, field.seqCounts.size());
+                    for (const auto& counts : field.seqCounts)
+                    {
+                        writeVector(file, counts);
+                    }
+                }
+            }
+
+            if (!file)
+            {
+                std::remove(tmpPath.c_str());
+                return;
+            }
+
+            entryBytes = static_cast<size_t>(file.tellp());
+        }
+
+        // Replacing an entry frees the space of the old one
+        struct stat info;
+        const bool replaces = stat(path.c_str(), &info) == 0;
+
+        if (std::rename(tmpPath.c_str(), path.c_str()) != 0)
+        {
+            std::remove(tmpPath.c_str());
+            return;
+        }
+
+        if (replaces)
+        {
+            currentBytes_ -= std::min(currentBytes_, static_cast<size_t>(info.st_size));
+        }
+
+        currentBytes_ += entryBytes;
+
+        if (currentBytes_ > maxBytes_)
+        {
+            evict();
+        }
+    }
+
+    std::string MessageCache::pathFor(const std::string& key) const
+    {
+        return directory_ + "/" + key + CacheFileExtension;
+    }
+
+    void MessageCache::evict()
+    {
+        // Other jobs may share the directory, so start from what is actually there.
+        auto entries = listEntries(directory_);
+        std::sort(entries.begin(),
+                  entries.end(),
+                  [](const CacheEntry& a, const CacheEntry& b)
+                  {
+                      return a.lastUsed < b.lastUsed;
+                  });
+
+        currentBytes_ = 0;
+        for (const auto& entry : entries)
+        {
+            currentBytes_ += entry.size;
+        }
+
+        const auto targetBytes = static_cast<size_t>(maxBytes_ * EvictionTarget);
+        for (const auto& entry : entries)
+        {
+            if (currentBytes_ <= targetBytes) break;
+
+            if (std::remove(entry.path.c_str()) == 0)
+            {
+                currentBytes_ -= entry.size;
+            }
+        }
+    }
+}  // namespace bufr
+}  // namespace Ingester
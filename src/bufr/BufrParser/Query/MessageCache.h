@@ -0,0 +1,117 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "QuerySet.h"
+
+
+namespace Ingester {
+namespace bufr {
+
+    /// \brief The collected data for one field of one message subset (see DataField).
+    struct CachedField
+    {
+        std::vector<double> data;
+        std::vector<std::vector<int>> seqCounts;
+    };
+
+    /// \brief The collected data for all the subsets of a BUFR message (one vector of fields per
+    ///        subset, in the order of the QuerySet names).
+    typedef std::vector<std::vector<CachedField>> CachedMessage;
+
+    /// \brief Reads the raw BUFR messages of a file in the order NCEPLIB-bufr returns them from
+    ///        ireadmg (dictionary messages are skipped).
+    class RawMessageReader
+    {
+     public:
+        RawMessageReader() = delete;
+        explicit RawMessageReader(const std::string& filePath);
+
+        /// \brief Read the next data message.
+        /// \return False if there are no more messages (or the file can't be read).
+        bool next();
+
+        /// \brief The bytes of the current message.
+        inline const std::vector<unsigned char>& message() const { return message_; }
+
+        /// \brief The number of subsets in the current message (from section 3).
+        inline size_t numSubsets() const { return numSubsets_; }
+
+        /// \brief Hash of the dictionary (DX table) messages that define the current message.
+        inline uint64_t tableHash() const { return tableHash_; }
+
+     private:
+        std::ifstream file_;
+        std::vector<unsigned char> message_;
+        size_t numSubsets_ = 0;
+        uint64_t tableHash_ = 0;
+        bool inDictionary_ = false;
+    };
+
+    /// \brief Content addressed cache for the data collected from BUFR messages. Entries are
+    ///        keyed by a hash of the raw message bytes, a hash of the table used to decode them
+    ///        and a fingerprint of the QuerySet, and are stored as files in a local directory so
+    ///        that consecutive jobs (ex: overlapping cycle dumps) on the same node can share them.
+    ///        The size of the directory is bounded, the least recently used entries (oldest
+    ///        modification time) are evicted first.
+    class MessageCache
+    {
+     public:
+        MessageCache() = delete;
+
+        /// \brief Constructor.
+        /// \param directory The cache directory (created if it doesn't exist).
+        /// \param maxBytes The maximum size of the cache in bytes.
+        MessageCache(const std::string& directory, size_t maxBytes);
+
+        /// \brief Make the fingerprint for a QuerySet (part of every cache key).
+        static uint64_t fingerprint(const QuerySet& querySet);
+
+        /// \brief Make the key for a message.
+        /// \param message The raw message bytes.
+        /// \param tableHash The hash of the table of the message (see RawMessageReader).
+        /// \param fingerprint The QuerySet fingerprint.
+        static std::string makeKey(const std::vector<unsigned char>& message,
+                                   uint64_t tableHash,
+                                   uint64_t fingerprint);
+
+        /// \brief Look up a message.
+        /// \param key The message key (see makeKey).
+        /// \param[out] message The cached data.
+        /// \return True if the message was found.
+        bool load(const std::string& key, CachedMessage& message);
+
+        /// \brief Add a message to the cache (evicting old entries if needed).
+        /// \param key The message key (see makeKey).
+        /// \param message The data to cache.
+        void store(const std::string& key, const CachedMessage& message);
+
+        /// \brief Number of hits and misses so far.
+        inline size_t hits() const { return hits_; }
+        inline size_t misses() const { return misses_; }
+
+     private:
+        const std::string directory_;
+        const size_t maxBytes_;
+        size_t currentBytes_ = 0;
+        size_t hits_ = 0;
+        size_t misses_ = 0;
+
+        /// \brief Get the path of the cache file for a key.
+        std::string pathFor(const std::string& key) const;
+
+        /// \brief Remove the least recently used entries until the cache fits in its bound.
+        void evict();
+    };
+}  // namespace bufr
+}  // namespace Ingester
@@ -0,0 +1,30 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include "TaskScheduler.h"
+
+
+namespace Ingester {
+namespace bufr {
+
+    /// \brief Call func(begin, end) for every chunk of grainSize indices in [0, size) on the
+    ///        scheduler of the calling thread (see TaskScheduler::current and
+    ///        TaskScheduler::parallelFor). Calls from inside another parallelFor share its
+    ///        threads, so nested loops don't oversubscribe the node.
+    /// \param size Number of indices.
+    /// \param grainSize Number of indices per chunk.
+    /// \param func Function that processes the indices [begin, end).
+    /// \param numThreads Max number of threads (0 for all the threads of the scheduler).
+    template<typename Func>
+    void parallelFor(size_t size, size_t grainSize, Func func, size_t numThreads = 0)
+    {
+        TaskScheduler::current().parallelFor(size, grainSize, func, numThreads);
+    }
+}  // namespace bufr
+}  // namespace Ingester
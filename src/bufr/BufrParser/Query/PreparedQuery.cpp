@@ -0,0 +1,100 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include "PreparedQuery.h"
+
+#include <string>
+
+#include "MessageCache.h"
+#include "QueryRunner.h"
+
+
+namespace
+{
+    const uint64_t FnvOffset = 14695981039346656037ULL;
+    const uint64_t FnvPrime = 1099511628211ULL;
+
+    template<typename T>
+    uint64_t fnv1a(const T& value, uint64_t hash)
+    {
+        const auto data = reinterpret_cast<const unsigned char*>(&value);
+        for (size_t idx = 0; idx < sizeof(T); ++idx)
+        {
+            hash ^= data[idx];
+            hash *= FnvPrime;
+        }
+
+        return hash;
+    }
+
+    uint64_t fnv1a(const std::string& str, uint64_t hash)
+    {
+        for (const auto character : str)
+        {
+            hash ^= static_cast<unsigned char>(character);
+            hash *= FnvPrime;
+        }
+
+        // Terminate the string so consecutive strings can't run into each other.
+        return fnv1a<unsigned char>(0, hash);
+    }
+}  // namespace
+
+
+namespace Ingester {
+namespace bufr {
+
+    PreparedQuery::PreparedQuery(const QuerySet& querySet) :
+        querySet_(querySet),
+        messageCacheFingerprint_(MessageCache::fingerprint(querySet))
+    {
+    }
+
+    size_t PreparedQuery::numPlans() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return plans_.size();
+    }
+
+    uint64_t PreparedQuery::tableFingerprint(const DataProvider& dataProvider)
+    {
+        const auto subsetVariant = dataProvider.getSubsetVariant();
+        const auto inode = dataProvider.getInode();
+
+        uint64_t hash = fnv1a(subsetVariant.subset, FnvOffset);
+        hash = fnv1a(subsetVariant.variantId, hash);
+        hash = fnv1a(inode, hash);
+
+        const auto lastNode = dataProvider.getIsc(inode);
+        for (auto nodeIdx = inode; nodeIdx <= lastNode; ++nodeIdx)
+        {
+            hash = fnv1a(dataProvider.getTyp(nodeIdx), hash);
+            hash = fnv1a(dataProvider.getItp(nodeIdx), hash);
+            hash = fnv1a(dataProvider.getJmpb(nodeIdx), hash);
+            hash = fnv1a(dataProvider.getLink(nodeIdx), hash);
+            hash = fnv1a(dataProvider.getTag(nodeIdx), hash);
+        }
+
+        return hash;
+    }
+
+    std::shared_ptr<__details::SubsetPlan>
+        PreparedQuery::findPlan(uint64_t tableFingerprint) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto planIt = plans_.find(tableFingerprint);
+        return planIt == plans_.end() ? nullptr : planIt->second;
+    }
+
+    void PreparedQuery::storePlan(uint64_t tableFingerprint,
+                                  const std::shared_ptr<__details::SubsetPlan>& plan) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        plans_[tableFingerprint] = plan;
+    }
+}  // namespace bufr
+}  // namespace Ingester
@@ -0,0 +1,69 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+
+#include "QuerySet.h"
+#include "DataProvider/DataProvider.h"
+
+
+namespace Ingester {
+namespace bufr {
+    namespace __details
+    {
+        struct SubsetPlan;
+    }  // namespace __details
+
+    /// \brief A QuerySet prepared once so it can be executed against many BUFR files (see
+    ///        File::execute). The plans (targets and processing masks) resolved for each subset
+    ///        variant are kept and keyed by a fingerprint of the variant's BUFR table, so files
+    ///        that share their tables skip building the subset table and resolving the queries.
+    ///        Safe to share between threads.
+    class PreparedQuery
+    {
+     public:
+        PreparedQuery() = delete;
+
+        /// \brief Constructor.
+        /// \param querySet The queries to prepare (copied).
+        explicit PreparedQuery(const QuerySet& querySet);
+
+        /// \brief The prepared queries.
+        inline const QuerySet& querySet() const { return querySet_; }
+
+        /// \brief The MessageCache fingerprint of the queries.
+        inline uint64_t messageCacheFingerprint() const { return messageCacheFingerprint_; }
+
+        /// \brief Number of plans resolved so far (one per distinct subset table).
+        size_t numPlans() const;
+
+        /// \brief Fingerprint of the BUFR table of the subset variant that is currently open in
+        ///        the data provider (subset name, variant and the structure of its table nodes).
+        static uint64_t tableFingerprint(const DataProvider& dataProvider);
+
+        /// \brief Get the plan stored for a table fingerprint.
+        /// \return The plan or nullptr if there is none.
+        std::shared_ptr<__details::SubsetPlan> findPlan(uint64_t tableFingerprint) const;
+
+        /// \brief Store (or replace) the plan for a table fingerprint.
+        void storePlan(uint64_t tableFingerprint,
+                       const std::shared_ptr<__details::SubsetPlan>& plan) const;
+
+     private:
+        const QuerySet querySet_;
+        const uint64_t messageCacheFingerprint_;
+
+        mutable std::mutex mutex_;
+        mutable std::unordered_map<uint64_t, std::shared_ptr<__details::SubsetPlan>> plans_;
+    };
+}  // namespace bufr
+}  // namespace Ingester
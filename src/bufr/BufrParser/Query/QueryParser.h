@@ -16,12 +16,51 @@
 namespace Ingester {
 namespace bufr {
 
+    /// \brief Picks one element of each repeat of a sequence (ex: one event of a prepbufr event
+    ///        stack) so only the values of that element are collected.
+    struct Selector
+    {
+        enum class Type
+        {
+            None,
+            First,  ///< The first element (the latest event in prepbufr stacks)
+            Last,   ///< The last element (the earliest event in prepbufr stacks)
+            Code    ///< The first element whose mnemonic has the code (ex: TPC=1)
+        };
+
+        Type type = Type::None;
+        std::string mnemonic;
+        int code = 0;
+
+        /// \brief Is there no selector?
+        bool empty() const { return type == Type::None; }
+
+        /// \brief The selector as it appears in a query string (ex: '{last}').
+        std::string str() const
+        {
+            switch (type)
+            {
+                case Type::First: return "{first}";
+                case Type::Last: return "{last}";
+                case Type::Code: return "{" + mnemonic + "=" + std::to_string(code) + "}";
+                default: return "";
+            }
+        }
+    };
+
+    /// \brief == operator for Selector.
+    inline bool operator==(const Selector& lhs, const Selector& rhs)
+    {
+        return lhs.type == rhs.type && lhs.mnemonic == rhs.mnemonic && lhs.code == rhs.code;
+    }
+
     /// \brief A component of a query string. Abstract base class.
     struct QueryComponent
     {
         std::string name;
         size_t index = 0;
         std::vector<size_t> filter;
+        Selector selector;
 
         virtual ~QueryComponent() = default;
     };
@@ -102,6 +141,24 @@ namespace bufr {
                 {
                     component->filter = filterToken->indices();
                 }
+                else if (auto selectorToken = std::dynamic_pointer_cast<SelectorToken>(token))
+                {
+                    auto& selector = component->selector;
+                    if (selectorToken->name() == "first")
+                    {
+                        selector.type = Selector::Type::First;
+                    }
+                    else if (selectorToken->name() == "last")
+                    {
+                        selector.type = Selector::Type::Last;
+                    }
+                    else
+                    {
+                        selector.type = Selector::Type::Code;
+                        selector.mnemonic = selectorToken->name();
+                        selector.code = selectorToken->code();
+                    }
+                }
             }
 
             return component;
@@ -113,7 +170,8 @@ namespace bufr {
     /// \param rhs The right hand side of the operator.
     inline bool operator==(const PathComponent& lhs, const PathComponent& rhs)
     {
-        return lhs.name == rhs.name && lhs.index == rhs.index && lhs.filter == rhs.filter;
+        return lhs.name == rhs.name && lhs.index == rhs.index && lhs.filter == rhs.filter &&
+               lhs.selector == rhs.selector;
     }
 
     /// \brief A query. Contains the components that make up a query.
@@ -167,6 +225,9 @@ namespace bufr {
                         }
                         pathStr << "}";
                     }
+
+                    // Add selector string
+                    pathStr << pathComponent->selector.str();
                 }
                 else
                 {
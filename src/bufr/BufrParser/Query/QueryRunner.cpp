@@ -6,6 +6,7 @@
  */
 #include "QueryRunner.h"
 
+#include <algorithm>
 #include <string>
 #include <iostream>
 #include <memory>
@@ -30,33 +31,135 @@ namespace bufr
 
     QueryRunner::QueryRunner(const QuerySet &querySet,
                              ResultSet &resultSet,
-                             const DataProviderType &dataProvider) :
+                             const DataProviderType &dataProvider,
+                             const PreparedQuery* preparedQuery) :
         querySet_(querySet),
         resultSet_(resultSet),
-        dataProvider_(dataProvider)
+        dataProvider_(dataProvider),
+        preparedQuery_(preparedQuery)
     {
     }
 
     void QueryRunner::accumulate()
     {
-        Targets targets;
-        std::shared_ptr<__details::ProcessingMasks> masks;
+        // The plan only needs to change when the subset variant does (normally once per message).
+        const auto handle = dataProvider_->getSubsetVariantHandle();
+        if (plan_ == nullptr || handle != planHandle_)
+        {
+            bindPlan(handle);
+        }
 
-        findTargets(targets, masks);
-        collectData(targets, masks, resultSet_);
+        collectData(plan_->targets, plan_->masks, resultSet_);
     }
 
-    void QueryRunner::findTargets(Targets &targets,
-                                  std::shared_ptr<__details::ProcessingMasks> &masks)
+    void QueryRunner::accumulateCached(CachedMessage& message)
     {
-        // Check if the target list for this subset is cached
-        if (targetCache_.find(dataProvider_->getSubsetVariant()) != targetCache_.end())
+        const auto handle = dataProvider_->getSubsetVariantHandle();
+        if (plan_ == nullptr || handle != planHandle_)
         {
-            targets = targetCache_.at(dataProvider_->getSubsetVariant());
-            masks = maskCache_.at(dataProvider_->getSubsetVariant());
-            return;
+            bindPlan(handle);
+        }
+
+        for (auto& cachedFrame : message)
+        {
+            auto& dataFrame = resultSet_.nextDataFrame();
+            for (size_t fieldIdx = 0; fieldIdx < cachedFrame.size(); ++fieldIdx)
+            {
+                auto& dataField = dataFrame.fieldAtIdx(fieldIdx);
+                dataField.target = plan_->targets[fieldIdx];
+                dataField.data = std::move(cachedFrame[fieldIdx].data);
+                dataField.seqCounts = std::move(cachedFrame[fieldIdx].seqCounts);
+            }
+        }
+    }
+
+    void QueryRunner::bindPlan(SubsetVariantHandle handle)
+    {
+        if (handle >= plans_.size())
+        {
+            plans_.resize(handle + 1);
+        }
+
+        if (plans_[handle] == nullptr)
+        {
+            if (preparedQuery_ != nullptr)
+            {
+                // Reuse the plan of another file (or job) that had the same table.
+                const auto fingerprint = PreparedQuery::tableFingerprint(*dataProvider_);
+                auto plan = preparedQuery_->findPlan(fingerprint);
+                if (plan == nullptr || !typesMatch(*plan))
+                {
+                    plan = findTargets();
+                    markTypesChecked(*plan);
+                    preparedQuery_->storePlan(fingerprint, plan);
+                }
+
+                plans_[handle] = plan;
+            }
+            else
+            {
+                plans_[handle] = findTargets();
+            }
         }
 
+        plan_ = plans_[handle];
+        planHandle_ = handle;
+    }
+
+    bool QueryRunner::typesMatch(__details::SubsetPlan& plan) const
+    {
+        const auto tableData = dataProvider_->getCurrentTableData();
+        {
+            std::lock_guard<std::mutex> lock(plan.mutex);
+            for (const auto& checkedTable : plan.typeCheckedTables)
+            {
+                if (checkedTable.lock() == tableData) return true;
+            }
+        }
+
+        for (const auto& target : plan.targets)
+        {
+            if (target->nodeIdx == 0) continue;
+
+            const auto typeInfo = dataProvider_->getTypeInfo(target->nodeIdx);
+            if (typeInfo.scale != target->typeInfo.scale ||
+                typeInfo.reference != target->typeInfo.reference ||
+                typeInfo.bits != target->typeInfo.bits ||
+                typeInfo.unit != target->typeInfo.unit)
+            {
+                return false;
+            }
+        }
+
+        markTypesChecked(plan);
+        return true;
+    }
+
+    void QueryRunner::markTypesChecked(__details::SubsetPlan& plan) const
+    {
+        std::lock_guard<std::mutex> lock(plan.mutex);
+
+        // Forget the tables of the files that are gone.
+        auto& tables = plan.typeCheckedTables;
+        tables.erase(std::remove_if(tables.begin(),
+                                    tables.end(),
+                                    [](const std::weak_ptr<const TableData>& table)
+                                    {
+                                        return table.expired();
+                                    }),
+                     tables.end());
+
+        tables.push_back(dataProvider_->getCurrentTableData());
+    }
+
+    std::shared_ptr<__details::SubsetPlan> QueryRunner::findTargets() const
+    {
+        auto plan = std::make_shared<__details::SubsetPlan>();
+        auto& targets = plan->targets;
+        auto& masks = plan->masks;
+
+        const auto subsetVariant = dataProvider_->getSubsetVariant();
+
         masks = std::make_shared<__details::ProcessingMasks>();
         {  // Initialize Masks
             size_t numNodes = dataProvider_->getIsc(dataProvider_->getInode());
@@ -75,8 +178,8 @@ namespace bufr
             for (const auto &query : querySet_.queriesFor(name))
             {
                 if (query.subset->isAnySubset ||
-                    (query.subset->name == dataProvider_->getSubsetVariant().subset &&
-                     query.subset->index == dataProvider_->getSubsetVariant().variantId))
+                    (query.subset->name == subsetVariant.subset &&
+                     query.subset->index == subsetVariant.variantId))
                 {
                     tableNode = table.getNodeForPath(query.path);
                     foundQuery = query;
@@ -104,7 +207,7 @@ namespace bufr
                 oops::Log::warning() << "Warning: Query String ";
                 oops::Log::warning() << querySet_.queriesFor(name)[0].str();
                 oops::Log::warning() << " didn't apply to subset ";
-                oops::Log::warning() << dataProvider_->getSubsetVariant().str();
+                oops::Log::warning() << subsetVariant.str();
                 oops::Log::warning() << std::endl;
 #endif
 
@@ -112,7 +215,7 @@ namespace bufr
                 std::cout << "Warning: Query String ";
                 std::cout << querySet_.queriesFor(name)[0].str();
                 std::cout << " didn't apply to subset ";
-                std::cout << dataProvider_->getSubsetVariant().str();
+                std::cout << subsetVariant.str();
                 std::cout << std::endl;
 #endif
 
@@ -145,6 +248,42 @@ namespace bufr
             target->typeInfo = tableNode->typeInfo;
             target->nodeIdx = tableNode->nodeIdx;
 
+            // Selectors pick one element of the innermost repeat, codes need the mnemonic values
+            for (size_t componentIdx = 1; componentIdx < path.size(); componentIdx++)
+            {
+                const auto& selector = path[componentIdx].queryComponent->selector;
+                if (selector.empty()) continue;
+
+                if (path[componentIdx].type != TargetComponent::Type::Repeat ||
+                    path[componentIdx].branch != static_cast<size_t>(target->seqPath.back()) ||
+                    !path[componentIdx].queryComponent->filter.empty())
+                {
+                    throw eckit::BadParameter("QueryRunner::findTargets: The selector " +
+                                              selector.str() + " in query " + foundQuery.str() +
+                                              " must be on the innermost repeated sequence.");
+                }
+
+                if (selector.type == Selector::Type::Code)
+                {
+                    auto codePath = std::vector<std::shared_ptr<PathComponent>>(
+                        foundQuery.path.begin(), foundQuery.path.begin() + componentIdx);
+                    codePath.push_back(std::make_shared<PathComponent>());
+                    codePath.back()->name = selector.mnemonic;
+
+                    auto codeNode = table.getNodeForPath(codePath);
+                    if (codeNode == nullptr || codeNode->type != Typ::Number)
+                    {
+                        throw eckit::BadParameter("QueryRunner::findTargets: The selector " +
+                                                  selector.str() + " in query " +
+                                                  foundQuery.str() + " needs a numeric " +
+                                                  selector.mnemonic + " in the sequence.");
+                    }
+
+                    target->selectorNodeIdx = codeNode->nodeIdx;
+                    masks->valueNodeMask[codeNode->nodeIdx] = true;
+                }
+            }
+
             targets.push_back(target);
 
             // Set the mask
@@ -155,9 +294,7 @@ namespace bufr
             }
         }
 
-        // Cache the targets and masks we just found
-        targetCache_.insert({dataProvider_->getSubsetVariant(), targets});
-        maskCache_.insert({dataProvider_->getSubsetVariant(), masks});
+        return plan;
     }
 
     bool QueryRunner::isQueryNode(int nodeIdx) const
@@ -168,8 +305,8 @@ namespace bufr
                 dataProvider_->getTyp(nodeIdx) == Typ::DelayedBinary);
     }
 
-    void QueryRunner::collectData(Targets &targets,
-                                  std::shared_ptr<__details::ProcessingMasks> masks,
+    void QueryRunner::collectData(const Targets &targets,
+                                  const std::shared_ptr<__details::ProcessingMasks> &masks,
                                   ResultSet &resultSet) const
     {
         std::vector<int> currentPath;
@@ -302,44 +439,38 @@ namespace bufr
             {
                 dataField.seqCounts.resize(targ->seqPath.size() + 1);
                 dataField.seqCounts[0] = {1};
-                SeqCounts counts;
 
                 bool hasFilter = false;
                 std::vector<std::vector<size_t>> filters;
+                std::vector<std::vector<size_t>> selections;
                 for (size_t pathIdx = 0; pathIdx < targ->seqPath.size(); pathIdx++)
                 {
                     auto& pathComponent = targ->path[pathIdx + 1];
                     auto& filter = pathComponent.queryComponent->filter;
-                    if (filter.empty())
+                    auto& selector = pathComponent.queryComponent->selector;
+                    dataField.seqCounts[pathIdx + 1] = dataTable[targ->seqPath[pathIdx] + 1].counts;
+
+                    if (filter.empty() && selector.empty()) continue;
+
+                    // Delay the creation of the filters until we know we need them in order to
+                    // avoid unnecessary allocations
+                    if (filters.empty())
+                    {
+                        filters = std::vector<std::vector<size_t>>(targ->seqPath.size() + 1);
+                        selections = std::vector<std::vector<size_t>>(targ->seqPath.size() + 1);
+                    }
+
+                    hasFilter = true;
+                    if (!selector.empty())
                     {
-                        dataField.seqCounts[pathIdx + 1] =
-                            dataTable[targ->seqPath[pathIdx] + 1].counts;
+                        selections[pathIdx + 1] = makeSelection(dataField.seqCounts[pathIdx + 1],
+                                                                selector,
+                                                                dataTable[targ->selectorNodeIdx]
+                                                                    .values);
                     }
                     else
                     {
-                        // Delay the creation of the counts and filters until we know we need them
-                        // in order to avoid unnecessary allocations
-                        if (counts.empty())
-                            counts = SeqCounts(
-                                std::vector<std::vector<int>>(targ->seqPath.size() + 1, {1}));
-
-                        if (filters.empty())
-                            filters = std::vector<std::vector<size_t>>(targ->seqPath.size() + 1);
-
                         filters[pathIdx + 1] = filter;
-                        hasFilter = true;
-
-                        auto filteredCounts =
-                          std::vector<int>(dataTable[targ->seqPath[pathIdx] + 1].counts.size(), 1);
-
-                        for (size_t countIdx = 0; countIdx < filteredCounts.size(); countIdx++)
-                        {
-                            filteredCounts[countIdx] =
-                                std::max(static_cast<int>(filter.size()), filteredCounts[countIdx]);
-                        }
-
-                        dataField.seqCounts[pathIdx + 1] = filteredCounts;
-                        counts[pathIdx + 1] = dataTable[targ->seqPath[pathIdx] + 1].counts;
                     }
                 }
 
@@ -349,24 +480,79 @@ namespace bufr
                 }
                 else
                 {
+                    // The counts of every layer are walked together, so filters and selectors on
+                    // several layers only visit the elements of the repeats they belong to.
+                    const auto origCounts = dataField.seqCounts;
                     dataField.data = makeFilteredData(dataTable[targ->nodeIdx].values,
-                                                      counts,
-                                                      filters);
+                                                      origCounts,
+                                                      filters,
+                                                      selections,
+                                                      dataField.seqCounts);
                 }
             }
         }
     }
 
+    std::vector<size_t> QueryRunner::makeSelection(const std::vector<int>& counts,
+                                                   const Selector& selector,
+                                                   const std::vector<double>& codes) const
+    {
+        auto selection = std::vector<size_t>(counts.size(), 0);
+
+        size_t offset = 0;
+        for (size_t countIdx = 0; countIdx < counts.size(); countIdx++)
+        {
+            const auto count = static_cast<size_t>(std::max(counts[countIdx], 0));
+            if (count == 0) continue;
+
+            if (selector.type == Selector::Type::First)
+            {
+                selection[countIdx] = 1;
+            }
+            else if (selector.type == Selector::Type::Last)
+            {
+                selection[countIdx] = count;
+            }
+            else
+            {
+                for (size_t elementIdx = 0;
+                     elementIdx < count && offset + elementIdx < codes.size();
+                     elementIdx++)
+                {
+                    if (codes[offset + elementIdx] == selector.code)
+                    {
+                        selection[countIdx] = elementIdx + 1;
+                        break;
+                    }
+                }
+            }
+
+            offset += count;
+        }
+
+        return selection;
+    }
+
     std::vector<double> QueryRunner::makeFilteredData(
-                                            const std::vector<double>& srcData,
-                                            const SeqCounts& origCounts,
-                                            const std::vector<std::vector<size_t>>& filter) const
+                                    const std::vector<double>& srcData,
+                                    const SeqCounts& origCounts,
+                                    const std::vector<std::vector<size_t>>& filter,
+                                    const std::vector<std::vector<size_t>>& selections,
+                                    SeqCounts& filteredCounts) const
     {
         auto data = std::vector<double>();
-        data.reserve(sum(origCounts.back()));
+        data.reserve(srcData.size());
+
+        filteredCounts = SeqCounts(std::vector<std::vector<int>>(origCounts.size()));
+        filteredCounts[0] = {1};
 
         size_t offset = 0;
-        _makeFilteredData(srcData, origCounts, filter, data, offset, 0);
+        auto cursors = std::vector<size_t>(origCounts.size(), 0);
+        while (cursors[1] < origCounts[1].size())
+        {
+            _makeFilteredData(srcData, origCounts, filter, selections, data, filteredCounts,
+                              offset, cursors, 1, false);
+        }
 
         return data;
     }
@@ -374,8 +560,11 @@ namespace bufr
     void QueryRunner::_makeFilteredData(const std::vector<double>& srcData,
                                         const SeqCounts& origCounts,
                                         const std::vector<std::vector<size_t>> &filters,
+                                        const std::vector<std::vector<size_t>> &selections,
                                         std::vector<double>& data,
+                                        SeqCounts& filteredCounts,
                                         size_t& offset,
+                                        std::vector<size_t>& cursors,
                                         size_t depth,
                                         bool skipResult) const
     {
@@ -387,34 +576,61 @@ namespace bufr
             return;
         }
 
-        auto& layerCounts = origCounts[depth];
+        // Each call is one element of the parent layer, so it only walks the count of the repeat
+        // that belongs to that element.
+        const auto countIdx = cursors[depth]++;
+        const auto count = countIdx < origCounts[depth].size() ?
+            static_cast<size_t>(std::max(origCounts[depth][countIdx], 0)) : 0;
         auto& layerFilter = filters[depth];
+        auto& layerSelection = selections[depth];
 
-        if (layerFilter.empty())
+        if (!layerSelection.empty())
         {
-            for (size_t countIdx = 0; countIdx < layerCounts.size(); countIdx++)
+            // One element per repeat, a missing value when no element was selected (the selector
+            // is always on the innermost repeat so the missing value is a single value).
+            if (!skipResult)
             {
-                _makeFilteredData(srcData, origCounts, filters, data,
-                                  offset, depth + 1, skipResult);
+                filteredCounts[depth].push_back(1);
+                if (layerSelection[countIdx] == 0) data.push_back(MissingValue);
+            }
+
+            for (size_t elementIdx = 1; elementIdx <= count; elementIdx++)
+            {
+                _makeFilteredData(srcData, origCounts, filters, selections, data, filteredCounts,
+                                  offset, cursors, depth + 1,
+                                  skipResult || elementIdx != layerSelection[countIdx]);
+            }
+        }
+        else if (layerFilter.empty())
+        {
+            if (!skipResult) filteredCounts[depth].push_back(static_cast<int>(count));
+
+            for (size_t elementIdx = 1; elementIdx <= count; elementIdx++)
+            {
+                _makeFilteredData(srcData, origCounts, filters, selections, data, filteredCounts,
+                                  offset, cursors, depth + 1, skipResult);
             }
         }
         else
         {
-            for (size_t countIdx = 0; countIdx < layerCounts.size(); countIdx++)
+            if (!skipResult)
             {
-                for (size_t count = 1; count <= static_cast<size_t>(layerCounts[countIdx]); count++)
-                {
-                    bool skip = skipResult;
+                filteredCounts[depth].push_back(std::max(static_cast<int>(layerFilter.size()), 1));
+            }
 
-                    if (!skip)
-                    {
-                        skip = std::find(layerFilter.begin(),
-                                         layerFilter.end(),
-                                         count) == layerFilter.end();
-                    }
+            for (size_t elementIdx = 1; elementIdx <= count; elementIdx++)
+            {
+                bool skip = skipResult;
 
-                    _makeFilteredData(srcData, origCounts, filters, data, offset, depth + 1, skip);
+                if (!skip)
+                {
+                    skip = std::find(layerFilter.begin(),
+                                     layerFilter.end(),
+                                     elementIdx) == layerFilter.end();
                 }
+
+                _makeFilteredData(srcData, origCounts, filters, selections, data, filteredCounts,
+                                  offset, cursors, depth + 1, skip);
             }
         }
     }
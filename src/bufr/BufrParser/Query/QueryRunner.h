@@ -7,11 +7,15 @@
 
 #pragma once
 
+#include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include <vector>
 #include <array>
 #include <unordered_map>
 
+#include "MessageCache.h"
+#include "PreparedQuery.h"
 #include "QuerySet.h"
 #include "ResultSet.h"
 #include "DataProvider/DataProvider.h"
@@ -49,6 +53,18 @@ namespace bufr {
             std::vector<bool> valueNodeMask;
             std::vector<bool> pathNodeMask;
         };
+
+        /// \brief The targets and processing masks resolved for a subset variant.
+        struct SubsetPlan {
+            Targets targets;
+            std::shared_ptr<ProcessingMasks> masks;
+
+            /// \brief The tables the type info of the targets is known to match, so a plan that
+            /// is reused against one of them (ex: by every execute on a file) isn't checked again.
+            /// Guarded by the mutex as the plans of a PreparedQuery are shared between threads.
+            std::vector<std::weak_ptr<const TableData>> typeCheckedTables;
+            std::mutex mutex;
+        };
     }  // namespace __details
 
     /// \brief Manages the execution of queries against on a BUFR file.
@@ -59,28 +75,57 @@ namespace bufr {
         /// \param[in] querySet The set of queries to execute against the BUFR file.
         /// \param[in, out] resultSet The object used to store the accumulated collected data.
         /// \param[in] dataProvider The BUFR data provider to use.
+        /// \param[in] preparedQuery Optional prepared query whose plans are reused (and extended)
+        ///                          for subset variants with a known table.
         QueryRunner(const QuerySet& querySet,
                     ResultSet& resultSet,
-                    const DataProviderType& dataProvider);
+                    const DataProviderType& dataProvider,
+                    const PreparedQuery* preparedQuery = nullptr);
         void accumulate();
 
+        /// \brief Add the data of a whole message that was collected before (see MessageCache)
+        ///        instead of collecting it from the subsets. The data is moved out of message.
+        /// \param[in, out] message The collected data of each subset of the message.
+        void accumulateCached(CachedMessage& message);
+
      private:
-        const QuerySet querySet_;
+        const QuerySet& querySet_;
         ResultSet& resultSet_;
         const DataProviderType& dataProvider_;
+        const PreparedQuery* preparedQuery_;
+
+        /// \brief Plans indexed by the subset variant handle (see DataProvider).
+        std::vector<std::shared_ptr<__details::SubsetPlan>> plans_;
+
+        /// \brief The plan bound to the current message (and the handle it was bound for).
+        std::shared_ptr<__details::SubsetPlan> plan_;
+        SubsetVariantHandle planHandle_ = 0;
 
-        std::unordered_map<SubsetVariant, Targets> targetCache_;
-        std::unordered_map<SubsetVariant, std::shared_ptr<__details::ProcessingMasks>> maskCache_;
-        std::unordered_map<SubsetVariant, std::unordered_map<std::string, std::string>> unitCache_;
+
+        /// \brief Bind the plan for the subset variant (finds the targets the first time the
+        /// variant is seen).
+        /// \param[in] handle The subset variant handle.
+        void bindPlan(SubsetVariantHandle handle);
+
+
+        /// \brief Does the type info of the plan's targets match the current table? Guards plans
+        /// reused from the prepared query against tables that only differ in scale, reference or
+        /// bit width. The type info is only read (getTypeInfo) the first time a plan meets a
+        /// table, the tables that match are cached in the plan.
+        /// \param[in, out] plan The plan to check.
+        bool typesMatch(__details::SubsetPlan& plan) const;
+
+
+        /// \brief Record that the type info of the plan's targets matches the current table.
+        /// \param[in, out] plan The plan.
+        void markTypesChecked(__details::SubsetPlan& plan) const;
 
 
         /// \brief Look for the list of targets for the currently active BUFR message subset that
-        /// apply to the QuerySet and cache them. Processing mask information is also collected in
-        /// order to make the data collection more efficient.
-        /// \param[in, out] targets The list of targets to populate.
-        /// \param[in, out] masks The processing masks to populate.
-        void findTargets(Targets& targets,
-                         std::shared_ptr<__details::ProcessingMasks>& masks);
+        /// apply to the QuerySet. Processing mask information is also collected in order to make
+        /// the data collection more efficient.
+        /// \return The plan (targets and processing masks) for the subset variant.
+        std::shared_ptr<__details::SubsetPlan> findTargets() const;
 
 
         /// \brief Does the node idx correspond to an element you'd find in a query string (repeat
@@ -93,37 +138,56 @@ namespace bufr {
         /// \param[in] targets The list of targets to collect for this subset.
         /// \param[in] masks The processing masks to use.
         /// \param[in, out] resultSet The object used to store the accumulated collected data.
-        void collectData(Targets& targets,
-                         std::shared_ptr<__details::ProcessingMasks> masks,
+        void collectData(const Targets& targets,
+                         const std::shared_ptr<__details::ProcessingMasks>& masks,
                          ResultSet& resultSet) const;
 
 
+        /// \brief Find the element each repeat of a sequence selects.
+        /// \param[in] counts The number of elements of each repeat.
+        /// \param[in] selector The selector.
+        /// \param[in] codes The values of the selector mnemonic (one per element, code selectors).
+        /// \return The (1 based) index of the selected element of each repeat (0 for none).
+        std::vector<size_t> makeSelection(const std::vector<int>& counts,
+                                          const Selector& selector,
+                                          const std::vector<double>& codes) const;
+
         /// \brief Given data counts and a filter specification this function creates the resulting
         ///        data vector.
         /// \param[in] srcData The source data vector.
         /// \param[in] origCounts The original data counts.
         /// \param[in] filter The filter specification.
+        /// \param[in] selections The selected element of each repeat (see makeSelection) for the
+        ///                       layers with a selector.
+        /// \param[out] filteredCounts The counts of the resulting data.
         /// \return The resulting data vector after the filter is applied.
         std::vector<double> makeFilteredData(const std::vector<double>& srcData,
                                              const SeqCounts &origCounts,
-                                             const std::vector<std::vector<size_t>> &filter)
-                                                  const;
+                                             const std::vector<std::vector<size_t>> &filter,
+                                             const std::vector<std::vector<size_t>> &selections,
+                                             SeqCounts& filteredCounts) const;
 
         /// \brief Recursive function that does the actual work of creating the filtered data
         ///        vector.
         /// \param[in] srcData The source data vector.
         /// \param[in] origCounts The original data counts.
         /// \param[in] filters The filter specification.
+        /// \param[in] selections The selected element of each repeat for selector layers.
         /// \param[in, out] data The resulting data vector.
+        /// \param[in, out] filteredCounts The counts of the resulting data.
         /// \param[in, out] offset The current offset into the resulting data vector.
+        /// \param[in, out] cursors The next count of each layer (one count per parent element).
         /// \param[in] depth The current depth of the recursion.
         /// \param[in] skipResult If true, the result of the current recursion is not stored in the
         ///                       resulting data vector. This data is being filtered out.
         void _makeFilteredData(const std::vector<double>& srcData,
                                const SeqCounts& origCounts,
                                const std::vector<std::vector<size_t>>& filters,
+                               const std::vector<std::vector<size_t>>& selections,
                                std::vector<double>& data,
+                               SeqCounts& filteredCounts,
                                size_t& offset,
+                               std::vector<size_t>& cursors,
                                size_t depth,
                                bool skipResult = false) const;
     };
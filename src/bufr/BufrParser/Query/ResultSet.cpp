@@ -8,8 +8,10 @@
 #include "ResultSet.h"
 
 #include "eckit/exception/Exceptions.h"
+#include "oops/util/Logger.h"
 
 #include <algorithm>
+#include <limits>
 #include <string>
 #include <iostream>
 
@@ -23,11 +25,15 @@
 #endif
 
 #include "Constants.h"
+#include "ParallelFor.h"
 #include "VectorMath.h"
 
 
 namespace Ingester {
 namespace bufr {
+    // Frames per parallel task when materializing a field (small so jagged frames balance)
+    static const size_t FramesPerTask = 64;
+
     ResultSet::ResultSet(const std::vector<std::string>& names) :
       names_(names)
     {
@@ -129,8 +135,17 @@ namespace bufr {
 
             auto array = py::array(py::dtype("datetime64[s]"), yearObj->getDims(), strides);
             auto arrayPtr = static_cast<int64_t*>(array.mutable_data());
+            std::fill(arrayPtr, arrayPtr + yearObj->size(), 0);
+
+            // A datetime is valid if all of its components are valid
+            auto validity = yearObj->getValidity();
+            validity &= monthObj->getValidity();
+            validity &= dayObj->getValidity();
+            validity &= hourObj->getValidity();
+            if (minuteObj) validity &= minuteObj->getValidity();
+            if (secondObj) validity &= secondObj->getValidity();
 
-            for (size_t i = 0; i < yearObj->size(); ++i)
+            validity.forEachValid([&](size_t i)
             {
                 std::tm time;
                 time.tm_year = yearObj->getAsInt(i) - 1900;
@@ -142,23 +157,13 @@ namespace bufr {
                 time.tm_isdst = 0;
 
                 arrayPtr[i] = static_cast<int64_t>(timegm(&time));
-            }
+            });
 
-            // Create the mask array
             py::object numpyModule = py::module::import("numpy");
 
             // Create the mask array
             py::array_t<bool> mask(yearObj->getDims());
-            bool* maskPtr = static_cast<bool*>(mask.mutable_data());
-            for (size_t idx = 0; idx < yearObj->size(); idx++)
-            {
-                maskPtr[idx] = yearObj->isMissing(idx) |
-                               monthObj->isMissing(idx) |
-                               dayObj->isMissing(idx) |
-                               hourObj->isMissing(idx) |
-                               (minuteObj ? minuteObj->isMissing(idx) : false) |
-                               (secondObj ? secondObj->isMissing(idx) : false);
-            }
+            validity.toMissingFlags(static_cast<bool*>(mask.mutable_data()));
 
             // Create a masked array from the data and mask arrays
             py::array maskedArray = numpyModule.attr("ma").attr("masked_array")(array, mask);
@@ -175,6 +180,25 @@ namespace bufr {
         return dataFrames_.back();
     }
 
+    void ResultSet::trackMemory()
+    {
+        size_t bytes = dataFrames_.capacity() * sizeof(DataFrame);
+        for (const auto& dataFrame : dataFrames_)
+        {
+            for (size_t fieldIdx = 0; fieldIdx < names_.size(); ++fieldIdx)
+            {
+                const auto& dataField = dataFrame.fieldAtIdx(fieldIdx);
+                bytes += sizeof(DataField) + dataField.data.capacity() * sizeof(double);
+                for (const auto& counts : dataField.seqCounts)
+                {
+                    bytes += sizeof(counts) + counts.capacity() * sizeof(int);
+                }
+            }
+        }
+
+        memory_.set(bytes);
+    }
+
     void ResultSet::getRawValues(const std::string& fieldName,
                                  const std::string& groupByField,
                                  std::vector<double>& data,
@@ -219,74 +243,166 @@ namespace bufr {
             }
         }
 
-        auto& targetField = dataFrames_[0].fieldAtIdx(targetFieldIdx);
-        dimPaths = targetField.target->dimPaths;
-        exportDims = targetField.target->exportDimIdxs;
+        // Reduce the dims and type info over the frames. The seq count scans run in parallel on
+        // ranges of frames and the range results are merged in frame order, so the result is the
+        // same as a serial pass. The few rules that depend on the order of the frames are applied
+        // afterwards in a serial pass over the per frame stats.
+        struct FrameStats
+        {
+            size_t targetLevels = 0;
+            size_t groupByLevels = 0;
+            int groupByElements = 1;
+            int scale = 0;
+        };
 
-        for (auto& dataFrame : dataFrames_)
+        struct RangeSummary
         {
-            auto& targetField = dataFrame.fieldAtIdx(targetFieldIdx);
-            if (!targetField.target->dimPaths.empty() &&
-                dimPaths.size() < targetField.target->dimPaths.size())
+            std::vector<int> dimsList;
+            size_t dimPathsFrame = 0;
+            size_t dimPathsSize = 0;
+            int reference = std::numeric_limits<int>::max();
+            int bits = std::numeric_limits<int>::min();
+            size_t unitFrame = std::numeric_limits<size_t>::max();
+        };
+
+        std::vector<FrameStats> frameStats(dataFrames_.size());
+        std::vector<RangeSummary> summaries((dataFrames_.size() + FramesPerTask - 1) /
+                                            FramesPerTask);
+
+        parallelFor(summaries.size(), 1, [&](size_t rangeBegin, size_t rangeEnd)
+        {
+            for (size_t rangeIdx = rangeBegin; rangeIdx < rangeEnd; ++rangeIdx)
             {
-                dimPaths = targetField.target->dimPaths;
-                exportDims = targetField.target->exportDimIdxs;
+                auto& summary = summaries[rangeIdx];
+                const size_t frameEnd = std::min(dataFrames_.size(),
+                                                 (rangeIdx + 1) * FramesPerTask);
+
+                for (size_t frameIdx = rangeIdx * FramesPerTask; frameIdx < frameEnd; ++frameIdx)
+                {
+                    const auto& dataFrame = dataFrames_[frameIdx];
+                    const auto& targetField = dataFrame.fieldAtIdx(targetFieldIdx);
+                    auto& stats = frameStats[frameIdx];
+
+                    stats.targetLevels = targetField.seqCounts.size();
+                    stats.scale = targetField.target->typeInfo.scale;
+
+                    if (summary.dimsList.size() < stats.targetLevels)
+                    {
+                        summary.dimsList.resize(stats.targetLevels, 0);
+                    }
+
+                    for (size_t cntIdx = 0; cntIdx < targetField.seqCounts.size(); ++cntIdx)
+                    {
+                        if (!targetField.seqCounts[cntIdx].empty())
+                        {
+                            summary.dimsList[cntIdx] = std::max(summary.dimsList[cntIdx],
+                                                                max(targetField.seqCounts[cntIdx]));
+                        }
+                    }
+
+                    // The dim paths come from the first frame with the most of them
+                    if (targetField.target->dimPaths.size() > summary.dimPathsSize)
+                    {
+                        summary.dimPathsSize = targetField.target->dimPaths.size();
+                        summary.dimPathsFrame = frameIdx;
+                    }
+
+                    summary.reference = std::min(summary.reference,
+                                                 targetField.target->typeInfo.reference);
+                    summary.bits = std::max(summary.bits, targetField.target->typeInfo.bits);
+
+                    if (summary.unitFrame == std::numeric_limits<size_t>::max() &&
+                        !targetField.target->typeInfo.unit.empty())
+                    {
+                        summary.unitFrame = frameIdx;
+                    }
+
+                    if (groupByField != "")
+                    {
+                        const auto& groupByField = dataFrame.fieldAtIdx(groupByFieldIdx);
+                        stats.groupByLevels = groupByField.seqCounts.size();
+                        for (auto &seqCount : groupByField.seqCounts)
+                        {
+                            if (!seqCount.empty())
+                            {
+                                stats.groupByElements *= max(seqCount);
+                            }
+                        }
+                    }
+                }
             }
+        });
 
-            size_t dimsLen = targetField.seqCounts.size();
-            if (dimsList.size() < dimsLen)
+        size_t dimPathsFrame = 0;
+        size_t dimPathsSize = dataFrames_[0].fieldAtIdx(targetFieldIdx).target->dimPaths.size();
+        for (const auto& summary : summaries)
+        {
+            if (dimsList.size() < summary.dimsList.size())
             {
-                dimsList.resize(dimsLen, 0);
+                dimsList.resize(summary.dimsList.size(), 0);
             }
 
-            for (size_t cntIdx = 0; cntIdx < targetField.seqCounts.size(); ++cntIdx)
+            for (size_t dimIdx = 0; dimIdx < summary.dimsList.size(); ++dimIdx)
             {
-                if (!targetField.seqCounts[cntIdx].empty())
-                {
-                    dimsList[cntIdx] = std::max(dimsList[cntIdx],
-                                                max(targetField.seqCounts[cntIdx]));
-                }
+                dimsList[dimIdx] = std::max(dimsList[dimIdx], summary.dimsList[dimIdx]);
             }
 
-            info.reference = std::min(info.reference, targetField.target->typeInfo.reference);
-            info.bits = std::max(info.bits, targetField.target->typeInfo.bits);
-
-            if (std::abs(targetField.target->typeInfo.scale) > info.scale)
+            if (summary.dimPathsSize > dimPathsSize)
             {
-                info.scale = targetField.target->typeInfo.scale;
+                dimPathsSize = summary.dimPathsSize;
+                dimPathsFrame = summary.dimPathsFrame;
             }
 
-            if (info.unit.empty()) info.unit = targetField.target->typeInfo.unit;
+            info.reference = std::min(info.reference, summary.reference);
+            info.bits = std::max(info.bits, summary.bits);
 
-            if (groupByField != "")
+            if (info.unit.empty() && summary.unitFrame != std::numeric_limits<size_t>::max())
             {
-                auto& groupByField = dataFrame.fieldAtIdx(groupByFieldIdx);
-                groupbyIdx = std::max(groupbyIdx, static_cast<int>(groupByField.seqCounts.size()));
+                info.unit = dataFrames_[summary.unitFrame].fieldAtIdx(targetFieldIdx)
+                                .target->typeInfo.unit;
+            }
+        }
 
-                if (groupbyIdx > static_cast<int>(dimsList.size()))
-                {
-                    dimPaths = {groupByField.target->dimPaths.back()};
+        const auto& dimPathsTarget = dataFrames_[dimPathsFrame].fieldAtIdx(targetFieldIdx).target;
+        dimPaths = dimPathsTarget->dimPaths;
+        exportDims = dimPathsTarget->exportDimIdxs;
 
-                    int groupbyElementsForFrame = 1;
-                    for (auto &seqCount : groupByField.seqCounts)
-                    {
-                        if (!seqCount.empty())
-                        {
-                            groupbyElementsForFrame *= max(seqCount);
-                        }
-                    }
+        size_t targetLevels = 0;
+        for (const auto& stats : frameStats)
+        {
+            targetLevels = std::max(targetLevels, stats.targetLevels);
+
+            if (std::abs(stats.scale) > info.scale)
+            {
+                info.scale = stats.scale;
+            }
 
-                    totalGroupbyElements = std::max(totalGroupbyElements, groupbyElementsForFrame);
+            if (groupByField != "")
+            {
+                groupbyIdx = std::max(groupbyIdx, static_cast<int>(stats.groupByLevels));
+                if (groupbyIdx > static_cast<int>(targetLevels))
+                {
+                    totalGroupbyElements = std::max(totalGroupbyElements, stats.groupByElements);
                 }
-                else
+            }
+        }
+
+        if (groupByField != "")
+        {
+            const auto& groupByTarget = dataFrames_.back().fieldAtIdx(groupByFieldIdx).target;
+            const auto& lastTarget = dataFrames_.back().fieldAtIdx(targetFieldIdx).target;
+            if (groupbyIdx > static_cast<int>(dimsList.size()))
+            {
+                dimPaths = {groupByTarget->dimPaths.back()};
+            }
+            else
+            {
+                dimPaths = {};
+                for (size_t targetIdx = groupByTarget->exportDimIdxs.size() - 1;
+                     targetIdx < lastTarget->dimPaths.size();
+                     ++targetIdx)
                 {
-                    dimPaths = {};
-                    for (size_t targetIdx = groupByField.target->exportDimIdxs.size() - 1;
-                         targetIdx < targetField.target->dimPaths.size();
-                         ++targetIdx)
-                    {
-                        dimPaths.push_back(targetField.target->dimPaths[targetIdx]);
-                    }
+                    dimPaths.push_back(lastTarget->dimPaths[targetIdx]);
                 }
             }
         }
@@ -363,29 +479,34 @@ namespace bufr {
         }
 
         data.resize(totalRows * rowLength, MissingValue);
-        for (size_t frameIdx = 0; frameIdx < dataFrames_.size(); ++frameIdx)
+
+        // Each frame has its own slot of dims[0] rows, so the frames are filled in parallel.
+        const size_t frameElems = dims[0] * rowLength;
+        parallelFor(dataFrames_.size(), FramesPerTask, [&](size_t frameBegin, size_t frameEnd)
         {
-            auto& dataFrame = dataFrames_[frameIdx];
-            std::vector<std::vector<double>> frameData;
-            auto& targetField = dataFrame.fieldAtIdx(targetFieldIdx);
+            for (size_t frameIdx = frameBegin; frameIdx < frameEnd; ++frameIdx)
+            {
+                auto& targetField = dataFrames_[frameIdx].fieldAtIdx(targetFieldIdx);
+                if (targetField.data.empty()) continue;
 
-            if (!targetField.data.empty()) {
+                std::vector<std::vector<double>> frameData;
                 getRowsForField(targetField,
                                 frameData,
                                 allDims,
                                 groupbyIdx);
 
-                auto dataRowIdx = dims[0] * frameIdx;
-                for (size_t rowIdx = 0; rowIdx < frameData.size(); ++rowIdx)
+                // Rows past the slot of the frame only hold missing values, skip them.
+                auto frameOut = data.begin() + frameIdx * frameElems;
+                size_t offset = 0;
+                for (size_t rowIdx = 0; rowIdx < frameData.size() && offset < frameElems; ++rowIdx)
                 {
-                    auto &row = frameData[rowIdx];
-                    for (size_t colIdx = 0; colIdx < row.size(); ++colIdx)
-                    {
-                        data[dataRowIdx*rowLength + rowIdx * row.size() + colIdx] = row[colIdx];
-                    }
+                    const auto& row = frameData[rowIdx];
+                    const size_t numCols = std::min(row.size(), frameElems - offset);
+                    std::copy(row.begin(), row.begin() + numCols, frameOut + offset);
+                    offset += row.size();
                 }
             }
-        }
+        });
 
         // Convert dims per data frame to dims for all the collected data.
         dims[0] = totalRows;
@@ -514,6 +635,10 @@ namespace bufr {
         {
             object = objectByTypeInfo(info);
         }
+        else if (overrideType == NarrowestType)
+        {
+            object = objectByNarrowestType(fieldName, info, data);
+        }
         else
         {
             object = objectByType(overrideType);
@@ -585,6 +710,45 @@ namespace bufr {
         return object;
     }
 
+    std::shared_ptr<DataObjectBase> ResultSet::objectByNarrowestType(
+                                                        const std::string& fieldName,
+                                                        TypeInfo& info,
+                                                        const std::vector<double>& data) const
+    {
+        if (info.isString() || !info.isInteger() || info.integerBytes() > 2)
+        {
+            return objectByTypeInfo(info);
+        }
+
+        // The table meta data can be off (ex: changed data width operators), so make sure the
+        // values really fit (the max value of the type is the missing value).
+        const size_t bytes = info.integerBytes();
+        const double minValue = bytes == 1 ? INT8_MIN : INT16_MIN;
+        const double maxValue = bytes == 1 ? INT8_MAX : INT16_MAX;
+        for (const auto value : data)
+        {
+            if (value != MissingValue && (value < minValue || value >= maxValue))
+            {
+                oops::Log::warning() << "Warning: The values of " << fieldName << " don't fit ";
+                oops::Log::warning() << "in " << 8 * bytes << " bits, keeping the default type.";
+                oops::Log::warning() << std::endl;
+                return objectByTypeInfo(info);
+            }
+        }
+
+        std::shared_ptr<DataObjectBase> object;
+        if (bytes == 1)
+        {
+            object = std::make_shared<DataObject<int8_t>>();
+        }
+        else
+        {
+            object = std::make_shared<DataObject<int16_t>>();
+        }
+
+        return object;
+    }
+
     std::shared_ptr<DataObjectBase> ResultSet::objectByType(const std::string& overrideType) const
     {
         std::shared_ptr<DataObjectBase> object;
@@ -593,6 +757,14 @@ namespace bufr {
         {
             object = std::make_shared<DataObject<int32_t>>();
         }
+        else if (overrideType == "int8")
+        {
+            object = std::make_shared<DataObject<int8_t>>();
+        }
+        else if (overrideType == "int16")
+        {
+            object = std::make_shared<DataObject<int16_t>>();
+        }
         else if (overrideType == "float" || overrideType == "float32")
         {
             object = std::make_shared<DataObject<float>>();
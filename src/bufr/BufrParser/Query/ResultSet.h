@@ -25,6 +25,7 @@
 
 #include "DataProvider/DataProvider.h"
 #include "DataObject.h"
+#include "MemoryTracker.h"
 #include "Target.h"
 
 
@@ -115,7 +116,8 @@ namespace bufr {
         /// \param fieldName The name of the field to get the data for.
         /// \param groupByFieldName The name of the field to group the data by.
         /// \param overrideType The name of the override type to convert the data to. Possible
-        /// values are int, uint, int32, uint32, int64, uint64, float, double
+        /// values are int, uint, int8, int16, int32, uint32, int64, uint64, float, double and
+        /// narrowest (the narrowest integer type that holds the values of integer elements).
         /// \return A Result object containing the data.
         std::shared_ptr<Ingester::DataObjectBase>
         get(const std::string& fieldName,
@@ -128,7 +130,7 @@ namespace bufr {
         /// \param fieldName The name of the field to get the data for.
         /// \param groupByFieldName The name of the field to group the data by.
         /// \param type The name of the type to convert the data to. Possible values are int, uint,
-        /// int32, uint32, int64, uint64, float, double
+        /// int8, int16, int32, uint32, int64, uint64, float, double and narrowest
         py::array getNumpyArray(const std::string& fieldName,
                                 const std::string& groupByFieldName = "",
                                 const std::string& overrideType = "") const;
@@ -155,9 +157,20 @@ namespace bufr {
         /// \return A reference to the new DataFrame.
         DataFrame& nextDataFrame();
 
+        /// \brief Get the number of DataFrames (message subsets) collected so far.
+        inline size_t numFrames() const { return dataFrames_.size(); }
+
+        /// \brief Get the DataFrame at the given index.
+        inline const DataFrame& frameAt(size_t idx) const { return dataFrames_[idx]; }
+
         void setTargets(Targets targets) { targets_ = targets; }
 
+        /// \brief Report the bytes held by the collected data to the MemoryTracker. Called once
+        ///        the data has been collected (the data only grows while collecting).
+        void trackMemory();
+
      private:
+        TrackedBytes memory_{MemoryTracker::Subsystem::ResultSet};
         Targets targets_;
         std::vector<DataFrame> dataFrames_;
         std::vector<std::string> names_;
@@ -199,7 +212,8 @@ namespace bufr {
         /// \param groupByFieldName The name of the field to group the data by.
         /// \param info The meta data for the element.
         /// \param overrideType The name of the override type to convert the data to. Possible
-        /// values are int, uint, int32, uint32, int64, uint64, float, double
+        /// values are int, uint, int8, int16, int32, uint32, int64, uint64, float, double and
+        /// narrowest
         /// \param data The data
         /// \param dims The dimensioning information
         /// \param dimPaths The sub-query path strings for each dimension.
@@ -218,6 +232,17 @@ namespace bufr {
         /// \return A Result DataObject containing the data.
         std::shared_ptr<DataObjectBase> objectByTypeInfo(TypeInfo& info) const;
 
+        /// \brief Make a DataObject with the narrowest integer type (int8, int16 or int32) that
+        /// holds the values of the element (falls back to objectByTypeInfo).
+        /// \param fieldName The name of the field (for the messages).
+        /// \param info The meta data for the element.
+        /// \param data The data (checked against the range of the narrow type).
+        /// \return A Result DataObject containing the data.
+        std::shared_ptr<DataObjectBase> objectByNarrowestType(
+                                                        const std::string& fieldName,
+                                                        TypeInfo& info,
+                                                        const std::vector<double>& data) const;
+
         /// \brief Make an appropriate DataObject for data with the override type
         /// \param overrideType The meta data for the element.
         /// \return A Result DataObject containing the data.
@@ -39,7 +39,8 @@ namespace bufr {
         bool addsDimension() const
         {
             return (type == Type::Subset || type == Type::Repeat) &&
-                   (queryComponent->filter.empty() || queryComponent->filter.size() > 1);
+                   ((queryComponent->filter.empty() && queryComponent->selector.empty()) ||
+                    queryComponent->filter.size() > 1);
         }
 
         /// \brief Sets the TargetComponent type based on the type of the BUFR query node type.
@@ -76,6 +77,7 @@ namespace bufr {
         size_t nodeIdx;
         TargetComponents path;
         size_t numDimensions = 0;
+        size_t selectorNodeIdx = 0;  ///< Node of the mnemonic a code selector matches (0 if none)
 
         std::vector<Query> dimPaths;
         std::vector<int> exportDimIdxs;
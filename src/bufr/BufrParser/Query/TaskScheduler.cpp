@@ -0,0 +1,395 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include "TaskScheduler.h"
+
+#ifdef __linux__
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+#include <chrono>  // NOLINT
+#include <sstream>
+
+#include "eckit/exception/Exceptions.h"
+
+
+namespace
+{
+    namespace AffinityNames
+    {
+        const char* None = "none";
+        const char* Compact = "compact";
+        const char* Scatter = "scatter";
+    }  // namespace AffinityNames
+
+    // How long a thread waiting on a TaskGroup sleeps before it looks for tasks to run again
+    const auto WaitPollInterval = std::chrono::microseconds(500);
+
+    struct ThreadState
+    {
+        /// \brief The scheduler this thread is a worker of (null for other threads)
+        Ingester::bufr::TaskScheduler* scheduler = nullptr;
+
+        /// \brief The queue of the worker
+        size_t queueIdx = 0;
+
+        /// \brief The scheduler bound with the innermost TaskScheduler::Scope
+        Ingester::bufr::TaskScheduler* bound = nullptr;
+    };
+
+    thread_local ThreadState threadState;
+
+    void pinThread(int cpu)
+    {
+#ifdef __linux__
+        if (cpu < 0) return;
+
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(cpu, &cpuSet);
+
+        // Not being able to pin a thread only costs performance
+        pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+#endif
+    }
+}  // namespace
+
+namespace Ingester {
+namespace bufr {
+
+    TaskScheduler::TaskScheduler(const SchedulerOptions& options)
+    {
+        const auto allowed = allowedCpus();
+        for (const auto cpu : options.cpus)
+        {
+            if (std::find(allowed.begin(), allowed.end(), cpu) == allowed.end())
+            {
+                std::ostringstream errStr;
+                errStr << "TaskScheduler: CPU " << cpu << " is not available to this process.";
+                throw eckit::BadParameter(errStr.str());
+            }
+        }
+
+        size_t numThreads = options.numThreads;
+        if (numThreads == 0)
+        {
+            numThreads = options.cpus.empty() ? allowed.size() : options.cpus.size();
+        }
+
+        const size_t numWorkers = std::max<size_t>(1, numThreads) - 1;
+        for (size_t queueIdx = 0; queueIdx <= numWorkers; ++queueIdx)
+        {
+            queues_.push_back(std::make_unique<WorkQueue>());
+        }
+
+        const auto cpus = workerCpus(options, numWorkers);
+        for (size_t workerIdx = 0; workerIdx < numWorkers; ++workerIdx)
+        {
+            workers_.emplace_back(&TaskScheduler::work, this, workerIdx, cpus[workerIdx]);
+        }
+    }
+
+    TaskScheduler::~TaskScheduler()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex_);
+            stop_ = true;
+        }
+
+        wakeUp_.notify_all();
+
+        for (auto& worker : workers_)
+        {
+            worker.join();
+        }
+    }
+
+    TaskScheduler& TaskScheduler::current()
+    {
+        if (threadState.scheduler != nullptr) return *threadState.scheduler;
+        if (threadState.bound != nullptr) return *threadState.bound;
+
+        return *defaultScheduler();
+    }
+
+    std::shared_ptr<TaskScheduler> TaskScheduler::defaultScheduler()
+    {
+        static std::mutex mutex;
+        static std::shared_ptr<TaskScheduler> scheduler;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (scheduler == nullptr)
+        {
+            scheduler = std::make_shared<TaskScheduler>();
+        }
+
+        return scheduler;
+    }
+
+    Affinity TaskScheduler::affinityFromName(const std::string& name)
+    {
+        if (name == AffinityNames::None) return Affinity::None;
+        if (name == AffinityNames::Compact) return Affinity::Compact;
+        if (name == AffinityNames::Scatter) return Affinity::Scatter;
+
+        std::ostringstream errStr;
+        errStr << "TaskScheduler: affinity " << name << " is unknown (use ";
+        errStr << AffinityNames::None << ", " << AffinityNames::Compact << " or ";
+        errStr << AffinityNames::Scatter << ").";
+        throw eckit::BadParameter(errStr.str());
+    }
+
+    std::vector<int> TaskScheduler::parseCpuList(const std::string& cpuList)
+    {
+        std::vector<int> cpus;
+        std::istringstream listStream(cpuList);
+        std::string range;
+        while (std::getline(listStream, range, ','))
+        {
+            std::istringstream rangeStream(range);
+            int first = -1;
+            int last = -1;
+            char dash = '-';
+
+            rangeStream >> first;
+            if (!rangeStream.eof()) rangeStream >> dash >> last;
+            else last = first;
+
+            if (rangeStream.fail() || !rangeStream.eof() || dash != '-' || first < 0 ||
+                last < first)
+            {
+                std::ostringstream errStr;
+                errStr << "TaskScheduler: bad CPU list " << cpuList;
+                errStr << " (expected something like 0-7,16,18).";
+                throw eckit::BadParameter(errStr.str());
+            }
+
+            for (int cpu = first; cpu <= last; ++cpu)
+            {
+                cpus.push_back(cpu);
+            }
+        }
+
+        return cpus;
+    }
+
+    std::vector<int> TaskScheduler::allowedCpus()
+    {
+        std::vector<int> cpus;
+
+#ifdef __linux__
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        if (sched_getaffinity(0, sizeof(cpuSet), &cpuSet) == 0)
+        {
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            {
+                if (CPU_ISSET(cpu, &cpuSet)) cpus.push_back(cpu);
+            }
+        }
+#endif
+
+        if (cpus.empty())
+        {
+            const auto numCpus = std::max<unsigned>(1, std::thread::hardware_concurrency());
+            for (unsigned cpu = 0; cpu < numCpus; ++cpu)
+            {
+                cpus.push_back(static_cast<int>(cpu));
+            }
+        }
+
+        return cpus;
+    }
+
+    void TaskScheduler::submit(Task task)
+    {
+        auto& queue = *queues_[ownQueue()];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+
+        numQueued_++;
+
+        // Taking the lock makes sure a worker that is about to sleep sees the new task
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex_);
+        }
+
+        wakeUp_.notify_one();
+    }
+
+    bool TaskScheduler::runOne()
+    {
+        const size_t ownIdx = ownQueue();
+
+        Task task;
+        bool found = false;
+        {
+            auto& queue = *queues_[ownIdx];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.tasks.empty())
+            {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+                found = true;
+            }
+        }
+
+        // Steal the oldest task of another queue (the biggest piece of work in divide and
+        // conquer style code). Start with the next queue so that the thieves spread out.
+        for (size_t offset = 1; !found && offset < queues_.size(); ++offset)
+        {
+            auto& queue = *queues_[(ownIdx + offset) % queues_.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.tasks.empty())
+            {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+                found = true;
+            }
+        }
+
+        if (!found) return false;
+
+        numQueued_--;
+        execute(task);
+        return true;
+    }
+
+    void TaskScheduler::work(size_t workerIdx, int cpu)
+    {
+        threadState.scheduler = this;
+        threadState.queueIdx = workerIdx;
+        pinThread(cpu);
+
+        while (true)
+        {
+            if (runOne()) continue;
+
+            std::unique_lock<std::mutex> lock(sleepMutex_);
+            wakeUp_.wait(lock, [this]() { return stop_ || numQueued_ > 0; });
+            if (stop_) return;
+        }
+    }
+
+    void TaskScheduler::execute(Task& task)
+    {
+        std::exception_ptr error;
+        try
+        {
+            task.func();
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        task.group->finishTask(error);
+    }
+
+    size_t TaskScheduler::ownQueue() const
+    {
+        return threadState.scheduler == this ? threadState.queueIdx : queues_.size() - 1;
+    }
+
+    std::vector<int> TaskScheduler::workerCpus(const SchedulerOptions& options, size_t numWorkers)
+    {
+        std::vector<int> workerCpus(numWorkers, -1);
+        if (options.affinity == Affinity::None) return workerCpus;
+
+        const auto cpus = options.cpus.empty() ? allowedCpus() : options.cpus;
+
+        // Slot 0 is left for the thread that waits on the tasks (it isn't pinned)
+        const size_t numSlots = numWorkers + 1;
+        for (size_t workerIdx = 0; workerIdx < numWorkers; ++workerIdx)
+        {
+            size_t cpuIdx = workerIdx + 1;
+            if (options.affinity == Affinity::Scatter)
+            {
+                cpuIdx = cpuIdx * cpus.size() / numSlots;
+            }
+
+            workerCpus[workerIdx] = cpus[cpuIdx % cpus.size()];
+        }
+
+        return workerCpus;
+    }
+
+    TaskScheduler::Scope::Scope(const std::shared_ptr<TaskScheduler>& scheduler) :
+        scheduler_(scheduler),
+        previous_(threadState.bound)
+    {
+        if (scheduler_ != nullptr) threadState.bound = scheduler_.get();
+    }
+
+    TaskScheduler::Scope::~Scope()
+    {
+        threadState.bound = previous_;
+    }
+
+    TaskGroup::TaskGroup(TaskScheduler& scheduler) :
+        scheduler_(scheduler)
+    {
+    }
+
+    TaskGroup::~TaskGroup()
+    {
+        waitForTasks();
+    }
+
+    void TaskGroup::run(std::function<void()> func)
+    {
+        numPending_++;
+
+        TaskScheduler::Task task{std::move(func), this};
+        if (scheduler_.workers_.empty())
+        {
+            TaskScheduler::execute(task);
+            return;
+        }
+
+        scheduler_.submit(std::move(task));
+    }
+
+    void TaskGroup::wait()
+    {
+        waitForTasks();
+
+        std::exception_ptr error;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::swap(error, error_);
+        }
+
+        if (error) std::rethrow_exception(error);
+    }
+
+    void TaskGroup::waitForTasks()
+    {
+        while (numPending_ > 0)
+        {
+            // Help out rather than block, so nested groups can't run out of threads
+            if (scheduler_.runOne()) continue;
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            done_.wait_for(lock, WaitPollInterval, [this]() { return numPending_ == 0; });
+        }
+
+        // Don't let the group go away while the last task is still finishing
+        std::lock_guard<std::mutex> lock(mutex_);
+    }
+
+    void TaskGroup::finishTask(std::exception_ptr error)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (error && !error_) error_ = error;
+        if (--numPending_ == 0) done_.notify_all();
+    }
+}  // namespace bufr
+}  // namespace Ingester
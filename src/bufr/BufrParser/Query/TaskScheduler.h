@@ -0,0 +1,231 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+
+namespace Ingester {
+namespace bufr {
+
+    class TaskGroup;
+
+    /// \brief How the worker threads of a TaskScheduler are pinned to CPUs.
+    enum class Affinity
+    {
+        None,     ///< Let the OS place the threads
+        Compact,  ///< Pin the threads to consecutive CPUs (they share caches)
+        Scatter   ///< Spread the threads evenly over the CPUs (more memory bandwidth)
+    };
+
+    /// \brief Options of a TaskScheduler.
+    struct SchedulerOptions
+    {
+        /// \brief Max number of threads working at the same time, counting the thread that
+        ///        waits on the tasks (0 for the number of CPUs the process may run on).
+        size_t numThreads = 0;
+
+        Affinity affinity = Affinity::None;
+
+        /// \brief CPUs to pin the threads to (empty for the CPUs the process may run on).
+        std::vector<int> cpus;
+    };
+
+    /// \brief Work stealing task scheduler shared by all the stages of a run (decoding,
+    ///        materializing the fields, exporting and encoding), so that stages that run in
+    ///        parallel at the same time (or inside each other) share one pool of threads instead
+    ///        of each starting its own. Every worker has its own queue: it runs its newest task
+    ///        first and idle workers steal the oldest tasks of the others. Threads that wait on
+    ///        a TaskGroup run tasks while they wait, so tasks can start (and wait on) more tasks
+    ///        without deadlocking or going over the thread cap.
+    class TaskScheduler
+    {
+     public:
+        explicit TaskScheduler(const SchedulerOptions& options = SchedulerOptions());
+        ~TaskScheduler();
+
+        TaskScheduler(const TaskScheduler&) = delete;
+        TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+        /// \brief Max number of threads working at the same time (the workers and the waiting
+        ///        thread).
+        size_t numThreads() const { return workers_.size() + 1; }
+
+        /// \brief Call func(begin, end) for every chunk of grainSize indices in [0, size). The
+        ///        chunks are claimed one at a time by the tasks as they become idle, so chunks
+        ///        that take very different amounts of time (ex: jagged data frames) still balance
+        ///        out. Runs on the calling thread when there is a single chunk.
+        /// \param size Number of indices.
+        /// \param grainSize Number of indices per chunk.
+        /// \param func Function that processes the indices [begin, end).
+        /// \param maxThreads Max number of threads to use (0 for all of them).
+        template<typename Func>
+        void parallelFor(size_t size, size_t grainSize, Func func, size_t maxThreads = 0);
+
+        /// \brief The scheduler of the calling thread: the scheduler the thread works for, the
+        ///        one bound with the innermost Scope, or else the process default.
+        static TaskScheduler& current();
+
+        /// \brief The process default scheduler (one thread per CPU, made on first use).
+        static std::shared_ptr<TaskScheduler> defaultScheduler();
+
+        /// \brief Get the affinity from its name (none, compact or scatter).
+        static Affinity affinityFromName(const std::string& name);
+
+        /// \brief Parse a list of CPUs like "0-7,16,18".
+        static std::vector<int> parseCpuList(const std::string& cpuList);
+
+        /// \brief The CPUs the process may run on.
+        static std::vector<int> allowedCpus();
+
+        /// \brief Binds a scheduler to the calling thread for its lifetime, so that current()
+        ///        (and so parallelFor) use it. A null scheduler keeps the current one.
+        class Scope
+        {
+         public:
+            explicit Scope(const std::shared_ptr<TaskScheduler>& scheduler);
+            ~Scope();
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+         private:
+            std::shared_ptr<TaskScheduler> scheduler_;
+            TaskScheduler* previous_;
+        };
+
+     private:
+        friend class TaskGroup;
+
+        struct Task
+        {
+            std::function<void()> func;
+            TaskGroup* group;
+        };
+
+        struct WorkQueue
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        /// \brief The queue of each worker followed by the queue of the other threads.
+        std::vector<std::unique_ptr<WorkQueue>> queues_;
+        std::vector<std::thread> workers_;
+
+        std::atomic<size_t> numQueued_{0};
+        std::mutex sleepMutex_;
+        std::condition_variable wakeUp_;
+        bool stop_ = false;
+
+        /// \brief Queue a task (on the queue of the calling worker if it is one of ours).
+        void submit(Task task);
+
+        /// \brief Run one queued task, preferring the newest task of the calling worker.
+        /// \return False if there was nothing to run.
+        bool runOne();
+
+        /// \brief Main loop of the worker threads.
+        void work(size_t workerIdx, int cpu);
+
+        /// \brief Run a task and report its completion to its group.
+        static void execute(Task& task);
+
+        /// \brief The queue the calling thread pushes to and pops from.
+        size_t ownQueue() const;
+
+        /// \brief The CPU each worker is pinned to (-1 for none).
+        static std::vector<int> workerCpus(const SchedulerOptions& options, size_t numWorkers);
+    };
+
+    /// \brief A set of tasks run on a TaskScheduler that can be waited on together. The first
+    ///        exception thrown by a task is rethrown by wait().
+    class TaskGroup
+    {
+     public:
+        explicit TaskGroup(TaskScheduler& scheduler = TaskScheduler::current());
+
+        /// \brief Waits for the tasks (their exceptions are dropped).
+        ~TaskGroup();
+
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+
+        /// \brief Start a task (runs it right away if the scheduler has no worker threads).
+        void run(std::function<void()> func);
+
+        /// \brief Run tasks until all the tasks of the group are done.
+        void wait();
+
+     private:
+        friend class TaskScheduler;
+
+        TaskScheduler& scheduler_;
+        std::atomic<size_t> numPending_{0};
+        std::mutex mutex_;
+        std::condition_variable done_;
+        std::exception_ptr error_;
+
+        void waitForTasks();
+        void finishTask(std::exception_ptr error);
+    };
+
+    template<typename Func>
+    void TaskScheduler::parallelFor(size_t size, size_t grainSize, Func func, size_t maxThreads)
+    {
+        grainSize = std::max<size_t>(1, grainSize);
+        const size_t numChunks = (size + grainSize - 1) / grainSize;
+
+        size_t numTasks = numThreads();
+        if (maxThreads > 0) numTasks = std::min(numTasks, maxThreads);
+        numTasks = std::min(numTasks, numChunks);
+
+        if (numTasks <= 1)
+        {
+            if (size > 0) func(0, size);
+            return;
+        }
+
+        std::atomic<size_t> nextChunk(0);
+        auto work = [&]()
+        {
+            try
+            {
+                for (size_t chunk = nextChunk++; chunk < numChunks; chunk = nextChunk++)
+                {
+                    func(chunk * grainSize, std::min(size, (chunk + 1) * grainSize));
+                }
+            }
+            catch (...)
+            {
+                nextChunk = numChunks;
+                throw;
+            }
+        };
+
+        TaskGroup group(*this);
+        for (size_t taskIdx = 1; taskIdx < numTasks; ++taskIdx)
+        {
+            group.run(work);
+        }
+
+        work();
+        group.wait();
+    }
+}  // namespace bufr
+}  // namespace Ingester
@@ -16,6 +16,7 @@
 #include <iostream>
 #include <sstream>
 #include <set>
+#include <stdexcept>
 
 #include "eckit/exception/Exceptions.h"
 
@@ -207,12 +208,62 @@ namespace bufr {
         std::vector<size_t> indices_;
     };
 
+    /// \brief Token for the selector part of a query (i.e. '{last}' or '{TPC=1}') that picks one
+    ///        element of each repeat, such as one event of a prepbufr event stack.
+    class SelectorToken : public TokenBase<SelectorToken> {
+     public:
+        constexpr static const char* Pattern = "\\{(first|last|[A-Z0-9_]+=\\d+)\\}";
+        constexpr static const char* DebugStr = "<selector>";
+
+        /// \brief Get the selector name ('first', 'last' or the mnemonic to match).
+        std::string name() const { return name_; }
+
+        /// \brief Get the value the mnemonic must have (only for mnemonic selectors).
+        int code() const { return code_; }
+
+        /// \brief Tokenize the str_ into tokens.
+        void tokenize() final
+        {
+            const auto body = std::string(++str_.begin(), --str_.end());
+            const auto eqPos = body.find('=');
+            if (eqPos == std::string::npos)
+            {
+                name_ = body;
+            }
+            else
+            {
+                name_ = body.substr(0, eqPos);
+                try
+                {
+                    code_ = std::stoi(body.substr(eqPos + 1));
+                }
+                catch (const std::logic_error&)
+                {
+                    throw eckit::BadParameter("SelectorToken::tokenize: invalid code in selector "
+                                              + str_);
+                }
+            }
+        }
+
+        /// \brief Get the debug string for the token.
+        std::string debugStr() const override
+        {
+            std::ostringstream debugStr;
+            debugStr << "<selector=" << std::string(++str_.begin(), --str_.end()) << ">";
+            return debugStr.str();
+        }
+
+     private:
+        std::string name_;
+        int code_ = 0;
+    };
+
     /// \brief Token for a query (i.e. '*/BRIT{2-4}/PCCF[2]'). This token contains tokens for all
     ///        the elements of the query string.
     class QueryToken : public TokenBase<QueryToken> {
      public:
         constexpr static const char* Pattern =
-            "([A-Z0-9_\\*\\/]+((\\[\\d+\\])?)+(\\{[0-9\\-,]+\\})?)+";
+            "([A-Z0-9_\\*\\/]+((\\[\\d+\\])?)+(\\{[0-9\\-,]+\\}|\\{[a-zA-Z0-9_=]+\\})?)+";
         constexpr static const char* DebugStr = "<query>";
         constexpr static const char* SubPattern = "[^,]+";
 
@@ -248,6 +299,8 @@ namespace bufr {
                     subTokens_.push_back(sep);
                 else if (auto filter = FilterToken::parse(start, end))
                     subTokens_.push_back(filter);
+                else if (auto selector = SelectorToken::parse(start, end))
+                    subTokens_.push_back(selector);
                 else if (auto index = IndexToken::parse(start, end))
                     subTokens_.push_back(index);
                 else
@@ -6,19 +6,40 @@
  */
 
 #include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
 #include <vector>
 #include <string>
 
+#include "eckit/exception/Exceptions.h"
+
 #include "QuerySet.h"
+#include "PreparedQuery.h"
 #include "File.h"
 #include "ResultSet.h"
+#include "../Exports/Variables/Transforms/atms/BackusGilbertRemap.h"
+#include "../Exports/Variables/Transforms/VerticalResample.h"
+#include "MemoryTracker.h"
 
 
 namespace py = pybind11;
 
 using Ingester::bufr::ResultSet;
 using Ingester::bufr::QuerySet;
+using Ingester::bufr::PreparedQuery;
 using Ingester::bufr::File;
+using Ingester::bufr::MessageCache;
+using Ingester::BackusGilbertRemap;
+using Ingester::VerticalResample;
+using Ingester::MemoryTracker;
+
+template<typename T>
+using CArray = py::array_t<T, py::array::c_style | py::array::forcecast>;
+
+template<typename T>
+std::vector<T> toVector(const CArray<T>& array)
+{
+    return std::vector<T>(array.data(), array.data() + array.size());
+}
 
     PYBIND11_MODULE(bufr, m)
     {
@@ -30,18 +51,64 @@ using Ingester::bufr::File;
             .def("size", &QuerySet::size, "Get the number of queries in the query set.")
             .def("add", &QuerySet::add, "Add a query to the query set.");
 
+        py::class_<PreparedQuery, std::shared_ptr<PreparedQuery>>(m, "PreparedQuery")
+            .def(py::init<const QuerySet&>(),
+                 py::arg("query_set"),
+                 "Prepare a query set once to execute it on many files. The targets resolved "
+                 "for each subset are shared by all the files with the same tables.")
+            .def("size", [](const PreparedQuery& self) { return self.querySet().size(); },
+                 "Get the number of queries in the prepared query.")
+            .def("num_plans", &PreparedQuery::numPlans,
+                 "Get the number of distinct subset tables resolved so far.");
+
         py::class_<File>(m, "File")
+            .def(py::init([](const py::buffer& data, const std::string& wmoTablePath)
+                 {
+                     // bytes, bytearray, memoryview, numpy uint8 arrays, ...
+                     auto info = data.request();
+                     if (info.ndim > 1 || (info.ndim == 1 && info.strides[0] != info.itemsize))
+                     {
+                         throw eckit::BadParameter("BUFR data buffers must be contiguous.");
+                     }
+
+                     py::gil_scoped_release release;
+                     return new File(info.ptr, info.size * info.itemsize, wmoTablePath);
+                 }),
+                 py::arg("data"),
+                 py::arg("wmoTablePath") = std::string(""),
+                 "Open BUFR data held in memory (bytes or any contiguous buffer).")
             .def(py::init<const std::string&, const std::string&>(),
                  py::arg("filename"),
-                 py::arg("wmoTablePath") = std::string(""))
-            .def("execute", &File::execute,
-                             py::arg("query_set"),
-                             py::arg("next") = static_cast<int>(0),
-                             "Execute a query set on the file. Returns a ResultSet object.")
+                 py::arg("wmoTablePath") = std::string(""),
+                 "Open a BUFR file (\"-\" reads from stdin).")
+            .def(py::init<int, const std::string&>(),
+                 py::arg("fd"),
+                 py::arg("wmoTablePath") = std::string(""),
+                 "Open BUFR data read from a file descriptor (ex: sys.stdin.fileno()).")
+            .def("execute",
+                 py::overload_cast<const QuerySet&, size_t>(&File::execute),
+                 py::arg("query_set"),
+                 py::arg("next") = static_cast<int>(0),
+                 "Execute a query set on the file. Returns a ResultSet object.")
+            .def("execute",
+                 py::overload_cast<const PreparedQuery&, size_t>(&File::execute),
+                 py::arg("query"),
+                 py::arg("next") = static_cast<int>(0),
+                 "Execute a prepared query on the file. Returns a ResultSet object.")
             .def("rewind", &File::rewind,
                            "Rewind the file to the beginning.")
             .def("close", &File::close,
                           "Close the file.")
+            .def("set_message_cache",
+                 [](File& self, const std::string& directory, size_t maxSizeMB)
+                 {
+                     self.setMessageCache(
+                         std::make_shared<MessageCache>(directory, maxSizeMB * 1024 * 1024));
+                 },
+                 py::arg("directory"),
+                 py::arg("max_size_mb") = static_cast<size_t>(1024),
+                 "Cache the data of the messages read by execute in the given directory so "
+                 "they don't need to be decoded again (NCEP files only).")
             .def("__enter__", [](File &f) { return &f; })
             .def("__exit__", [](File &f, py::args args) { f.close(); });
 
@@ -67,6 +134,138 @@ using Ingester::bufr::File;
                         "specified, they are assumed to be 0. If the group_by field is "
                         "specified, the datetime objects are grouped by the specified "
                         "field.");
+
+        py::class_<BackusGilbertRemap>(m, "BackusGilbertRemap")
+            .def(py::init([](const CArray<int>& windowSize,
+                             const CArray<double>& alpha,
+                             const CArray<int>& windowIndex,
+                             const CArray<int>& indexSrc)
+                 {
+                     if (alpha.ndim() != 2)
+                     {
+                         throw eckit::BadParameter("alpha must be (fov, window).");
+                     }
+
+                     return BackusGilbertRemap(toVector(windowSize),
+                                               toVector(alpha),
+                                               toVector(windowIndex),
+                                               toVector(indexSrc),
+                                               static_cast<size_t>(alpha.shape(1)));
+                 }),
+                 py::arg("window_size"),
+                 py::arg("alpha"),
+                 py::arg("window_index"),
+                 py::arg("index_src"),
+                 "Make the remapping from the Backus-Gilbert coefficients (the windowSize, "
+                 "alpha, windowIndex and indexSrc variables of the coefficients file).")
+            .def("apply", [](const BackusGilbertRemap& self,
+                             const CArray<float>& image,
+                             float missingValue,
+                             size_t numThreads)
+                 {
+                     if (image.ndim() != 2 || static_cast<size_t>(image.shape(1)) != self.numFov())
+                     {
+                         throw eckit::BadParameter("image must be (scan, fov) with the number of "
+                                                   "fovs in the coefficients.");
+                     }
+
+                     const auto numScans = static_cast<size_t>(image.shape(0));
+                     py::array_t<float> output({image.shape(0), image.shape(1)});
+                     const float* imagePtr = image.data();
+                     float* outputPtr = output.mutable_data();
+                     {
+                         py::gil_scoped_release release;
+                         self.apply(imagePtr, numScans, missingValue, outputPtr, numThreads);
+                     }
+
+                     return output;
+                 },
+                 py::arg("image"),
+                 py::arg("missing_value") = 9.96921e+36f,
+                 py::arg("threads") = static_cast<size_t>(0),
+                 "Remap a (scan, fov) image. Elements whose window is not complete are set "
+                 "to the missing value.")
+            .def_property_readonly("num_fov", &BackusGilbertRemap::numFov,
+                                   "Number of fields of view in the coefficients.");
+
+        py::class_<VerticalResample>(m, "VerticalResample")
+            .def(py::init([](const CArray<double>& levels, const std::string& method)
+                 {
+                     return VerticalResample(toVector(levels),
+                                             VerticalResample::methodFromName(method));
+                 }),
+                 py::arg("levels"),
+                 py::arg("method") = std::string("logLinear"),
+                 "Make the resampling onto the target levels with the method (logLinear, "
+                 "linear, nearest or layerMean).")
+            .def("apply", [](const VerticalResample& self,
+                             const CArray<float>& coords,
+                             const CArray<float>& values,
+                             float missingValue,
+                             size_t numThreads)
+                 {
+                     if (coords.ndim() != 2 || values.ndim() != 2 ||
+                         coords.shape(0) != values.shape(0) || coords.shape(1) != values.shape(1))
+                     {
+                         throw eckit::BadParameter("coords and values must both be (profile, "
+                                                   "level).");
+                     }
+
+                     const auto numProfiles = static_cast<size_t>(coords.shape(0));
+                     const auto numLevels = static_cast<size_t>(coords.shape(1));
+                     py::array_t<float> output({coords.shape(0),
+                                                static_cast<py::ssize_t>(self.numTargets())});
+                     const float* coordsPtr = coords.data();
+                     const float* valuesPtr = values.data();
+                     float* outputPtr = output.mutable_data();
+                     {
+                         py::gil_scoped_release release;
+                         self.apply(coordsPtr,
+                                    valuesPtr,
+                                    numProfiles,
+                                    numLevels,
+                                    missingValue,
+                                    outputPtr,
+                                    numThreads);
+                     }
+
+                     return output;
+                 },
+                 py::arg("coords"),
+                 py::arg("values"),
+                 py::arg("missing_value") = 9.96921e+36f,
+                 py::arg("threads") = static_cast<size_t>(0),
+                 "Resample (profile, level) values onto the target levels. Targets outside "
+                 "of a profile are set to the missing value.")
+            .def_property_readonly("num_targets", &VerticalResample::numTargets,
+                                   "Number of target levels.");
+
+        m.def("memory_usage",
+              []()
+              {
+                  auto& tracker = MemoryTracker::instance();
+                  py::dict usage;
+                  for (size_t idx = 0;
+                       idx < static_cast<size_t>(MemoryTracker::Subsystem::Count);
+                       ++idx)
+                  {
+                      const auto subsystem = static_cast<MemoryTracker::Subsystem>(idx);
+                      const auto subsystemUsage = tracker.usage(subsystem);
+                      usage[py::str(MemoryTracker::name(subsystem))] =
+                          py::dict(py::arg("current") = subsystemUsage.current,
+                                   py::arg("peak") = subsystemUsage.peak);
+                  }
+
+                  usage["Total"] = py::dict(py::arg("current") = tracker.total().current,
+                                            py::arg("peak") = tracker.total().peak);
+                  return usage;
+              },
+              "Get the bytes held by the ResultSets, DataObjects, DataContainers and encoder "
+              "buffers ({name: {current, peak}}).");
+
+        m.def("reset_memory_peaks",
+              []() { MemoryTracker::instance().resetPeaks(); },
+              "Set the memory peaks to the current usage.");
     }
 //}  // namespace bufr
 //}  // namespace Ingester
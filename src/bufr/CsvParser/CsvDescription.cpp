@@ -0,0 +1,132 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include "CsvDescription.h"
+
+#include <set>
+#include <sstream>
+
+#include "eckit/exception/Exceptions.h"
+
+
+namespace
+{
+    namespace ConfKeys
+    {
+        const char* Filename = "obsdatain";
+        const char* Delimiter = "delimiter";
+        const char* FixedWidth = "fixedWidth";
+        const char* Header = "header";
+        const char* SkipLines = "skipLines";
+        const char* Comment = "comment";
+        const char* Threads = "threads";
+        const char* Columns = "columns";
+        const char* Exports = "exports";
+
+        namespace Column
+        {
+            const char* Name = "name";
+            const char* Type = "type";
+            const char* Header = "header";
+            const char* Index = "index";
+            const char* Start = "start";
+            const char* Width = "width";
+            const char* Missing = "missing";
+            const char* Format = "format";
+        }  // namespace Column
+    }  // namespace ConfKeys
+
+    const std::set<std::string> ColumnTypes = {"int", "int64", "float", "double",
+                                               "string", "datetime"};
+}  // namespace
+
+namespace Ingester
+{
+    CsvDescription::CsvDescription(const eckit::Configuration &conf) :
+        export_(Export(conf.getSubConfiguration(ConfKeys::Exports)))
+    {
+        filepath_ = conf.getString(ConfKeys::Filename);
+        delimiter_ = conf.getString(ConfKeys::Delimiter, ",");
+        isFixedWidth_ = conf.getBool(ConfKeys::FixedWidth, false);
+        hasHeader_ = conf.getBool(ConfKeys::Header, false);
+        skipLines_ = static_cast<size_t>(conf.getInt(ConfKeys::SkipLines, 0));
+        comment_ = conf.getString(ConfKeys::Comment, "");
+        numThreads_ = static_cast<size_t>(conf.getInt(ConfKeys::Threads, 0));
+
+        if (delimiter_.empty())
+        {
+            throw eckit::BadParameter("csv::delimiter can't be empty.");
+        }
+
+        auto colConfs = conf.getSubConfigurations(ConfKeys::Columns);
+        if (colConfs.size() == 0)
+        {
+            throw eckit::BadParameter("csv::columns must contain a list of columns!");
+        }
+
+        for (size_t colIdx = 0; colIdx < colConfs.size(); ++colIdx)
+        {
+            const auto& colConf = colConfs[colIdx];
+
+            CsvColumnDescription column;
+            column.name = colConf.getString(ConfKeys::Column::Name);
+            column.type = colConf.getString(ConfKeys::Column::Type, "float");
+
+            if (ColumnTypes.find(column.type) == ColumnTypes.end())
+            {
+                std::ostringstream errStr;
+                errStr << "csv::columns: Unknown type " << column.type << " for column ";
+                errStr << column.name << ".";
+                throw eckit::BadParameter(errStr.str());
+            }
+
+            if (isFixedWidth_)
+            {
+                if (!colConf.has(ConfKeys::Column::Start) || !colConf.has(ConfKeys::Column::Width))
+                {
+                    throw eckit::BadParameter("csv::columns: Fixed width column " + column.name
+                                              + " needs a start and a width.");
+                }
+
+                column.start = static_cast<size_t>(colConf.getInt(ConfKeys::Column::Start));
+                column.width = static_cast<size_t>(colConf.getInt(ConfKeys::Column::Width));
+            }
+            else if (colConf.has(ConfKeys::Column::Header))
+            {
+                if (!hasHeader_)
+                {
+                    throw eckit::BadParameter("csv::columns: Column " + column.name + " refers "
+                                              "to a header but the file has no header.");
+                }
+
+                column.header = colConf.getString(ConfKeys::Column::Header);
+            }
+            else
+            {
+                column.index = colConf.getInt(ConfKeys::Column::Index, static_cast<int>(colIdx));
+            }
+
+            if (colConf.has(ConfKeys::Column::Missing))
+            {
+                column.missing = colConf.getStringVector(ConfKeys::Column::Missing);
+            }
+
+            if (column.type == "datetime")
+            {
+                if (!colConf.has(ConfKeys::Column::Format))
+                {
+                    throw eckit::BadParameter("csv::columns: Datetime column " + column.name
+                                              + " needs a format.");
+                }
+
+                column.datetimeFormat = colConf.getString(ConfKeys::Column::Format);
+            }
+
+            columns_.push_back(column);
+        }
+    }
+}  // namespace Ingester
@@ -0,0 +1,81 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "eckit/config/LocalConfiguration.h"
+
+#include "BufrParser/Exports/Export.h"
+
+
+namespace Ingester
+{
+    /// \brief Describes a single column of a delimited or fixed width text file.
+    struct CsvColumnDescription
+    {
+        std::string name;
+        std::string type;  // int, int64, float, double, string or datetime
+        std::string header;  // Optional (delimited files with a header line)
+        int index = -1;  // Optional (delimited files)
+        size_t start = 0;  // Fixed width files
+        size_t width = 0;  // Fixed width files
+        std::vector<std::string> missing;  // Optional
+        std::string datetimeFormat;  // Only for datetime columns
+    };
+
+    typedef std::vector<CsvColumnDescription> CsvColumnDescriptions;
+
+    /// \brief Description of the columns to read from a text file and how to expose that data to
+    /// the outside world.
+    class CsvDescription
+    {
+     public:
+        explicit CsvDescription(const eckit::Configuration &conf);
+
+        // Getters
+        inline std::string filepath() const { return filepath_; }
+        inline std::string delimiter() const { return delimiter_; }
+        inline bool isFixedWidth() const { return isFixedWidth_; }
+        inline bool hasHeader() const { return hasHeader_; }
+        inline size_t skipLines() const { return skipLines_; }
+        inline std::string comment() const { return comment_; }
+        inline size_t numThreads() const { return numThreads_; }
+        inline CsvColumnDescriptions getColumns() const { return columns_; }
+        inline Export getExport() const { return export_; }
+
+     private:
+        /// \brief Specifies the relative path to the text file to read.
+        std::string filepath_;
+
+        /// \brief Field delimiter ("whitespace" splits on runs of spaces and tabs).
+        std::string delimiter_;
+
+        /// \brief Columns are defined by character positions rather than a delimiter.
+        bool isFixedWidth_;
+
+        /// \brief The first (non skipped) line holds the column names.
+        bool hasHeader_;
+
+        /// \brief Number of lines to skip at the start of the file.
+        size_t skipLines_;
+
+        /// \brief Lines that start with this string are ignored.
+        std::string comment_;
+
+        /// \brief Number of threads used to scan the file (0 means one per core).
+        size_t numThreads_;
+
+        /// \brief The columns to read.
+        CsvColumnDescriptions columns_;
+
+        /// \brief Map of export strings to Variable classes.
+        Export export_;
+    };
+}  // namespace Ingester
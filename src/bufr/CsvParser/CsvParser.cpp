@@ -0,0 +1,535 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include "CsvParser.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>  // NOLINT
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <ostream>
+#include <sstream>
+
+#include "eckit/exception/Exceptions.h"
+#include "oops/util/Logger.h"
+
+#include "DataContainer.h"
+#include "DataObject.h"
+#include "BufrParser/Query/Constants.h"
+#include "BufrParser/Query/ParallelFor.h"
+
+
+namespace
+{
+    const char* WhitespaceDelimiter = "whitespace";
+
+    /// \brief Blocks smaller than this are not worth a thread of their own.
+    const size_t MinBytesPerThread = 1 << 20;
+
+    /// \brief Read only memory map of a whole file.
+    class MappedFile
+    {
+     public:
+        explicit MappedFile(const std::string& filepath)
+        {
+            fd_ = ::open(filepath.c_str(), O_RDONLY);
+            if (fd_ < 0)
+            {
+                throw eckit::BadParameter("Could not open the file " + filepath);
+            }
+
+            struct stat fileStat;
+            if (::fstat(fd_, &fileStat) != 0)
+            {
+                ::close(fd_);
+                throw eckit::BadParameter("Could not stat the file " + filepath);
+            }
+
+            size_ = static_cast<size_t>(fileStat.st_size);
+            if (size_ > 0)
+            {
+                void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+                if (addr == MAP_FAILED)
+                {
+                    ::close(fd_);
+                    throw eckit::BadParameter("Could not memory map the file " + filepath);
+                }
+
+                ::madvise(addr, size_, MADV_SEQUENTIAL);
+                data_ = static_cast<const char*>(addr);
+            }
+        }
+
+        ~MappedFile()
+        {
+            if (data_ != nullptr)
+            {
+                ::munmap(const_cast<char*>(data_), size_);
+            }
+
+            ::close(fd_);
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const char* begin() const { return data_; }
+        const char* end() const { return data_ + size_; }
+
+     private:
+        int fd_ = -1;
+        size_t size_ = 0;
+        const char* data_ = nullptr;
+    };
+
+    /// \brief Find the start of the line after the one that contains pos.
+    const char* nextLine(const char* pos, const char* end)
+    {
+        auto newLine = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+        return newLine == nullptr ? end : newLine + 1;
+    }
+
+    /// \brief Get the line that starts at pos (without the line ending).
+    std::string lineAt(const char* pos, const char* end)
+    {
+        auto lineEnd = nextLine(pos, end);
+        while (lineEnd > pos && (*(lineEnd - 1) == '\n' || *(lineEnd - 1) == '\r'))
+        {
+            --lineEnd;
+        }
+
+        return std::string(pos, lineEnd);
+    }
+
+    /// \brief Remove the leading and trailing whitespace.
+    std::string trim(const char* begin, const char* end)
+    {
+        while (begin < end && std::isspace(static_cast<unsigned char>(*begin))) ++begin;
+        while (end > begin && std::isspace(static_cast<unsigned char>(*(end - 1)))) --end;
+        return std::string(begin, end);
+    }
+
+    bool isStringType(const std::string& type)
+    {
+        return type == "string";
+    }
+
+    /// \brief Make the (empty) DataObject for a column type (or a query type override).
+    std::shared_ptr<Ingester::DataObjectBase> objectForType(const std::string& type)
+    {
+        std::shared_ptr<Ingester::DataObjectBase> object;
+
+        if (type == "int" || type == "int32")
+        {
+            object = std::make_shared<Ingester::DataObject<int32_t>>();
+        }
+        else if (type == "int64" || type == "datetime")
+        {
+            object = std::make_shared<Ingester::DataObject<int64_t>>();
+        }
+        else if (type == "float" || type == "float32")
+        {
+            object = std::make_shared<Ingester::DataObject<float>>();
+        }
+        else if (type == "double" || type == "float64")
+        {
+            object = std::make_shared<Ingester::DataObject<double>>();
+        }
+        else
+        {
+            std::ostringstream errMsg;
+            errMsg << "Unknown or unsupported type " << type << ".";
+            throw eckit::BadParameter(errMsg.str());
+        }
+
+        return object;
+    }
+}  // namespace
+
+namespace Ingester
+{
+    CsvParser::CsvParser(const CsvDescription& description) :
+        description_(description),
+        columns_(description.getColumns())
+    {
+        oops::Log::info() << "CsvParser: Parsing file " << description_.filepath() << std::endl;
+    }
+
+    CsvParser::CsvParser(const eckit::LocalConfiguration& conf) :
+        description_(CsvDescription(conf)),
+        columns_(description_.getColumns())
+    {
+        oops::Log::info() << "CsvParser: Parsing file " << description_.filepath() << std::endl;
+    }
+
+    std::shared_ptr<DataContainer> CsvParser::parse(const size_t maxRowsToParse)
+    {
+        auto startTime = std::chrono::steady_clock::now();
+        bufr::TaskScheduler::Scope schedulerScope(scheduler_);
+
+        MappedFile file(description_.filepath());
+        const char* dataBegin = file.begin();
+        const char* dataEnd = file.end();
+
+        // Skip the leading lines and read the header
+        for (size_t lineIdx = 0; lineIdx < description_.skipLines() && dataBegin < dataEnd;
+             ++lineIdx)
+        {
+            dataBegin = nextLine(dataBegin, dataEnd);
+        }
+
+        if (description_.hasHeader() && dataBegin < dataEnd)
+        {
+            resolveColumns(lineAt(dataBegin, dataEnd));
+            dataBegin = nextLine(dataBegin, dataEnd);
+        }
+
+        // Only scan as far as we need to when the number of rows is limited
+        if (maxRowsToParse > 0)
+        {
+            size_t rowCnt = 0;
+            const char* pos = dataBegin;
+            while (pos < dataEnd && rowCnt < maxRowsToParse)
+            {
+                auto line = lineAt(pos, dataEnd);
+                if (!trim(line.data(), line.data() + line.size()).empty() &&
+                    (description_.comment().empty() || line.rfind(description_.comment(), 0) != 0))
+                {
+                    ++rowCnt;
+                }
+
+                pos = nextLine(pos, dataEnd);
+            }
+
+            dataEnd = pos;
+        }
+
+        // Divide the file into blocks of whole lines (one per thread)
+        const size_t numBytes = static_cast<size_t>(dataEnd - dataBegin);
+        size_t numThreads = description_.numThreads();
+        if (numThreads == 0)
+        {
+            numThreads = bufr::TaskScheduler::current().numThreads();
+        }
+
+        numThreads = std::max<size_t>(1, std::min(numThreads, numBytes / MinBytesPerThread));
+
+        std::vector<const char*> blockStarts = {dataBegin};
+        for (size_t blockIdx = 1; blockIdx < numThreads; ++blockIdx)
+        {
+            auto pos = std::max(blockStarts.back(), dataBegin + blockIdx * (numBytes / numThreads));
+            blockStarts.push_back(pos == dataBegin ? pos : nextLine(pos - 1, dataEnd));
+        }
+        blockStarts.push_back(dataEnd);
+
+        oops::Log::info() << "Scanning " << numBytes << " bytes with " << numThreads
+                          << " thread(s)" << std::endl;
+
+        std::vector<ColumnData> blocks(numThreads);
+        bufr::parallelFor(numThreads,
+                          1,
+                          [&](size_t beginBlock, size_t endBlock)
+                          {
+                              for (size_t blockIdx = beginBlock; blockIdx < endBlock; ++blockIdx)
+                              {
+                                  blocks[blockIdx] = parseBlock(blockStarts[blockIdx],
+                                                                blockStarts[blockIdx + 1]);
+                              }
+                          },
+                          numThreads);
+
+        // Stitch the blocks back together (in file order)
+        ColumnData columnData;
+        columnData.numbers.resize(columns_.size());
+        columnData.strings.resize(columns_.size());
+        for (size_t colIdx = 0; colIdx < columns_.size(); ++colIdx)
+        {
+            auto& numbers = columnData.numbers[colIdx];
+            auto& strings = columnData.strings[colIdx];
+            for (auto& block : blocks)
+            {
+                numbers.insert(numbers.end(),
+                               block.numbers[colIdx].begin(),
+                               block.numbers[colIdx].end());
+                strings.insert(strings.end(),
+                               std::make_move_iterator(block.strings[colIdx].begin()),
+                               std::make_move_iterator(block.strings[colIdx].end()));
+            }
+        }
+
+        oops::Log::info() << "Building Column Data" << std::endl;
+        auto srcData = BufrDataMap();
+        for (const auto& var : description_.getExport().getVariables())
+        {
+            for (const auto& queryInfo : var->getQueryList())
+            {
+                auto colIt = std::find_if(columns_.begin(), columns_.end(),
+                                          [&queryInfo](const CsvColumnDescription& column)
+                                          {
+                                              return column.name == queryInfo.query;
+                                          });
+
+                if (colIt == columns_.end())
+                {
+                    std::ostringstream errMsg;
+                    errMsg << "Column " << queryInfo.query << " (needed for " << queryInfo.name;
+                    errMsg << ") is not defined in csv::columns.";
+                    throw eckit::BadParameter(errMsg.str());
+                }
+
+                const auto colIdx = static_cast<size_t>(colIt - columns_.begin());
+                const auto type = queryInfo.type.empty() ? colIt->type : queryInfo.type;
+
+                if (isStringType(type) != isStringType(colIt->type))
+                {
+                    std::ostringstream errMsg;
+                    errMsg << "Conversions between numbers and strings are not currently "
+                           << "supported. See the export definition for \"" << queryInfo.name
+                           << "\".";
+                    throw eckit::BadParameter(errMsg.str());
+                }
+
+                std::shared_ptr<DataObjectBase> object;
+                if (isStringType(type))
+                {
+                    auto strObject = std::make_shared<DataObject<std::string>>();
+                    strObject->setData(columnData.strings[colIdx]);
+                    object = strObject;
+                }
+                else
+                {
+                    object = objectForType(type);
+                    object->setData(columnData.numbers[colIdx], bufr::MissingValue);
+                }
+
+                object->setDims({static_cast<int>(object->size())});
+                object->setFieldName(queryInfo.name);
+                object->setGroupByFieldName(queryInfo.groupByField);
+                object->setQuery(queryInfo.query);
+                object->setDimPaths({bufr::Query()});
+
+                srcData[queryInfo.name] = object;
+            }
+        }
+
+        oops::Log::info()  << "Exporting Data" << std::endl;
+        auto exportedData = exportData(description_.getExport(), srcData);
+
+        auto timeElapsed = std::chrono::steady_clock::now() - startTime;
+        auto timeElapsedDuration = std::chrono::duration_cast<std::chrono::milliseconds>
+                (timeElapsed);
+        oops::Log::info()  << "Finished "
+                           << "[" << timeElapsedDuration.count() / 1000.0 << "s]"
+                           << std::endl;
+
+        return exportedData;
+    }
+
+    void CsvParser::resolveColumns(const std::string& headerLine)
+    {
+        auto headers = splitLine(headerLine.data(), headerLine.data() + headerLine.size());
+
+        for (auto& column : columns_)
+        {
+            if (column.header.empty()) continue;
+
+            auto headerIt = std::find(headers.begin(), headers.end(), column.header);
+            if (headerIt == headers.end())
+            {
+                std::ostringstream errMsg;
+                errMsg << "Could not find the header " << column.header << " (column ";
+                errMsg << column.name << ") in " << description_.filepath() << ".";
+                throw eckit::BadParameter(errMsg.str());
+            }
+
+            column.index = static_cast<int>(headerIt - headers.begin());
+        }
+    }
+
+    CsvParser::ColumnData CsvParser::parseBlock(const char* begin, const char* end) const
+    {
+        ColumnData data;
+        data.numbers.resize(columns_.size());
+        data.strings.resize(columns_.size());
+
+        const auto& comment = description_.comment();
+        std::vector<std::string> fields;
+
+        for (const char* pos = begin; pos < end; pos = nextLine(pos, end))
+        {
+            // Find the line without the line ending
+            auto lineEnd = nextLine(pos, end);
+            while (lineEnd > pos && (*(lineEnd - 1) == '\n' || *(lineEnd - 1) == '\r'))
+            {
+                --lineEnd;
+            }
+
+            if (trim(pos, lineEnd).empty()) continue;
+            if (!comment.empty() &&
+                static_cast<size_t>(lineEnd - pos) >= comment.size() &&
+                std::equal(comment.begin(), comment.end(), pos)) continue;
+
+            if (!description_.isFixedWidth())
+            {
+                fields = splitLine(pos, lineEnd);
+            }
+
+            for (size_t colIdx = 0; colIdx < columns_.size(); ++colIdx)
+            {
+                const auto& column = columns_[colIdx];
+
+                std::string field;
+                if (description_.isFixedWidth())
+                {
+                    const auto lineSize = static_cast<size_t>(lineEnd - pos);
+                    if (column.start < lineSize)
+                    {
+                        field = trim(pos + column.start,
+                                     pos + std::min(lineSize, column.start + column.width));
+                    }
+                }
+                else if (column.index >= 0 && static_cast<size_t>(column.index) < fields.size())
+                {
+                    field = fields[column.index];
+                }
+
+                if (isStringType(column.type))
+                {
+                    if (std::find(column.missing.begin(), column.missing.end(), field) !=
+                        column.missing.end())
+                    {
+                        field.clear();
+                    }
+
+                    data.strings[colIdx].push_back(std::move(field));
+                }
+                else
+                {
+                    data.numbers[colIdx].push_back(toNumber(field, column));
+                }
+            }
+        }
+
+        return data;
+    }
+
+    std::vector<std::string> CsvParser::splitLine(const char* begin, const char* end) const
+    {
+        std::vector<std::string> fields;
+        const auto& delimiter = description_.delimiter();
+
+        if (delimiter == WhitespaceDelimiter)
+        {
+            const char* pos = begin;
+            while (pos < end)
+            {
+                while (pos < end && std::isspace(static_cast<unsigned char>(*pos))) ++pos;
+                if (pos == end) break;
+
+                const char* fieldStart = pos;
+                while (pos < end && !std::isspace(static_cast<unsigned char>(*pos))) ++pos;
+                fields.emplace_back(fieldStart, pos);
+            }
+
+            return fields;
+        }
+
+        const char* pos = begin;
+        while (true)
+        {
+            // Skip leading whitespace (that isn't the delimiter) so we can spot quoted fields
+            while (pos < end && (*pos == ' ' || *pos == '\t') &&
+                   delimiter.find(*pos) == std::string::npos)
+            {
+                ++pos;
+            }
+
+            std::string field;
+            if (pos < end && *pos == '"')
+            {
+                // Quoted field ("" is an escaped quote)
+                ++pos;
+                while (pos < end)
+                {
+                    if (*pos == '"')
+                    {
+                        if (pos + 1 < end && *(pos + 1) == '"')
+                        {
+                            field.push_back('"');
+                            pos += 2;
+                            continue;
+                        }
+
+                        ++pos;
+                        break;
+                    }
+
+                    field.push_back(*pos++);
+                }
+
+                auto delimPos = std::search(pos, end, delimiter.begin(), delimiter.end());
+                pos = delimPos;
+            }
+            else
+            {
+                auto delimPos = std::search(pos, end, delimiter.begin(), delimiter.end());
+                field = trim(pos, delimPos);
+                pos = delimPos;
+            }
+
+            fields.push_back(std::move(field));
+
+            if (pos >= end) break;
+            pos += delimiter.size();
+        }
+
+        return fields;
+    }
+
+    double CsvParser::toNumber(const std::string& field, const CsvColumnDescription& column) const
+    {
+        if (field.empty() ||
+            std::find(column.missing.begin(), column.missing.end(), field) != column.missing.end())
+        {
+            return bufr::MissingValue;
+        }
+
+        if (column.type == "datetime")
+        {
+            std::tm time = {};
+            auto parseEnd = strptime(field.c_str(), column.datetimeFormat.c_str(), &time);
+            if (parseEnd == nullptr || *parseEnd != '\0')
+            {
+                std::ostringstream errMsg;
+                errMsg << "Could not read \"" << field << "\" in column " << column.name;
+                errMsg << " with the datetime format " << column.datetimeFormat << ".";
+                throw eckit::BadValue(errMsg.str());
+            }
+
+            return static_cast<double>(timegm(&time));
+        }
+
+        char* numEnd = nullptr;
+        const double value = std::strtod(field.c_str(), &numEnd);
+        if (numEnd == field.c_str() || *numEnd != '\0')
+        {
+            std::ostringstream errMsg;
+            errMsg << "Could not convert \"" << field << "\" in column " << column.name;
+            errMsg << " to a number.";
+            throw eckit::BadValue(errMsg.str());
+        }
+
+        return value;
+    }
+}  // namespace Ingester
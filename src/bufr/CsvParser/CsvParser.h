@@ -0,0 +1,70 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "eckit/config/LocalConfiguration.h"
+
+#include "Parser.h"
+#include "CsvDescription.h"
+
+
+namespace Ingester
+{
+    class DataContainer;
+
+    /// \brief Parses delimited (ex: CSV) or fixed width text files. The file is memory mapped and
+    ///        divided into blocks of whole lines that are scanned in parallel. Every configured
+    ///        column becomes a DataObject which is then exported the same way as BUFR data.
+    class CsvParser final : public Parser
+    {
+     public:
+        explicit CsvParser(const CsvDescription& description);
+        explicit CsvParser(const eckit::LocalConfiguration& conf);
+
+        /// \brief Uses the provided description to parse the text file.
+        /// \param maxRowsToParse Rows to parse (0 for everything)
+        std::shared_ptr<DataContainer> parse(const size_t maxRowsToParse = 0) final;
+
+        /// \brief Start over from the beginning of the file (nothing is cached between parses).
+        void reset() final {}
+
+     private:
+        /// \brief Values of the columns for a block of lines. Numbers are stored as doubles
+        ///        (missing values are bufr::MissingValue), strings as strings.
+        struct ColumnData
+        {
+            std::vector<std::vector<double>> numbers;
+            std::vector<std::vector<std::string>> strings;
+        };
+
+        /// \brief The description the defines what to read from the text file
+        CsvDescription description_;
+
+        /// \brief The columns with the field indices (delimited files) resolved.
+        CsvColumnDescriptions columns_;
+
+        /// \brief Resolve the field index of columns that are referenced by header name.
+        /// \param headerLine The header line of the file.
+        void resolveColumns(const std::string& headerLine);
+
+        /// \brief Scan the lines in [begin, end) of the file.
+        /// \param begin Pointer to the start of the first line.
+        /// \param end Pointer to one past the end of the last line.
+        ColumnData parseBlock(const char* begin, const char* end) const;
+
+        /// \brief Split a delimited line into its (trimmed) fields.
+        std::vector<std::string> splitLine(const char* begin, const char* end) const;
+
+        /// \brief Convert a field to a double (bufr::MissingValue if the field is missing).
+        double toNumber(const std::string& field, const CsvColumnDescription& column) const;
+    };
+}  // namespace Ingester
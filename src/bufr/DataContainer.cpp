@@ -8,22 +8,46 @@
 
 #include <string>
 #include <ostream>
+#include <vector>
 
 #include "eckit/exception/Exceptions.h"
 
 #include "DataContainer.h"
 
 
+namespace
+{
+    /// \brief Estimate of the bytes of a map node (the tree pointers and colour).
+    template<typename Map>
+    size_t nodeBytes()
+    {
+        return sizeof(typename Map::value_type) + 4 * sizeof(void*);
+    }
+
+    size_t stringsBytes(const std::vector<std::string>& strs)
+    {
+        size_t bytes = 0;
+        for (const auto& str : strs)
+        {
+            bytes += str.capacity();
+        }
+
+        return bytes;
+    }
+}  // namespace
+
 namespace Ingester
 {
     DataContainer::DataContainer() :
-        categoryMap_({})
+        categoryMap_({}),
+        memory_(MemoryTracker::Subsystem::DataContainer)
     {
         makeDataSets();
     }
 
     DataContainer::DataContainer(const CategoryMap& categoryMap) :
-        categoryMap_(categoryMap)
+        categoryMap_(categoryMap),
+        memory_(MemoryTracker::Subsystem::DataContainer)
     {
         makeDataSets();
     }
@@ -41,6 +65,7 @@ namespace Ingester
         }
 
         dataSets_.at(categoryId).insert({fieldName, data});
+        memory_.set(memory_.bytes() + nodeBytes<DataSetMap>() + fieldName.capacity());
     }
 
     std::shared_ptr<DataObjectBase> DataContainer::get(const std::string& fieldName,
@@ -131,6 +156,26 @@ namespace Ingester
         return allCategories;
     }
 
+    std::vector<std::string> DataContainer::getFieldNames(const SubCategory& categoryId) const
+    {
+        if (dataSets_.find(categoryId) == dataSets_.end())
+        {
+            std::ostringstream errStr;
+            errStr << "ERROR: Category called " << makeSubCategoryStr(categoryId);
+            errStr << " does not exist.";
+
+            throw eckit::BadParameter(errStr.str());
+        }
+
+        std::vector<std::string> fieldNames;
+        for (const auto &dataPair : dataSets_.at(categoryId))
+        {
+            fieldNames.push_back(dataPair.first);
+        }
+
+        return fieldNames;
+    }
+
     void DataContainer::makeDataSets()
     {
         std::function<void(std::vector<size_t>&, const std::vector<size_t>&, size_t)> incIdx;
@@ -172,12 +217,14 @@ namespace Ingester
                     catIdx++;
                 }
 
+                memory_.set(memory_.bytes() + nodeBytes<DataSets>() + stringsBytes(subsets));
                 dataSets_.insert({subsets, DataSetMap()});
                 incIdx(indicies, lengths, 0);
             }
         }
         else
         {
+            memory_.set(memory_.bytes() + nodeBytes<DataSets>());
             dataSets_.insert({{}, DataSetMap()});
         }
     }
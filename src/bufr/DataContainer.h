@@ -14,6 +14,7 @@
 
 #include "DataObject.h"
 #include "IngesterTypes.h"
+#include "MemoryTracker.h"
 
 
 namespace Ingester
@@ -79,6 +80,10 @@ namespace Ingester
         /// \brief Get the number of rows of the specified sub category
         std::vector<SubCategory> allSubCategories() const;
 
+        /// \brief Get the names of the fields of the specified sub category
+        /// \param categoryId The vector<string> for the subcategory
+        std::vector<std::string> getFieldNames(const SubCategory& categoryId = {}) const;
+
         /// \brief Get the map of categories
         inline CategoryMap getCategoryMap() const { return categoryMap_; }
 
@@ -89,6 +94,9 @@ namespace Ingester
         /// Map of data for each possible subcategory
         DataSets dataSets_;
 
+        /// Bytes of the map entries (the DataObjects track their own data).
+        TrackedBytes memory_;
+
         /// \brief Uses category map to generate listings of all possible subcategories.
         void makeDataSets();
 
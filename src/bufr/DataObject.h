@@ -35,6 +35,8 @@
 
 #include "BufrParser/Query/Constants.h"
 #include "BufrParser/Query/QueryParser.h"
+#include "MemoryTracker.h"
+#include "ValidityMask.h"
 
 namespace Ingester
 {
@@ -152,10 +154,21 @@ namespace Ingester
         /// \return Float data.
         virtual float getAsFloat(size_t idx) const = 0;
 
+        /// \brief Get the data at the index as a double.
+        /// \return Double data.
+        virtual double getAsDouble(size_t idx) const = 0;
+
         /// \brief Is the element at the index the missing value.
         /// \return bool data.
         virtual bool isMissing(size_t idx) const = 0;
 
+        /// \brief Get the validity bitmap of the data (bit set for each element that is not
+        ///        missing). Built once when the data is set.
+        virtual const ValidityMask& getValidity() const = 0;
+
+        /// \brief Get the number of missing elements.
+        size_t numMissing() const { return getValidity().numMissing(); }
+
         /// \brief Get the data at the Location as an string.
         /// \return String data.
         virtual std::string getAsString(const Location& loc) const = 0;
@@ -235,13 +248,19 @@ namespace Ingester
                    const std::vector<bufr::Query>& dimPaths) :
             DataObjectBase(field_name, group_by_field_name, dimensions, query, dimPaths),
             data_(data)
-        {};
+        {
+            updateValidity();
+        };
 
         virtual ~DataObject() = default;
 
         /// \brief Set the data for this object
         /// \param data The data vector
-        void setData(const std::vector<T>& data) { data_ = data; }
+        void setData(const std::vector<T>& data)
+        {
+            data_ = data;
+            updateValidity();
+        }
 
         /// \brief Set the data for this object
         /// \param data The data vector
@@ -269,11 +288,7 @@ namespace Ingester
 
             // Create the mask array
             py::array_t<bool> mask(dims_);
-            bool* maskPtr = static_cast<bool*>(mask.mutable_data());
-            for (size_t idx = 0; idx < data_.size(); idx++)
-            {
-                maskPtr[idx] = isMissing(idx);
-            }
+            validity_.toMissingFlags(static_cast<bool*>(mask.mutable_data()));
 
             // Create a masked array from the data and mask arrays
             py::object numpyModule = py::module::import("numpy");
@@ -302,11 +317,7 @@ namespace Ingester
 
             // Create the mask array
             py::array_t<bool> mask(dims_);
-            bool* maskPtr = static_cast<bool*>(mask.mutable_data());
-            for (size_t idx = 0; idx < data_.size(); idx++)
-            {
-                maskPtr[idx] = isMissing(idx);
-            }
+            validity_.toMissingFlags(static_cast<bool*>(mask.mutable_data()));
 
             // Create a masked array from the data and mask arrays
             py::array maskedArray = numpyModule.attr("ma").attr("masked_array")(data, mask);
@@ -385,7 +396,7 @@ namespace Ingester
             for (auto val = data_.cbegin(); val != data_.cend(); ++val)
             {
                 if (val != data_.cbegin()) out << ", ";
-                out << *val;
+                out << _printable(*val);
             }
 
             out << std::endl;
@@ -394,29 +405,22 @@ namespace Ingester
         /// \brief Get the raw data.
         std::vector<T> getRawData() const { return data_; }
 
+        /// \brief Get a reference to the raw data (avoids the copy made by getRawData).
+        const std::vector<T>& rawData() const { return data_; }
+
         /// \brief Set the raw data.
-        void setRawData(std::vector<T> data) { data_ = data; }
+        void setRawData(std::vector<T> data)
+        {
+            data_ = std::move(data);
+            updateValidity();
+        }
 
         /// \brief Get data associated with a given location.
         /// \param location The location to get data for.
         /// \return The data at the given location.
         T get(const Location& loc) const
         {
-            size_t dim_prod = 1;
-            for (int dim_idx = dims_.size(); dim_idx > static_cast<int>(loc.size()); --dim_idx)
-            {
-                dim_prod *= dims_[dim_idx];
-            }
-
-            // Compute the index into the data array
-            size_t index = 0;
-            for (int dim_idx = loc.size() - 1; dim_idx >= 0; --dim_idx)
-            {
-                index += dim_prod*loc[dim_idx];
-                dim_prod *= dims_[dim_idx];
-            }
-
-            return data_[index];
+            return data_[index(loc)];
         };
 
         /// \brief Get the size of the data.
@@ -447,7 +451,7 @@ namespace Ingester
         /// \return bool data.
         bool isMissing(const Location& loc) const final
         {
-            return get(loc) == missingValue();
+            return !validity_.isValid(index(loc));
         }
 
         /// \brief Get the data at the index into the internal 1d array as a int. This function
@@ -466,6 +470,14 @@ namespace Ingester
         float getAsFloat(const size_t idx) const final { return _getAsFloat(idx); }
 
 
+        /// \brief idx Get the data at the index into the internal 1d array as a double. This
+        ///            function gives you direct access to the internal data and doesn't account for
+        ///            dimensional information (its up to the user).
+        /// \param idx The idx into the internal 1d array.
+        /// \return Double data.
+        double getAsDouble(const size_t idx) const final { return _getAsDouble(idx); }
+
+
         /// \brief idx See if the data at the index into the internal 1d array is missing. This
         ///            function gives you direct access to the internal data and doesn't account for
         ///            dimensional information (its up to the user).
@@ -473,9 +485,12 @@ namespace Ingester
         /// \return bool data.
         bool isMissing(const size_t idx) const final
         {
-            return data_[idx] == missingValue();
+            return !validity_.isValid(idx);
         }
 
+        /// \brief Get the validity bitmap of the data.
+        const ValidityMask& getValidity() const final { return validity_; }
+
 
         /// \brief Slice the dta object according to a list of indices.
         /// \param rows The indices to slice the data object by.
@@ -513,6 +528,86 @@ namespace Ingester
      private:
         std::vector<T> data_;
 
+        /// \brief Validity bitmap for data_ (kept in sync whenever data_ is set). The missing
+        ///        values are still stored in data_ so they become the fill values in ioda.
+        ValidityMask validity_;
+
+        /// \brief Bytes held by this object (see MemoryTracker).
+        TrackedBytes memory_{MemoryTracker::Subsystem::DataObject};
+
+        /// \brief Rebuild the validity bitmap from the data.
+        void updateValidity()
+        {
+            validity_ = ValidityMask::fromData(data_,
+                                               [](const T& val) { return val != missingValue(); });
+            trackMemory();
+        }
+
+        /// \brief Report the bytes held by the data and the validity bitmap.
+        void trackMemory()
+        {
+            memory_.set(_dataBytes() + validity_.words().size() * sizeof(ValidityMask::Word));
+        }
+
+        /// \brief Bytes held by the data (numeric DataObject).
+        template<typename U = void>
+        size_t _dataBytes(
+            typename std::enable_if<std::is_arithmetic<T>::value, U>::type* = nullptr) const
+        {
+            return data_.capacity() * sizeof(T);
+        }
+
+        /// \brief Bytes held by the data (string DataObject).
+        template<typename U = void>
+        size_t _dataBytes(
+            typename std::enable_if<std::is_same<T, std::string>::value, U>::type* = nullptr) const
+        {
+            size_t bytes = data_.capacity() * sizeof(T);
+            for (const auto& str : data_)
+            {
+                bytes += str.size();
+            }
+
+            return bytes;
+        }
+
+        /// \brief Value to print for numeric data (int8 values are printed as numbers).
+        template<typename U = T>
+        static auto _printable(const U& val,
+            typename std::enable_if<std::is_arithmetic<U>::value, U>::type* = nullptr)
+            -> decltype(+val)
+        {
+            return +val;
+        }
+
+        /// \brief Value to print for string data.
+        template<typename U = T>
+        static const U& _printable(const U& val,
+            typename std::enable_if<std::is_same<U, std::string>::value, U>::type* = nullptr)
+        {
+            return val;
+        }
+
+        /// \brief Get the index into data_ for a location.
+        size_t index(const Location& loc) const
+        {
+            size_t dim_prod = 1;
+            for (int dim_idx = dims_.size(); dim_idx > static_cast<int>(loc.size()); --dim_idx)
+            {
+                dim_prod *= dims_[dim_idx];
+            }
+
+            // Compute the index into the data array
+            size_t index = 0;
+            for (int dim_idx = loc.size() - 1; dim_idx >= 0; --dim_idx)
+            {
+                index += dim_prod*loc[dim_idx];
+                dim_prod *= dims_[dim_idx];
+            }
+
+            return index;
+        }
+
 #ifdef BUILD_IODA_BINDING
         /// \brief Make the variable creation parameters.
         /// \param chunks The chunk sizes
@@ -657,6 +752,24 @@ namespace Ingester
             return 0.0f;
         }
 
+        /// \brief Get the data at the index as a double for numeric data.
+        /// \return Double data.
+        template<typename U = void>
+        double _getAsDouble(size_t idx,
+            typename std::enable_if<std::is_arithmetic<T>::value, U>::type* = nullptr) const
+        {
+            return static_cast<double>(data_[idx]);
+        }
+
+        /// \brief Get the data at the index as a double for non-numeric data.
+        /// \return Double data.
+        template<typename U = void>
+        double _getAsDouble(size_t idx,
+            typename std::enable_if<!std::is_arithmetic<T>::value, U>::type* = nullptr) const
+        {
+            throw std::runtime_error("The stored value is not a number");
+        }
+
         /// \brief Set the data associated with this data object (numeric DataObject).
         /// \param data - double vector of raw data
         /// \param dataMissingValue - The number that represents missing values within the raw data
@@ -665,11 +778,27 @@ namespace Ingester
                       double dataMissingValue,
                       typename std::enable_if<std::is_arithmetic<T>::value, U>::type* = nullptr)
         {
-            data_ = std::vector<T>(data.begin(), data.end());
-            std::replace(data_.begin(),
-                         data_.end(),
-                         static_cast<T>(dataMissingValue),
-                         missingValue());
+            // Convert the data and build the validity bitmap in one pass
+            data_.resize(data.size());
+            validity_ = ValidityMask(data.size());
+            for (size_t idx = 0; idx < data.size(); ++idx)
+            {
+                // Compare before converting, the raw missing value doesn't fit in small types
+                if (data[idx] == dataMissingValue)
+                {
+                    data_[idx] = missingValue();
+                    validity_.set(idx, false);
+                    continue;
+                }
+
+                data_[idx] = static_cast<T>(data[idx]);
+                if (data_[idx] == missingValue())
+                {
+                    validity_.set(idx, false);
+                }
+            }
+
+            trackMemory();
         }
 
         /// \brief Set the data associated with this data object (string DataObject).
@@ -702,6 +831,8 @@ namespace Ingester
                     data_.push_back("");
                 }
             }
+
+            updateValidity();
         }
 
         /// \brief Multiply the stored values in this data object by a scalar.
@@ -721,13 +852,10 @@ namespace Ingester
                 typeid(T) == typeid(double) ||  // NOLINT
                 trunc(val) == val)
             {
-                for (size_t i = 0; i < data_.size(); i++)
+                validity_.forEachValid([this, val](size_t idx)
                 {
-                    if (data_[i] != missingValue())
-                    {
-                        data_[i] = static_cast<T>(static_cast<double>(data_[i]) * val);
-                    }
-                }
+                    data_[idx] = static_cast<T>(static_cast<double>(data_[idx]) * val);
+                });
             }
             else
             {
@@ -762,13 +890,11 @@ namespace Ingester
         void _offsetBy(double val,
                        typename std::enable_if<std::is_arithmetic<T>::value, U>::type* = nullptr)
         {
-            for (size_t i = 0; i < data_.size(); i++)
+            const auto offset = static_cast<T>(val);
+            validity_.forEachValid([this, offset](size_t idx)
             {
-                if (data_[i] != missingValue())
-                {
-                    data_[i] = data_[i] + static_cast<T>(val);
-                }
-            }
+                data_[idx] = data_[idx] + offset;
+            });
         }
 
         /// \brief Add a scalar to the stored values in this data object (string version).
@@ -0,0 +1,405 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include "FilterPipeline.h"
+
+#include <map>
+#include <set>
+#include <sstream>
+
+#include "eckit/exception/Exceptions.h"
+#include "oops/util/Logger.h"
+
+
+namespace
+{
+    namespace ConfKeys
+    {
+        const char* Name = "name";
+        const char* Level = "level";
+        const char* Compressor = "compressor";
+        const char* Shuffle = "shuffle";
+        const char* Fallback = "fallback";
+    }  // namespace ConfKeys
+
+    namespace FilterNames
+    {
+        const char* Shuffle = "shuffle";
+        const char* Deflate = "deflate";
+        const char* Gzip = "gzip";
+        const char* Bitshuffle = "bitshuffle";
+        const char* Zstd = "zstd";
+        const char* Lz4 = "lz4";
+        const char* Blosc = "blosc";
+        const char* None = "none";
+    }  // namespace FilterNames
+
+    // Registered HDF5 filter ids of the plugins
+    const H5Z_filter_t BloscFilterId = 32001;
+    const H5Z_filter_t Lz4FilterId = 32004;
+    const H5Z_filter_t BitshuffleFilterId = 32008;
+    const H5Z_filter_t ZstdFilterId = 32015;
+
+    const int DefaultDeflateLevel = 6;
+    const int DefaultZstdLevel = 3;
+    const int DefaultBloscLevel = 5;
+
+    // Compression codes of the bitshuffle plugin
+    const std::map<std::string, unsigned int> BitshuffleCompressors = {{FilterNames::None, 0},
+                                                                       {FilterNames::Lz4, 2},
+                                                                       {FilterNames::Zstd, 3}};
+
+    // Compressor and shuffle codes of the blosc plugin
+    const std::map<std::string, unsigned int> BloscCompressors = {{"blosclz", 0},
+                                                                  {"lz4", 1},
+                                                                  {"lz4hc", 2},
+                                                                  {"snappy", 3},
+                                                                  {"zlib", 4},
+                                                                  {"zstd", 5}};
+
+    const std::map<std::string, unsigned int> BloscShuffles = {{"none", 0},
+                                                               {"byte", 1},
+                                                               {"bit", 2}};
+
+    using Ingester::FilterDescription;
+
+    int getLevel(const eckit::Configuration& conf, const std::string& name, int min, int max,
+                 int defaultLevel)
+    {
+        const int level = conf.getInt(ConfKeys::Level, defaultLevel);
+        if (level < min || level > max)
+        {
+            std::ostringstream errStr;
+            errStr << "The " << name << " filter level must be a number " << min << "-" << max;
+            throw eckit::BadParameter(errStr.str());
+        }
+
+        return level;
+    }
+
+    std::string getOption(const eckit::Configuration& conf,
+                          const std::string& key,
+                          const std::string& filterName,
+                          const std::map<std::string, unsigned int>& options,
+                          const std::string& defaultOption)
+    {
+        const auto option = conf.getString(key, defaultOption);
+        if (options.find(option) == options.end())
+        {
+            std::ostringstream errStr;
+            errStr << "Unknown " << key << " " << option << " for the " << filterName;
+            errStr << " filter (use one of";
+            for (const auto& optionPair : options) errStr << " " << optionPair.first;
+            errStr << ").";
+            throw eckit::BadParameter(errStr.str());
+        }
+
+        return option;
+    }
+
+    FilterDescription makeDeflate(int level)
+    {
+        FilterDescription filter;
+        filter.type = FilterDescription::Type::Deflate;
+        filter.name = FilterNames::Deflate;
+        filter.level = level;
+        return filter;
+    }
+
+    FilterDescription makeShuffle()
+    {
+        FilterDescription filter;
+        filter.type = FilterDescription::Type::Shuffle;
+        filter.name = FilterNames::Shuffle;
+        return filter;
+    }
+
+    /// \brief The filters used when a plugin isn't available and no fallback was configured.
+    std::vector<FilterDescription> defaultFallback(const FilterDescription& filter)
+    {
+        std::vector<FilterDescription> fallback;
+        switch (filter.type)
+        {
+            case FilterDescription::Type::Bitshuffle:
+                fallback.push_back(makeShuffle());
+                if (filter.compressor != FilterNames::None)
+                {
+                    fallback.push_back(makeDeflate(DefaultDeflateLevel));
+                }
+                break;
+            case FilterDescription::Type::Blosc:
+                if (filter.shuffle != FilterNames::None) fallback.push_back(makeShuffle());
+                fallback.push_back(makeDeflate(DefaultDeflateLevel));
+                break;
+            case FilterDescription::Type::Zstd:
+            case FilterDescription::Type::Lz4:
+                fallback.push_back(makeDeflate(DefaultDeflateLevel));
+                break;
+            default:
+                break;
+        }
+
+        return fallback;
+    }
+
+    FilterDescription makeFilter(const eckit::LocalConfiguration& conf)
+    {
+        if (!conf.has(ConfKeys::Name))
+        {
+            throw eckit::BadParameter("Filter pipeline entries need a name.");
+        }
+
+        FilterDescription filter;
+        filter.name = conf.getString(ConfKeys::Name);
+
+        if (filter.name == FilterNames::Shuffle)
+        {
+            filter.type = FilterDescription::Type::Shuffle;
+        }
+        else if (filter.name == FilterNames::Deflate || filter.name == FilterNames::Gzip)
+        {
+            filter.type = FilterDescription::Type::Deflate;
+            filter.name = FilterNames::Deflate;
+            filter.level = getLevel(conf, filter.name, 0, 9, DefaultDeflateLevel);
+        }
+        else if (filter.name == FilterNames::Bitshuffle)
+        {
+            filter.type = FilterDescription::Type::Bitshuffle;
+            filter.compressor = getOption(conf, ConfKeys::Compressor, filter.name,
+                                          BitshuffleCompressors, FilterNames::None);
+            if (filter.compressor == FilterNames::Zstd)
+            {
+                filter.level = getLevel(conf, filter.name, 1, 22, DefaultZstdLevel);
+            }
+        }
+        else if (filter.name == FilterNames::Zstd)
+        {
+            filter.type = FilterDescription::Type::Zstd;
+            filter.level = getLevel(conf, filter.name, 1, 22, DefaultZstdLevel);
+        }
+        else if (filter.name == FilterNames::Lz4)
+        {
+            filter.type = FilterDescription::Type::Lz4;
+        }
+        else if (filter.name == FilterNames::Blosc)
+        {
+            filter.type = FilterDescription::Type::Blosc;
+            filter.level = getLevel(conf, filter.name, 0, 9, DefaultBloscLevel);
+            filter.compressor = getOption(conf, ConfKeys::Compressor, filter.name,
+                                          BloscCompressors, FilterNames::Lz4);
+            filter.shuffle = getOption(conf, ConfKeys::Shuffle, filter.name,
+                                       BloscShuffles, "byte");
+        }
+        else
+        {
+            std::ostringstream errStr;
+            errStr << "Unknown filter " << filter.name << " (use " << FilterNames::Shuffle << ", ";
+            errStr << FilterNames::Deflate << ", " << FilterNames::Bitshuffle << ", ";
+            errStr << FilterNames::Zstd << ", " << FilterNames::Lz4 << " or ";
+            errStr << FilterNames::Blosc << ").";
+            throw eckit::BadParameter(errStr.str());
+        }
+
+        if (conf.has(ConfKeys::Fallback))
+        {
+            for (const auto& fallbackConf : conf.getSubConfigurations(ConfKeys::Fallback))
+            {
+                filter.fallback.push_back(makeFilter(fallbackConf));
+            }
+        }
+        else
+        {
+            filter.fallback = defaultFallback(filter);
+        }
+
+        return filter;
+    }
+
+    H5Z_filter_t pluginId(const FilterDescription& filter)
+    {
+        switch (filter.type)
+        {
+            case FilterDescription::Type::Bitshuffle: return BitshuffleFilterId;
+            case FilterDescription::Type::Zstd: return ZstdFilterId;
+            case FilterDescription::Type::Lz4: return Lz4FilterId;
+            case FilterDescription::Type::Blosc: return BloscFilterId;
+            default: return H5Z_FILTER_NONE;
+        }
+    }
+
+    /// \brief The parameters (cd_values) of a plugin filter. The first values of bitshuffle and
+    ///        blosc are reserved, their plugins fill them in when the dataset is created.
+    std::vector<unsigned int> pluginValues(const FilterDescription& filter)
+    {
+        switch (filter.type)
+        {
+            case FilterDescription::Type::Bitshuffle:
+            {
+                std::vector<unsigned int> values = {0, 0, 0, 0,
+                                                    BitshuffleCompressors.at(filter.compressor)};
+                if (filter.compressor == FilterNames::Zstd)
+                {
+                    values.push_back(static_cast<unsigned int>(filter.level));
+                }
+                return values;
+            }
+            case FilterDescription::Type::Zstd:
+                return {static_cast<unsigned int>(filter.level)};
+            case FilterDescription::Type::Blosc:
+                return {0, 0, 0, 0,
+                        static_cast<unsigned int>(filter.level),
+                        BloscShuffles.at(filter.shuffle),
+                        BloscCompressors.at(filter.compressor)};
+            default:
+                return {};
+        }
+    }
+
+    std::string filterStr(const FilterDescription& filter)
+    {
+        std::ostringstream str;
+        str << filter.name;
+        switch (filter.type)
+        {
+            case FilterDescription::Type::Deflate:
+            case FilterDescription::Type::Zstd:
+                str << "(" << filter.level << ")";
+                break;
+            case FilterDescription::Type::Bitshuffle:
+                if (filter.compressor != FilterNames::None) str << "(" << filter.compressor << ")";
+                break;
+            case FilterDescription::Type::Blosc:
+                str << "(" << filter.compressor << ", " << filter.level << ", ";
+                str << filter.shuffle << ")";
+                break;
+            default:
+                break;
+        }
+
+        return str.str();
+    }
+
+    std::string filtersStr(const std::vector<FilterDescription>& filters)
+    {
+        std::ostringstream str;
+        for (size_t filterIdx = 0; filterIdx < filters.size(); ++filterIdx)
+        {
+            if (filterIdx > 0) str << ", ";
+            str << filterStr(filters[filterIdx]);
+        }
+
+        return filters.empty() ? std::string("no filters") : str.str();
+    }
+
+    /// \brief Can HDF5 load the plugin? Warns (once per filter) when it can't.
+    bool pluginAvailable(const FilterDescription& filter)
+    {
+        static std::set<H5Z_filter_t> missingFilters;
+
+        const auto id = pluginId(filter);
+        if (H5Zfilter_avail(id) > 0) return true;
+
+        if (missingFilters.insert(id).second)
+        {
+            oops::Log::warning() << "Warning: The HDF5 " << filter.name << " filter plugin is not ";
+            oops::Log::warning() << "available (see HDF5_PLUGIN_PATH). Using ";
+            oops::Log::warning() << filtersStr(filter.fallback) << " instead." << std::endl;
+        }
+
+        return false;
+    }
+
+    void applyFilters(hid_t dcpl, const std::vector<FilterDescription>& filters)
+    {
+        for (const auto& filter : filters)
+        {
+            herr_t status = 0;
+            switch (filter.type)
+            {
+                case FilterDescription::Type::Shuffle:
+                    status = H5Pset_shuffle(dcpl);
+                    break;
+                case FilterDescription::Type::Deflate:
+                    if (filter.level > 0) status = H5Pset_deflate(dcpl, filter.level);
+                    break;
+                default:
+                {
+                    if (!pluginAvailable(filter))
+                    {
+                        applyFilters(dcpl, filter.fallback);
+                        break;
+                    }
+
+                    const auto values = pluginValues(filter);
+                    status = H5Pset_filter(dcpl,
+                                           pluginId(filter),
+                                           H5Z_FLAG_OPTIONAL,
+                                           values.size(),
+                                           values.data());
+                    break;
+                }
+            }
+
+            if (status < 0)
+            {
+                throw eckit::BadParameter("Could not add the " + filterStr(filter) + " filter.");
+            }
+        }
+    }
+
+    int deflateLevel(const std::vector<FilterDescription>& filters)
+    {
+        for (const auto& filter : filters)
+        {
+            if (filter.type == FilterDescription::Type::Deflate) return filter.level;
+
+            const int level = deflateLevel(filter.fallback);
+            if (level > 0) return level;
+        }
+
+        return 0;
+    }
+}  // namespace
+
+
+namespace Ingester
+{
+    FilterPipeline::FilterPipeline(const std::vector<eckit::LocalConfiguration>& confs)
+    {
+        for (const auto& conf : confs)
+        {
+            filters_.push_back(makeFilter(conf));
+        }
+    }
+
+    FilterPipeline FilterPipeline::deflate(int level)
+    {
+        FilterPipeline pipeline;
+        if (level > 0) pipeline.filters_.push_back(makeDeflate(level));
+        return pipeline;
+    }
+
+    bool FilterPipeline::needsHdf5() const
+    {
+        for (const auto& filter : filters_)
+        {
+            if (filter.type != FilterDescription::Type::Deflate) return true;
+        }
+
+        return false;
+    }
+
+    int FilterPipeline::deflateLevel() const
+    {
+        return ::deflateLevel(filters_);
+    }
+
+    void FilterPipeline::apply(hid_t dcpl) const
+    {
+        applyFilters(dcpl, filters_);
+    }
+}  // namespace Ingester
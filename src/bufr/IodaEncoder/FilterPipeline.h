@@ -0,0 +1,79 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <hdf5.h>
+
+#include <string>
+#include <vector>
+
+#include "eckit/config/LocalConfiguration.h"
+
+
+namespace Ingester
+{
+    /// \brief One HDF5 filter of a FilterPipeline.
+    struct FilterDescription
+    {
+        enum class Type
+        {
+            Shuffle,     ///< Byte shuffle (built into HDF5)
+            Deflate,     ///< GZip (built into HDF5)
+            Bitshuffle,  ///< Bit shuffle with optional lz4 or zstd compression (plugin)
+            Zstd,        ///< Zstandard (plugin)
+            Lz4,         ///< LZ4 (plugin)
+            Blosc        ///< Blosc with any of its compressors (plugin)
+        };
+
+        Type type;
+        std::string name;
+        int level = 0;           ///< Compression level (Deflate, Zstd, Blosc and Bitshuffle+zstd)
+        std::string compressor;  ///< Inner compressor (Bitshuffle and Blosc)
+        std::string shuffle;     ///< Shuffle done by Blosc (none, byte or bit)
+
+        /// \brief Filters used instead of this one when its plugin can't be loaded.
+        std::vector<FilterDescription> fallback;
+    };
+
+    /// \brief The list of HDF5 filters applied (in order) to the chunks of a variable, ex: shuffle
+    ///        followed by zstd. Filters that are HDF5 plugins (bitshuffle, zstd, lz4 and blosc)
+    ///        are only used when HDF5 can load the plugin, otherwise their fallback filters are
+    ///        used (deflate for the codecs and shuffle for bitshuffle unless configured).
+    class FilterPipeline
+    {
+     public:
+        FilterPipeline() = default;
+
+        /// \brief Make the pipeline from a list of filter configurations.
+        /// \param confs The filters (keys: name, level, compressor, shuffle and fallback).
+        explicit FilterPipeline(const std::vector<eckit::LocalConfiguration>& confs);
+
+        /// \brief Pipeline that only uses deflate (gzip).
+        /// \param level The deflate level (0 means no filter at all).
+        static FilterPipeline deflate(int level);
+
+        /// \brief Does the pipeline use filters that ioda can't apply (anything but deflate)? Such
+        ///        pipelines are applied with HDF5 directly.
+        bool needsHdf5() const;
+
+        /// \brief The deflate level to use when the variable is written through ioda (ex: string
+        ///        variables or the in-memory backend). Filters other than deflate are replaced by
+        ///        their fallbacks. 0 if the pipeline doesn't deflate.
+        int deflateLevel() const;
+
+        /// \brief The filters in the order they are applied.
+        const std::vector<FilterDescription>& filters() const { return filters_; }
+
+        /// \brief Add the filters to a (chunked) HDF5 dataset creation property list.
+        /// \param dcpl The dataset creation property list.
+        void apply(hid_t dcpl) const;
+
+     private:
+        std::vector<FilterDescription> filters_;
+    };
+}  // namespace Ingester
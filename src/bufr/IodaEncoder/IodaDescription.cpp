@@ -20,6 +20,9 @@ namespace
         const char* Dimensions = "dimensions";
         const char* Variables = "variables";
         const char* Globals = "globals";
+        const char* MaxLocationsPerFile = "maxLocationsPerFile";
+        const char* Manifest = "manifest";
+        const char* Filters = "filters";
 
         namespace Dimension
         {
@@ -39,6 +42,7 @@ namespace
             const char* Coords = "coordinates";
             const char* Chunks = "chunks";
             const char* CompressionLevel = "compressionLevel";
+            const char* Filters = "filters";
         }  // namespace Variable
 
         namespace Global
@@ -74,7 +78,7 @@ namespace Ingester
         }
         else
         {
-            if (backend_ == ioda::Engines::BackendNames::ObsStore)
+            if (!writesFiles())
             {
                 filepath_ = "";
             }
@@ -84,6 +88,34 @@ namespace Ingester
             }
         }
 
+        if (conf.has(ConfKeys::MaxLocationsPerFile))
+        {
+            int maxLocs = conf.getInt(ConfKeys::MaxLocationsPerFile);
+            if (maxLocs <= 0)
+            {
+                throw eckit::BadParameter("ioda::maxLocationsPerFile must be a positive number.");
+            }
+
+            if (writesFiles() &&
+                filepath_.find("{shard}") == std::string::npos)
+            {
+                throw eckit::BadParameter(
+                    "ioda::obsdataout must contain {shard} when maxLocationsPerFile is set.");
+            }
+
+            maxLocationsPerFile_ = static_cast<size_t>(maxLocs);
+        }
+
+        if (conf.has(ConfKeys::Manifest))
+        {
+            if (!writesFiles())
+            {
+                throw eckit::BadParameter("ioda::manifest is only supported for file backends.");
+            }
+
+            manifestPath_ = conf.getString(ConfKeys::Manifest);
+        }
+
         if (conf.has(ConfKeys::Dimensions))
         {
             auto dimConfs = conf.getSubConfigurations(ConfKeys::Dimensions);
@@ -132,6 +164,12 @@ namespace Ingester
             throw eckit::BadParameter(errStr.str());
         }
 
+        auto defaultFilters = FilterPipeline::deflate(6);
+        if (conf.has(ConfKeys::Filters))
+        {
+            defaultFilters = FilterPipeline(conf.getSubConfigurations(ConfKeys::Filters));
+        }
+
         for (const auto& varConf : varConfs)
         {
             VariableDescription variable;
@@ -177,8 +215,15 @@ namespace Ingester
                 variable.chunks = chunks;
             }
 
-            variable.compressionLevel = 6;
-            if (varConf.has(ConfKeys::Variable::CompressionLevel))
+            // The variable's own filters or compressionLevel take precedence over the default
+            // filters.
+            variable.filters = defaultFilters;
+            if (varConf.has(ConfKeys::Variable::Filters))
+            {
+                variable.filters =
+                    FilterPipeline(varConf.getSubConfigurations(ConfKeys::Variable::Filters));
+            }
+            else if (varConf.has(ConfKeys::Variable::CompressionLevel))
             {
                 int compressionLevel = varConf.getInt(ConfKeys::Variable::CompressionLevel);
                 if (compressionLevel < 0 || compressionLevel > 9)
@@ -186,9 +231,11 @@ namespace Ingester
                     throw eckit::BadParameter("GZip compression level must be a number 0-9");
                 }
 
-                variable.compressionLevel = varConf.getInt(ConfKeys::Variable::CompressionLevel);
+                variable.filters = FilterPipeline::deflate(compressionLevel);
             }
 
+            variable.compressionLevel = variable.filters.deflateLevel();
+
             addVariable(variable);
         }
 
@@ -271,6 +318,12 @@ namespace Ingester
         {
             setBackend(ioda::Engines::BackendNames::ObsStore);
         }
+        else if (backend_lowercase == "zarr")
+        {
+            // The ObsGroup is built in memory and written out as a Zarr store
+            setBackend(ioda::Engines::BackendNames::ObsStore);
+            setZarr(true);
+        }
         else
         {
             throw eckit::BadParameter("Unknown ioda::backend specified.");
@@ -16,6 +16,7 @@
 #include "ioda/Group.h"
 
 #include "../BufrParser/Query/QueryParser.h"
+#include "FilterPipeline.h"
 
 namespace Ingester
 {
@@ -43,6 +44,7 @@ namespace Ingester
         std::shared_ptr<Range> range;  // Optional
         std::vector<ioda::Dimensions_t> chunks;  // Optional
         int compressionLevel;  // Optional
+        FilterPipeline filters;  // Optional
     };
 
     struct GlobalDescriptionBase
@@ -110,12 +112,27 @@ namespace Ingester
         void addGlobal(const std::shared_ptr<GlobalDescriptionBase>& global);
 
         // Setters
-        inline void setBackend(const ioda::Engines::BackendNames& backend) { backend_ = backend; }
+        inline void setBackend(const ioda::Engines::BackendNames& backend)
+        {
+            backend_ = backend;
+            zarr_ = false;
+        }
+
+        inline void setZarr(bool zarr) { zarr_ = zarr; }
         inline void setFilepath(const std::string& filepath) { filepath_ = filepath; }
+        inline void setMaxLocationsPerFile(size_t maxLocs) { maxLocationsPerFile_ = maxLocs; }
+        inline void setManifestPath(const std::string& path) { manifestPath_ = path; }
 
         // Getters
         inline ioda::Engines::BackendNames getBackend() const { return backend_; }
+        inline bool isZarr() const { return zarr_; }
+        inline bool writesFiles() const
+        {
+            return zarr_ || backend_ == ioda::Engines::BackendNames::Hdf5File;
+        }
         inline std::string getFilepath() const { return filepath_; }
+        inline size_t getMaxLocationsPerFile() const { return maxLocationsPerFile_; }
+        inline std::string getManifestPath() const { return manifestPath_; }
         inline DimDescriptions getDims() const { return dimensions_; }
         inline VariableDescriptions getVariables() const { return variables_; }
         inline GlobalDescriptions getGlobals() const { return globals_; }
@@ -124,9 +141,18 @@ namespace Ingester
         /// \brief The backend type to use
         ioda::Engines::BackendNames backend_;
 
+        /// \brief Write a Zarr store (the ObsGroup itself is kept in memory)
+        bool zarr_ = false;
+
         /// \brief The relative path of the output file to create
         std::string filepath_;
 
+        /// \brief The max number of locations to write to a single file (0 means no limit)
+        size_t maxLocationsPerFile_ = 0;
+
+        /// \brief Path of the manifest file listing the output files (empty means none)
+        std::string manifestPath_;
+
         /// \brief Collection of defined dimensions
         DimDescriptions dimensions_;
 
@@ -7,10 +7,18 @@
 
 #include "IodaEncoder.h"
 
+#include <hdf5.h>
+#include <hdf5_hl.h>
+
+#include <algorithm>
+#include <fstream>
 #include <memory>
 #include <map>
+#include <numeric>
 #include <string>
 #include <sstream>
+#include <type_traits>
+#include <vector>
 
 #include "eckit/exception/Exceptions.h"
 #include "oops/util/Logger.h"
@@ -18,6 +26,128 @@
 #include "ioda/Layout.h"
 #include "ioda/Misc/DimensionScales.h"
 
+#include "ZarrWriter.h"
+
+
+namespace
+{
+    /// \brief Owns an HDF5 identifier.
+    class Hdf5Handle
+    {
+     public:
+        Hdf5Handle(hid_t id, herr_t (*close)(hid_t)) :
+            id_(id),
+            close_(close)
+        {
+        }
+
+        ~Hdf5Handle()
+        {
+            if (id_ >= 0) close_(id_);
+        }
+
+        Hdf5Handle(const Hdf5Handle&) = delete;
+        Hdf5Handle& operator=(const Hdf5Handle&) = delete;
+
+        inline operator hid_t() const { return id_; }
+
+     private:
+        hid_t id_;
+        herr_t (*close_)(hid_t);
+    };
+
+    /// \brief Throw if an HDF5 call failed.
+    template<typename T>
+    T check(T result, const std::string& errorMsg)
+    {
+        if (result < 0)
+        {
+            throw eckit::BadParameter(errorMsg);
+        }
+
+        return result;
+    }
+
+    template<typename T>
+    hid_t nativeType()
+    {
+        if (std::is_same<T, float>::value) return H5T_NATIVE_FLOAT;
+        if (std::is_same<T, double>::value) return H5T_NATIVE_DOUBLE;
+
+        const bool isSigned = std::is_signed<T>::value;
+        switch (sizeof(T))
+        {
+            case 1: return isSigned ? H5T_NATIVE_INT8 : H5T_NATIVE_UINT8;
+            case 2: return isSigned ? H5T_NATIVE_INT16 : H5T_NATIVE_UINT16;
+            case 4: return isSigned ? H5T_NATIVE_INT32 : H5T_NATIVE_UINT32;
+            default: return isSigned ? H5T_NATIVE_INT64 : H5T_NATIVE_UINT64;
+        }
+    }
+
+    template<typename T>
+    void addAttribute(hid_t loc, const std::string& name, const std::vector<T>& values)
+    {
+        const hsize_t size = values.size();
+        Hdf5Handle space(H5Screate_simple(1, &size, nullptr), H5Sclose);
+        Hdf5Handle attr(check(H5Acreate2(loc, name.c_str(), nativeType<T>(), space, H5P_DEFAULT,
+                                         H5P_DEFAULT),
+                              "Could not create the attribute " + name),
+                        H5Aclose);
+        check(H5Awrite(attr, nativeType<T>(), values.data()),
+              "Could not write the attribute " + name);
+    }
+
+    void addStringAttribute(hid_t loc, const std::string& name, const std::string& value)
+    {
+        Hdf5Handle type(H5Tcopy(H5T_C_S1), H5Tclose);
+        H5Tset_size(type, H5T_VARIABLE);
+        H5Tset_cset(type, H5T_CSET_UTF8);
+
+        const hsize_t size = 1;
+        Hdf5Handle space(H5Screate_simple(1, &size, nullptr), H5Sclose);
+        Hdf5Handle attr(check(H5Acreate2(loc, name.c_str(), type, space, H5P_DEFAULT,
+                                         H5P_DEFAULT),
+                              "Could not create the attribute " + name),
+                        H5Aclose);
+
+        const char* str = value.c_str();
+        check(H5Awrite(attr, type, &str), "Could not write the attribute " + name);
+    }
+
+    /// \brief Create and write the dataset if the data is a DataObject<T>.
+    /// \return False if the data has another type.
+    template<typename T>
+    bool writeDataset(hid_t file,
+                      const std::string& name,
+                      const std::shared_ptr<Ingester::DataObjectBase>& dataObject,
+                      const std::vector<hsize_t>& dims,
+                      hid_t dcpl)
+    {
+        const auto typedObject = std::dynamic_pointer_cast<Ingester::DataObject<T>>(dataObject);
+        if (typedObject == nullptr) return false;
+
+        const T fillValue = Ingester::DataObject<T>::missingValue();
+        check(H5Pset_fill_value(dcpl, nativeType<T>(), &fillValue),
+              "Could not set the fill value of " + name);
+
+        Hdf5Handle space(H5Screate_simple(static_cast<int>(dims.size()), dims.data(), nullptr),
+                         H5Sclose);
+        Hdf5Handle lcpl(H5Pcreate(H5P_LINK_CREATE), H5Pclose);
+        H5Pset_create_intermediate_group(lcpl, 1);
+
+        Hdf5Handle dataset(check(H5Dcreate2(file, name.c_str(), nativeType<T>(), space, lcpl,
+                                            dcpl, H5P_DEFAULT),
+                                 "Could not create the variable " + name),
+                           H5Dclose);
+        check(H5Dwrite(dataset, nativeType<T>(), H5S_ALL, H5S_ALL, H5P_DEFAULT,
+                       typedObject->rawData().data()),
+              "Could not write the variable " + name);
+
+        addAttribute<T>(dataset, "_FillValue", {fillValue});
+        return true;
+    }
+}  // namespace
+
 
 namespace Ingester
 {
@@ -32,6 +162,8 @@ namespace Ingester
     std::map<SubCategory, ioda::ObsGroup>
         IodaEncoder::encode(const std::shared_ptr<DataContainer>& dataContainer, bool append)
     {
+        bufr::TaskScheduler::Scope schedulerScope(scheduler_);
+
         auto backendParams = ioda::Engines::BackendCreationParameters();
         std::map<SubCategory, ioda::ObsGroup> obsGroups;
 
@@ -80,12 +212,10 @@ namespace Ingester
             }
         }
 
-        // Got through each unique category
+        // Divide each unique category into the shards (output objects) we need to write
+        std::vector<Shard> shards;
         for (const auto& categories : dataContainer->allSubCategories())
         {
-            // Create the dimensions variables
-            std::map<std::string, std::shared_ptr<DimensionDataBase>> dimMap;
-
             auto dataObjectGroupBy = dataContainer->getGroupByObject(
                 description_.getVariables()[0].source, categories);
 
@@ -100,10 +230,78 @@ namespace Ingester
                 continue;
             }
 
+            auto categoryShards = makeShards(categories, dataObjectGroupBy->getDims()[0]);
+            shards.insert(shards.end(), categoryShards.begin(), categoryShards.end());
+        }
+
+        // The fields each shard needs
+        std::vector<std::string> sources;
+        for (const auto& dimDesc : description_.getDims())
+        {
+            if (!dimDesc.source.empty()) sources.push_back(dimDesc.source);
+        }
+
+        for (const auto& varDesc : description_.getVariables())
+        {
+            sources.push_back(varDesc.source);
+        }
+
+        std::sort(sources.begin(), sources.end());
+        sources.erase(std::unique(sources.begin(), sources.end()), sources.end());
+
+        // Get the data of a shard (only the rows that belong to it) as tasks, so the data of the
+        // next shard is sliced while ioda writes the current one.
+        std::vector<std::shared_ptr<DataObjectBase>> shardData;
+        std::vector<std::shared_ptr<DataObjectBase>> nextShardData;
+        bufr::TaskGroup slicing;
+        auto startSlicing = [&](size_t shardIdx)
+        {
+            nextShardData.assign(sources.size(), nullptr);
+            for (size_t srcIdx = 0; srcIdx < sources.size(); ++srcIdx)
+            {
+                slicing.run([&, shardIdx, srcIdx]()
+                {
+                    const auto& shard = shards[shardIdx];
+                    auto dataObject = dataContainer->get(sources[srcIdx], shard.categories);
+                    if (shard.count != shard.totalCount)
+                    {
+                        std::vector<size_t> shardRows(shard.count);
+                        std::iota(shardRows.begin(), shardRows.end(), shard.start);
+                        dataObject = dataObject->slice(shardRows);
+                    }
+
+                    nextShardData[srcIdx] = dataObject;
+                });
+            }
+        };
+
+        if (!shards.empty()) startSlicing(0);
+
+        // Got through each shard
+        for (size_t shardIdx = 0; shardIdx < shards.size(); ++shardIdx)
+        {
+            auto& shard = shards[shardIdx];
+            const auto& categories = shard.categories;
+
+            slicing.wait();
+            std::swap(shardData, nextShardData);
+            if (shardIdx + 1 < shards.size()) startSlicing(shardIdx + 1);
+
+            auto getData = [&](const std::string& source) -> std::shared_ptr<DataObjectBase>
+            {
+                auto srcIt = std::lower_bound(sources.begin(), sources.end(), source);
+                return shardData[static_cast<size_t>(srcIt - sources.begin())];
+            };
+
+            // Create the dimensions variables
+            std::map<std::string, std::shared_ptr<DimensionDataBase>> dimMap;
+
+            auto dataObjectGroupBy = dataContainer->getGroupByObject(
+                description_.getVariables()[0].source, categories);
+
             // Create the root Location dimension for this category
-            auto rootDim = std::make_shared<DimensionData<int>>(dataObjectGroupBy->getDims()[0]);
-            rootDim->dimScale =
-                ioda::NewDimensionScale<int>(LocationName, dataObjectGroupBy->getDims()[0]);
+            auto rootDim = std::make_shared<DimensionData<int>>(shard.count);
+            rootDim->dimScale = ioda::NewDimensionScale<int>(LocationName, shard.count);
             dimMap[LocationName] = rootDim;
 
             // Add the root Location dimension as a named dimension
@@ -117,7 +315,7 @@ namespace Ingester
             {
                 if (!dimDesc.source.empty())
                 {
-                    auto dataObject = dataContainer->get(dimDesc.source, categories);
+                    auto dataObject = getData(dimDesc.source);
 
                     // Validate the path for the source field makes sense for the dimension
                     if (std::find(dimDesc.paths.begin(),
@@ -142,7 +340,7 @@ namespace Ingester
             int autoGenDimNumber = 2;
             for (const auto& varDesc : description_.getVariables())
             {
-                auto dataObject = dataContainer->get(varDesc.source, categories);
+                auto dataObject = getData(varDesc.source);
 
                 for (std::size_t dimIdx  = 1; dimIdx < dataObject->getDimPaths().size(); dimIdx++)
                 {
@@ -176,7 +374,7 @@ namespace Ingester
             }
 
             // Make the filename string
-            if (description_.getBackend() == ioda::Engines::BackendNames::Hdf5File)
+            if (description_.writesFiles())
             {
                 std::string filename = description_.getFilepath();
 
@@ -188,7 +386,13 @@ namespace Ingester
                     catIdx++;
                 }
 
+                if (description_.getMaxLocationsPerFile() > 0)
+                {
+                    substitutions.insert({"shard", std::to_string(shard.index)});
+                }
+
                 backendParams.fileName = makeStrWithSubstitions(filename, substitutions);
+                shard.filename = backendParams.fileName;
             }
 
             backendParams.openMode = ioda::Engines::BackendOpenModes::Read_Write;
@@ -196,7 +400,8 @@ namespace Ingester
             backendParams.action = append ? ioda::Engines::BackendFileActions::Open : \
                                         ioda::Engines::BackendFileActions::Create;
             backendParams.flush = true;
-            backendParams.allocBytes = dataContainer->size(categories);
+            backendParams.allocBytes = dataContainer->size(categories) * shard.count \
+                                       / shard.totalCount;
 
             auto rootGroup = ioda::Engines::constructBackend(description_.getBackend(),
                                                              backendParams);
@@ -217,12 +422,16 @@ namespace Ingester
                 global->addTo(rootGroup);
             }
 
+            // The Zarr stores are written from the data objects, so the in-memory ObsGroup
+            // only needs the variables when the caller reads them.
+            const bool writeObsGroup = !description_.isZarr() || keepObsGroups_;
+
             // Write the Dimension Variables
             for (const auto& dimDesc : description_.getDims())
             {
-                if (!dimDesc.source.empty())
+                if (writeObsGroup && !dimDesc.source.empty())
                 {
-                    auto dataObject = dataContainer->get(dimDesc.source, categories);
+                    auto dataObject = getData(dimDesc.source);
                     for (size_t dimIdx = 0; dimIdx < dataObject->getDims().size(); dimIdx++)
                     {
                         auto dimPath = dataObject->getDimPaths()[dimIdx];
@@ -245,11 +454,14 @@ namespace Ingester
             }
 
             // Write all the other Variables
+            std::vector<FilteredVariable> filteredVars;
+            std::vector<FilteredVariable> zarrVars;
             for (const auto& varDesc : description_.getVariables())
             {
                 std::vector<ioda::Dimensions_t> chunks;
                 auto dimensions = std::vector<ioda::Variable>();
-                auto dataObject = dataContainer->get(varDesc.source, categories);
+                std::vector<std::string> dimNames;
+                auto dataObject = getData(varDesc.source);
                 for (size_t dimIdx = 0; dimIdx < dataObject->getDims().size(); dimIdx++)
                 {
                     auto dimPath = dataObject->getDimPaths()[dimIdx];
@@ -264,8 +476,10 @@ namespace Ingester
                         namedPathDims = namedExtraDims;
                     }
 
-                    auto dimVar = obsGroup.vars[dimForDimPath(dimPath, namedPathDims).name];
+                    auto dimName = dimForDimPath(dimPath, namedPathDims).name;
+                    auto dimVar = obsGroup.vars[dimName];
                     dimensions.push_back(dimVar);
+                    dimNames.push_back(dimName);
 
                     if (dimIdx < varDesc.chunks.size())
                     {
@@ -278,6 +492,25 @@ namespace Ingester
                     }
                 }
 
+                // ioda can only deflate, so numeric variables with other filters are written
+                // with HDF5 directly (strings keep deflate, see FilterPipeline::deflateLevel).
+                if (description_.getBackend() == ioda::Engines::BackendNames::Hdf5File &&
+                    varDesc.filters.needsHdf5() &&
+                    std::dynamic_pointer_cast<DataObject<std::string>>(dataObject) == nullptr)
+                {
+                    filteredVars.push_back({varDesc, dataObject, dimNames, chunks});
+                    continue;
+                }
+
+                if (description_.isZarr())
+                {
+                    zarrVars.push_back({varDesc, dataObject, dimNames, chunks});
+                    if (!writeObsGroup)
+                    {
+                        continue;
+                    }
+                }
+
                 auto var = dataObject->createVariable(obsGroup,
                                                       varDesc.name,
                                                       dimensions,
@@ -304,12 +537,195 @@ namespace Ingester
                 }
             }
 
-            obsGroups.insert({categories, obsGroup});
+            if (!filteredVars.empty())
+            {
+                // Let ioda close the file while HDF5 adds the filtered variables, then open it
+                // again for the caller.
+                obsGroup = ioda::ObsGroup();
+                rootGroup = ioda::Group();
+
+                writeFilteredVariables(shard.filename, filteredVars);
+
+                backendParams.action = ioda::Engines::BackendFileActions::Open;
+                rootGroup = ioda::Engines::constructBackend(description_.getBackend(),
+                                                            backendParams);
+                obsGroup = ioda::ObsGroup(rootGroup, layoutPolicy);
+            }
+
+            if (description_.isZarr())
+            {
+                ZarrWriter zarr(shard.filename);
+                for (const auto& global : description_.getGlobals())
+                {
+                    zarr.addGlobal(*global);
+                }
+
+                for (const auto& dimPair : dimMap)
+                {
+                    zarr.addDimension(dimPair.first, *dimPair.second);
+                }
+
+                for (const auto& var : zarrVars)
+                {
+                    zarr.addVariable(var.description, var.data, var.dimNames, var.chunks);
+                }
+
+                zarr.write();
+            }
+
+            // Shards of the same category are told apart by their shard index
+            auto key = categories;
+            if (description_.getMaxLocationsPerFile() > 0)
+            {
+                key.push_back(std::to_string(shard.index));
+            }
+
+            obsGroups.insert({key, obsGroup});
+        }
+
+        if (!description_.getManifestPath().empty())
+        {
+            writeManifest(shards);
         }
 
         return obsGroups;
     }
 
+    void IodaEncoder::writeFilteredVariables(const std::string& filename,
+                                             const std::vector<FilteredVariable>& variables) const
+    {
+        Hdf5Handle file(check(H5Fopen(filename.c_str(), H5F_ACC_RDWR, H5P_DEFAULT),
+                              "Could not open " + filename + " to add the filtered variables."),
+                        H5Fclose);
+
+        for (const auto& variable : variables)
+        {
+            const auto& varDesc = variable.description;
+            const auto dataDims = variable.data->getDims();
+            std::vector<hsize_t> dims(dataDims.begin(), dataDims.end());
+
+            // Empty variables can't be chunked (and have nothing to filter anyway).
+            Hdf5Handle dcpl(H5Pcreate(H5P_DATASET_CREATE), H5Pclose);
+            if (std::find(dims.begin(), dims.end(), 0) == dims.end())
+            {
+                std::vector<hsize_t> chunks(dims.size());
+                for (size_t dimIdx = 0; dimIdx < dims.size(); ++dimIdx)
+                {
+                    const auto chunk = static_cast<hsize_t>(
+                        std::max<ioda::Dimensions_t>(1, variable.chunks[dimIdx]));
+                    chunks[dimIdx] = std::min(chunk, dims[dimIdx]);
+                }
+
+                check(H5Pset_chunk(dcpl, static_cast<int>(chunks.size()), chunks.data()),
+                      "Could not set the chunks of " + varDesc.name);
+                varDesc.filters.apply(dcpl);
+            }
+
+            const auto& data = variable.data;
+            if (!(writeDataset<float>(file, varDesc.name, data, dims, dcpl) ||
+                  writeDataset<double>(file, varDesc.name, data, dims, dcpl) ||
+                  writeDataset<int>(file, varDesc.name, data, dims, dcpl) ||
+                  writeDataset<int8_t>(file, varDesc.name, data, dims, dcpl) ||
+                  writeDataset<int16_t>(file, varDesc.name, data, dims, dcpl) ||
+                  writeDataset<int64_t>(file, varDesc.name, data, dims, dcpl) ||
+                  writeDataset<uint32_t>(file, varDesc.name, data, dims, dcpl) ||
+                  writeDataset<uint64_t>(file, varDesc.name, data, dims, dcpl)))
+            {
+                throw eckit::BadParameter("The type of " + varDesc.name + " can't be written "
+                                          "with HDF5 filters.");
+            }
+
+            Hdf5Handle dataset(H5Dopen2(file, varDesc.name.c_str(), H5P_DEFAULT), H5Dclose);
+            for (size_t dimIdx = 0; dimIdx < variable.dimNames.size(); ++dimIdx)
+            {
+                const auto& dimName = variable.dimNames[dimIdx];
+                Hdf5Handle scale(check(H5Dopen2(file, dimName.c_str(), H5P_DEFAULT),
+                                       "Could not open the dimension " + dimName),
+                                 H5Dclose);
+                check(H5DSattach_scale(dataset, scale, static_cast<unsigned int>(dimIdx)),
+                      "Could not attach the dimension " + dimName + " to " + varDesc.name);
+            }
+
+            addStringAttribute(dataset, "long_name", varDesc.longName);
+
+            if (!varDesc.units.empty())
+            {
+                addStringAttribute(dataset, "units", varDesc.units);
+            }
+
+            if (varDesc.coordinates)
+            {
+                addStringAttribute(dataset, "coordinates", *varDesc.coordinates);
+            }
+
+            if (varDesc.range)
+            {
+                addAttribute<float>(dataset, "valid_range",
+                                    {varDesc.range->start, varDesc.range->end});
+            }
+        }
+    }
+
+    std::vector<IodaEncoder::Shard> IodaEncoder::makeShards(const SubCategory& categories,
+                                                            size_t numLocations) const
+    {
+        size_t numShards = 1;
+        if (description_.getMaxLocationsPerFile() > 0)
+        {
+            const auto maxLocs = description_.getMaxLocationsPerFile();
+            numShards = (numLocations + maxLocs - 1) / maxLocs;
+        }
+
+        // Spread the remainder over the first shards so that sizes differ by at most one
+        const size_t baseCount = numLocations / numShards;
+        const size_t remainder = numLocations % numShards;
+
+        std::vector<Shard> shards;
+        shards.reserve(numShards);
+
+        size_t start = 0;
+        for (size_t shardIdx = 0; shardIdx < numShards; ++shardIdx)
+        {
+            Shard shard;
+            shard.categories = categories;
+            shard.index = shardIdx;
+            shard.start = start;
+            shard.count = baseCount + (shardIdx < remainder ? 1 : 0);
+            shard.totalCount = numLocations;
+
+            start += shard.count;
+            shards.push_back(shard);
+        }
+
+        return shards;
+    }
+
+    void IodaEncoder::writeManifest(const std::vector<Shard>& shards) const
+    {
+        std::ofstream manifest(description_.getManifestPath());
+        if (!manifest.is_open())
+        {
+            throw eckit::BadParameter("Could not open the manifest file "
+                                      + description_.getManifestPath());
+        }
+
+        manifest << "files:" << std::endl;
+        for (const auto& shard : shards)
+        {
+            manifest << "  - path: \"" << shard.filename << "\"" << std::endl;
+            manifest << "    category: [";
+            for (size_t catIdx = 0; catIdx < shard.categories.size(); ++catIdx)
+            {
+                if (catIdx > 0) manifest << ", ";
+                manifest << "\"" << shard.categories[catIdx] << "\"";
+            }
+            manifest << "]" << std::endl;
+            manifest << "    shard: " << shard.index << std::endl;
+            manifest << "    start: " << shard.start << std::endl;
+            manifest << "    locations: " << shard.count << std::endl;
+        }
+    }
+
     std::string IodaEncoder::makeStrWithSubstitions(const std::string& prototype,
                                                    const std::map<std::string, std::string>& subMap)
     {
@@ -7,13 +7,17 @@
 
 #pragma once
 
+#include <map>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "eckit/config/LocalConfiguration.h"
 #include "ioda/Group.h"
 #include "ioda/Engines/EngineUtils.h"
 #include "ioda/ObsGroup.h"
 
+#include "BufrParser/Query/TaskScheduler.h"
 #include "DataContainer.h"
 #include "IodaDescription.h"
 
@@ -32,12 +36,56 @@ namespace Ingester
         std::map<SubCategory, ioda::ObsGroup> encode(const std::shared_ptr<DataContainer>& data,
                                                     bool append = false);
 
+        /// \brief Prepare the data of the outputs on a task scheduler shared with the other
+        ///        stages of the run (ioda writes the outputs on the calling thread).
+        /// \param scheduler The scheduler (null for the scheduler of the calling thread).
+        void setScheduler(const std::shared_ptr<bufr::TaskScheduler>& scheduler)
+        {
+            scheduler_ = scheduler;
+        }
+
+        /// \brief Does the caller use the ObsGroups returned by encode (true by default)? When
+        ///        it doesn't, the variables of the "zarr" backend are only written to the Zarr
+        ///        stores and the returned ObsGroups just have the dimensions.
+        /// \param keepObsGroups True to copy the variables into the returned ObsGroups.
+        void setKeepObsGroups(bool keepObsGroups)
+        {
+            keepObsGroups_ = keepObsGroups;
+        }
+
      private:
         typedef std::map<std::vector<bufr::Query>, DimensionDescription> NamedPathDims;
 
+        /// \brief Range of locations (rows) of a category that is written to a single output.
+        struct Shard
+        {
+            SubCategory categories;
+            size_t index;
+            size_t start;
+            size_t count;
+            size_t totalCount;
+            std::string filename;
+        };
+
+        /// \brief A variable with filters that ioda can't apply (see FilterPipeline). It is
+        ///        written with HDF5 once ioda has closed the file (or to the Zarr store).
+        struct FilteredVariable
+        {
+            VariableDescription description;
+            std::shared_ptr<DataObjectBase> data;
+            std::vector<std::string> dimNames;
+            std::vector<ioda::Dimensions_t> chunks;
+        };
+
         /// \brief The description
         const IodaDescription description_;
 
+        /// \brief The task scheduler to run on (null for the scheduler of the calling thread).
+        std::shared_ptr<bufr::TaskScheduler> scheduler_;
+
+        /// \brief Copy the variables into the returned ObsGroups (see setKeepObsGroups).
+        bool keepObsGroups_ = true;
+
         /// \brief Create a string from a template string.
         /// \param prototype A template string ex: "my {dogType} barks". Sections labeled {__key__}
         ///        are treated as keys into the dictionary that defines their replacment values.
@@ -49,6 +97,23 @@ namespace Ingester
         std::vector<std::pair<std::string, std::pair<int, int>>>
         findSubIdxs(const std::string& str);
 
+        /// \brief Divide the locations of a category into balanced shards no bigger than the
+        ///        configured maxLocationsPerFile.
+        /// \param categories The category to divide.
+        /// \param numLocations The number of locations in the category (not zero, encode skips
+        ///        the empty categories).
+        std::vector<Shard> makeShards(const SubCategory& categories, size_t numLocations) const;
+
+        /// \brief Add the filtered variables to an output file (the file must be closed by ioda).
+        /// \param filename The output file.
+        /// \param variables The variables to add.
+        void writeFilteredVariables(const std::string& filename,
+                                    const std::vector<FilteredVariable>& variables) const;
+
+        /// \brief Write a YAML manifest describing the output files.
+        /// \param shards The shards that were written.
+        void writeManifest(const std::vector<Shard>& shards) const;
+
         /// \brief Check if the subquery string is a named dimension.
         /// \param path The subquery string to check.
         /// \param pathMap The map of named dimensions.
@@ -0,0 +1,786 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include "ZarrWriter.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef HAVE_ZLIB
+    #include <zlib.h>
+#endif
+
+#ifdef HAVE_ZSTD
+    #include <zstd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <mutex>  // NOLINT
+#include <set>
+#include <sstream>
+#include <type_traits>
+#include <utility>
+
+#include "eckit/exception/Exceptions.h"
+#include "oops/util/Logger.h"
+
+#include "BufrParser/Query/ParallelFor.h"
+#include "MemoryTracker.h"
+
+
+namespace
+{
+    const char* GroupMetadata = "{\"zarr_format\": 2}";
+
+    std::string quote(const std::string& str)
+    {
+        std::ostringstream quoted;
+        quoted << '"';
+        for (const auto c : str)
+        {
+            switch (c)
+            {
+                case '"': quoted << "\\\""; break;
+                case '\\': quoted << "\\\\"; break;
+                case '\n': quoted << "\\n"; break;
+                case '\r': quoted << "\\r"; break;
+                case '\t': quoted << "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20)
+                    {
+                        quoted << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+                               << static_cast<int>(c) << std::dec;
+                    }
+                    else
+                    {
+                        quoted << c;
+                    }
+            }
+        }
+
+        quoted << '"';
+        return quoted.str();
+    }
+
+    std::string jsonValue(const std::string& value)
+    {
+        return quote(value);
+    }
+
+    template<typename T>
+    std::string jsonValue(T value)
+    {
+        static_assert(std::is_arithmetic<T>::value, "jsonValue needs a number or a string.");
+
+        if (std::is_floating_point<T>::value)
+        {
+            // Zarr spells the non finite fill values as strings
+            if (std::isnan(value)) return "\"NaN\"";
+            if (std::isinf(value)) return value > 0 ? "\"Infinity\"" : "\"-Infinity\"";
+        }
+
+        std::ostringstream str;
+        str << std::setprecision(std::numeric_limits<T>::max_digits10) << +value;
+
+        // Keep whole floating point numbers floating point for the readers (ex: 400.0)
+        auto json = str.str();
+        if (std::is_floating_point<T>::value && json.find_first_of(".e") == std::string::npos)
+        {
+            json += ".0";
+        }
+
+        return json;
+    }
+
+    template<typename T>
+    std::string jsonList(const std::vector<T>& values)
+    {
+        std::ostringstream str;
+        str << "[";
+        for (size_t idx = 0; idx < values.size(); ++idx)
+        {
+            if (idx > 0) str << ", ";
+            str << jsonValue(values[idx]);
+        }
+
+        str << "]";
+        return str.str();
+    }
+
+    std::string jsonObject(const std::map<std::string, std::string>& members)
+    {
+        std::ostringstream str;
+        str << "{";
+        for (auto member = members.begin(); member != members.end(); ++member)
+        {
+            if (member != members.begin()) str << ", ";
+            str << quote(member->first) << ": " << member->second;
+        }
+
+        str << "}";
+        return str.str();
+    }
+
+    /// \brief The Zarr (numpy) data type of T.
+    template<typename T>
+    std::string dtype()
+    {
+        const uint16_t probe = 1;
+        const bool littleEndian = *reinterpret_cast<const char*>(&probe) == 1;
+
+        std::ostringstream str;
+        str << (sizeof(T) == 1 ? '|' : (littleEndian ? '<' : '>'));
+        if (std::is_floating_point<T>::value) str << 'f';
+        else str << (std::is_signed<T>::value ? 'i' : 'u');
+        str << sizeof(T);
+
+        return str.str();
+    }
+
+    /// \brief Call func(srcOffset, dstOffset, count) for every contiguous run of the data
+    ///        (row major, of the given shape) that falls in a chunk. The offsets are in
+    ///        elements, dstOffset is relative to the (row major) chunk.
+    template<typename Func>
+    void forEachRun(const std::vector<size_t>& shape,
+                    const std::vector<size_t>& chunks,
+                    const std::vector<size_t>& chunkIdx,
+                    Func func)
+    {
+        const size_t numDims = shape.size();
+        const size_t lastDim = numDims - 1;
+        const size_t runStart = chunkIdx[lastDim] * chunks[lastDim];
+        if (runStart >= shape[lastDim]) return;
+        const size_t runLength = std::min(chunks[lastDim], shape[lastDim] - runStart);
+
+        // Position in the chunk of every dimension but the last
+        std::vector<size_t> pos(numDims, 0);
+        while (true)
+        {
+            size_t srcOffset = 0;
+            size_t dstOffset = 0;
+            bool inData = true;
+            for (size_t dimIdx = 0; dimIdx < numDims; ++dimIdx)
+            {
+                const size_t coord = chunkIdx[dimIdx] * chunks[dimIdx] + pos[dimIdx];
+                inData = inData && coord < shape[dimIdx];
+                srcOffset = srcOffset * shape[dimIdx] + coord;
+                dstOffset = dstOffset * chunks[dimIdx] + pos[dimIdx];
+            }
+
+            if (inData) func(srcOffset, dstOffset, runLength);
+
+            // Next position (odometer over all the dimensions but the last)
+            size_t dimIdx = lastDim;
+            while (dimIdx > 0)
+            {
+                --dimIdx;
+                if (++pos[dimIdx] < chunks[dimIdx]) break;
+                pos[dimIdx] = 0;
+                if (dimIdx == 0) return;
+            }
+
+            if (numDims == 1) return;
+        }
+    }
+
+    size_t numElements(const std::vector<size_t>& shape)
+    {
+        size_t count = 1;
+        for (const auto size : shape) count *= size;
+        return count;
+    }
+
+    /// \brief The bytes of a chunk of numeric data (the parts outside of the data are filled).
+    template<typename T>
+    std::string numericChunk(const std::vector<T>& data,
+                             const std::vector<size_t>& shape,
+                             const std::vector<size_t>& chunks,
+                             const std::vector<size_t>& chunkIdx,
+                             T fillValue)
+    {
+        std::vector<T> chunk(numElements(chunks), fillValue);
+        forEachRun(shape, chunks, chunkIdx, [&](size_t srcOffset, size_t dstOffset, size_t count)
+        {
+            std::copy(data.begin() + srcOffset,
+                      data.begin() + srcOffset + count,
+                      chunk.begin() + dstOffset);
+        });
+
+        return std::string(reinterpret_cast<const char*>(chunk.data()), chunk.size() * sizeof(T));
+    }
+
+    void appendUint32(std::string& bytes, uint32_t value)
+    {
+        for (int byteIdx = 0; byteIdx < 4; ++byteIdx)
+        {
+            bytes.push_back(static_cast<char>((value >> (8 * byteIdx)) & 0xFF));
+        }
+    }
+
+    /// \brief A chunk of strings encoded with the numcodecs vlen-utf8 codec (little endian item
+    ///        count followed by the length and bytes of each item).
+    std::string stringChunk(const std::vector<std::string>& data,
+                            const std::vector<size_t>& shape,
+                            const std::vector<size_t>& chunks,
+                            const std::vector<size_t>& chunkIdx)
+    {
+        std::vector<const std::string*> items(numElements(chunks), nullptr);
+        forEachRun(shape, chunks, chunkIdx, [&](size_t srcOffset, size_t dstOffset, size_t count)
+        {
+            for (size_t idx = 0; idx < count; ++idx)
+            {
+                items[dstOffset + idx] = &data[srcOffset + idx];
+            }
+        });
+
+        std::string bytes;
+        appendUint32(bytes, static_cast<uint32_t>(items.size()));
+        for (const auto* item : items)
+        {
+            const auto size = item == nullptr ? 0 : item->size();
+            appendUint32(bytes, static_cast<uint32_t>(size));
+            if (size > 0) bytes.append(*item);
+        }
+
+        return bytes;
+    }
+
+    /// \brief Byte shuffle (same layout as the numcodecs and HDF5 shuffle filters).
+    std::string shuffle(const std::string& bytes, size_t elementSize)
+    {
+        const size_t numElements = bytes.size() / elementSize;
+        std::string shuffled(bytes.size(), '\0');
+        for (size_t elementIdx = 0; elementIdx < numElements; ++elementIdx)
+        {
+            for (size_t byteIdx = 0; byteIdx < elementSize; ++byteIdx)
+            {
+                shuffled[byteIdx * numElements + elementIdx] =
+                    bytes[elementIdx * elementSize + byteIdx];
+            }
+        }
+
+        // A trailing partial element (never the case for whole chunks) is left as it is
+        std::copy(bytes.begin() + numElements * elementSize,
+                  bytes.end(),
+                  shuffled.begin() + numElements * elementSize);
+        return shuffled;
+    }
+
+    /// \brief Warn (once per filter) that a filter isn't available with the Zarr backend.
+    void warnUnsupported(const Ingester::FilterDescription& filter)
+    {
+        static std::mutex warnedMutex;
+        static std::set<std::string> warnedFilters;
+
+        std::lock_guard<std::mutex> lock(warnedMutex);
+        if (warnedFilters.insert(filter.name).second)
+        {
+            oops::Log::warning() << "Warning: The " << filter.name << " filter is not available ";
+            oops::Log::warning() << "with the zarr backend (its fallback filters are used ";
+            oops::Log::warning() << "instead, if it has any)." << std::endl;
+        }
+    }
+
+    /// \brief Make the directory (and its parents) if it doesn't exist.
+    void makeDirectories(const std::string& path)
+    {
+        for (size_t pos = path.find('/', 1); ; pos = path.find('/', pos + 1))
+        {
+            const auto dir = path.substr(0, pos);
+            if (!dir.empty() && mkdir(dir.c_str(), 0775) != 0 && errno != EEXIST)
+            {
+                throw eckit::BadParameter("ZarrWriter: Could not create directory " + dir + ".");
+            }
+
+            if (pos == std::string::npos) break;
+        }
+    }
+
+    /// \brief Remove a directory and everything in it.
+    void removeTree(const std::string& path)
+    {
+        DIR* dir = opendir(path.c_str());
+        if (dir != nullptr)
+        {
+            while (auto entry = readdir(dir))
+            {
+                const std::string name = entry->d_name;
+                if (name == "." || name == "..") continue;
+
+                const auto entryPath = path + "/" + name;
+                struct stat info;
+                if (lstat(entryPath.c_str(), &info) == 0 && S_ISDIR(info.st_mode))
+                {
+                    removeTree(entryPath);
+                }
+                else
+                {
+                    unlink(entryPath.c_str());
+                }
+            }
+
+            closedir(dir);
+        }
+
+        if (rmdir(path.c_str()) != 0 && errno != ENOENT)
+        {
+            throw eckit::BadParameter("ZarrWriter: Could not remove " + path + ".");
+        }
+    }
+
+    void writeFile(const std::string& path, const std::string& content)
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(content.data(), static_cast<std::streamsize>(content.size()));
+        if (!file)
+        {
+            throw eckit::BadParameter("ZarrWriter: Could not write " + path + ".");
+        }
+    }
+}  // namespace
+
+
+namespace Ingester
+{
+    ZarrWriter::ZarrWriter(const std::string& path) :
+        path_(path)
+    {
+        if (path_.empty())
+        {
+            throw eckit::BadParameter("ZarrWriter: The path of the store is empty.");
+        }
+    }
+
+    void ZarrWriter::addGlobal(const GlobalDescriptionBase& global)
+    {
+        if (auto str = dynamic_cast<const GlobalDescription<std::string>*>(&global))
+        {
+            globals_[global.name] = jsonValue(str->value);
+        }
+        else if (auto flt = dynamic_cast<const GlobalDescription<float>*>(&global))
+        {
+            globals_[global.name] = jsonValue(flt->value);
+        }
+        else if (auto intg = dynamic_cast<const GlobalDescription<int>*>(&global))
+        {
+            globals_[global.name] = jsonValue(intg->value);
+        }
+        else if (auto flts = dynamic_cast<const GlobalDescription<std::vector<float>>*>(&global))
+        {
+            globals_[global.name] = jsonList(flts->value);
+        }
+        else if (auto ints = dynamic_cast<const GlobalDescription<std::vector<int>>*>(&global))
+        {
+            globals_[global.name] = jsonList(ints->value);
+        }
+        else
+        {
+            throw eckit::BadParameter("ZarrWriter: The type of the global " + global.name +
+                                      " is not supported.");
+        }
+    }
+
+    void ZarrWriter::addDimension(const std::string& name, const DimensionDataBase& dimension)
+    {
+        Array array;
+        array.path = name;
+        array.attributes["_ARRAY_DIMENSIONS"] = jsonList(std::vector<std::string>{name});
+
+        if (!(addDimensionArray<int>(array, dimension) ||
+              addDimensionArray<int8_t>(array, dimension) ||
+              addDimensionArray<int16_t>(array, dimension) ||
+              addDimensionArray<float>(array, dimension) ||
+              addDimensionArray<double>(array, dimension) ||
+              addDimensionArray<int64_t>(array, dimension) ||
+              addDimensionArray<uint32_t>(array, dimension) ||
+              addDimensionArray<uint64_t>(array, dimension) ||
+              addDimensionArray<std::string>(array, dimension)))
+        {
+            throw eckit::BadParameter("ZarrWriter: The type of the dimension " + name +
+                                      " is not supported.");
+        }
+
+        arrays_.push_back(array);
+    }
+
+    void ZarrWriter::addVariable(const VariableDescription& description,
+                                 const std::shared_ptr<DataObjectBase>& data,
+                                 const std::vector<std::string>& dimNames,
+                                 const std::vector<ioda::Dimensions_t>& chunks)
+    {
+        Array array;
+        array.path = description.name;
+
+        for (const auto size : data->getDims())
+        {
+            array.shape.push_back(static_cast<size_t>(size));
+        }
+
+        for (size_t dimIdx = 0; dimIdx < array.shape.size(); ++dimIdx)
+        {
+            auto chunk = dimIdx < chunks.size() ? static_cast<size_t>(chunks[dimIdx]) : 0;
+            if (chunk == 0) chunk = array.shape[dimIdx];
+            array.chunks.push_back(std::max<size_t>(1, std::min(chunk, array.shape[dimIdx])));
+        }
+
+        array.attributes["_ARRAY_DIMENSIONS"] = jsonList(dimNames);
+        array.attributes["long_name"] = jsonValue(description.longName);
+
+        if (!description.units.empty())
+        {
+            array.attributes["units"] = jsonValue(description.units);
+        }
+
+        if (description.coordinates)
+        {
+            array.attributes["coordinates"] = jsonValue(*description.coordinates);
+        }
+
+        if (description.range)
+        {
+            array.attributes["valid_range"] = jsonList(std::vector<float>{description.range->start,
+                                                                          description.range->end});
+        }
+
+        if (!(addArray<float>(array, data) ||
+              addArray<double>(array, data) ||
+              addArray<int>(array, data) ||
+              addArray<int8_t>(array, data) ||
+              addArray<int16_t>(array, data) ||
+              addArray<int64_t>(array, data) ||
+              addArray<uint32_t>(array, data) ||
+              addArray<uint64_t>(array, data) ||
+              addArray<std::string>(array, data)))
+        {
+            throw eckit::BadParameter("ZarrWriter: The type of " + description.name +
+                                      " is not supported.");
+        }
+
+        setCodecs(array, description.filters.filters());
+        arrays_.push_back(array);
+    }
+
+    template<typename T>
+    bool ZarrWriter::addArray(Array& array, const std::shared_ptr<DataObjectBase>& data)
+    {
+        const auto typedData = std::dynamic_pointer_cast<DataObject<T>>(data);
+        if (typedData == nullptr) return false;
+
+        const auto shape = array.shape;
+        const auto chunks = array.chunks;
+        if constexpr (std::is_same<T, std::string>::value)
+        {
+            array.dtype = "|O";
+            array.fillValue = jsonValue(std::string(""));
+            array.vlenUtf8 = true;
+            array.chunkBytes = [typedData, shape, chunks](const std::vector<size_t>& chunkIdx)
+            {
+                return stringChunk(typedData->rawData(), shape, chunks, chunkIdx);
+            };
+        }
+        else
+        {
+            array.dtype = dtype<T>();
+            array.fillValue = jsonValue(DataObject<T>::missingValue());
+            array.chunkBytes = [typedData, shape, chunks](const std::vector<size_t>& chunkIdx)
+            {
+                return numericChunk<T>(typedData->rawData(), shape, chunks, chunkIdx,
+                                       DataObject<T>::missingValue());
+            };
+        }
+
+        return true;
+    }
+
+    template<typename T>
+    bool ZarrWriter::addDimensionArray(Array& array, const DimensionDataBase& dimension)
+    {
+        const auto typedDim = dynamic_cast<const DimensionData<T>*>(&dimension);
+        if (typedDim == nullptr) return false;
+
+        const auto data = std::make_shared<std::vector<T>>(typedDim->data);
+        const std::vector<size_t> shape = {data->size()};
+        const std::vector<size_t> chunks = {std::max<size_t>(1, data->size())};
+        array.shape = shape;
+        array.chunks = chunks;
+
+        if constexpr (std::is_same<T, std::string>::value)
+        {
+            array.dtype = "|O";
+            array.fillValue = jsonValue(std::string(""));
+            array.vlenUtf8 = true;
+            array.chunkBytes = [data, shape, chunks](const std::vector<size_t>& chunkIdx)
+            {
+                return stringChunk(*data, shape, chunks, chunkIdx);
+            };
+        }
+        else
+        {
+            array.dtype = dtype<T>();
+            array.fillValue = jsonValue(DataObject<T>::missingValue());
+            array.chunkBytes = [data, shape, chunks](const std::vector<size_t>& chunkIdx)
+            {
+                return numericChunk<T>(*data, shape, chunks, chunkIdx,
+                                       DataObject<T>::missingValue());
+            };
+        }
+
+        return true;
+    }
+
+    void ZarrWriter::setCodecs(Array& array, const std::vector<FilterDescription>& filters) const
+    {
+        for (const auto& filter : filters)
+        {
+            switch (filter.type)
+            {
+                case FilterDescription::Type::Shuffle:
+                    // Strings are variable length, there is nothing to shuffle
+                    if (!array.vlenUtf8)
+                    {
+                        array.shuffleSize = static_cast<size_t>(
+                            std::stoi(array.dtype.substr(2)));
+                    }
+                    break;
+                case FilterDescription::Type::Deflate:
+#ifdef HAVE_ZLIB
+                    if (filter.level > 0 && array.compressor == Compressor::None)
+                    {
+                        array.compressor = Compressor::Zlib;
+                        array.level = filter.level;
+                    }
+#else
+                    warnUnsupported(filter);
+#endif
+                    break;
+                case FilterDescription::Type::Zstd:
+#ifdef HAVE_ZSTD
+                    if (array.compressor == Compressor::None)
+                    {
+                        array.compressor = Compressor::Zstd;
+                        array.level = filter.level;
+                    }
+#else
+                    warnUnsupported(filter);
+                    setCodecs(array, filter.fallback);
+#endif
+                    break;
+                default:
+                    warnUnsupported(filter);
+                    setCodecs(array, filter.fallback);
+            }
+        }
+    }
+
+    std::string ZarrWriter::arrayMetadata(const Array& array) const
+    {
+        std::map<std::string, std::string> metadata;
+        metadata["zarr_format"] = "2";
+        metadata["shape"] = jsonList(array.shape);
+        metadata["chunks"] = jsonList(array.chunks);
+        metadata["dtype"] = quote(array.dtype);
+        metadata["fill_value"] = array.fillValue;
+        metadata["order"] = quote("C");
+        metadata["dimension_separator"] = quote(".");
+
+        std::vector<std::string> filters;
+        if (array.vlenUtf8) filters.push_back("{\"id\": \"vlen-utf8\"}");
+        if (array.shuffleSize > 1)
+        {
+            filters.push_back("{\"elementsize\": " + std::to_string(array.shuffleSize) +
+                              ", \"id\": \"shuffle\"}");
+        }
+
+        std::ostringstream filtersStr;
+        filtersStr << "[";
+        for (size_t filterIdx = 0; filterIdx < filters.size(); ++filterIdx)
+        {
+            if (filterIdx > 0) filtersStr << ", ";
+            filtersStr << filters[filterIdx];
+        }
+        filtersStr << "]";
+        metadata["filters"] = filters.empty() ? "null" : filtersStr.str();
+
+        switch (array.compressor)
+        {
+            case Compressor::Zlib:
+                metadata["compressor"] = "{\"id\": \"zlib\", \"level\": " +
+                                         std::to_string(array.level) + "}";
+                break;
+            case Compressor::Zstd:
+                metadata["compressor"] = "{\"id\": \"zstd\", \"level\": " +
+                                         std::to_string(array.level) + "}";
+                break;
+            default:
+                metadata["compressor"] = "null";
+        }
+
+        return jsonObject(metadata);
+    }
+
+    std::string ZarrWriter::encodeChunk(const Array& array, std::string bytes) const
+    {
+        if (array.shuffleSize > 1)
+        {
+            // The shuffled copy
+            TrackedBytes shuffleMemory(MemoryTracker::Subsystem::Encoder, bytes.size());
+            bytes = shuffle(bytes, array.shuffleSize);
+        }
+
+        switch (array.compressor)
+        {
+#ifdef HAVE_ZLIB
+            case Compressor::Zlib:
+            {
+                auto compressedSize = compressBound(static_cast<uLong>(bytes.size()));
+                std::string compressed(compressedSize, '\0');
+                TrackedBytes compressedMemory(MemoryTracker::Subsystem::Encoder, compressedSize);
+                if (compress2(reinterpret_cast<Bytef*>(&compressed[0]),
+                              &compressedSize,
+                              reinterpret_cast<const Bytef*>(bytes.data()),
+                              static_cast<uLong>(bytes.size()),
+                              array.level) != Z_OK)
+                {
+                    throw eckit::BadParameter("ZarrWriter: Could not compress a chunk of " +
+                                              array.path + ".");
+                }
+
+                compressed.resize(compressedSize);
+                return compressed;
+            }
+#endif
+#ifdef HAVE_ZSTD
+            case Compressor::Zstd:
+            {
+                std::string compressed(ZSTD_compressBound(bytes.size()), '\0');
+                TrackedBytes compressedMemory(MemoryTracker::Subsystem::Encoder,
+                                              compressed.size());
+                const auto compressedSize = ZSTD_compress(&compressed[0],
+                                                          compressed.size(),
+                                                          bytes.data(),
+                                                          bytes.size(),
+                                                          array.level);
+                if (ZSTD_isError(compressedSize))
+                {
+                    throw eckit::BadParameter("ZarrWriter: Could not compress a chunk of " +
+                                              array.path + ".");
+                }
+
+                compressed.resize(compressedSize);
+                return compressed;
+            }
+#endif
+            default:
+                return bytes;
+        }
+    }
+
+    void ZarrWriter::write() const
+    {
+        // Replace an existing store, but never anything else
+        struct stat info;
+        if (stat(path_.c_str(), &info) == 0)
+        {
+            struct stat groupInfo;
+            if (!S_ISDIR(info.st_mode) || stat((path_ + "/.zgroup").c_str(), &groupInfo) != 0)
+            {
+                throw eckit::BadParameter("ZarrWriter: " + path_ + " exists and is not a Zarr "
+                                          "store.");
+            }
+
+            removeTree(path_);
+        }
+
+        // Metadata (relative path of the file and JSON content)
+        std::map<std::string, std::string> metadata;
+        metadata[".zgroup"] = GroupMetadata;
+        metadata[".zattrs"] = jsonObject(globals_);
+
+        for (const auto& array : arrays_)
+        {
+            for (size_t pos = array.path.find('/'); pos != std::string::npos;
+                 pos = array.path.find('/', pos + 1))
+            {
+                metadata[array.path.substr(0, pos) + "/.zgroup"] = GroupMetadata;
+            }
+
+            metadata[array.path + "/.zarray"] = arrayMetadata(array);
+            metadata[array.path + "/.zattrs"] = jsonObject(array.attributes);
+        }
+
+        for (const auto& file : metadata)
+        {
+            const auto filePath = path_ + "/" + file.first;
+            makeDirectories(filePath.substr(0, filePath.rfind('/')));
+            writeFile(filePath, file.second);
+        }
+
+        std::map<std::string, std::string> consolidated;
+        consolidated["metadata"] = jsonObject(metadata);
+        consolidated["zarr_consolidated_format"] = "1";
+        writeFile(path_ + "/.zmetadata", jsonObject(consolidated));
+
+        // Chunks (array index and chunk index)
+        std::vector<std::pair<size_t, size_t>> chunks;
+        for (size_t arrayIdx = 0; arrayIdx < arrays_.size(); ++arrayIdx)
+        {
+            const auto& array = arrays_[arrayIdx];
+
+            size_t numChunks = 1;
+            for (size_t dimIdx = 0; dimIdx < array.shape.size(); ++dimIdx)
+            {
+                numChunks *= (array.shape[dimIdx] + array.chunks[dimIdx] - 1) /
+                             array.chunks[dimIdx];
+            }
+
+            for (size_t chunkIdx = 0; chunkIdx < numChunks; ++chunkIdx)
+            {
+                chunks.push_back({arrayIdx, chunkIdx});
+            }
+        }
+
+        bufr::parallelFor(chunks.size(), 1, [&](size_t chunkBegin, size_t chunkEnd)
+        {
+            for (size_t idx = chunkBegin; idx < chunkEnd; ++idx)
+            {
+                const auto& array = arrays_[chunks[idx].first];
+
+                // Position of the chunk in the chunk grid (row major)
+                std::vector<size_t> gridIdx(array.shape.size());
+                size_t linearIdx = chunks[idx].second;
+                for (size_t dimIdx = array.shape.size(); dimIdx > 0; --dimIdx)
+                {
+                    const size_t gridSize = (array.shape[dimIdx - 1] + array.chunks[dimIdx - 1] -
+                                             1) / array.chunks[dimIdx - 1];
+                    gridIdx[dimIdx - 1] = linearIdx % gridSize;
+                    linearIdx /= gridSize;
+                }
+
+                std::ostringstream key;
+                for (size_t dimIdx = 0; dimIdx < gridIdx.size(); ++dimIdx)
+                {
+                    key << (dimIdx > 0 ? "." : "") << gridIdx[dimIdx];
+                }
+
+                auto bytes = array.chunkBytes(gridIdx);
+                TrackedBytes chunkMemory(MemoryTracker::Subsystem::Encoder, bytes.size());
+                const auto encoded = encodeChunk(array, std::move(bytes));
+                chunkMemory.set(encoded.size());
+
+                writeFile(path_ + "/" + array.path + "/" + key.str(), encoded);
+            }
+        });
+    }
+}  // namespace Ingester
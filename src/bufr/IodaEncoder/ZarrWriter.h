@@ -0,0 +1,106 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "DataObject.h"
+#include "IodaDescription.h"
+
+
+namespace Ingester
+{
+    /// \brief Writes the ObsGroup layout made by the IodaEncoder (dimension variables at the
+    ///        root, groups of variables, attributes and fill values) as a Zarr (v2) directory
+    ///        store, with the xarray _ARRAY_DIMENSIONS convention for the dimensions and
+    ///        consolidated metadata. Every chunk is a file of its own, so the chunks are encoded
+    ///        and written by tasks on the task scheduler of the calling thread without any lock.
+    ///        The filter pipelines map to the numcodecs shuffle, zlib and zstd codecs (zstd only
+    ///        when built with it). Other filters are replaced by their fallbacks.
+    class ZarrWriter
+    {
+     public:
+        /// \brief Constructor
+        /// \param path The directory of the store (an existing store is replaced).
+        explicit ZarrWriter(const std::string& path);
+
+        /// \brief Add a global attribute (root attribute).
+        void addGlobal(const GlobalDescriptionBase& global);
+
+        /// \brief Add a dimension variable (at the root of the store).
+        /// \param name The name of the dimension.
+        /// \param dimension The dimension data.
+        void addDimension(const std::string& name, const DimensionDataBase& dimension);
+
+        /// \brief Add a variable.
+        /// \param description The variable description (its name is the path in the store).
+        /// \param data The data of the variable.
+        /// \param dimNames The dimension of each axis of the data.
+        /// \param chunks The chunk size of each axis.
+        void addVariable(const VariableDescription& description,
+                         const std::shared_ptr<DataObjectBase>& data,
+                         const std::vector<std::string>& dimNames,
+                         const std::vector<ioda::Dimensions_t>& chunks);
+
+        /// \brief Write the store.
+        void write() const;
+
+     private:
+        enum class Compressor
+        {
+            None,
+            Zlib,
+            Zstd
+        };
+
+        /// \brief A Zarr array and the function that gets the (uncompressed) bytes of a chunk.
+        struct Array
+        {
+            std::string path;
+            std::string dtype;
+            std::vector<size_t> shape;
+            std::vector<size_t> chunks;
+            std::string fillValue;  ///< JSON
+            std::map<std::string, std::string> attributes;  ///< Name and JSON value
+
+            bool vlenUtf8 = false;
+            size_t shuffleSize = 0;  ///< Element size of the shuffle filter (0 for none)
+            Compressor compressor = Compressor::None;
+            int level = 0;
+
+            std::function<std::string(const std::vector<size_t>& chunkIdx)> chunkBytes;
+        };
+
+        const std::string path_;
+        std::map<std::string, std::string> globals_;
+        std::vector<Array> arrays_;
+
+        /// \brief Add an array with the data of a DataObject<T>.
+        /// \return False if the data has another type.
+        template<typename T>
+        bool addArray(Array& array, const std::shared_ptr<DataObjectBase>& data);
+
+        /// \brief Add an array with the data of a DimensionData<T>.
+        /// \return False if the dimension has another type.
+        template<typename T>
+        bool addDimensionArray(Array& array, const DimensionDataBase& dimension);
+
+        /// \brief Set the codecs of an array from a filter pipeline.
+        void setCodecs(Array& array, const std::vector<FilterDescription>& filters) const;
+
+        /// \brief The .zarray metadata of an array.
+        std::string arrayMetadata(const Array& array) const;
+
+        /// \brief Encode (filter and compress) a chunk.
+        std::string encodeChunk(const Array& array, std::string bytes) const;
+    };
+}  // namespace Ingester
@@ -0,0 +1,551 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+#include <datetime.h>
+
+#include <algorithm>
+#include <ctime>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "eckit/exception/Exceptions.h"
+#include "ioda/Engines/EngineUtils.h"
+#include "ioda/Layout.h"
+#include "ioda/ObsGroup.h"
+
+
+namespace py = pybind11;
+
+namespace
+{
+    const char* DateTimeName = "dateTime";
+    const char* DateTimeUnits = "seconds since 1970-01-01T00:00:00Z";
+    const char* IsoDateTimeFormat = "%Y-%m-%dT%H:%M:%SZ";
+    const char* FillValueName = "_FillValue";
+    const char* UnitsName = "units";
+    const char* LocationName = "Location";
+
+    // Same defaults as get_default_fill_val in ioda_conv_engines.py
+    const int64_t DefaultDateTimeFill = 7258118400;  // 2200-01-01T00:00:00Z
+
+    template<typename T> T defaultFill();
+    template<> float defaultFill<float>() { return 9.969209968386869e+36f; }
+    template<> double defaultFill<double>() { return 9.969209968386869e+36; }
+    template<> int64_t defaultFill<int64_t>() { return -9223372036854775806; }
+    template<> int32_t defaultFill<int32_t>() { return -2147483647; }
+    template<> int16_t defaultFill<int16_t>() { return -32767; }
+    template<> int8_t defaultFill<int8_t>() { return -127; }
+    // The netCDF default fill values (ioda_conv_engines.py has none for unsigned types)
+    template<> uint64_t defaultFill<uint64_t>() { return 18446744073709551614ULL; }
+    template<> uint32_t defaultFill<uint32_t>() { return 4294967295U; }
+    template<> uint16_t defaultFill<uint16_t>() { return 65535; }
+    template<> std::string defaultFill<std::string>() { return std::string("\x00", 1); }
+
+    /// \brief Attribute values copied out of the python objects so they can be written after
+    ///        the GIL has been released.
+    struct AttrBase
+    {
+        std::string name;
+        virtual void addTo(ioda::Has_Attributes& atts) const = 0;
+        virtual ~AttrBase() = default;
+    };
+
+    template<typename T>
+    struct Attr : public AttrBase
+    {
+        std::vector<T> values;
+
+        void addTo(ioda::Has_Attributes& atts) const final
+        {
+            atts.add<T>(name, values, {static_cast<ioda::Dimensions_t>(values.size())});
+        }
+    };
+
+    typedef std::vector<std::shared_ptr<AttrBase>> Attrs;
+
+    /// \brief Variable data copied out of the python objects so it can be written after the
+    ///        GIL has been released.
+    struct VarBase
+    {
+        std::string name;
+        std::vector<std::string> dims;
+        Attrs attrs;
+
+        virtual ioda::Variable write(ioda::ObsGroup& obsGroup,
+                                     const std::vector<ioda::Variable>& dimVars,
+                                     const std::vector<ioda::Dimensions_t>& chunks,
+                                     int compressionLevel) const = 0;
+        virtual ~VarBase() = default;
+    };
+
+    template<typename T>
+    struct VarData : public VarBase
+    {
+        std::vector<T> data;
+        T fillValue;
+
+        ioda::Variable write(ioda::ObsGroup& obsGroup,
+                             const std::vector<ioda::Variable>& dimVars,
+                             const std::vector<ioda::Dimensions_t>& chunks,
+                             int compressionLevel) const final
+        {
+            ioda::VariableCreationParameters params;
+            params.chunk = true;
+            params.chunks = chunks;
+            if (compressionLevel > 0)
+            {
+                params.compressWithGZIP(compressionLevel);
+            }
+            params.setFillValue<T>(fillValue);
+
+            auto var = obsGroup.vars.createWithScales<T>(name, dimVars, params);
+            var.write<T>(data);
+            return var;
+        }
+    };
+
+    /// \brief Seconds since the epoch for a python datetime (naive datetimes are UTC).
+    int64_t toEpoch(const py::handle& obj)
+    {
+        if (!obj.attr("tzinfo").is_none())
+        {
+            return static_cast<int64_t>(obj.attr("timestamp")().cast<double>());
+        }
+
+        std::tm time = {};
+        time.tm_year = PyDateTime_GET_YEAR(obj.ptr()) - 1900;
+        time.tm_mon = PyDateTime_GET_MONTH(obj.ptr()) - 1;
+        time.tm_mday = PyDateTime_GET_DAY(obj.ptr());
+        time.tm_hour = PyDateTime_DATE_GET_HOUR(obj.ptr());
+        time.tm_min = PyDateTime_DATE_GET_MINUTE(obj.ptr());
+        time.tm_sec = PyDateTime_DATE_GET_SECOND(obj.ptr());
+
+        return static_cast<int64_t>(timegm(&time));
+    }
+
+    /// \brief Seconds since the epoch for an ISO 8601 (%Y-%m-%dT%H:%M:%SZ) string.
+    int64_t toEpoch(const std::string& str)
+    {
+        std::tm time = {};
+        const char* end = strptime(str.c_str(), IsoDateTimeFormat, &time);
+        if (end == nullptr || *end != '\0')
+        {
+            std::ostringstream errMsg;
+            errMsg << "Could not parse \"" << str << "\" as a date time (expected ";
+            errMsg << IsoDateTimeFormat << ").";
+            throw eckit::BadParameter(errMsg.str());
+        }
+
+        return static_cast<int64_t>(timegm(&time));
+    }
+
+    bool isMasked(const py::handle& obj)
+    {
+        return py::isinstance(obj, py::module::import("numpy.ma").attr("MaskedArray"));
+    }
+
+    template<typename T>
+    std::shared_ptr<VarData<T>> makeNumericVar(py::object values, const py::handle& fill)
+    {
+        auto var = std::make_shared<VarData<T>>();
+        var->fillValue = fill.is_none() ? defaultFill<T>() : fill.cast<T>();
+
+        if (isMasked(values))
+        {
+            values = values.attr("filled")(var->fillValue);
+        }
+
+        auto array = py::array_t<T, py::array::c_style | py::array::forcecast>::ensure(values);
+        var->data.assign(array.data(), array.data() + array.size());
+        return var;
+    }
+
+    /// \brief Make the variable for an object (or unicode/bytes) array. These hold strings,
+    ///        datetime objects or, for dateTime, ISO date strings. The dateTime strings and
+    ///        the datetime objects are written as seconds since the epoch.
+    std::shared_ptr<VarBase> makeObjectVar(const std::string& varName,
+                                           const py::array& values,
+                                           const py::handle& fill)
+    {
+        // Masked elements come out of tolist as None
+        py::list items = values.attr("ravel")().attr("tolist")();
+
+        bool isDateTime = false;
+        bool isIsoString = false;
+        for (const auto& item : items)
+        {
+            if (item.is_none()) continue;
+
+            isDateTime = PyDateTime_Check(item.ptr());
+            isIsoString = (varName == DateTimeName) && py::isinstance<py::str>(item);
+            break;
+        }
+
+        if (isDateTime || isIsoString)
+        {
+            auto var = std::make_shared<VarData<int64_t>>();
+            var->fillValue = DefaultDateTimeFill;
+            if (!fill.is_none())
+            {
+                var->fillValue = PyDateTime_Check(fill.ptr()) ? toEpoch(fill) :
+                                                                fill.cast<int64_t>();
+            }
+
+            var->data.reserve(items.size());
+            for (const auto& item : items)
+            {
+                if (item.is_none())
+                {
+                    var->data.push_back(var->fillValue);
+                }
+                else if (isDateTime)
+                {
+                    var->data.push_back(toEpoch(item));
+                }
+                else
+                {
+                    var->data.push_back(toEpoch(item.cast<std::string>()));
+                }
+            }
+
+            auto units = std::make_shared<Attr<std::string>>();
+            units->name = UnitsName;
+            units->values = {DateTimeUnits};
+            var->attrs.push_back(units);
+
+            return var;
+        }
+
+        auto var = std::make_shared<VarData<std::string>>();
+        var->fillValue = fill.is_none() ? defaultFill<std::string>() : fill.cast<std::string>();
+        var->data.reserve(items.size());
+        for (const auto& item : items)
+        {
+            if (item.is_none())
+            {
+                var->data.push_back(var->fillValue);
+            }
+            else if (py::isinstance<py::bytes>(item))
+            {
+                var->data.push_back(item.cast<std::string>());
+            }
+            else
+            {
+                var->data.push_back(py::str(item).cast<std::string>());
+            }
+        }
+
+        return var;
+    }
+
+    /// \brief Copy the python array into a typed variable (numpy dtype decides the type).
+    std::shared_ptr<VarBase> makeVar(const std::string& varName,
+                                     const py::handle& obj,
+                                     const py::handle& fill)
+    {
+        py::object values = py::reinterpret_borrow<py::object>(obj);
+        if (!py::isinstance<py::array>(values))
+        {
+            values = py::module::import("numpy").attr("asarray")(values);
+        }
+
+        auto dtype = py::reinterpret_borrow<py::array>(values).dtype();
+        const char kind = dtype.kind();
+        const size_t itemSize = dtype.itemsize();
+
+        if (kind == 'f' && itemSize == 4) return makeNumericVar<float>(values, fill);
+        if (kind == 'f' && itemSize == 8) return makeNumericVar<double>(values, fill);
+        if (kind == 'i' && itemSize == 1) return makeNumericVar<int8_t>(values, fill);
+        if (kind == 'i' && itemSize == 2) return makeNumericVar<int16_t>(values, fill);
+        if (kind == 'i' && itemSize == 4) return makeNumericVar<int32_t>(values, fill);
+        if (kind == 'i' && itemSize == 8) return makeNumericVar<int64_t>(values, fill);
+        if (kind == 'u' && itemSize == 2) return makeNumericVar<uint16_t>(values, fill);
+        if (kind == 'u' && itemSize == 4) return makeNumericVar<uint32_t>(values, fill);
+        if (kind == 'u' && itemSize == 8) return makeNumericVar<uint64_t>(values, fill);
+
+        // ioda has no unsigned byte type, so uint8 is widened
+        if (kind == 'u' && itemSize == 1)
+        {
+            return makeNumericVar<uint16_t>(values.attr("astype")("uint16"), fill);
+        }
+
+        // Bools are written as bytes, like the ObsSpace does (a masked array keeps its mask)
+        if (kind == 'b')
+        {
+            return makeNumericVar<int8_t>(values.attr("astype")("int8"), fill);
+        }
+
+        if (kind == 'M')
+        {
+            // numpy datetime64 (NaT becomes the fill value)
+            py::object seconds = values.attr("astype")("datetime64[s]").attr("astype")("int64");
+            py::object dateTimeFill = py::reinterpret_borrow<py::object>(fill);
+            if (fill.is_none())
+            {
+                dateTimeFill = py::int_(DefaultDateTimeFill);
+            }
+
+            auto var = makeNumericVar<int64_t>(seconds, dateTimeFill);
+            std::replace(var->data.begin(),
+                         var->data.end(),
+                         std::numeric_limits<int64_t>::min(),
+                         var->fillValue);
+
+            auto units = std::make_shared<Attr<std::string>>();
+            units->name = UnitsName;
+            units->values = {DateTimeUnits};
+            var->attrs.push_back(units);
+            return var;
+        }
+
+        if (kind == 'O' || kind == 'U' || kind == 'S')
+        {
+            return makeObjectVar(varName, py::reinterpret_borrow<py::array>(values), fill);
+        }
+
+        std::ostringstream errMsg;
+        errMsg << "Variable " << varName << " has an unsupported data type ";
+        errMsg << py::str(dtype).cast<std::string>() << ".";
+        throw eckit::BadParameter(errMsg.str());
+    }
+
+    /// \brief Copy a python attribute value (scalar, list or array) into a typed attribute.
+    ///        The type follows numpy (python int -> int64, python float -> double).
+    std::shared_ptr<AttrBase> makeAttr(const std::string& name, const py::handle& value)
+    {
+        if (py::isinstance<py::str>(value) || py::isinstance<py::bytes>(value))
+        {
+            auto attr = std::make_shared<Attr<std::string>>();
+            attr->name = name;
+            attr->values = {value.cast<std::string>()};
+            return attr;
+        }
+
+        auto var = makeVar(name, value, py::none());
+
+        std::shared_ptr<AttrBase> attr;
+        if (auto floatVar = std::dynamic_pointer_cast<VarData<float>>(var))
+        {
+            auto typedAttr = std::make_shared<Attr<float>>();
+            typedAttr->values = floatVar->data;
+            attr = typedAttr;
+        }
+        else if (auto doubleVar = std::dynamic_pointer_cast<VarData<double>>(var))
+        {
+            auto typedAttr = std::make_shared<Attr<double>>();
+            typedAttr->values = doubleVar->data;
+            attr = typedAttr;
+        }
+        else if (auto int64Var = std::dynamic_pointer_cast<VarData<int64_t>>(var))
+        {
+            auto typedAttr = std::make_shared<Attr<int64_t>>();
+            typedAttr->values = int64Var->data;
+            attr = typedAttr;
+        }
+        else if (auto uint64Var = std::dynamic_pointer_cast<VarData<uint64_t>>(var))
+        {
+            auto typedAttr = std::make_shared<Attr<uint64_t>>();
+            typedAttr->values = uint64Var->data;
+            attr = typedAttr;
+        }
+        else if (auto uint32Var = std::dynamic_pointer_cast<VarData<uint32_t>>(var))
+        {
+            auto typedAttr = std::make_shared<Attr<uint32_t>>();
+            typedAttr->values = uint32Var->data;
+            attr = typedAttr;
+        }
+        else if (auto strVar = std::dynamic_pointer_cast<VarData<std::string>>(var))
+        {
+            auto typedAttr = std::make_shared<Attr<std::string>>();
+            typedAttr->values = strVar->data;
+            attr = typedAttr;
+        }
+        else
+        {
+            // The smaller integer types are written as int
+            auto typedAttr = std::make_shared<Attr<int>>();
+            auto values = py::array_t<int, py::array::c_style | py::array::forcecast>::ensure(
+                py::module::import("numpy").attr("asarray")(value));
+            typedAttr->values.assign(values.data(), values.data() + values.size());
+            attr = typedAttr;
+        }
+
+        attr->name = name;
+        return attr;
+    }
+
+    Attrs makeAttrs(const py::dict& attrDict, const std::vector<std::string>& skip = {})
+    {
+        Attrs attrs;
+        for (const auto& attrPair : attrDict)
+        {
+            auto name = py::str(attrPair.first).cast<std::string>();
+            if (std::find(skip.begin(), skip.end(), name) == skip.end())
+            {
+                attrs.push_back(makeAttr(name, attrPair.second));
+            }
+        }
+
+        return attrs;
+    }
+
+    /// \brief Write the IODA file. ObsVars, VarDims, VarAttrs and GlobalAttrs have the same
+    ///        layout as for IodaWriter.BuildIoda in ioda_conv_engines.py.
+    void writeIoda(const std::string& filename,
+               const py::dict& dimDict,
+               const py::dict& obsVars,
+               const py::dict& varDims,
+               const py::dict& varAttrs,
+               const py::dict& globalAttrs,
+               int compressionLevel,
+               ioda::Dimensions_t chunkSize)
+    {
+        // Copy everything out of python while we hold the GIL
+        std::vector<std::pair<std::string, ioda::Dimensions_t>> dims;
+        for (const auto& dimPair : dimDict)
+        {
+            dims.push_back({py::str(dimPair.first).cast<std::string>(),
+                            dimPair.second.cast<ioda::Dimensions_t>()});
+        }
+
+        std::vector<std::shared_ptr<VarBase>> vars;
+        for (const auto& varPair : obsVars)
+        {
+            auto varKey = py::reinterpret_borrow<py::tuple>(varPair.first);
+            auto varName = varKey[0].cast<std::string>();
+            auto groupName = varKey[1].cast<std::string>();
+
+            py::dict attrDict;
+            if (varAttrs.contains(varKey))
+            {
+                attrDict = varAttrs[varKey].cast<py::dict>();
+            }
+
+            py::object fill = py::none();
+            if (attrDict.contains(FillValueName))
+            {
+                fill = attrDict[FillValueName];
+            }
+
+            auto var = makeVar(varName, varPair.second, fill);
+            var->name = groupName.empty() ? varName : groupName + "/" + varName;
+
+            if (varDims.contains(varKey))
+            {
+                var->dims = varDims[varKey].cast<std::vector<std::string>>();
+            }
+            else if (varDims.contains(py::str(varName)))
+            {
+                var->dims = varDims[py::str(varName)].cast<std::vector<std::string>>();
+            }
+            else
+            {
+                var->dims = {LocationName};
+            }
+
+            // The units set for the dateTime conversion are replaced by any given units
+            if (attrDict.contains(UnitsName))
+            {
+                var->attrs.clear();
+            }
+
+            auto attrs = makeAttrs(attrDict, {FillValueName});
+            var->attrs.insert(var->attrs.end(), attrs.begin(), attrs.end());
+            vars.push_back(var);
+        }
+
+        auto globals = makeAttrs(globalAttrs);
+
+        // Nothing below touches python objects
+        py::gil_scoped_release release;
+
+        auto backendParams = ioda::Engines::BackendCreationParameters();
+        backendParams.fileName = filename;
+        backendParams.openMode = ioda::Engines::BackendOpenModes::Read_Write;
+        backendParams.createMode = ioda::Engines::BackendCreateModes::Truncate_If_Exists;
+        backendParams.action = ioda::Engines::BackendFileActions::Create;
+        backendParams.flush = true;
+
+        auto rootGroup = ioda::Engines::constructBackend(ioda::Engines::BackendNames::Hdf5File,
+                                                         backendParams);
+
+        ioda::NewDimensionScales_t newDims;
+        for (const auto& dim : dims)
+        {
+            newDims.push_back(ioda::NewDimensionScale<int>(dim.first, dim.second));
+        }
+
+        auto policy = ioda::detail::DataLayoutPolicy::Policies::ObsGroup;
+        auto layoutPolicy = ioda::detail::DataLayoutPolicy::generate(policy);
+        auto obsGroup = ioda::ObsGroup::generate(rootGroup, newDims, layoutPolicy);
+
+        for (const auto& var : vars)
+        {
+            std::vector<ioda::Variable> dimVars;
+            std::vector<ioda::Dimensions_t> chunks;
+            for (const auto& dimName : var->dims)
+            {
+                if (!obsGroup.vars.exists(dimName))
+                {
+                    std::ostringstream errMsg;
+                    errMsg << "Dimension " << dimName << " (used by " << var->name << ")";
+                    errMsg << " is not in the dimension dictionary.";
+                    throw eckit::BadParameter(errMsg.str());
+                }
+
+                auto dimVar = obsGroup.vars.open(dimName);
+                dimVars.push_back(dimVar);
+
+                auto chunk = std::max<ioda::Dimensions_t>(dimVar.getChunkSizes()[0], 1);
+                if (chunkSize > 0)
+                {
+                    chunk = std::min(chunk, chunkSize);
+                }
+
+                chunks.push_back(chunk);
+            }
+
+            auto iodaVar = var->write(obsGroup, dimVars, chunks, compressionLevel);
+            for (const auto& attr : var->attrs)
+            {
+                attr->addTo(iodaVar.atts);
+            }
+        }
+
+        for (const auto& global : globals)
+        {
+            global->addTo(rootGroup.atts);
+        }
+    }
+}  // namespace
+
+    PYBIND11_MODULE(ioda_writer, m)
+    {
+        PyDateTime_IMPORT;
+
+        m.doc() = "Writes the IodaWriter (ioda_conv_engines) dictionaries to an IODA file.";
+
+        m.def("write", &writeIoda,
+              py::arg("filename"),
+              py::arg("dim_dict"),
+              py::arg("obs_vars"),
+              py::arg("var_dims"),
+              py::arg("var_attrs"),
+              py::arg("global_attrs"),
+              py::arg("compression_level") = static_cast<int>(6),
+              py::arg("chunk_size") = static_cast<ioda::Dimensions_t>(0),
+              "Write the obs variables, their dimensions and attributes and the global "
+              "attributes to a new IODA (HDF5) file. The data is converted in one pass "
+              "(dateTime strings and datetime objects become seconds since the epoch) and "
+              "the file is written without holding the GIL.");
+    }
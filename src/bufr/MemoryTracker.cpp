@@ -0,0 +1,103 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include "MemoryTracker.h"
+
+#include <iomanip>
+#include <sstream>
+
+
+namespace
+{
+    /// \brief Raise peak to value if it is bigger.
+    void updatePeak(std::atomic<size_t>& peak, size_t value)
+    {
+        size_t prevPeak = peak.load(std::memory_order_relaxed);
+        while (value > prevPeak &&
+               !peak.compare_exchange_weak(prevPeak, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    std::string formatBytes(size_t bytes)
+    {
+        std::ostringstream str;
+        str << std::fixed << std::setprecision(1)
+            << static_cast<double>(bytes) / (1024.0 * 1024.0) << " MB";
+        return str.str();
+    }
+}  // namespace
+
+namespace Ingester
+{
+    MemoryTracker& MemoryTracker::instance()
+    {
+        static MemoryTracker tracker;
+        return tracker;
+    }
+
+    void MemoryTracker::add(Subsystem subsystem, size_t bytes)
+    {
+        const auto idx = static_cast<size_t>(subsystem);
+        updatePeak(peak_[idx], current_[idx].fetch_add(bytes, std::memory_order_relaxed) + bytes);
+        updatePeak(totalPeak_, totalCurrent_.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+    }
+
+    void MemoryTracker::remove(Subsystem subsystem, size_t bytes)
+    {
+        current_[static_cast<size_t>(subsystem)].fetch_sub(bytes, std::memory_order_relaxed);
+        totalCurrent_.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    MemoryTracker::Usage MemoryTracker::usage(Subsystem subsystem) const
+    {
+        const auto idx = static_cast<size_t>(subsystem);
+        return {current_[idx].load(), peak_[idx].load()};
+    }
+
+    MemoryTracker::Usage MemoryTracker::total() const
+    {
+        return {totalCurrent_.load(), totalPeak_.load()};
+    }
+
+    void MemoryTracker::resetPeaks()
+    {
+        for (size_t idx = 0; idx < NumSubsystems; ++idx)
+        {
+            peak_[idx].store(current_[idx].load());
+        }
+
+        totalPeak_.store(totalCurrent_.load());
+    }
+
+    std::string MemoryTracker::name(Subsystem subsystem)
+    {
+        switch (subsystem)
+        {
+            case Subsystem::ResultSet: return "ResultSet";
+            case Subsystem::DataObject: return "DataObject";
+            case Subsystem::DataContainer: return "DataContainer";
+            case Subsystem::Encoder: return "Encoder";
+            default: return "Unknown";
+        }
+    }
+
+    void MemoryTracker::print(std::ostream& out) const
+    {
+        out << "Memory use (current / peak):" << std::endl;
+        for (size_t idx = 0; idx < NumSubsystems; ++idx)
+        {
+            const auto subsystem = static_cast<Subsystem>(idx);
+            const auto subsystemUsage = usage(subsystem);
+            out << "  " << name(subsystem) << ": " << formatBytes(subsystemUsage.current)
+                << " / " << formatBytes(subsystemUsage.peak) << std::endl;
+        }
+
+        out << "  Total: " << formatBytes(total().current)
+            << " / " << formatBytes(total().peak) << std::endl;
+    }
+}  // namespace Ingester
@@ -0,0 +1,139 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <ostream>
+#include <string>
+
+
+namespace Ingester
+{
+    /// \brief Keeps count of the bytes held by the big ingester data structures (current and peak
+    ///        per subsystem) so the memory use of a conversion can be reported. Thread safe.
+    class MemoryTracker
+    {
+     public:
+        /// \brief The parts of a conversion that are tracked.
+        enum class Subsystem
+        {
+            ResultSet = 0,  ///< Data collected by the queries (DataFrames)
+            DataObject,     ///< Exported, split and filtered variable data
+            DataContainer,  ///< Entries of the DataContainers (the DataObjects are counted above)
+            Encoder,        ///< Chunk and compression buffers of the encoders
+            Count
+        };
+
+        /// \brief Bytes in use for a subsystem.
+        struct Usage
+        {
+            size_t current;
+            size_t peak;
+        };
+
+        /// \brief Get the process wide tracker.
+        static MemoryTracker& instance();
+
+        /// \brief Record that a subsystem allocated bytes.
+        void add(Subsystem subsystem, size_t bytes);
+
+        /// \brief Record that a subsystem freed bytes.
+        void remove(Subsystem subsystem, size_t bytes);
+
+        /// \brief Get the usage of a subsystem.
+        Usage usage(Subsystem subsystem) const;
+
+        /// \brief Get the usage of all the subsystems together (the peak is the peak of the sum).
+        Usage total() const;
+
+        /// \brief Set the peaks to the current values (ex: before a new conversion).
+        void resetPeaks();
+
+        /// \brief Get the name of a subsystem.
+        static std::string name(Subsystem subsystem);
+
+        /// \brief Print the usage of each subsystem.
+        void print(std::ostream& out) const;
+
+     private:
+        static constexpr size_t NumSubsystems = static_cast<size_t>(Subsystem::Count);
+
+        std::array<std::atomic<size_t>, NumSubsystems> current_ = {};
+        std::array<std::atomic<size_t>, NumSubsystems> peak_ = {};
+        std::atomic<size_t> totalCurrent_ = {0};
+        std::atomic<size_t> totalPeak_ = {0};
+
+        MemoryTracker() = default;
+    };
+
+    /// \brief Bytes held by an object, reported to the MemoryTracker for as long as the object
+    ///        lives. Meant to be a member of the tracked object (copies are counted again).
+    class TrackedBytes
+    {
+     public:
+        explicit TrackedBytes(MemoryTracker::Subsystem subsystem, size_t bytes = 0) :
+            subsystem_(subsystem)
+        {
+            set(bytes);
+        }
+
+        TrackedBytes(const TrackedBytes& other) :
+            subsystem_(other.subsystem_)
+        {
+            set(other.bytes_);
+        }
+
+        TrackedBytes(TrackedBytes&& other) noexcept :
+            subsystem_(other.subsystem_),
+            bytes_(other.bytes_)
+        {
+            other.bytes_ = 0;
+        }
+
+        TrackedBytes& operator=(const TrackedBytes& other)
+        {
+            set(other.bytes_);
+            return *this;
+        }
+
+        TrackedBytes& operator=(TrackedBytes&& other) noexcept
+        {
+            set(0);
+            bytes_ = other.bytes_;
+            other.bytes_ = 0;
+            return *this;
+        }
+
+        ~TrackedBytes()
+        {
+            set(0);
+        }
+
+        /// \brief Change the number of bytes held.
+        void set(size_t bytes)
+        {
+            if (bytes > bytes_)
+            {
+                MemoryTracker::instance().add(subsystem_, bytes - bytes_);
+            }
+            else if (bytes < bytes_)
+            {
+                MemoryTracker::instance().remove(subsystem_, bytes_ - bytes);
+            }
+
+            bytes_ = bytes;
+        }
+
+        inline size_t bytes() const { return bytes_; }
+
+     private:
+        const MemoryTracker::Subsystem subsystem_;
+        size_t bytes_ = 0;
+    };
+}  // namespace Ingester
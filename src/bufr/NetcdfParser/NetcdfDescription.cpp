@@ -0,0 +1,44 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include "NetcdfDescription.h"
+
+#include "eckit/exception/Exceptions.h"
+
+
+namespace
+{
+    namespace ConfKeys
+    {
+        const char* Filename = "obsdatain";
+        const char* ChunkSize = "chunkSize";
+        const char* Exports = "exports";
+    }  // namespace ConfKeys
+
+    const size_t DefaultChunkSize = 100000;
+}  // namespace
+
+namespace Ingester
+{
+    NetcdfDescription::NetcdfDescription(const eckit::Configuration &conf) :
+        export_(Export(conf.getSubConfiguration(ConfKeys::Exports)))
+    {
+        setFilepath(conf.getString(ConfKeys::Filename));
+
+        setChunkSize(DefaultChunkSize);
+        if (conf.has(ConfKeys::ChunkSize))
+        {
+            int chunkSize = conf.getInt(ConfKeys::ChunkSize);
+            if (chunkSize <= 0)
+            {
+                throw eckit::BadParameter("netcdf::chunkSize must be a positive number.");
+            }
+
+            setChunkSize(static_cast<size_t>(chunkSize));
+        }
+    }
+}  // namespace Ingester
@@ -0,0 +1,46 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "eckit/config/LocalConfiguration.h"
+
+#include "BufrParser/Exports/Export.h"
+
+
+namespace Ingester
+{
+    /// \brief Description of the data to be read from a netCDF (or HDF5) file and how to expose
+    /// that data to the outside world.
+    class NetcdfDescription
+    {
+     public:
+        explicit NetcdfDescription(const eckit::Configuration &conf);
+
+        // Setters
+        inline void setFilepath(const std::string& filepath) { filepath_ = filepath; }
+        inline void setChunkSize(size_t chunkSize) { chunkSize_ = chunkSize; }
+        inline void setExport(const Export& newExport) { export_ = newExport; }
+
+        // Getters
+        inline std::string filepath() const { return filepath_; }
+        inline size_t chunkSize() const { return chunkSize_; }
+        inline Export getExport() const { return export_; }
+
+     private:
+        /// \brief Specifies the relative path to the netCDF file to read.
+        std::string filepath_;
+
+        /// \brief Number of locations (rows of the first dimension) read per hyperslab.
+        size_t chunkSize_;
+
+        /// \brief Map of export strings to Variable classes.
+        Export export_;
+    };
+}  // namespace Ingester
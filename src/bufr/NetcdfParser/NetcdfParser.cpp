@@ -0,0 +1,601 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include "NetcdfParser.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <limits>
+#include <list>
+#include <ostream>
+#include <sstream>
+#include <type_traits>
+
+#include <gsl/gsl-lite.hpp>
+
+#include "eckit/exception/Exceptions.h"
+#include "oops/util/Logger.h"
+#include "ioda/Engines/HH.h"
+
+#include "DataContainer.h"
+#include "DataObject.h"
+#include "BufrParser/Query/Constants.h"
+#include "BufrParser/Query/QueryParser.h"
+
+
+namespace
+{
+    const char* FillValueAttrName = "_FillValue";
+    const char* ScaleFactorAttrName = "scale_factor";
+    const char* AddOffsetAttrName = "add_offset";
+    const char* UnsignedAttrName = "_Unsigned";
+    const char* ValidRangeAttrName = "valid_range";
+    const char* ValidMinAttrName = "valid_min";
+    const char* ValidMaxAttrName = "valid_max";
+
+    /// \brief Make a dimension path for a netCDF dimension. The netCDF dimension name is turned
+    ///        into a valid query mnemonic (upper case, non alpha-numeric characters replaced by
+    ///        _) so that the ioda::dimensions section can refer to it ex: "*/CHANNEL".
+    /// \param dimName The netCDF dimension name (empty for the Location dimension).
+    Ingester::bufr::Query makeDimPath(const std::string& dimName)
+    {
+        std::vector<std::shared_ptr<Ingester::bufr::QueryComponent>> components;
+        components.push_back(std::make_shared<Ingester::bufr::SubsetComponent>());
+
+        if (!dimName.empty())
+        {
+            auto component = std::make_shared<Ingester::bufr::PathComponent>();
+            component->name = dimName.substr(dimName.find_last_of('/') + 1);
+            std::transform(component->name.begin(),
+                           component->name.end(),
+                           component->name.begin(),
+                           [](unsigned char c)
+                           {
+                               return std::isalnum(c) ? std::toupper(c) : '_';
+                           });
+
+            components.push_back(component);
+        }
+
+        return Ingester::bufr::Query(components);
+    }
+
+    /// \brief Read the rows [start, start + count) of the variable.
+    template<typename T>
+    void readRows(const ioda::Variable& var,
+                  const std::vector<ioda::Dimensions_t>& dims,
+                  size_t start,
+                  size_t count,
+                  T* dest)
+    {
+        std::vector<ioda::Dimensions_t> fileStart(dims.size(), 0);
+        std::vector<ioda::Dimensions_t> fileCount = dims;
+        fileStart[0] = static_cast<ioda::Dimensions_t>(start);
+        fileCount[0] = static_cast<ioda::Dimensions_t>(count);
+
+        ioda::Selection fileSelection;
+        fileSelection.extent(dims)
+                     .select({ioda::SelectionOperator::SET, fileStart, fileCount});
+
+        ioda::Selection memSelection;
+        memSelection.extent(fileCount)
+                    .select({ioda::SelectionOperator::SET,
+                             std::vector<ioda::Dimensions_t>(dims.size(), 0),
+                             fileCount});
+
+        size_t rowSize = 1;
+        for (size_t dimIdx = 1; dimIdx < dims.size(); ++dimIdx)
+        {
+            rowSize *= static_cast<size_t>(dims[dimIdx]);
+        }
+
+        var.read<T>(gsl::span<T>(dest, count * rowSize), memSelection, fileSelection);
+    }
+
+    /// \brief The CF attributes that change how the stored values are read: packing
+    ///        (scale_factor and add_offset), _Unsigned and the valid range.
+    struct CfEncoding
+    {
+        bool packed = false;
+        double scaleFactor = 1.0;
+        double addOffset = 0.0;
+        bool packedAsDouble = false;
+        bool isUnsigned = false;
+        double validMin = -std::numeric_limits<double>::infinity();
+        double validMax = std::numeric_limits<double>::infinity();
+        bool validRangePacked = true;  ///< The valid range is in stored (packed) units
+
+        /// \brief Do the stored values need a conversion?
+        bool needed() const
+        {
+            return packed || isUnsigned || std::isfinite(validMin) || std::isfinite(validMax);
+        }
+    };
+
+    /// \brief Read the CF encoding attributes of a variable.
+    CfEncoding readCfEncoding(const ioda::Variable& var)
+    {
+        CfEncoding cf;
+        if (var.atts.exists(ScaleFactorAttrName))
+        {
+            const auto att = var.atts.open(ScaleFactorAttrName);
+            cf.packed = true;
+            cf.packedAsDouble = att.isA<double>();
+            cf.scaleFactor = att.read<double>();
+        }
+
+        if (var.atts.exists(AddOffsetAttrName))
+        {
+            const auto att = var.atts.open(AddOffsetAttrName);
+            cf.packed = true;
+            cf.packedAsDouble = cf.packedAsDouble || att.isA<double>();
+            cf.addOffset = att.read<double>();
+        }
+
+        if (var.atts.exists(UnsignedAttrName))
+        {
+            auto isUnsigned = var.atts.open(UnsignedAttrName).read<std::string>();
+            std::transform(isUnsigned.begin(), isUnsigned.end(), isUnsigned.begin(), ::tolower);
+            cf.isUnsigned = (isUnsigned == "true");
+        }
+
+        // A range of the type of the unpacked data (float or double) is in unpacked units
+        const auto isPackedUnits = [&cf](const ioda::Attribute& att)
+        {
+            return !cf.packed || !(att.isA<float>() || att.isA<double>());
+        };
+
+        if (var.atts.exists(ValidRangeAttrName))
+        {
+            const auto att = var.atts.open(ValidRangeAttrName);
+            std::vector<double> range;
+            att.read<double>(range);
+            if (range.size() != 2)
+            {
+                throw eckit::BadParameter("The valid_range attribute must have 2 values.");
+            }
+
+            cf.validMin = range[0];
+            cf.validMax = range[1];
+            cf.validRangePacked = isPackedUnits(att);
+        }
+        else
+        {
+            if (var.atts.exists(ValidMinAttrName))
+            {
+                const auto att = var.atts.open(ValidMinAttrName);
+                cf.validMin = att.read<double>();
+                cf.validRangePacked = isPackedUnits(att);
+            }
+
+            if (var.atts.exists(ValidMaxAttrName))
+            {
+                const auto att = var.atts.open(ValidMaxAttrName);
+                cf.validMax = att.read<double>();
+                cf.validRangePacked = isPackedUnits(att);
+            }
+        }
+
+        return cf;
+    }
+
+    /// \brief The unsigned type of a stored integer type (floating point types are unchanged).
+    template<typename S, bool = std::is_integral<S>::value>
+    struct UnsignedOf
+    {
+        typedef typename std::make_unsigned<S>::type type;
+    };
+
+    template<typename S>
+    struct UnsignedOf<S, false>
+    {
+        typedef S type;
+    };
+
+    /// \brief The value of a stored integer flagged with _Unsigned.
+    template<typename S>
+    typename UnsignedOf<S>::type asUnsigned(S value)
+    {
+        return static_cast<typename UnsignedOf<S>::type>(value);
+    }
+
+    /// \brief Read a numeric variable stored as S with CF encoding attributes as T. Each hyperslab
+    ///        is read in its stored type, then the _Unsigned values are reinterpreted, the values
+    ///        outside of the valid range (and the fill values) become missing and the packed
+    ///        values are unpacked (value * scale_factor + add_offset).
+    template<typename S, typename T>
+    std::shared_ptr<Ingester::DataObjectBase> readEncoded(
+        const ioda::Variable& var,
+        const std::vector<ioda::Dimensions_t>& fileDims,
+        size_t numLocs,
+        size_t rowSize,
+        size_t chunkSize,
+        const CfEncoding& cf)
+    {
+        const T missingValue = Ingester::DataObject<T>::missingValue();
+
+        // Without a _FillValue the BUFR missing value is used (when the type can hold it).
+        bool hasFillValue = true;
+        S fillValue = S();
+        if (var.atts.exists(FillValueAttrName))
+        {
+            fillValue = var.atts.open(FillValueAttrName).read<S>();
+        }
+        else if (std::is_floating_point<S>::value)
+        {
+            fillValue = static_cast<S>(Ingester::bufr::MissingValue);
+        }
+        else
+        {
+            hasFillValue = false;
+        }
+
+        std::vector<T> data(numLocs * rowSize);
+        std::vector<S> stored(std::min(chunkSize, numLocs) * rowSize);
+        for (size_t start = 0; start < numLocs; start += chunkSize)
+        {
+            const size_t count = std::min(chunkSize, numLocs - start);
+            readRows<S>(var, fileDims, start, count, stored.data());
+
+            auto dest = data.begin() + start * rowSize;
+            for (size_t idx = 0; idx < count * rowSize; ++idx, ++dest)
+            {
+                const S storedValue = stored[idx];
+                if ((hasFillValue && storedValue == fillValue) || std::isnan(storedValue))
+                {
+                    *dest = missingValue;
+                    continue;
+                }
+
+                const double value = cf.isUnsigned ? static_cast<double>(asUnsigned(storedValue)) :
+                                                     static_cast<double>(storedValue);
+                const double unpacked = value * cf.scaleFactor + cf.addOffset;
+
+                const double checked = cf.validRangePacked ? value : unpacked;
+                if (checked < cf.validMin || checked > cf.validMax)
+                {
+                    *dest = missingValue;
+                }
+                else if (cf.packed)
+                {
+                    *dest = static_cast<T>(unpacked);
+                }
+                else
+                {
+                    *dest = cf.isUnsigned ? static_cast<T>(asUnsigned(storedValue)) :
+                                            static_cast<T>(storedValue);
+                }
+            }
+        }
+
+        auto object = std::make_shared<Ingester::DataObject<T>>();
+        object->setRawData(std::move(data));
+        return object;
+    }
+
+    /// \brief Read a numeric variable with CF encoding attributes as T, for its stored type.
+    template<typename T>
+    std::shared_ptr<Ingester::DataObjectBase> readEncoded(
+        const ioda::Variable& var,
+        const std::vector<ioda::Dimensions_t>& fileDims,
+        size_t numLocs,
+        size_t rowSize,
+        size_t chunkSize,
+        const CfEncoding& cf)
+    {
+        if (var.isA<int8_t>())
+            return readEncoded<int8_t, T>(var, fileDims, numLocs, rowSize, chunkSize, cf);
+        if (var.isA<uint8_t>())
+            return readEncoded<uint8_t, T>(var, fileDims, numLocs, rowSize, chunkSize, cf);
+        if (var.isA<int16_t>())
+            return readEncoded<int16_t, T>(var, fileDims, numLocs, rowSize, chunkSize, cf);
+        if (var.isA<uint16_t>())
+            return readEncoded<uint16_t, T>(var, fileDims, numLocs, rowSize, chunkSize, cf);
+        if (var.isA<int32_t>())
+            return readEncoded<int32_t, T>(var, fileDims, numLocs, rowSize, chunkSize, cf);
+        if (var.isA<uint32_t>())
+            return readEncoded<uint32_t, T>(var, fileDims, numLocs, rowSize, chunkSize, cf);
+        if (var.isA<int64_t>())
+            return readEncoded<int64_t, T>(var, fileDims, numLocs, rowSize, chunkSize, cf);
+        if (var.isA<uint64_t>())
+            return readEncoded<uint64_t, T>(var, fileDims, numLocs, rowSize, chunkSize, cf);
+        if (var.isA<float>())
+            return readEncoded<float, T>(var, fileDims, numLocs, rowSize, chunkSize, cf);
+
+        return readEncoded<double, T>(var, fileDims, numLocs, rowSize, chunkSize, cf);
+    }
+
+    /// \brief Read a numeric variable as T (HDF5 converts from the storage type). Each hyperslab
+    ///        is read straight into the storage of the DataObject and its fill values (and NaNs)
+    ///        are turned into missing values, so no intermediate copy of the variable is made.
+    ///        Variables with CF encoding attributes are read by readEncoded.
+    template<typename T>
+    std::shared_ptr<Ingester::DataObjectBase> readNumeric(
+        const ioda::Variable& var,
+        const std::vector<ioda::Dimensions_t>& fileDims,
+        size_t numLocs,
+        size_t rowSize,
+        size_t chunkSize,
+        const CfEncoding& cf)
+    {
+        if (cf.needed())
+        {
+            return readEncoded<T>(var, fileDims, numLocs, rowSize, chunkSize, cf);
+        }
+
+        const T missingValue = Ingester::DataObject<T>::missingValue();
+
+        // Without a _FillValue the BUFR missing value is used (when the type can hold it).
+        T fillValue = missingValue;
+        if (var.atts.exists(FillValueAttrName))
+        {
+            fillValue = var.atts.open(FillValueAttrName).read<T>();
+        }
+        else if (std::is_floating_point<T>::value)
+        {
+            fillValue = static_cast<T>(Ingester::bufr::MissingValue);
+        }
+
+        std::vector<T> data(numLocs * rowSize);
+        for (size_t start = 0; start < numLocs; start += chunkSize)
+        {
+            const size_t count = std::min(chunkSize, numLocs - start);
+            auto chunkBegin = data.begin() + start * rowSize;
+            readRows<T>(var, fileDims, start, count, &(*chunkBegin));
+
+            std::replace_if(chunkBegin,
+                            chunkBegin + count * rowSize,
+                            [fillValue](T val)
+                            {
+                                return val == fillValue || std::isnan(val);
+                            },
+                            missingValue);
+        }
+
+        auto object = std::make_shared<Ingester::DataObject<T>>();
+        object->setRawData(std::move(data));
+        return object;
+    }
+
+    /// \brief Get the type to read a numeric variable as: its storage type (smaller integer
+    ///        types are widened to int32) or the type override of the export.
+    std::string numericType(const ioda::Variable& var, const std::string& overrideType)
+    {
+        if (overrideType.empty())
+        {
+            if (var.isA<double>()) return "double";
+            if (var.isA<float>()) return "float";
+            if (var.isA<int64_t>()) return "int64";
+            if (var.isA<uint64_t>()) return "uint64";
+            if (var.isA<uint32_t>()) return "uint32";
+            return "int";
+        }
+
+        if (overrideType == "int32") return "int";
+        if (overrideType == "float32") return "float";
+        if (overrideType == "float64") return "double";
+        if (overrideType == "uint") return "uint32";
+
+        return overrideType;
+    }
+
+    /// \brief Get the type to read a CF encoded variable as: float or double (the type of
+    ///        scale_factor) for packed variables, otherwise the storage type with _Unsigned
+    ///        integers read as unsigned (widened to int32 when they fit).
+    std::string encodedType(const ioda::Variable& var,
+                            const CfEncoding& cf,
+                            const std::string& overrideType)
+    {
+        if (cf.packed)
+        {
+            if (overrideType.empty()) return cf.packedAsDouble ? "double" : "float";
+            if (overrideType == "float" || overrideType == "float32") return "float";
+            if (overrideType == "double" || overrideType == "float64") return "double";
+
+            throw eckit::BadParameter("Packed variables (scale_factor, add_offset) can only be "
+                                      "read as float or double.");
+        }
+
+        if (cf.isUnsigned && overrideType.empty())
+        {
+            if (var.isA<int64_t>()) return "uint64";
+            if (var.isA<int32_t>()) return "uint32";
+        }
+
+        return numericType(var, overrideType);
+    }
+}  // namespace
+
+namespace Ingester
+{
+    NetcdfParser::NetcdfParser(const NetcdfDescription& description) :
+        description_(description)
+    {
+        oops::Log::info() << "NetcdfParser: Parsing file " << description_.filepath() << std::endl;
+    }
+
+    NetcdfParser::NetcdfParser(const eckit::LocalConfiguration& conf) :
+        description_(NetcdfDescription(conf))
+    {
+        oops::Log::info() << "NetcdfParser: Parsing file " << description_.filepath() << std::endl;
+    }
+
+    std::shared_ptr<DataContainer> NetcdfParser::parse(const size_t maxLocsToParse)
+    {
+        auto startTime = std::chrono::steady_clock::now();
+        bufr::TaskScheduler::Scope schedulerScope(scheduler_);
+
+        auto file = ioda::Engines::HH::openFile(description_.filepath(),
+                                                ioda::Engines::BackendOpenModes::Read_Only);
+
+        // The dimension scales are used to name the dimensions of the variables we read.
+        std::vector<ioda::Named_Variable> dimScales;
+        for (const auto& varName : file.vars.list())
+        {
+            auto var = file.vars.open(varName);
+            if (var.isDimensionScale())
+            {
+                dimScales.push_back({varName, var});
+            }
+        }
+
+        oops::Log::info() << "Reading Variables" << std::endl;
+        auto srcData = BufrDataMap();
+        for (const auto& var : description_.getExport().getVariables())
+        {
+            for (const auto& queryInfo : var->getQueryList())
+            {
+                srcData[queryInfo.name] = readVariable(file, dimScales, queryInfo, maxLocsToParse);
+            }
+        }
+
+        oops::Log::info()  << "Exporting Data" << std::endl;
+        auto exportedData = exportData(description_.getExport(), srcData);
+
+        auto timeElapsed = std::chrono::steady_clock::now() - startTime;
+        auto timeElapsedDuration = std::chrono::duration_cast<std::chrono::milliseconds>
+                (timeElapsed);
+        oops::Log::info()  << "Finished "
+                           << "[" << timeElapsedDuration.count() / 1000.0 << "s]"
+                           << std::endl;
+
+        return exportedData;
+    }
+
+    std::shared_ptr<DataObjectBase> NetcdfParser::readVariable(
+        const ioda::Group& file,
+        const std::vector<ioda::Named_Variable>& dimScales,
+        const QueryInfo& queryInfo,
+        size_t maxLocs) const
+    {
+        if (!file.vars.exists(queryInfo.query))
+        {
+            std::ostringstream errMsg;
+            errMsg << "Variable " << queryInfo.query << " (needed for " << queryInfo.name << ")";
+            errMsg << " does not exist in " << description_.filepath() << ".";
+            throw eckit::BadParameter(errMsg.str());
+        }
+
+        auto var = file.vars.open(queryInfo.query);
+        auto fileDims = var.getDimensions().dimsCur;
+        if (fileDims.empty())
+        {
+            throw eckit::BadParameter("Variable " + queryInfo.query + " has no dimensions. The "
+                                      "first dimension must be the location dimension.");
+        }
+
+        // Work out the dimensions and dimension paths of the result
+        size_t numLocs = static_cast<size_t>(fileDims[0]);
+        if (maxLocs > 0)
+        {
+            numLocs = std::min(numLocs, maxLocs);
+        }
+
+        Dimensions dims = {static_cast<int>(numLocs)};
+        size_t rowSize = 1;
+        for (size_t dimIdx = 1; dimIdx < fileDims.size(); ++dimIdx)
+        {
+            dims.push_back(static_cast<int>(fileDims[dimIdx]));
+            rowSize *= static_cast<size_t>(fileDims[dimIdx]);
+        }
+
+        auto scaleMappings = var.getDimensionScaleMappings(
+            std::list<ioda::Named_Variable>(dimScales.begin(), dimScales.end()));
+
+        std::vector<bufr::Query> dimPaths = {makeDimPath("")};
+        for (size_t dimIdx = 1; dimIdx < fileDims.size(); ++dimIdx)
+        {
+            if (dimIdx < scaleMappings.size() && !scaleMappings[dimIdx].empty())
+            {
+                dimPaths.push_back(makeDimPath(scaleMappings[dimIdx][0].name));
+            }
+            else
+            {
+                dimPaths.push_back(makeDimPath(queryInfo.name + "_" + std::to_string(dimIdx)));
+            }
+        }
+
+        // Read the data one hyperslab (chunkSize locations) at a time.
+        const size_t chunkSize = description_.chunkSize();
+        std::shared_ptr<DataObjectBase> object;
+        if (var.isA<std::string>())
+        {
+            if (!queryInfo.type.empty() && queryInfo.type != "string")
+            {
+                std::ostringstream errMsg;
+                errMsg << "Conversions between numbers and strings are not currently supported. ";
+                errMsg << "See the export definition for \"" << queryInfo.name << "\".";
+                throw eckit::BadParameter(errMsg.str());
+            }
+
+            std::vector<std::string> data(numLocs * rowSize);
+            for (size_t start = 0; start < numLocs; start += chunkSize)
+            {
+                const size_t count = std::min(chunkSize, numLocs - start);
+                readRows<std::string>(var, fileDims, start, count, data.data() + start * rowSize);
+            }
+
+            auto strObject = std::make_shared<DataObject<std::string>>();
+            strObject->setRawData(std::move(data));
+            object = strObject;
+        }
+        else
+        {
+            if (queryInfo.type == "string")
+            {
+                std::ostringstream errMsg;
+                errMsg << "Conversions between numbers and strings are not currently supported. ";
+                errMsg << "See the export definition for \"" << queryInfo.name << "\".";
+                throw eckit::BadParameter(errMsg.str());
+            }
+
+            const auto cf = readCfEncoding(var);
+            const auto type = cf.needed() ? encodedType(var, cf, queryInfo.type) :
+                                            numericType(var, queryInfo.type);
+            if (type == "int")
+            {
+                object = readNumeric<int32_t>(var, fileDims, numLocs, rowSize, chunkSize, cf);
+            }
+            else if (type == "float")
+            {
+                object = readNumeric<float>(var, fileDims, numLocs, rowSize, chunkSize, cf);
+            }
+            else if (type == "double")
+            {
+                object = readNumeric<double>(var, fileDims, numLocs, rowSize, chunkSize, cf);
+            }
+            else if (type == "int64")
+            {
+                object = readNumeric<int64_t>(var, fileDims, numLocs, rowSize, chunkSize, cf);
+            }
+            else if (type == "uint64")
+            {
+                object = readNumeric<uint64_t>(var, fileDims, numLocs, rowSize, chunkSize, cf);
+            }
+            else if (type == "uint32")
+            {
+                object = readNumeric<uint32_t>(var, fileDims, numLocs, rowSize, chunkSize, cf);
+            }
+            else
+            {
+                std::ostringstream errMsg;
+                errMsg << "Unknown or unsupported type " << queryInfo.type << ".";
+                throw eckit::BadParameter(errMsg.str());
+            }
+        }
+
+        object->setDims(dims);
+        object->setFieldName(queryInfo.name);
+        object->setGroupByFieldName(queryInfo.groupByField);
+        object->setQuery(queryInfo.query);
+        object->setDimPaths(dimPaths);
+
+        return object;
+    }
+}  // namespace Ingester
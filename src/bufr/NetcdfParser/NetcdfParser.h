@@ -0,0 +1,57 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "eckit/config/LocalConfiguration.h"
+#include "ioda/Group.h"
+
+#include "Parser.h"
+#include "NetcdfDescription.h"
+
+
+namespace Ingester
+{
+    class DataContainer;
+
+    /// \brief Uses a NetcdfDescription to read the variables of a netCDF (or HDF5) file into the
+    ///        same DataObjects the BufrParser makes, so that the export filters, splits and the
+    ///        IodaEncoder can be reused unchanged.
+    class NetcdfParser final : public Parser
+    {
+     public:
+        explicit NetcdfParser(const NetcdfDescription& description);
+        explicit NetcdfParser(const eckit::LocalConfiguration& conf);
+
+        /// \brief Uses the provided description to parse the netCDF file.
+        /// \param maxLocsToParse Locations to parse (0 for everything)
+        std::shared_ptr<DataContainer> parse(const size_t maxLocsToParse = 0) final;
+
+        /// \brief Start over from the beginning of the file (nothing is cached between parses).
+        void reset() final {}
+
+     private:
+        /// \brief The description the defines what to read from the netCDF file
+        NetcdfDescription description_;
+
+        /// \brief Read one variable into a DataObject, one hyperslab of rows at a time.
+        /// \param file The open file.
+        /// \param dimScales The dimension scale variables of the file.
+        /// \param queryInfo Describes the variable to read.
+        /// \param maxLocs Max number of locations to read (0 for everything)
+        std::shared_ptr<DataObjectBase> readVariable(
+            const ioda::Group& file,
+            const std::vector<ioda::Named_Variable>& dimScales,
+            const QueryInfo& queryInfo,
+            size_t maxLocs) const;
+    };
+}  // namespace Ingester
@@ -0,0 +1,123 @@
+/*
+ * (C) Copyright 2020 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include "Parser.h"
+
+#include <ostream>
+#include <sstream>
+
+#include "oops/util/Logger.h"
+
+#include "DataObject.h"
+#include "BufrParser/Exports/Splits/Split.h"
+#include "BufrParser/Query/ParallelFor.h"
+
+
+namespace Ingester
+{
+    std::shared_ptr<DataContainer> Parser::exportData(const Export& exportDescription,
+                                                      const BufrDataMap& srcData)
+    {
+        auto filters = exportDescription.getFilters();
+        auto splits = exportDescription.getSplits();
+        auto vars = exportDescription.getVariables();
+
+        // Filter
+        BufrDataMap dataCopy = srcData;  // make mutable copy
+        for (const auto &filter : filters)
+        {
+            filter->apply(dataCopy);
+        }
+
+        // Split
+        CategoryMap catMap;
+        for (const auto &split : splits)
+        {
+            std::ostringstream catName;
+            catName << "splits/" << split->getName();
+            catMap.insert({catName.str(), split->subCategories(dataCopy)});
+        }
+
+        CatDataMap splitDataMaps;
+        splitDataMaps.insert({std::vector<std::string>(), dataCopy});
+        for (const auto &split : splits)
+        {
+            splitDataMaps = splitData(splitDataMaps, *split);
+        }
+
+        // Export (the thread safe variables of every category are exported concurrently, the
+        // others one at a time on this thread, and then all are added to the container in order)
+        struct VariableExport
+        {
+            const std::vector<std::string>* categories;
+            const BufrDataMap* dataMap;
+            std::shared_ptr<Variable> var;
+            std::shared_ptr<DataObjectBase> data;
+        };
+
+        std::vector<VariableExport> varExports;
+        std::vector<size_t> concurrentIdxs;
+        std::vector<size_t> serialIdxs;
+        for (const auto &dataPair : splitDataMaps)
+        {
+            for (const auto &var : vars)
+            {
+                auto& idxs = var->isThreadSafe() ? concurrentIdxs : serialIdxs;
+                idxs.push_back(varExports.size());
+                varExports.push_back({&dataPair.first, &dataPair.second, var, nullptr});
+            }
+        }
+
+        bufr::parallelFor(concurrentIdxs.size(), 1, [&](size_t idxBegin, size_t idxEnd)
+        {
+            for (size_t idx = idxBegin; idx < idxEnd; ++idx)
+            {
+                auto& varExport = varExports[concurrentIdxs[idx]];
+                varExport.data = varExport.var->exportData(*varExport.dataMap);
+            }
+        });
+
+        for (const auto exportIdx : serialIdxs)
+        {
+            auto& varExport = varExports[exportIdx];
+            varExport.data = varExport.var->exportData(*varExport.dataMap);
+        }
+
+        auto exportData = std::make_shared<Ingester::DataContainer>(catMap);
+        for (const auto &varExport : varExports)
+        {
+            std::ostringstream pathStr;
+            pathStr << "variables/" << varExport.var->getExportName();
+
+            oops::Log::debug() << "Exporting variable = " << varExport.var->getExportName()
+                               << std::endl;
+
+            exportData->add(pathStr.str(), varExport.data, *varExport.categories);
+        }
+
+        return exportData;
+    }
+
+    Parser::CatDataMap Parser::splitData(Parser::CatDataMap &splitMaps, Split &split)
+    {
+        CatDataMap splitDataMap;
+
+        for (const auto &splitMapPair : splitMaps)
+        {
+            auto newData = split.split(splitMapPair.second);
+
+            for (const auto &newDataPair : newData)
+            {
+                auto catVect = splitMapPair.first;
+                catVect.push_back(newDataPair.first);
+                splitDataMap.insert({catVect, newDataPair.second});
+            }
+        }
+
+        return splitDataMap;
+    }
+}  // namespace Ingester
@@ -7,9 +7,17 @@
 
 #pragma once
 
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "eckit/config/LocalConfiguration.h"
 
 #include "DataContainer.h"
+#include "IngesterTypes.h"
+#include "BufrParser/Exports/Export.h"
+#include "BufrParser/Query/TaskScheduler.h"
 
 namespace Ingester
 {
@@ -27,5 +35,34 @@ namespace Ingester
 
         /// \brief Start over from the beginning
         virtual void reset() = 0;
+
+        /// \brief Run the parsing (and exporting) on a task scheduler shared with the other
+        ///        stages of the run.
+        /// \param scheduler The scheduler (null for the scheduler of the calling thread).
+        void setScheduler(const std::shared_ptr<bufr::TaskScheduler>& scheduler)
+        {
+            scheduler_ = scheduler;
+        }
+
+     protected:
+        typedef std::map<std::vector<std::string>, BufrDataMap> CatDataMap;
+
+        /// \brief The task scheduler to run on (null for the scheduler of the calling thread).
+        std::shared_ptr<bufr::TaskScheduler> scheduler_;
+
+        /// \brief Applies the filters, splits and variables of the export description to the
+        ///        collected source data. The variables of all the categories are exported as
+        ///        tasks on the scheduler of the calling thread.
+        /// \param exportDescription Description of what to export
+        /// \param srcData Data to export
+        std::shared_ptr<DataContainer> exportData(const Export& exportDescription,
+                                                  const BufrDataMap& srcData);
+
+        /// \brief Function responsible for dividing the data into subcategories.
+        /// \details This function is intended to be called over and over for each specified Split
+        ///          object, sub-splitting the data given into all the possible subcategories.
+        /// \param splitMaps Pre-split map of data.
+        /// \param split Object that knows how to split data.
+        CatDataMap splitData(CatDataMap& splitMaps, Split& split);
     };
 }  // namespace Ingester
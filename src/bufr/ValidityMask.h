@@ -0,0 +1,182 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <vector>
+
+
+namespace Ingester
+{
+    /// \brief Packed bitmap with one bit per data element, the bit is set when the element is
+    ///        valid (not missing). Lets kernels skip or process whole 64 element words at a time
+    ///        instead of comparing every element against the missing value.
+    class ValidityMask
+    {
+     public:
+        typedef uint64_t Word;
+        static constexpr size_t WordBits = 64;
+        static constexpr Word AllValid = ~Word(0);
+
+        ValidityMask() = default;
+
+        /// \brief Constructor.
+        /// \param size Number of elements.
+        /// \param isValid Initial state of all the elements.
+        explicit ValidityMask(size_t size, bool isValid = true) :
+            size_(size),
+            words_((size + WordBits - 1) / WordBits, isValid ? AllValid : 0)
+        {
+            clearTail();
+        }
+
+        /// \brief Make the mask for data by testing each element once.
+        /// \param data The data.
+        /// \param isValid Predicate that returns true for valid elements.
+        template<typename T, typename Pred>
+        static ValidityMask fromData(const std::vector<T>& data, Pred isValid)
+        {
+            ValidityMask mask(data.size(), false);
+            for (size_t wordIdx = 0; wordIdx < mask.words_.size(); ++wordIdx)
+            {
+                const size_t start = wordIdx * WordBits;
+                const size_t end = std::min(start + WordBits, data.size());
+
+                Word word = 0;
+                for (size_t idx = start; idx < end; ++idx)
+                {
+                    word |= static_cast<Word>(isValid(data[idx])) << (idx - start);
+                }
+
+                mask.words_[wordIdx] = word;
+            }
+
+            return mask;
+        }
+
+        inline size_t size() const { return size_; }
+        inline bool empty() const { return size_ == 0; }
+
+        inline bool isValid(size_t idx) const
+        {
+            return (words_[idx / WordBits] >> (idx % WordBits)) & 1;
+        }
+
+        inline void set(size_t idx, bool isValid)
+        {
+            const Word bit = Word(1) << (idx % WordBits);
+            if (isValid)
+            {
+                words_[idx / WordBits] |= bit;
+            }
+            else
+            {
+                words_[idx / WordBits] &= ~bit;
+            }
+        }
+
+        /// \brief The packed words (element idx is bit idx % 64 of word idx / 64).
+        inline const std::vector<Word>& words() const { return words_; }
+
+        /// \brief Number of valid elements (a popcount per word).
+        size_t numValid() const
+        {
+            size_t count = 0;
+            for (const auto word : words_)
+            {
+                count += std::bitset<WordBits>(word).count();
+            }
+
+            return count;
+        }
+
+        /// \brief Number of missing elements.
+        inline size_t numMissing() const { return size_ - numValid(); }
+
+        /// \brief Only keep the elements that are valid in both masks (same size).
+        ValidityMask& operator&=(const ValidityMask& other)
+        {
+            for (size_t wordIdx = 0; wordIdx < words_.size(); ++wordIdx)
+            {
+                words_[wordIdx] &= other.words_[wordIdx];
+            }
+
+            return *this;
+        }
+
+        /// \brief Call func(idx) for every valid element. Fully valid words are done without
+        ///        testing bits and fully missing words are skipped.
+        template<typename Func>
+        void forEachValid(Func func) const
+        {
+            for (size_t wordIdx = 0; wordIdx < words_.size(); ++wordIdx)
+            {
+                Word word = words_[wordIdx];
+                const size_t start = wordIdx * WordBits;
+
+                if (word == AllValid)
+                {
+                    for (size_t idx = start; idx < start + WordBits; ++idx)
+                    {
+                        func(idx);
+                    }
+                }
+                else
+                {
+                    for (size_t bit = 0; word != 0; ++bit, word >>= 1)
+                    {
+                        if (word & 1) func(start + bit);
+                    }
+                }
+            }
+        }
+
+        /// \brief Write the inverse of the mask as bools (ex: for numpy masked arrays).
+        /// \param isMissing Output array with size() elements.
+        void toMissingFlags(bool* isMissing) const
+        {
+            for (size_t wordIdx = 0; wordIdx < words_.size(); ++wordIdx)
+            {
+                const Word word = words_[wordIdx];
+                const size_t start = wordIdx * WordBits;
+                const size_t end = std::min(start + WordBits, size_);
+
+                if (word == AllValid)
+                {
+                    std::fill(isMissing + start, isMissing + end, false);
+                }
+                else if (word == 0)
+                {
+                    std::fill(isMissing + start, isMissing + end, true);
+                }
+                else
+                {
+                    for (size_t idx = start; idx < end; ++idx)
+                    {
+                        isMissing[idx] = !((word >> (idx - start)) & 1);
+                    }
+                }
+            }
+        }
+
+     private:
+        size_t size_ = 0;
+        std::vector<Word> words_;
+
+        /// \brief Clear the unused bits of the last word (so full words compare to AllValid).
+        void clearTail()
+        {
+            if (size_ % WordBits != 0)
+            {
+                words_.back() &= (Word(1) << (size_ % WordBits)) - 1;
+            }
+        }
+    };
+}  // namespace Ingester
@@ -5,17 +5,36 @@
  * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
  */
 
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
 #include <string>
 #include <iostream>
 #include <ostream>
+#include <vector>
 
 #include "eckit/config/YAMLConfiguration.h"
 #include "eckit/exception/Exceptions.h"
 #include "eckit/filesystem/PathName.h"
+#include "oops/util/Logger.h"
 
 #include "BufrParser/BufrParser.h"
+#include "BufrParser/Exports/Variables/Transforms/atms/atms_spatial_average_interface.h"
+#include "BufrParser/Query/TaskScheduler.h"
+#include "CsvParser/CsvParser.h"
+#include "NetcdfParser/NetcdfParser.h"
 #include "IodaEncoder/IodaDescription.h"
 #include "IodaEncoder/IodaEncoder.h"
+#include "MemoryTracker.h"
 #include "ObjectFactory.h"
 
 
@@ -23,47 +42,301 @@ namespace Ingester
 {
     typedef ObjectFactory<Ingester::Parser, const eckit::LocalConfiguration&> ParseFactory;
 
-    void parse(const std::string& yamlPath, std::size_t numMsgs = 0)
+    /// \brief Parse one observations entry and write its ioda output.
+    /// \param obsConf The observations entry.
+    /// \param numMsgs Number of messages to parse (0 for all of them).
+    /// \param scheduler The task scheduler all the stages run on.
+    void parseEntry(const eckit::LocalConfiguration& obsConf,
+                    std::size_t numMsgs,
+                    const std::shared_ptr<bufr::TaskScheduler>& scheduler)
     {
         ParseFactory parseFactory;
         parseFactory.registerObject<BufrParser>("bufr");
+        parseFactory.registerObject<NetcdfParser>("netcdf");
+        parseFactory.registerObject<CsvParser>("csv");
 
-        std::unique_ptr<eckit::YAMLConfiguration>
-            yaml(new eckit::YAMLConfiguration(eckit::PathName(yamlPath)));
+        if (!obsConf.has("obs space") ||
+            !obsConf.has("ioda"))
+        {
+            eckit::BadParameter(
+                "Incomplete obs found. All obs must have a obs space and ioda.");
+        }
 
-        if (yaml->has("observations"))
+        auto configuration = obsConf.getSubConfiguration("obs space");
+        auto parserName = std::string("bufr");
+        if (configuration.has("parser"))
+        {
+            parserName = configuration.getString("parser");
+        }
+
+        auto parser = parseFactory.create(parserName, configuration);
+        parser->setScheduler(scheduler);
+        auto data = parser->parse(numMsgs);
+
+        auto encoder = IodaEncoder(obsConf.getSubConfiguration("ioda"));
+        encoder.setScheduler(scheduler);
+        encoder.setKeepObsGroups(false);
+        encoder.encode(data);
+
+        MemoryTracker::instance().print(oops::Log::info());
+        MemoryTracker::instance().resetPeaks();
+    }
+
+    /// \brief The scheduler options of one of numJobs processes that share the threads (and the
+    ///        CPUs when the threads are pinned) of a run.
+    /// \param options The scheduler options of the run.
+    /// \param jobSlot The slot of the process (in [0, numJobs)).
+    /// \param numJobs Number of processes running at the same time.
+    bufr::SchedulerOptions jobSchedulerOptions(const bufr::SchedulerOptions& options,
+                                               std::size_t jobSlot,
+                                               std::size_t numJobs)
+    {
+        const auto cpus = options.cpus.empty() ? bufr::TaskScheduler::allowedCpus() : options.cpus;
+        const auto numThreads = options.numThreads > 0 ? options.numThreads : cpus.size();
+
+        bufr::SchedulerOptions jobOptions;
+        jobOptions.numThreads = std::max<std::size_t>(1, numThreads / numJobs);
+        jobOptions.affinity = options.affinity;
+
+        if (options.affinity != bufr::Affinity::None)
+        {
+            const auto cpusPerJob = std::max<std::size_t>(1, cpus.size() / numJobs);
+            for (std::size_t cpuIdx = 0; cpuIdx < cpusPerJob; ++cpuIdx)
+            {
+                jobOptions.cpus.push_back(cpus[(jobSlot * cpusPerJob + cpuIdx) % cpus.size()]);
+            }
+        }
+
+        return jobOptions;
+    }
+
+    /// \brief Flush the C, C++ and Fortran output buffers of the process.
+    void flushOutput()
+    {
+        std::cout.flush();
+        std::cerr.flush();
+        std::fflush(nullptr);
+        Flush_Fortran_Output_f();
+    }
+
+    /// \brief Run the entries in worker processes, at most numJobs at a time. NCEPLIB-bufr
+    ///        keeps its state (open units, tables) in Fortran globals, so the entries can't
+    ///        share a process. The output of each worker goes to its own log, which is copied to
+    ///        stdout when the worker ends so the logs of the entries don't interleave. The
+    ///        workers split the threads (and pinned CPUs) of the scheduler options between them.
+    ///        If this process throws, the running workers are killed (and reaped) first.
+    /// \return The number of entries that failed.
+    std::size_t parseConcurrently(const std::vector<eckit::LocalConfiguration>& obsConfs,
+                                  std::size_t numMsgs,
+                                  std::size_t numJobs,
+                                  const std::string& logDir,
+                                  const bufr::SchedulerOptions& schedulerOptions)
+    {
+        struct Worker
+        {
+            std::size_t entryIdx;
+            std::string logPath;
+            std::size_t jobSlot;
+        };
+
+        numJobs = std::min(numJobs, obsConfs.size());
+
+        std::map<pid_t, Worker> workers;
+        std::vector<std::size_t> freeSlots;
+        for (std::size_t jobSlot = numJobs; jobSlot > 0; --jobSlot)
         {
-            for (const auto& obsConf : yaml->getSubConfigurations("observations"))
+            freeSlots.push_back(jobSlot - 1);
+        }
+
+        std::size_t numFailed = 0;
+
+        const auto finishWorker = [&]()
+        {
+            int status = 0;
+            const pid_t pid = waitpid(-1, &status, 0);
+            if (pid < 0 || workers.find(pid) == workers.end())
+            {
+                throw eckit::SeriousBug("bufr2ioda: lost track of a worker process.");
+            }
+
+            const auto worker = workers.at(pid);
+            workers.erase(pid);
+            freeSlots.push_back(worker.jobSlot);
+
+            std::ifstream log(worker.logPath);
+            std::cout << "==== observations entry " << worker.entryIdx << " (" << worker.logPath
+                      << ")" << std::endl;
+            if (log) std::cout << log.rdbuf();
+
+            std::cout << "==== observations entry " << worker.entryIdx;
+            if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+            {
+                std::cout << " finished." << std::endl;
+            }
+            else
             {
-                if (!obsConf.has("obs space") ||
-                    !obsConf.has("ioda"))
+                numFailed++;
+                if (WIFSIGNALED(status))
                 {
-                    eckit::BadParameter(
-                        "Incomplete obs found. All obs must have a obs space and ioda.");
+                    std::cout << " FAILED (signal " << WTERMSIG(status) << ")." << std::endl;
                 }
+                else
+                {
+                    std::cout << " FAILED (exit status " << WEXITSTATUS(status) << ")."
+                              << std::endl;
+                }
+            }
+
+            if (logDir.empty()) std::remove(worker.logPath.c_str());
+        };
 
-                auto configuration = obsConf.getSubConfiguration("obs space");
-                auto parser = parseFactory.create("bufr", configuration);
-                auto data = parser->parse(numMsgs);
+        const auto startWorker = [&](std::size_t entryIdx)
+        {
+            const auto jobSlot = freeSlots.back();
+            freeSlots.pop_back();
+
+            std::string logPath;
+            int logFd = -1;
+            if (logDir.empty())
+            {
+                const char* tmpDir = std::getenv("TMPDIR");
+                logPath = std::string(tmpDir ? tmpDir : "/tmp") + "/bufr2ioda_XXXXXX";
+                logFd = mkstemp(&logPath[0]);
+            }
+            else
+            {
+                logPath = logDir + "/bufr2ioda_" + std::to_string(entryIdx) + ".log";
+                logFd = open(logPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            }
 
-                auto encoder = IodaEncoder(obsConf.getSubConfiguration("ioda"));
-                encoder.encode(data);
+            if (logFd < 0)
+            {
+                throw eckit::BadParameter("bufr2ioda: could not create the log " + logPath);
+            }
+
+            // Don't let the worker inherit (and flush a second time) buffered output.
+            flushOutput();
+
+            const pid_t pid = fork();
+            if (pid < 0)
+            {
+                close(logFd);
+                throw eckit::SeriousBug("bufr2ioda: could not start a worker process.");
+            }
+
+            if (pid == 0)
+            {
+                dup2(logFd, STDOUT_FILENO);
+                dup2(logFd, STDERR_FILENO);
+                close(logFd);
+
+                int exitStatus = 0;
+                try
+                {
+                    // Start the threads after the fork (only the forking thread is copied)
+                    auto scheduler = std::make_shared<bufr::TaskScheduler>(
+                        jobSchedulerOptions(schedulerOptions, jobSlot, numJobs));
+                    parseEntry(obsConfs[entryIdx], numMsgs, scheduler);
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << e.what() << std::endl;
+                    exitStatus = 1;
+                }
+                catch (...)
+                {
+                    // Never unwind into the parent's code (it would kill the other workers).
+                    exitStatus = 1;
+                }
+
+                // _exit doesn't run the exit handlers that flush the Fortran units (and the
+                // static objects copied from the parent must not be destroyed here).
+                flushOutput();
+                _exit(exitStatus);
+            }
+
+            close(logFd);
+            workers[pid] = {entryIdx, logPath, jobSlot};
+        };
+
+        try
+        {
+            for (std::size_t entryIdx = 0; entryIdx < obsConfs.size(); ++entryIdx)
+            {
+                if (workers.size() >= numJobs) finishWorker();
+                startWorker(entryIdx);
+            }
+
+            while (!workers.empty()) finishWorker();
+        }
+        catch (...)
+        {
+            for (const auto& worker : workers)
+            {
+                kill(worker.first, SIGKILL);
+                waitpid(worker.first, nullptr, 0);
+                if (logDir.empty()) std::remove(worker.second.logPath.c_str());
+            }
+
+            throw;
+        }
+
+        return numFailed;
+    }
+
+    /// \brief Parse all the observations entries of the YAML file.
+    /// \return The number of entries that failed (always 0 when they run in this process, as
+    ///         errors are thrown).
+    std::size_t parse(const std::string& yamlPath,
+                      std::size_t numMsgs = 0,
+                      std::size_t numJobs = 1,
+                      const std::string& logDir = "",
+                      const bufr::SchedulerOptions& schedulerOptions = bufr::SchedulerOptions())
+    {
+        std::unique_ptr<eckit::YAMLConfiguration>
+            yaml(new eckit::YAMLConfiguration(eckit::PathName(yamlPath)));
+
+        if (yaml->has("observations"))
+        {
+            const auto obsConfs = yaml->getSubConfigurations("observations");
+            if (numJobs > 1 && obsConfs.size() > 1)
+            {
+                return parseConcurrently(obsConfs, numMsgs, numJobs, logDir, schedulerOptions);
+            }
+
+            auto scheduler = std::make_shared<bufr::TaskScheduler>(schedulerOptions);
+            for (const auto& obsConf : obsConfs)
+            {
+                parseEntry(obsConf, numMsgs, scheduler);
             }
         }
         else
         {
             eckit::BadParameter("No section named \"observations\"");
         }
+
+        return 0;
     }
 }  // namespace Ingester
 
 
 static void showHelp()
 {
-    std::cerr << "Usage: bufr2ioda.x [-n NUM_MESSAGES] YAML_PATH"
+    std::cerr << "Usage: bufr2ioda.x [-n NUM_MESSAGES] [-j NUM_JOBS] [-l LOG_DIR]\n"
+              << "                   [-t NUM_THREADS] [-a AFFINITY] [-c CPU_LIST] YAML_PATH\n"
               << "Options:\n"
               << "  -h,  Show this help message\n"
-              << "  -n NUM_MESSAGES,  Number of BUFR messages to parse."
+              << "  -n NUM_MESSAGES,  Number of BUFR messages to parse.\n"
+              << "  -j NUM_JOBS,  Number of observations entries to run at the same time (each\n"
+              << "                in its own process, default 1).\n"
+              << "  -l LOG_DIR,  Keep the log of each entry as LOG_DIR/bufr2ioda_<entry>.log\n"
+              << "               (only with -j).\n"
+              << "  -t NUM_THREADS,  Max number of threads of the run (default one per CPU,\n"
+              << "                   shared by the -j processes).\n"
+              << "  -a AFFINITY,  Pin the threads to CPUs: none (default), compact (consecutive\n"
+              << "                CPUs) or scatter (spread over the CPUs).\n"
+              << "  -c CPU_LIST,  CPUs to use with -a, ex: 0-7,16 (default the CPUs the process\n"
+              << "                may run on)."
               << std::endl;
 }
 
@@ -78,6 +351,9 @@ int main(int argc, char **argv)
 
     std::string yamlPath;
     std::size_t numMsgs = 0;
+    std::size_t numJobs = 1;
+    std::string logDir;
+    Ingester::bufr::SchedulerOptions schedulerOptions;
 
     std::size_t argIdx = 1;
     while (argIdx < static_cast<std::size_t> (argc))
@@ -96,6 +372,38 @@ int main(int argc, char **argv)
 
             argIdx += 2;
         }
+        else if (strcmp(argv[argIdx], "-j") == 0 || strcmp(argv[argIdx], "-l") == 0 ||
+                 strcmp(argv[argIdx], "-t") == 0 || strcmp(argv[argIdx], "-a") == 0 ||
+                 strcmp(argv[argIdx], "-c") == 0)
+        {
+            if (static_cast<std::size_t> (argc) <= argIdx + 1)
+            {
+                showHelp();
+                return 0;
+            }
+
+            const std::string value(argv[argIdx + 1]);
+            switch (argv[argIdx][1])
+            {
+                case 'j':
+                    numJobs = std::max(1, atoi(value.c_str()));
+                    break;
+                case 'l':
+                    logDir = value;
+                    break;
+                case 't':
+                    schedulerOptions.numThreads = std::max(0, atoi(value.c_str()));
+                    break;
+                case 'a':
+                    schedulerOptions.affinity =
+                        Ingester::bufr::TaskScheduler::affinityFromName(value);
+                    break;
+                default:
+                    schedulerOptions.cpus = Ingester::bufr::TaskScheduler::parseCpuList(value);
+            }
+
+            argIdx += 2;
+        }
         else if (strcmp(argv[argIdx], "-h") == 0)
         {
             showHelp();
@@ -108,7 +416,7 @@ int main(int argc, char **argv)
         }
     }
 
-    Ingester::parse(yamlPath, numMsgs);
+    const auto numFailed = Ingester::parse(yamlPath, numMsgs, numJobs, logDir, schedulerOptions);
 
     try
     {
@@ -119,6 +427,12 @@ int main(int argc, char **argv)
         throw;
     }
 
+    if (numFailed > 0)
+    {
+        std::cerr << numFailed << " observations entries failed." << std::endl;
+        return 1;
+    }
+
     return 0;
 }
 
@@ -0,0 +1,310 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "eckit/config/LocalConfiguration.h"
+#include "eckit/config/YAMLConfiguration.h"
+#include "eckit/exception/Exceptions.h"
+#include "eckit/filesystem/PathName.h"
+
+#include "BufrParser/BufrParser.h"
+#include "DataContainer.h"
+#include "DataObject.h"
+#include "IodaEncoder/IodaEncoder.h"
+
+
+namespace py = pybind11;
+
+using Ingester::BufrParser;
+using Ingester::DataContainer;
+using Ingester::DataObject;
+using Ingester::DataObjectBase;
+using Ingester::IodaEncoder;
+using Ingester::SubCategory;
+
+namespace
+{
+    namespace ConfKeys
+    {
+        const char* Observations = "observations";
+        const char* ObsSpace = "obs space";
+        const char* Ioda = "ioda";
+    }  // namespace ConfKeys
+
+    /// \brief Load a configuration from a dict, a YAML string or the path of a YAML file.
+    eckit::LocalConfiguration loadConfiguration(const py::object& config)
+    {
+        std::unique_ptr<eckit::YAMLConfiguration> yaml;
+        if (py::isinstance<py::str>(config))
+        {
+            const auto str = config.cast<std::string>();
+            if (eckit::PathName(str).exists())
+            {
+                yaml.reset(new eckit::YAMLConfiguration(eckit::PathName(str)));
+            }
+            else
+            {
+                yaml.reset(new eckit::YAMLConfiguration(str));
+            }
+        }
+        else
+        {
+            // JSON is valid YAML
+            const auto json = py::module_::import("json").attr("dumps")(config);
+            yaml.reset(new eckit::YAMLConfiguration(json.cast<std::string>()));
+        }
+
+        return eckit::LocalConfiguration(*yaml);
+    }
+
+    /// \brief Get the configuration of a section (ex: obs space). The config can be the section
+    ///        itself, an observations entry or a whole bufr2ioda YAML file.
+    /// \param entry The index of the observations entry to use (whole YAML files).
+    eckit::LocalConfiguration sectionConfiguration(const py::object& config,
+                                                   const std::string& section,
+                                                   size_t entry)
+    {
+        auto conf = loadConfiguration(config);
+        if (conf.has(ConfKeys::Observations))
+        {
+            const auto entries = conf.getSubConfigurations(ConfKeys::Observations);
+            if (entry >= entries.size())
+            {
+                throw eckit::BadParameter("There is no observations entry " +
+                                          std::to_string(entry) + ".");
+            }
+
+            conf = entries[entry];
+        }
+
+        if (conf.has(section))
+        {
+            conf = conf.getSubConfiguration(section);
+        }
+
+        return conf;
+    }
+
+    /// \brief Capsule that keeps a DataObject alive as long as the numpy arrays using its data.
+    py::capsule makeOwner(const std::shared_ptr<DataObjectBase>& data)
+    {
+        return py::capsule(new std::shared_ptr<DataObjectBase>(data),
+                           [](void* owner)
+                           {
+                               delete static_cast<std::shared_ptr<DataObjectBase>*>(owner);
+                           });
+    }
+
+    /// \brief Read only numpy array that uses the data of a DataObject<T> (no copy).
+    /// \param masked Return a masked array with the missing values masked (only the mask is
+    ///        made, the masked array uses the same data).
+    /// \return None if the data has another type.
+    template<typename T>
+    py::object makeView(const std::shared_ptr<DataObjectBase>& data, bool masked)
+    {
+        auto typedData = std::dynamic_pointer_cast<DataObject<T>>(data);
+        if (typedData == nullptr) return py::none();
+
+        const auto dims = typedData->getDims();
+        const auto shape = std::vector<py::ssize_t>(dims.begin(), dims.end());
+        py::array_t<T> view(shape, typedData->rawData().data(), makeOwner(data));
+        view.attr("setflags")(py::arg("write") = false);
+
+        if (!masked) return view;
+
+        py::array_t<bool> mask(shape);
+        typedData->getValidity().toMissingFlags(static_cast<bool*>(mask.mutable_data()));
+
+        auto numpyMa = py::module_::import("numpy").attr("ma");
+        auto maskedArray = numpyMa.attr("masked_array")(view, mask);
+        numpyMa.attr("set_fill_value")(maskedArray, DataObject<T>::missingValue());
+
+        return maskedArray;
+    }
+
+    /// \brief Numpy array of a DataObject. Numeric data isn't copied (the array is read only),
+    ///        string data is copied into an object array.
+    /// \param masked Return a masked array with the missing values masked.
+    py::object toNumpy(const std::shared_ptr<DataObjectBase>& data, bool masked)
+    {
+        for (auto makeTypedView : {&makeView<float>,
+                                   &makeView<double>,
+                                   &makeView<int>,
+                                   &makeView<int8_t>,
+                                   &makeView<int16_t>,
+                                   &makeView<int64_t>,
+                                   &makeView<uint32_t>,
+                                   &makeView<uint64_t>})
+        {
+            auto array = makeTypedView(data, masked);
+            if (!array.is_none()) return array;
+        }
+
+        if (std::dynamic_pointer_cast<DataObject<std::string>>(data) == nullptr)
+        {
+            throw eckit::BadParameter("Field " + data->getFieldName() +
+                                      " has an unsupported type.");
+        }
+
+        // Strings can't be shared with numpy, the DataObject copies them into a masked array
+        auto maskedStrings = data->getNumpyArray();
+        return masked ? py::object(maskedStrings) : py::object(maskedStrings.attr("data"));
+    }
+
+    /// \brief The fields of a sub category as a dict of numpy arrays.
+    py::dict fieldsToDict(const DataContainer& container,
+                          const SubCategory& category,
+                          bool masked)
+    {
+        py::dict fields;
+        for (const auto& fieldName : container.getFieldNames(category))
+        {
+            fields[py::str(fieldName)] = toNumpy(container.get(fieldName, category), masked);
+        }
+
+        return fields;
+    }
+}  // namespace
+
+
+PYBIND11_MODULE(bufr2ioda, m)
+{
+    m.doc() = "Runs the bufr2ioda pipeline (parser, exports and ioda encoder) in process.";
+
+    py::class_<DataContainer, std::shared_ptr<DataContainer>>(m, "DataContainer")
+        .def("categories", &DataContainer::allSubCategories,
+             "Get the sub categories (the combinations of the split categories).")
+        .def("category_map", &DataContainer::getCategoryMap,
+             "Get the map of each split to its categories.")
+        .def("fields", &DataContainer::getFieldNames,
+             py::arg("category") = SubCategory(),
+             "Get the names of the fields of a sub category.")
+        .def("size", &DataContainer::size,
+             py::arg("category") = SubCategory(),
+             "Get the number of locations of a sub category.")
+        .def("get",
+             [](const DataContainer& self,
+                const std::string& fieldName,
+                const SubCategory& category,
+                bool masked)
+             {
+                 return toNumpy(self.get(fieldName, category), masked);
+             },
+             py::arg("field_name"),
+             py::arg("category") = SubCategory(),
+             py::arg("masked") = true,
+             "Get a field as a numpy array. Numeric arrays use the data of the container (they "
+             "are read only).")
+        .def("to_dict",
+             [](const DataContainer& self, bool masked)
+             {
+                 py::dict categories;
+                 for (const auto& category : self.allSubCategories())
+                 {
+                     categories[py::tuple(py::cast(category))] =
+                         fieldsToDict(self, category, masked);
+                 }
+
+                 return categories;
+             },
+             py::arg("masked") = true,
+             "Get the fields of every sub category ({category tuple: {field name: array}}).");
+
+    py::class_<BufrParser>(m, "BufrParser")
+        .def(py::init([](const py::object& config, size_t entry)
+             {
+                 return new BufrParser(sectionConfiguration(config, ConfKeys::ObsSpace, entry));
+             }),
+             py::arg("config"),
+             py::arg("entry") = static_cast<size_t>(0),
+             "Make the parser from the obs space configuration (a dict, a YAML string or a YAML "
+             "file path). An observations entry or a whole bufr2ioda YAML is also accepted (entry "
+             "picks the observations entry).")
+        .def("parse",
+             [](BufrParser& self, size_t numMessages)
+             {
+                 py::gil_scoped_release release;
+                 return self.parse(numMessages);
+             },
+             py::arg("num_messages") = static_cast<size_t>(0),
+             "Parse the BUFR file (0 messages for all of them). Returns a DataContainer with the "
+             "exported, filtered and split data.")
+        .def("reset", &BufrParser::reset,
+             "Rewind the BUFR file.");
+
+    py::class_<IodaEncoder>(m, "IodaEncoder")
+        .def(py::init([](const py::object& config, size_t entry)
+             {
+                 return new IodaEncoder(sectionConfiguration(config, ConfKeys::Ioda, entry));
+             }),
+             py::arg("config"),
+             py::arg("entry") = static_cast<size_t>(0),
+             "Make the encoder from the ioda configuration (a dict, a YAML string or a YAML file "
+             "path). An observations entry or a whole bufr2ioda YAML is also accepted.")
+        .def("encode",
+             [](IodaEncoder& self, const std::shared_ptr<DataContainer>& data, bool append)
+             {
+                 // The ObsGroups can only be returned once the ioda python module is loaded
+                 const bool hasIodaTypes =
+                     py::detail::get_type_info(typeid(ioda::ObsGroup)) != nullptr;
+                 self.setKeepObsGroups(hasIodaTypes);
+
+                 std::map<SubCategory, ioda::ObsGroup> obsGroups;
+                 {
+                     py::gil_scoped_release release;
+                     obsGroups = self.encode(data, append);
+                 }
+
+                 py::dict result;
+                 for (const auto& obsGroup : obsGroups)
+                 {
+                     result[py::tuple(py::cast(obsGroup.first))] =
+                         hasIodaTypes ? py::cast(obsGroup.second) : py::none();
+                 }
+
+                 return result;
+             },
+             py::arg("data"),
+             py::arg("append") = false,
+             "Encode the data (writes the outputs of file backends). Returns {category tuple: "
+             "ObsGroup}, use the inMemory backend to only keep the ObsGroups (the ObsGroups are "
+             "None unless the ioda python module was imported first).");
+
+    m.def("run",
+          [](const py::object& config, size_t numMessages)
+          {
+              const auto yaml = loadConfiguration(config);
+              if (!yaml.has(ConfKeys::ObsSpace) && !yaml.has(ConfKeys::Observations))
+              {
+                  throw eckit::BadParameter("The config has no observations entries.");
+              }
+
+              py::gil_scoped_release release;
+              const auto entries = yaml.has(ConfKeys::Observations) ?
+                  yaml.getSubConfigurations(ConfKeys::Observations) :
+                  std::vector<eckit::LocalConfiguration>{yaml};
+              for (const auto& entry : entries)
+              {
+                  auto parser = BufrParser(entry.getSubConfiguration(ConfKeys::ObsSpace));
+                  auto encoder = IodaEncoder(entry.getSubConfiguration(ConfKeys::Ioda));
+                  encoder.setKeepObsGroups(false);
+                  encoder.encode(parser.parse(numMessages));
+              }
+          },
+          py::arg("config"),
+          py::arg("num_messages") = static_cast<size_t>(0),
+          "Run all the observations entries of a bufr2ioda YAML (a dict, a YAML string or a YAML "
+          "file path) like bufr2ioda.x does (BUFR parsers only).");
+}
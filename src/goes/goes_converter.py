@@ -47,6 +47,12 @@ from goes import Goes
 from goes_latlon import GoesLatLon
 from goes_util import GoesUtil
 
+# The compiled kernels are optional, the numpy implementation is used when they are not built.
+try:
+    from pyiodaconv import goes_kernels
+except ImportError:
+    goes_kernels = None
+
 
 class GoesConverter:
 
@@ -239,7 +245,6 @@ class GoesConverter:
         Creates the /MetaData/solarZenithAngle variable in an output netCDF4 dataset.
         output_dataset - A netCDF4 Dataset object
         """
-        d2r = np.pi / 180.0
         dataset = Dataset(self._input_file_path_template, 'r')
         dataset.set_auto_scale(True)
         dataset_latlon = Dataset(self._latlon_file_path, 'r')
@@ -248,10 +253,46 @@ class GoesConverter:
         dataset.close()
         dataset_latlon.close()
 
-        latitude_rad = latitude * d2r
         start_date = self._start_date
         start_date_tt = start_date.timetuple()
         day_number = start_date_tt.tm_yday
+        if goes_kernels is not None:
+            solar_zenith_angle_data_array = np.empty(len(latitude))
+            solar_azimuth_angle_data_array = np.empty(len(latitude))
+            goes_kernels.solar_angles(np.asarray(latitude, dtype=np.float64), np.asarray(longitude, dtype=np.float64),
+                                      day_number, start_date.hour, start_date.minute, start_date.second,
+                                      solar_zenith_angle_data_array, solar_azimuth_angle_data_array)
+        else:
+            solar_zenith_angle_data_array, solar_azimuth_angle_data_array = \
+                GoesConverter._calc_solar_angles_numpy(latitude, longitude, day_number, start_date)
+
+        # If the incoming data is flipped south-to-north.
+        solar_zenith_angle_data_array = \
+            self._goes_util.filter_data_array_by_yaw_flip_flag(solar_zenith_angle_data_array)
+        solar_azimuth_angle_data_array = \
+            self._goes_util.filter_data_array_by_yaw_flip_flag(solar_azimuth_angle_data_array)
+
+        solar_zenith_angle_data_array = np.nan_to_num(solar_zenith_angle_data_array, nan=-999)
+        output_dataset.createVariable('/MetaData/solarZenithAngle', 'f4', 'Location', fill_value=-999)
+        output_dataset['/MetaData/solarZenithAngle'][:] = solar_zenith_angle_data_array
+        output_dataset['/MetaData/solarZenithAngle'].setncattr('units', 'degrees')
+
+        solar_azimuth_angle_data_array = np.nan_to_num(solar_azimuth_angle_data_array, nan=-999)
+        output_dataset.createVariable('/MetaData/solarAzimuthAngle', 'f4', 'Location', fill_value=-999)
+        output_dataset['/MetaData/solarAzimuthAngle'][:] = solar_azimuth_angle_data_array
+        output_dataset['/MetaData/solarAzimuthAngle'].setncattr('units', 'degrees')
+
+    @staticmethod
+    def _calc_solar_angles_numpy(latitude, longitude, day_number, start_date):
+        """
+        Calculates the solar zenith and azimuth angles with numpy.
+        latitude - the latitude data array
+        longitude - the longitude data array
+        day_number - the day of the year of start_date
+        start_date - the UTC start date and time
+        """
+        d2r = np.pi / 180.0
+        latitude_rad = latitude * d2r
         declin = 23.45 * np.sin(d2r*(360./365.*(day_number-81)))
         eqnOfTime = 9.87*np.sin(2*declin*d2r) - 7.53*np.cos(declin*d2r) - 1.5*np.sin(declin*d2r)
 
@@ -273,22 +314,7 @@ class GoesConverter:
         dAzimuth = np.arctan2(dY, dX)
         dAzimuth[dAzimuth < 0.0] = dAzimuth[dAzimuth < 0.0] + 2.0 * np.pi
         solar_azimuth_angle_data_array = dAzimuth / d2r
-
-        # If the incoming data is flipped south-to-north.
-        solar_zenith_angle_data_array = \
-            self._goes_util.filter_data_array_by_yaw_flip_flag(solar_zenith_angle_data_array)
-        solar_azimuth_angle_data_array = \
-            self._goes_util.filter_data_array_by_yaw_flip_flag(solar_azimuth_angle_data_array)
-
-        solar_zenith_angle_data_array = np.nan_to_num(solar_zenith_angle_data_array, nan=-999)
-        output_dataset.createVariable('/MetaData/solarZenithAngle', 'f4', 'Location', fill_value=-999)
-        output_dataset['/MetaData/solarZenithAngle'][:] = solar_zenith_angle_data_array
-        output_dataset['/MetaData/solarZenithAngle'].setncattr('units', 'degrees')
-
-        solar_azimuth_angle_data_array = np.nan_to_num(solar_azimuth_angle_data_array, nan=-999)
-        output_dataset.createVariable('/MetaData/solarAzimuthAngle', 'f4', 'Location', fill_value=-999)
-        output_dataset['/MetaData/solarAzimuthAngle'][:] = solar_azimuth_angle_data_array
-        output_dataset['/MetaData/solarAzimuthAngle'].setncattr('units', 'degrees')
+        return solar_zenith_angle_data_array, solar_azimuth_angle_data_array
 
     def _create_location_dimension(self, output_dataset):
         """
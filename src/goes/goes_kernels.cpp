@@ -0,0 +1,357 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+
+namespace py = pybind11;
+
+template<typename T>
+using CArray = py::array_t<T, py::array::c_style | py::array::forcecast>;
+
+// Output arrays are bound with noconvert so pybind11 never hands the kernels a converted copy
+// (the results would be written to the copy and silently lost)
+using OutArray = py::array_t<double, py::array::c_style>;
+
+namespace
+{
+    const double D2R = M_PI / 180.0;
+    const double R2D = 180.0 / M_PI;
+    const double FillValue = -999.0;
+
+    // Elements per tile for the 1d kernels (the inputs and outputs of a tile fit in L2)
+    const size_t TileSize = 16384;
+
+    /// \brief Call func(begin, end) for each tile of [0, size) on numThreads threads (0 for the
+    ///        number of cores). The tiles are handed out dynamically so uneven tiles (ex: the
+    ///        space pixels of the full disk) balance out.
+    template<typename Func>
+    void forEachTile(size_t size, size_t tileSize, size_t numThreads, Func func)
+    {
+        const size_t numTiles = (size + tileSize - 1) / tileSize;
+        if (numThreads == 0)
+        {
+            numThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+        }
+
+        numThreads = std::min(numThreads, numTiles);
+
+        std::atomic<size_t> nextTile(0);
+        std::vector<std::exception_ptr> errors(numThreads);
+        auto worker = [&](size_t threadIdx)
+        {
+            try
+            {
+                for (size_t tile = nextTile++; tile < numTiles; tile = nextTile++)
+                {
+                    func(tile * tileSize, std::min(size, (tile + 1) * tileSize));
+                }
+            }
+            catch (...)
+            {
+                errors[threadIdx] = std::current_exception();
+                nextTile = numTiles;
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (size_t threadIdx = 1; threadIdx < numThreads; ++threadIdx)
+        {
+            threads.emplace_back(worker, threadIdx);
+        }
+
+        if (numThreads > 0) worker(0);
+
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        for (const auto& error : errors)
+        {
+            if (error) std::rethrow_exception(error);
+        }
+    }
+
+    /// \brief Check that an output array is writable and has size elements.
+    double* outputPtr(OutArray& array, size_t size, const char* name)
+    {
+        if (static_cast<size_t>(array.size()) != size || !array.writeable())
+        {
+            throw py::value_error(std::string(name) + " must be a writable float64 array with " +
+                                  std::to_string(size) + " elements.");
+        }
+
+        return array.mutable_data();
+    }
+
+    /// \brief Check that the input arrays have the same size.
+    void checkSameSize(const CArray<double>& first, const CArray<double>& second)
+    {
+        if (first.size() != second.size())
+        {
+            throw py::value_error("The latitude and longitude arrays must have the same size.");
+        }
+    }
+}  // namespace
+
+
+PYBIND11_MODULE(goes_kernels, m)
+{
+    m.doc() = "Tiled and threaded kernels for the GOES ABI fixed grid geolocation and angles.";
+
+    m.def("fixed_grid",
+          [](const CArray<double>& x,
+             const CArray<double>& y,
+             double rEq,
+             double rPol,
+             double h,
+             double lon0,
+             OutArray latitude,
+             OutArray longitude,
+             OutArray scanAngle,
+             OutArray elevationAngle,
+             size_t numThreads)
+          {
+              const size_t nx = static_cast<size_t>(x.size());
+              const size_t ny = static_cast<size_t>(y.size());
+              const size_t size = nx * ny;
+
+              double* latPtr = outputPtr(latitude, size, "latitude");
+              double* lonPtr = outputPtr(longitude, size, "longitude");
+              double* scanPtr = outputPtr(scanAngle, size, "scan_angle");
+              double* elevPtr = outputPtr(elevationAngle, size, "elevation_angle");
+
+              // The grid is separable so the trig functions are only needed per row and column
+              std::vector<double> sinX(nx), cosX(nx), sinY(ny), cosY(ny);
+              for (size_t ix = 0; ix < nx; ++ix)
+              {
+                  sinX[ix] = std::sin(x.data()[ix]);
+                  cosX[ix] = std::cos(x.data()[ix]);
+              }
+
+              for (size_t iy = 0; iy < ny; ++iy)
+              {
+                  sinY[iy] = std::sin(y.data()[iy]);
+                  cosY[iy] = std::cos(y.data()[iy]);
+              }
+
+              const double* xPtr = x.data();
+              const double* yPtr = y.data();
+              const double axisRatio = (rEq * rEq) / (rPol * rPol);
+              const double c = h * h - rEq * rEq;
+              const double lon0Rad = lon0 * D2R;
+
+              py::gil_scoped_release release;
+
+              // One tile per grid row
+              forEachTile(ny, 1, numThreads, [&](size_t rowBegin, size_t rowEnd)
+              {
+                  for (size_t iy = rowBegin; iy < rowEnd; ++iy)
+                  {
+                      const double sy = sinY[iy];
+                      const double cy = cosY[iy];
+                      const double rowTerm = cy * cy + axisRatio * sy * sy;
+                      const size_t offset = iy * nx;
+
+                      for (size_t ix = 0; ix < nx; ++ix)
+                      {
+                          const double sx = sinX[ix];
+                          const double cx = cosX[ix];
+
+                          const double a = sx * sx + cx * cx * rowTerm;
+                          const double b = -2.0 * h * cx * cy;
+                          const double rS = (-b - std::sqrt(b * b - 4.0 * a * c)) / (2.0 * a);
+
+                          const double sX = rS * cx * cy;
+                          const double sY = -rS * sx;
+                          const double sZ = rS * cx * sy;
+                          const double hMinusSx = h - sX;
+
+                          const double lat = std::atan(axisRatio * (sZ / std::sqrt(
+                              hMinusSx * hMinusSx + sY * sY))) * R2D;
+                          double lon = (lon0Rad - std::atan(sY / hMinusSx)) * R2D;
+                          if (lon <= -180.0) lon += 360.0;
+
+                          latPtr[offset + ix] = lat;
+                          lonPtr[offset + ix] = lon;
+                          scanPtr[offset + ix] = xPtr[ix] * R2D;
+                          elevPtr[offset + ix] = yPtr[iy] * R2D;
+                      }
+                  }
+              });
+          },
+          py::arg("x"),
+          py::arg("y"),
+          py::arg("r_eq"),
+          py::arg("r_pol"),
+          py::arg("h"),
+          py::arg("lon_0"),
+          py::arg("latitude").noconvert(),
+          py::arg("longitude").noconvert(),
+          py::arg("scan_angle").noconvert(),
+          py::arg("elevation_angle").noconvert(),
+          py::arg("threads") = static_cast<size_t>(0),
+          "Compute the latitude, longitude (degrees, nan off the earth) and the scan and "
+          "elevation angles of the (y, x) fixed grid into the given flat C contiguous float64 "
+          "arrays (they are not converted). h is the perspective point height plus the semi "
+          "major axis and lon_0 is in degrees.");
+
+    m.def("sensor_angles",
+          [](const CArray<double>& latitude,
+             const CArray<double>& longitude,
+             double rEq,
+             double h,
+             double lat0,
+             double lon0,
+             OutArray zenith,
+             OutArray azimuth,
+             OutArray view,
+             size_t numThreads)
+          {
+              checkSameSize(latitude, longitude);
+              const size_t size = static_cast<size_t>(latitude.size());
+
+              const double* latPtr = latitude.data();
+              const double* lonPtr = longitude.data();
+              double* zenPtr = outputPtr(zenith, size, "zenith");
+              double* aziPtr = outputPtr(azimuth, size, "azimuth");
+              double* viewPtr = outputPtr(view, size, "view");
+
+              const double lat0Rad = lat0 * D2R;
+              const double lon0Rad = lon0 * D2R;
+              const double sinLat0 = std::sin(lat0Rad);
+              const double cosLat0 = std::cos(lat0Rad);
+              const double hSqrPlusREqSqr = h * h + rEq * rEq;
+
+              py::gil_scoped_release release;
+
+              forEachTile(size, TileSize, numThreads, [&](size_t begin, size_t end)
+              {
+                  for (size_t idx = begin; idx < end; ++idx)
+                  {
+                      const double latRad = latPtr[idx] * D2R;
+                      const double dLon = lonPtr[idx] * D2R - lon0Rad;
+                      const double cosLat = std::cos(latRad);
+                      const double cosDLon = std::cos(dLon);
+
+                      const double beta = std::acos(std::cos(latRad - lat0Rad) * cosDLon);
+                      const double sqrtComp = hSqrPlusREqSqr - 2.0 * h * rEq * std::cos(beta);
+                      double zen = std::asin((h * std::sin(beta)) / std::sqrt(sqrtComp)) * R2D;
+                      double view = std::asin(rEq / h * std::sin(zen * D2R)) * R2D;
+
+                      const double ax = std::sin(dLon) * cosLat;
+                      const double ay = cosLat0 * std::sin(latRad) - sinLat0 * cosLat * cosDLon;
+                      double azi = std::atan2(ax, ay) * R2D + 180.0;
+
+                      // Zenith is limited to [0, 80] (CRTM)
+                      zen = std::isnan(zen) ? FillValue : std::min(80.0, std::max(0.0, zen));
+                      view = std::isnan(view) ? FillValue : std::min(80.0, std::max(0.0, view));
+                      azi = std::isnan(azi) ? FillValue : std::min(360.0, std::max(0.0, azi));
+
+                      zenPtr[idx] = zen;
+                      aziPtr[idx] = azi;
+                      viewPtr[idx] = view;
+                  }
+              });
+          },
+          py::arg("latitude"),
+          py::arg("longitude"),
+          py::arg("r_eq"),
+          py::arg("h"),
+          py::arg("lat_0"),
+          py::arg("lon_0"),
+          py::arg("zenith").noconvert(),
+          py::arg("azimuth").noconvert(),
+          py::arg("view").noconvert(),
+          py::arg("threads") = static_cast<size_t>(0),
+          "Compute the sensor zenith, azimuth and view angles (degrees, -999 where undefined) "
+          "into the given C contiguous float64 arrays (they are not converted). lat_0 and lon_0 "
+          "are the projection origin in degrees.");
+
+    m.def("solar_angles",
+          [](const CArray<double>& latitude,
+             const CArray<double>& longitude,
+             int dayOfYear,
+             double hour,
+             double minute,
+             double second,
+             OutArray zenith,
+             OutArray azimuth,
+             size_t numThreads)
+          {
+              checkSameSize(latitude, longitude);
+              const size_t size = static_cast<size_t>(latitude.size());
+
+              const double* latPtr = latitude.data();
+              const double* lonPtr = longitude.data();
+              double* zenPtr = outputPtr(zenith, size, "zenith");
+              double* aziPtr = outputPtr(azimuth, size, "azimuth");
+
+              const double declin = 23.45 * std::sin(D2R * (360.0 / 365.0 * (dayOfYear - 81)));
+              const double eqnOfTime = 9.87 * std::sin(2 * declin * D2R) -
+                                       7.53 * std::cos(declin * D2R) -
+                                       1.5 * std::sin(declin * D2R);
+              const double sinDeclin = std::sin(declin * D2R);
+              const double cosDeclin = std::cos(declin * D2R);
+              const double tanDeclin = std::tan(declin * D2R);
+              const double minutes = hour * 60.0 + minute + second / 60.0;
+              const double localStdTimeMeridian = 0.0;
+
+              py::gil_scoped_release release;
+
+              forEachTile(size, TileSize, numThreads, [&](size_t begin, size_t end)
+              {
+                  for (size_t idx = begin; idx < end; ++idx)
+                  {
+                      const double latRad = latPtr[idx] * D2R;
+                      const double sinLat = std::sin(latRad);
+                      const double cosLat = std::cos(latRad);
+
+                      // Local solar time (with the time correction) and solar hour angle
+                      const double timeCorrection = 4.0 * (lonPtr[idx] - localStdTimeMeridian) +
+                                                    eqnOfTime;
+                      const double localSolarTime = (minutes + timeCorrection) / 60.0;
+                      double omega = 15.0 * (localSolarTime - 12.0);
+                      if (omega > 180.0) omega -= 360.0;
+
+                      const double cosOmega = std::cos(omega * D2R);
+                      double zen = std::acos(sinDeclin * sinLat + cosDeclin * cosLat * cosOmega);
+                      zen *= R2D;
+
+                      const double dY = -std::sin(omega * D2R);
+                      const double dX = tanDeclin * cosLat - sinLat * cosOmega;
+                      double azi = std::atan2(dY, dX);
+                      if (azi < 0.0) azi += 2.0 * M_PI;
+                      azi *= R2D;
+
+                      zenPtr[idx] = std::isnan(zen) ? FillValue : zen;
+                      aziPtr[idx] = std::isnan(azi) ? FillValue : azi;
+                  }
+              });
+          },
+          py::arg("latitude"),
+          py::arg("longitude"),
+          py::arg("day_of_year"),
+          py::arg("hour"),
+          py::arg("minute"),
+          py::arg("second"),
+          py::arg("zenith").noconvert(),
+          py::arg("azimuth").noconvert(),
+          py::arg("threads") = static_cast<size_t>(0),
+          "Compute the solar zenith and azimuth angles (degrees, -999 where undefined) for the "
+          "given UTC time into the given C contiguous float64 arrays (they are not converted).");
+}
@@ -31,6 +31,12 @@ from numpy import ma
 import numpy as np
 from goes_util import GoesUtil
 
+# The compiled kernels are optional, the numpy implementation is used when they are not built.
+try:
+    from pyiodaconv import goes_kernels
+except ImportError:
+    goes_kernels = None
+
 
 class GoesLatLon:
 
@@ -47,6 +53,8 @@ class GoesLatLon:
         self._source_dataset = Dataset(self._source_file_path, 'r')
         self._source_dataset.set_auto_scale(True)
         self._lat_fill_value_index_array = None
+        self._scan_angle = None
+        self._elevation_angle = None
 
     def _calc_latlon(self):
         """
@@ -57,13 +65,50 @@ class GoesLatLon:
         self._y = ma.getdata(self._source_dataset['y'][:]).real
         self._x = self._goes_util.subsample_1d(ma.getdata(self._source_dataset['x'][:]))
         self._y = self._goes_util.subsample_1d(ma.getdata(self._source_dataset['y'][:]))
-        grid_x, grid_y = np.meshgrid(self._x, self._y, indexing='xy')
         goes_imager_projection = self._source_dataset.variables['goes_imager_projection']
         r_eq = goes_imager_projection.getncattr('semi_major_axis')
         r_pol = goes_imager_projection.getncattr('semi_minor_axis')
         h = goes_imager_projection.getncattr('perspective_point_height') + \
             goes_imager_projection.getncattr('semi_major_axis')
         lon_0 = goes_imager_projection.getncattr('longitude_of_projection_origin')
+        if goes_kernels is not None:
+            lat, lon = self._calc_fixed_grid_native(r_eq, r_pol, h, lon_0)
+        else:
+            lat, lon = GoesLatLon._calc_fixed_grid_numpy(self._x, self._y, r_eq, r_pol, h, lon_0)
+        lat = self._goes_util.filter_data_array_by_yaw_flip_flag(lat)
+        lon = self._goes_util.filter_data_array_by_yaw_flip_flag(lon)
+        lat = np.nan_to_num(lat, nan=-999)
+        lon = np.nan_to_num(lon, nan=-999)
+        self._lat_fill_value_index_array = np.where(lat == -999)
+        self._lon_fill_value_index_array = np.where(lon == -999)
+        lat = np.delete(lat, self._lat_fill_value_index_array)
+        lon = np.delete(lon, self._lon_fill_value_index_array)
+        lon = np.where(lon <= -180.0, lon + 360.0, lon)
+        return lat, lon
+
+    def _calc_fixed_grid_native(self, r_eq, r_pol, h, lon_0):
+        """
+        Calculates the flattened latitude and longitude (nan off the earth disk) with the compiled goes_kernels
+        module, the scan and elevation angles are computed in the same pass and kept for
+        _calc_scan_elevation_angles.
+        """
+        size = len(self._x) * len(self._y)
+        lat = np.empty(size)
+        lon = np.empty(size)
+        self._scan_angle = np.empty(size)
+        self._elevation_angle = np.empty(size)
+        goes_kernels.fixed_grid(np.asarray(self._x, dtype=np.float64), np.asarray(self._y, dtype=np.float64),
+                                r_eq, r_pol, h, lon_0, lat, lon, self._scan_angle, self._elevation_angle)
+        return lat, lon
+
+    @staticmethod
+    def _calc_fixed_grid_numpy(x, y, r_eq, r_pol, h, lon_0):
+        """
+        Calculates the flattened latitude and longitude (nan off the earth disk) with numpy.
+        x - the scan angles of the grid columns (radians)
+        y - the elevation angles of the grid rows (radians)
+        """
+        grid_x, grid_y = np.meshgrid(x, y, indexing='xy')
         lon_0 = (lon_0 * np.pi) / 180.0
         h_sqr = np.power(h, 2.0)
         r_eq_sqr = np.power(r_eq, 2.0)
@@ -93,15 +138,6 @@ class GoesLatLon:
         lon = lon * 180.0 / np.pi
         lat = lat.reshape(len(lat) * len(lat))
         lon = lon.reshape(len(lon) * len(lon))
-        lat = self._goes_util.filter_data_array_by_yaw_flip_flag(lat)
-        lon = self._goes_util.filter_data_array_by_yaw_flip_flag(lon)
-        lat = np.nan_to_num(lat, nan=-999)
-        lon = np.nan_to_num(lon, nan=-999)
-        self._lat_fill_value_index_array = np.where(lat == -999)
-        self._lon_fill_value_index_array = np.where(lon == -999)
-        lat = np.delete(lat, self._lat_fill_value_index_array)
-        lon = np.delete(lon, self._lon_fill_value_index_array)
-        lon = np.where(lon <= -180.0, lon + 360.0, lon)
         return lat, lon
 
     def _get_nadir_attributes(self):
@@ -117,11 +153,15 @@ class GoesLatLon:
         Calculates the scan and elevation angles from source_file_path Dataset, reshapes the scan and elevation angle
         data arrays to a single dimension, and returns a tuple containing these data arrays.
         """
-        grid_x, grid_y = np.meshgrid(self._x, self._y, indexing='xy')
-        scan_angle = grid_x * 180.0 / np.pi
-        elevation_angle = grid_y * 180.0 / np.pi
-        scan_angle = scan_angle.reshape(len(scan_angle) * len(scan_angle))
-        elevation_angle = elevation_angle.reshape(len(elevation_angle) * len(elevation_angle))
+        if self._scan_angle is not None:
+            scan_angle = self._scan_angle
+            elevation_angle = self._elevation_angle
+        else:
+            grid_x, grid_y = np.meshgrid(self._x, self._y, indexing='xy')
+            scan_angle = grid_x * 180.0 / np.pi
+            elevation_angle = grid_y * 180.0 / np.pi
+            scan_angle = scan_angle.reshape(len(scan_angle) * len(scan_angle))
+            elevation_angle = elevation_angle.reshape(len(elevation_angle) * len(elevation_angle))
         scan_angle = self._goes_util.filter_data_array_by_yaw_flip_flag(scan_angle)
         elevation_angle = self._goes_util.filter_data_array_by_yaw_flip_flag(elevation_angle)
         scan_angle = self._filter_by_fill_value(scan_angle)
@@ -144,13 +184,39 @@ class GoesLatLon:
         latitude - the latitude data array
         longitude - the longitude data array
         """
-        d2r = np.pi / 180.0
         goes_imager_projection = self._source_dataset.variables['goes_imager_projection']
         r_eq = goes_imager_projection.getncattr('semi_major_axis')
         h = goes_imager_projection.getncattr('perspective_point_height') + \
             goes_imager_projection.getncattr('semi_major_axis')
         lat_0 = goes_imager_projection.getncattr('latitude_of_projection_origin')
         lon_0 = goes_imager_projection.getncattr('longitude_of_projection_origin')
+        if goes_kernels is not None:
+            sensor_zenith_angle = np.empty(len(latitude))
+            sensor_azimuth_angle = np.empty(len(latitude))
+            sensor_view_angle = np.empty(len(latitude))
+            goes_kernels.sensor_angles(np.asarray(latitude, dtype=np.float64), np.asarray(longitude, dtype=np.float64),
+                                       r_eq, h, lat_0, lon_0, sensor_zenith_angle, sensor_azimuth_angle,
+                                       sensor_view_angle)
+        else:
+            sensor_zenith_angle, sensor_azimuth_angle, sensor_view_angle = \
+                GoesLatLon._calc_sensor_angles_numpy(latitude, longitude, r_eq, h, lat_0, lon_0)
+        sensor_zenith_angle = self._goes_util.filter_data_array_by_yaw_flip_flag(sensor_zenith_angle)
+        sensor_view_angle = self._goes_util.filter_data_array_by_yaw_flip_flag(sensor_view_angle)
+        sensor_azimuth_angle = self._goes_util.filter_data_array_by_yaw_flip_flag(sensor_azimuth_angle)
+        return sensor_zenith_angle, sensor_azimuth_angle, sensor_view_angle
+
+    @staticmethod
+    def _calc_sensor_angles_numpy(latitude, longitude, r_eq, h, lat_0, lon_0):
+        """
+        Calculates the sensor zenith, azimuth, and view angles with numpy.
+        latitude - the latitude data array
+        longitude - the longitude data array
+        r_eq - the semi major axis
+        h - the perspective point height plus the semi major axis
+        lat_0 - the latitude of the projection origin
+        lon_0 - the longitude of the projection origin
+        """
+        d2r = np.pi / 180.0
         lat_0_rad = lat_0 * d2r
         lon_0_rad = lon_0 * d2r
         latitude_rad = latitude * d2r
@@ -173,9 +239,6 @@ class GoesLatLon:
         sensor_zenith_angle = np.nan_to_num(sensor_zenith_angle, nan=-999)
         sensor_view_angle = np.nan_to_num(sensor_view_angle, nan=-999)
         sensor_azimuth_angle = np.nan_to_num(sensor_azimuth_angle, nan=-999)
-        sensor_zenith_angle = self._goes_util.filter_data_array_by_yaw_flip_flag(sensor_zenith_angle)
-        sensor_view_angle = self._goes_util.filter_data_array_by_yaw_flip_flag(sensor_view_angle)
-        sensor_azimuth_angle = self._goes_util.filter_data_array_by_yaw_flip_flag(sensor_azimuth_angle)
         return sensor_zenith_angle, sensor_azimuth_angle, sensor_view_angle
 
     def _filter_by_fill_value(self, data_array):
@@ -15,6 +15,12 @@ import numpy as np
 import statistics
 from scipy.interpolate import griddata
 
+# Use the compiled remapping engine (pyiodaconv bufr module) when it is available
+try:
+    from pyiodaconv.bufr import BackusGilbertRemap
+except ImportError:
+    BackusGilbertRemap = None
+
 
 class apply_BG_class:
     def __init__(self,
@@ -44,6 +50,15 @@ class apply_BG_class:
 
     def prepcoef(self):
 
+        if BackusGilbertRemap is not None:
+            # Ch1 and Ch2 use the same coefficients, load them once
+            f = h5py.File(self.coef_dir+'atms_BGremap_coeffs_ch1ch2.nc', 'r')
+            self.remap = BackusGilbertRemap(np.array(f['windowSize'][0:self.nfov]),
+                                            np.array(f['alpha'][0:self.nfov]),
+                                            np.array(f['windowIndex'][0:self.nfov]),
+                                            np.array(f['indexSrc'][0:self.nfov]))
+            return
+
         self.alpha_all = []
         self.windowsize_all = []
         self.windowindx_all = []
@@ -71,6 +86,9 @@ class apply_BG_class:
     def apply(self):
         for ich in [0, 1]:
             missing_value = 9.96921e+36
+            if BackusGilbertRemap is not None:
+                self.taAllCh[:, :, ich] = self.remap.apply(self.ta[ich], missing_value)
+                continue
             ta_rmp = np.full_like(self.ta[ich], missing_value)
             for ifr in range(self.nfov):
                 windowsize = self.windowsize_all[ich][ifr]
@@ -90,11 +108,15 @@ class apply_BG_class:
                     flag = 0
                     for iwin in range(windowsize):
                         [i, j] = np.array(windowindx[iwin])+np.array([isc, ifr])
-                        if i >= 0 and i < self.nscan and j >= 0 and j < self.nfov:
-                            temp += alpha[iwin]*self.ta[ich, i, j]
-                        else:
+                        # A window that leaves the image or holds a missing value gives a
+                        # missing value (as the compiled remap does)
+                        if i < 0 or i >= self.nscan or j < 0 or j >= self.nfov:
+                            flag = 1
+                            break
+                        if np.float32(self.ta[ich, i, j]) == np.float32(missing_value):
                             flag = 1
                             break
+                        temp += alpha[iwin]*self.ta[ich, i, j]
                     if flag == 0:
                         ta_rmp[isc, ifr] = temp
             self.taAllCh[:, :, ich] = ta_rmp
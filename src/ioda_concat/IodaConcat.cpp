@@ -0,0 +1,789 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include "IodaConcat.h"
+
+#include <fcntl.h>
+#include <hdf5_hl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <condition_variable>  // NOLINT
+#include <cstring>
+#include <iostream>
+#include <mutex>  // NOLINT
+#include <numeric>
+#include <thread>  // NOLINT
+
+#include "eckit/exception/Exceptions.h"
+
+
+namespace
+{
+    // Target size of the chunks of the variables that are along the concatenation dimension
+    const size_t ChunkBytes = 1 << 20;
+
+    // Attributes that belong to the dimension scale bookkeeping (recreated by finish) or that
+    // hold NetCDF dimension ids which are not valid in the output.
+    const std::set<std::string> SkippedAttributes = {"DIMENSION_LIST",
+                                                     "REFERENCE_LIST",
+                                                     "CLASS",
+                                                     "NAME",
+                                                     "_Netcdf4Coordinates",
+                                                     "_Netcdf4Dimid"};
+
+    /// \brief Owns an HDF5 identifier.
+    class Handle
+    {
+     public:
+        Handle(hid_t id, herr_t (*close)(hid_t)) :
+            id_(id),
+            close_(close)
+        {
+        }
+
+        ~Handle()
+        {
+            if (id_ >= 0) close_(id_);
+        }
+
+        Handle(const Handle&) = delete;
+        Handle& operator=(const Handle&) = delete;
+
+        inline operator hid_t() const { return id_; }
+        inline bool valid() const { return id_ >= 0; }
+
+     private:
+        hid_t id_;
+        herr_t (*close_)(hid_t);
+    };
+
+    /// \brief Throw if an HDF5 call failed.
+    template<typename T>
+    T check(T result, const std::string& errorMsg)
+    {
+        if (result < 0)
+        {
+            throw eckit::BadParameter(errorMsg);
+        }
+
+        return result;
+    }
+
+    std::vector<hsize_t> getDims(hid_t dataset)
+    {
+        Handle space(H5Dget_space(dataset), H5Sclose);
+        std::vector<hsize_t> dims(static_cast<size_t>(H5Sget_simple_extent_ndims(space)));
+        H5Sget_simple_extent_dims(space, dims.data(), nullptr);
+        return dims;
+    }
+
+    std::string dimsStr(const std::vector<hsize_t>& dims)
+    {
+        std::string str = "(";
+        for (size_t dimIdx = 0; dimIdx < dims.size(); ++dimIdx)
+        {
+            if (dimIdx > 0) str += ", ";
+            str += std::to_string(dims[dimIdx]);
+        }
+
+        return str + ")";
+    }
+
+    hsize_t product(std::vector<hsize_t>::const_iterator begin,
+                    std::vector<hsize_t>::const_iterator end)
+    {
+        return std::accumulate(begin, end, hsize_t(1), std::multiplies<hsize_t>());
+    }
+
+    /// \brief Get the paths (relative to the root group) of all the objects in the file.
+    std::vector<std::string> listObjects(hid_t file)
+    {
+        std::vector<std::string> paths;
+        auto addPath = [](hid_t, const char* name, const H5L_info_t* info, void* data) -> herr_t
+        {
+            if (info->type == H5L_TYPE_HARD)
+            {
+                static_cast<std::vector<std::string>*>(data)->push_back(name);
+            }
+
+            return 0;
+        };
+
+        check(H5Lvisit(file, H5_INDEX_NAME, H5_ITER_INC, addPath, &paths),
+              "Could not list the objects in the file.");
+
+        return paths;
+    }
+
+    /// \brief Get the path of the dimension scale attached to a dimension (empty if none).
+    std::string scalePath(hid_t dataset, unsigned int dimIdx)
+    {
+        std::string path;
+        if (H5DSget_num_scales(dataset, dimIdx) <= 0) return path;
+
+        auto getPath = [](hid_t, unsigned int, hid_t scale, void* data) -> herr_t
+        {
+            const auto size = H5Iget_name(scale, nullptr, 0);
+            std::string name(static_cast<size_t>(size), '\0');
+            H5Iget_name(scale, &name[0], static_cast<size_t>(size) + 1);
+            *static_cast<std::string*>(data) = name;
+            return 1;  // stop at the first scale
+        };
+
+        H5DSiterate_scales(dataset, dimIdx, nullptr, getPath, &path);
+        return path;
+    }
+
+    /// \brief Read the fill value of a dataset as memType (the _FillValue attribute if it has
+    ///        one, otherwise the HDF5 fill value).
+    std::vector<char> readFill(hid_t dataset, hid_t memType)
+    {
+        std::vector<char> fill(H5Tget_size(memType), 0);
+        if (H5Aexists(dataset, "_FillValue") > 0)
+        {
+            Handle attr(H5Aopen(dataset, "_FillValue", H5P_DEFAULT), H5Aclose);
+            Handle space(H5Aget_space(attr), H5Sclose);
+            if (H5Sget_simple_extent_npoints(space) == 1 &&
+                H5Aread(attr, memType, fill.data()) >= 0)
+            {
+                return fill;
+            }
+        }
+
+        Handle dcpl(H5Dget_create_plist(dataset), H5Pclose);
+        H5Pget_fill_value(dcpl, memType, fill.data());
+        return fill;
+    }
+
+    /// \brief Copy the attributes of an object to another object.
+    void copyAttributes(hid_t src, hid_t dst)
+    {
+        auto copyAttr = [](hid_t loc, const char* name, const H5A_info_t*, void* data) -> herr_t
+        {
+            if (SkippedAttributes.find(name) != SkippedAttributes.end()) return 0;
+
+            const auto dstLoc = *static_cast<hid_t*>(data);
+            if (H5Aexists(dstLoc, name) > 0) return 0;
+
+            Handle attr(H5Aopen(loc, name, H5P_DEFAULT), H5Aclose);
+            Handle type(H5Aget_type(attr), H5Tclose);
+            Handle space(H5Aget_space(attr), H5Sclose);
+
+            const auto numPoints = static_cast<size_t>(H5Sget_simple_extent_npoints(space));
+            std::vector<char> buffer(std::max<size_t>(1, numPoints) * H5Tget_size(type));
+            if (H5Aread(attr, type, buffer.data()) < 0) return -1;
+
+            Handle dstAttr(H5Acreate2(dstLoc, name, type, space, H5P_DEFAULT, H5P_DEFAULT),
+                           H5Aclose);
+            const auto status = dstAttr.valid() ? H5Awrite(dstAttr, type, buffer.data()) : -1;
+
+            if (H5Tdetect_class(type, H5T_VLEN) > 0 || H5Tis_variable_str(type) > 0)
+            {
+                H5Dvlen_reclaim(type, space, H5P_DEFAULT, buffer.data());
+            }
+
+            return status;
+        };
+
+        check(H5Aiterate2(src, H5_INDEX_NAME, H5_ITER_INC, nullptr, copyAttr, &dst),
+              "Could not copy the attributes.");
+    }
+
+    /// \brief Check that an input dataset has the same kind of type as the output variable (HDF5
+    ///        converts between the numeric types but not between strings and numbers).
+    void checkType(hid_t dataset, bool isString, bool isVarString, const std::string& desc)
+    {
+        Handle type(H5Dget_type(dataset), H5Tclose);
+        const bool inIsString = H5Tget_class(type) == H5T_STRING;
+        if (inIsString != isString || (isString && (H5Tis_variable_str(type) > 0) != isVarString))
+        {
+            throw eckit::BadParameter(desc + " has a type that can't be converted to the type it "
+                                      "has in the earlier files.");
+        }
+    }
+
+    /// \brief Reads the input files ahead of the merge on a few threads so they are in the page
+    ///        cache when HDF5 opens them. HDF5 itself is not called from the threads (the library
+    ///        is generally not built thread safe), this only overlaps the file system latency,
+    ///        which dominates when merging thousands of small files.
+    class Prefetcher
+    {
+     public:
+        Prefetcher(const std::vector<std::string>& paths, size_t numThreads) :
+            paths_(paths),
+            window_(2 * numThreads)
+        {
+            for (size_t threadIdx = 0; threadIdx < numThreads; ++threadIdx)
+            {
+                threads_.emplace_back([this]() { run(); });
+            }
+        }
+
+        ~Prefetcher()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+
+            cv_.notify_all();
+            for (auto& thread : threads_)
+            {
+                thread.join();
+            }
+        }
+
+        /// \brief Tell the prefetcher the file at idx was merged (lets it read further ahead).
+        void consumed(size_t idx)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                consumed_ = idx + 1;
+            }
+
+            cv_.notify_all();
+        }
+
+     private:
+        const std::vector<std::string>& paths_;
+        const size_t window_;
+        std::vector<std::thread> threads_;
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        size_t next_ = 0;
+        size_t consumed_ = 0;
+        bool stop_ = false;
+
+        void run()
+        {
+            std::vector<char> buffer(1 << 20);
+            while (true)
+            {
+                size_t idx;
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    cv_.wait(lock, [this]()
+                    {
+                        return stop_ || next_ >= paths_.size() || next_ < consumed_ + window_;
+                    });
+
+                    if (stop_ || next_ >= paths_.size()) return;
+
+                    next_ = std::max(next_, consumed_);
+                    if (next_ >= paths_.size()) return;
+                    idx = next_++;
+                }
+
+                const int fd = open(paths_[idx].c_str(), O_RDONLY);
+                if (fd < 0) continue;  // HDF5 reports the error when the file is merged
+
+                posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+                while (read(fd, buffer.data(), buffer.size()) > 0)
+                {
+                }
+
+                close(fd);
+            }
+        }
+    };
+}  // namespace
+
+namespace iodaconv
+{
+    IodaConcat::IodaConcat(const IodaConcatOptions& options) :
+        options_(options)
+    {
+    }
+
+    IodaConcat::Summary IodaConcat::concat(const std::vector<std::string>& inputs,
+                                           const std::string& output)
+    {
+        if (inputs.empty())
+        {
+            throw eckit::BadParameter("No input files to concatenate.");
+        }
+
+        variables_.clear();
+        variableOrder_.clear();
+        groups_.clear();
+        numLocations_ = 0;
+        dimIsSequence_ = true;
+        hasDimFirstValue_ = false;
+        dimFirstValue_ = 0;
+
+        // Track the creation order like NetCDF4 and ioda do so the output can be read by both
+        Handle fcpl(H5Pcreate(H5P_FILE_CREATE), H5Pclose);
+        H5Pset_link_creation_order(fcpl, H5P_CRT_ORDER_TRACKED | H5P_CRT_ORDER_INDEXED);
+        H5Pset_attr_creation_order(fcpl, H5P_CRT_ORDER_TRACKED | H5P_CRT_ORDER_INDEXED);
+
+        Handle outFile(H5Fcreate(output.c_str(), H5F_ACC_TRUNC, fcpl, H5P_DEFAULT), H5Fclose);
+        check(static_cast<hid_t>(outFile), "Could not create the output file " + output + ".");
+        outFile_ = outFile;
+
+        try
+        {
+            Prefetcher prefetcher(inputs, options_.numThreads);
+            for (size_t fileIdx = 0; fileIdx < inputs.size(); ++fileIdx)
+            {
+                if (options_.verbose)
+                {
+                    std::cout << "Merging " << inputs[fileIdx] << std::endl;
+                }
+
+                mergeFile(inputs[fileIdx]);
+                prefetcher.consumed(fileIdx);
+            }
+
+            finish();
+        }
+        catch (...)
+        {
+            variables_.clear();
+            outFile_ = -1;
+            throw;
+        }
+
+        Summary summary;
+        summary.numFiles = inputs.size();
+        summary.numLocations = numLocations_;
+        summary.numVariables = variables_.size();
+
+        variables_.clear();
+        outFile_ = -1;
+
+        return summary;
+    }
+
+    void IodaConcat::mergeFile(const std::string& path)
+    {
+        Handle file(H5Fopen(path.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT), H5Fclose);
+        check(static_cast<hid_t>(file), "Could not open " + path + ".");
+
+        if (H5Lexists(file, options_.dimName.c_str(), H5P_DEFAULT) <= 0)
+        {
+            throw eckit::BadParameter(path + " has no " + options_.dimName + " dimension.");
+        }
+
+        Handle dimDataset(H5Dopen2(file, options_.dimName.c_str(), H5P_DEFAULT), H5Dclose);
+        const auto numLocs = getDims(dimDataset).at(0);
+        checkDimSequence(dimDataset, numLocs);
+
+        addGroup(file, "/");
+        for (const auto& objPath : listObjects(file))
+        {
+            const auto varPath = "/" + objPath;
+            Handle obj(H5Oopen(file, objPath.c_str(), H5P_DEFAULT), H5Oclose);
+            const auto objType = H5Iget_type(obj);
+
+            if (objType == H5I_GROUP)
+            {
+                addGroup(file, varPath);
+                continue;
+            }
+            else if (objType != H5I_DATASET)
+            {
+                continue;
+            }
+
+            const auto dims = getDims(obj);
+            bool alongDim = false;
+            if (objPath == options_.dimName)
+            {
+                alongDim = true;
+            }
+            else if (!dims.empty() && H5DSis_scale(obj) <= 0)
+            {
+                alongDim = H5DSis_attached(obj, dimDataset, 0) > 0 ||
+                           (H5DSget_num_scales(obj, 0) <= 0 && dims[0] == numLocs);
+            }
+
+            std::shared_ptr<Variable> variable;
+            bool isNew = false;
+            if (variables_.find(varPath) != variables_.end())
+            {
+                variable = variables_.at(varPath);
+            }
+            else
+            {
+                variable = addVariable(obj, varPath, alongDim);
+                isNew = true;
+            }
+
+            const auto desc = "Variable " + varPath + " in " + path;
+            if (variable->alongDim != alongDim)
+            {
+                throw eckit::BadParameter(desc + " is " + (alongDim ? "" : "not ") +
+                                          "dimensioned by " + options_.dimName +
+                                          " but it was in the earlier files.");
+            }
+
+            checkType(obj, variable->isString, variable->isVarString, desc);
+
+            if (alongDim)
+            {
+                if (dims[0] != numLocs)
+                {
+                    throw eckit::BadParameter(desc + " has " + std::to_string(dims[0]) +
+                                              " locations, expected " +
+                                              std::to_string(numLocs) + ".");
+                }
+
+                appendData(obj, *variable, desc, numLocs);
+            }
+            else if (isNew)
+            {
+                copyData(obj, *variable);
+            }
+            else if (dims != variable->dims)
+            {
+                throw eckit::BadParameter(desc + " has the shape " + dimsStr(dims) +
+                                          " but it is " + dimsStr(variable->dims) +
+                                          " in the earlier files.");
+            }
+        }
+
+        numLocations_ += numLocs;
+    }
+
+    void IodaConcat::addGroup(hid_t inFile, const std::string& groupPath)
+    {
+        Handle inGroup(H5Gopen2(inFile, groupPath.c_str(), H5P_DEFAULT), H5Gclose);
+
+        std::shared_ptr<Handle> outGroup;
+        if (groups_.find(groupPath) != groups_.end() || groupPath == "/" ||
+            H5Lexists(outFile_, groupPath.c_str(), H5P_DEFAULT) > 0)
+        {
+            outGroup = std::make_shared<Handle>(H5Gopen2(outFile_, groupPath.c_str(),
+                                                         H5P_DEFAULT), H5Gclose);
+        }
+        else
+        {
+            Handle lcpl(H5Pcreate(H5P_LINK_CREATE), H5Pclose);
+            H5Pset_create_intermediate_group(lcpl, 1);
+            Handle gcpl(H5Pcreate(H5P_GROUP_CREATE), H5Pclose);
+            H5Pset_link_creation_order(gcpl, H5P_CRT_ORDER_TRACKED | H5P_CRT_ORDER_INDEXED);
+            H5Pset_attr_creation_order(gcpl, H5P_CRT_ORDER_TRACKED | H5P_CRT_ORDER_INDEXED);
+            outGroup = std::make_shared<Handle>(H5Gcreate2(outFile_, groupPath.c_str(), lcpl,
+                                                           gcpl, H5P_DEFAULT), H5Gclose);
+        }
+
+        check(static_cast<hid_t>(*outGroup), "Could not create the group " + groupPath + ".");
+        copyAttributes(inGroup, *outGroup);
+        groups_.insert(groupPath);
+    }
+
+    std::shared_ptr<IodaConcat::Variable> IodaConcat::addVariable(hid_t inDataset,
+                                                                 const std::string& varPath,
+                                                                 bool alongDim)
+    {
+        auto variable = std::make_shared<Variable>();
+        variable->path = varPath;
+        variable->alongDim = alongDim;
+
+        Handle fileType(H5Dget_type(inDataset), H5Tclose);
+        variable->isString = H5Tget_class(fileType) == H5T_STRING;
+        variable->isVarString = variable->isString && H5Tis_variable_str(fileType) > 0;
+        variable->memType = variable->isString ? H5Tcopy(fileType)
+                                               : H5Tget_native_type(fileType, H5T_DIR_ASCEND);
+        check(variable->memType, "Unsupported type for variable " + varPath + ".");
+
+        Handle inSpace(H5Dget_space(inDataset), H5Sclose);
+        const auto rank = H5Sget_simple_extent_ndims(inSpace);
+        variable->dims.resize(static_cast<size_t>(rank));
+        std::vector<hsize_t> maxDims(static_cast<size_t>(rank));
+        H5Sget_simple_extent_dims(inSpace, variable->dims.data(), maxDims.data());
+
+        for (int dimIdx = 0; dimIdx < rank; ++dimIdx)
+        {
+            variable->scales.push_back(scalePath(inDataset, static_cast<unsigned int>(dimIdx)));
+        }
+
+        if (H5DSis_scale(inDataset) > 0)
+        {
+            const auto size = H5DSget_scale_name(inDataset, nullptr, 0);
+            variable->scaleName = std::string(static_cast<size_t>(std::max<ssize_t>(size, 0)),
+                                              '\0');
+            if (size > 0)
+            {
+                H5DSget_scale_name(inDataset, &variable->scaleName[0],
+                                   static_cast<size_t>(size) + 1);
+            }
+            else
+            {
+                variable->scaleName = varPath.substr(varPath.rfind('/') + 1);
+            }
+        }
+
+        // Keep the filters (compression) of the input
+        Handle inDcpl(H5Dget_create_plist(inDataset), H5Pclose);
+        Handle dcpl(H5Pcopy(inDcpl), H5Pclose);
+
+        if (!variable->isString)
+        {
+            variable->fill = readFill(inDataset, variable->memType);
+            H5Pset_fill_value(dcpl, variable->memType, variable->fill.data());
+        }
+
+        std::vector<hsize_t> outDims = variable->dims;
+        if (alongDim)
+        {
+            outDims[0] = 0;
+            maxDims[0] = H5S_UNLIMITED;
+
+            const auto rowBytes = product(variable->dims.begin() + 1, variable->dims.end()) *
+                                  H5Tget_size(variable->memType);
+            std::vector<hsize_t> chunk(static_cast<size_t>(rank));
+            chunk[0] = std::max<hsize_t>(1, ChunkBytes / std::max<hsize_t>(1, rowBytes));
+            for (int dimIdx = 1; dimIdx < rank; ++dimIdx)
+            {
+                chunk[dimIdx] = std::max<hsize_t>(1, variable->dims[dimIdx]);
+            }
+
+            check(H5Pset_chunk(dcpl, rank, chunk.data()),
+                  "Could not set the chunks of " + varPath + ".");
+        }
+
+        Handle outSpace(rank == 0 ? H5Scopy(inSpace)
+                                  : H5Screate_simple(rank, outDims.data(), maxDims.data()),
+                        H5Sclose);
+
+        Handle lcpl(H5Pcreate(H5P_LINK_CREATE), H5Pclose);
+        H5Pset_create_intermediate_group(lcpl, 1);
+
+        // Room for the chunk being filled so it is only written once it is complete
+        Handle dapl(H5Pcreate(H5P_DATASET_ACCESS), H5Pclose);
+        H5Pset_chunk_cache(dapl, H5D_CHUNK_CACHE_NSLOTS_DEFAULT, 2 * ChunkBytes,
+                           H5D_CHUNK_CACHE_W0_DEFAULT);
+
+        variable->dataset = H5Dcreate2(outFile_, varPath.c_str(), fileType, outSpace, lcpl, dcpl,
+                                       dapl);
+        check(variable->dataset, "Could not create the variable " + varPath + ".");
+        copyAttributes(inDataset, variable->dataset);
+
+        variables_[varPath] = variable;
+        variableOrder_.push_back(varPath);
+        return variable;
+    }
+
+    void IodaConcat::appendData(hid_t inDataset,
+                                const Variable& variable,
+                                const std::string& desc,
+                                hsize_t numLocs)
+    {
+        const auto dims = getDims(inDataset);
+        if (dims.size() != variable.dims.size() ||
+            !std::equal(dims.begin() + 1, dims.end(), variable.dims.begin() + 1))
+        {
+            throw eckit::BadParameter(desc + " has the shape " + dimsStr(dims) + " but it is " +
+                                      dimsStr(variable.dims) + " in the earlier files.");
+        }
+
+        const auto outDataset = variable.dataset;
+
+        auto outDims = dims;
+        outDims[0] = numLocations_ + numLocs;
+        check(H5Dset_extent(outDataset, outDims.data()), "Could not extend " + variable.path + ".");
+
+        if (numLocs == 0) return;
+
+        // Values that are missing in this file are rewritten with the output fill value
+        std::vector<char> inFill;
+        if (!variable.isString)
+        {
+            inFill = readFill(inDataset, variable.memType);
+            if (inFill == variable.fill) inFill.clear();
+        }
+
+        const size_t typeSize = H5Tget_size(variable.memType);
+        const auto rowElems = product(dims.begin() + 1, dims.end());
+        const auto rowsPerBlock = std::max<hsize_t>(1, options_.blockSize /
+                                                       std::max<hsize_t>(1, rowElems));
+        std::vector<char> buffer(std::min(rowsPerBlock, numLocs) * rowElems * typeSize);
+
+        Handle inSpace(H5Dget_space(inDataset), H5Sclose);
+        Handle outSpace(H5Dget_space(outDataset), H5Sclose);
+
+        std::vector<hsize_t> inStart(dims.size(), 0);
+        std::vector<hsize_t> outStart(dims.size(), 0);
+        std::vector<hsize_t> count = dims;
+        for (hsize_t start = 0; start < numLocs; start += rowsPerBlock)
+        {
+            count[0] = std::min(rowsPerBlock, numLocs - start);
+            inStart[0] = start;
+            outStart[0] = numLocations_ + start;
+
+            Handle memSpace(H5Screate_simple(static_cast<int>(count.size()), count.data(),
+                                             nullptr), H5Sclose);
+            H5Sselect_hyperslab(inSpace, H5S_SELECT_SET, inStart.data(), nullptr,
+                                count.data(), nullptr);
+            H5Sselect_hyperslab(outSpace, H5S_SELECT_SET, outStart.data(), nullptr,
+                                count.data(), nullptr);
+
+            check(H5Dread(inDataset, variable.memType, memSpace, inSpace, H5P_DEFAULT,
+                          buffer.data()),
+                  "Could not read " + desc + ".");
+
+            if (!inFill.empty())
+            {
+                const size_t numElems = count[0] * rowElems;
+                for (size_t elemIdx = 0; elemIdx < numElems; ++elemIdx)
+                {
+                    char* elem = buffer.data() + elemIdx * typeSize;
+                    if (std::memcmp(elem, inFill.data(), typeSize) == 0)
+                    {
+                        std::memcpy(elem, variable.fill.data(), typeSize);
+                    }
+                }
+            }
+
+            const auto status = H5Dwrite(outDataset, variable.memType, memSpace, outSpace,
+                                         H5P_DEFAULT, buffer.data());
+
+            if (variable.isVarString)
+            {
+                H5Dvlen_reclaim(variable.memType, memSpace, H5P_DEFAULT, buffer.data());
+            }
+
+            check(status, "Could not write " + variable.path + ".");
+        }
+    }
+
+    void IodaConcat::checkDimSequence(hid_t dimDataset, hsize_t numLocs)
+    {
+        if (!dimIsSequence_ || numLocs == 0) return;
+
+        Handle fileType(H5Dget_type(dimDataset), H5Tclose);
+        if (H5Tget_class(fileType) != H5T_INTEGER || getDims(dimDataset).size() != 1)
+        {
+            dimIsSequence_ = false;
+            return;
+        }
+
+        // Read in blocks so the memory use does not depend on the size of the input
+        const auto blockSize = std::min<hsize_t>(options_.blockSize, numLocs);
+        std::vector<int64_t> values(blockSize);
+        Handle inSpace(H5Dget_space(dimDataset), H5Sclose);
+        int64_t start = 0;
+        for (hsize_t offset = 0; dimIsSequence_ && offset < numLocs; offset += blockSize)
+        {
+            hsize_t count = std::min(blockSize, numLocs - offset);
+            Handle memSpace(H5Screate_simple(1, &count, nullptr), H5Sclose);
+            H5Sselect_hyperslab(inSpace, H5S_SELECT_SET, &offset, nullptr, &count, nullptr);
+            check(H5Dread(dimDataset, H5T_NATIVE_INT64, memSpace, inSpace, H5P_DEFAULT,
+                          values.data()),
+                  "Could not read the " + options_.dimName + " dimension.");
+
+            if (offset == 0)
+            {
+                if (!hasDimFirstValue_)
+                {
+                    dimFirstValue_ = values[0];
+                    hasDimFirstValue_ = true;
+                }
+
+                // Each file numbers its own locations or continues the numbering of the files
+                // before it
+                start = values[0];
+                dimIsSequence_ = start == dimFirstValue_ ||
+                                 start == dimFirstValue_ + static_cast<int64_t>(numLocations_);
+            }
+
+            for (hsize_t locIdx = 0; dimIsSequence_ && locIdx < count; ++locIdx)
+            {
+                dimIsSequence_ = values[locIdx] == start + static_cast<int64_t>(offset + locIdx);
+            }
+        }
+    }
+
+    void IodaConcat::renumberDim()
+    {
+        const auto& variable = variables_.at("/" + options_.dimName);
+        const auto blockSize = std::min<size_t>(options_.blockSize, numLocations_);
+        std::vector<int64_t> values(blockSize);
+
+        Handle outSpace(H5Dget_space(variable->dataset), H5Sclose);
+        for (size_t start = 0; start < numLocations_; start += blockSize)
+        {
+            hsize_t count = std::min(blockSize, numLocations_ - start);
+            hsize_t offset = start;
+            std::iota(values.begin(), values.begin() + count,
+                      dimFirstValue_ + static_cast<int64_t>(start));
+
+            Handle memSpace(H5Screate_simple(1, &count, nullptr), H5Sclose);
+            H5Sselect_hyperslab(outSpace, H5S_SELECT_SET, &offset, nullptr, &count, nullptr);
+            check(H5Dwrite(variable->dataset, H5T_NATIVE_INT64, memSpace, outSpace, H5P_DEFAULT,
+                           values.data()),
+                  "Could not number the " + options_.dimName + " dimension.");
+        }
+    }
+
+    void IodaConcat::copyData(hid_t inDataset, const Variable& variable)
+    {
+        const auto outDataset = variable.dataset;
+        Handle space(H5Dget_space(inDataset), H5Sclose);
+
+        const auto numElems = static_cast<size_t>(H5Sget_simple_extent_npoints(space));
+        if (numElems == 0) return;
+
+        std::vector<char> buffer(numElems * H5Tget_size(variable.memType));
+        check(H5Dread(inDataset, variable.memType, H5S_ALL, H5S_ALL, H5P_DEFAULT, buffer.data()),
+              "Could not read " + variable.path + ".");
+
+        const auto status = H5Dwrite(outDataset, variable.memType, H5S_ALL, H5S_ALL, H5P_DEFAULT,
+                                     buffer.data());
+
+        if (variable.isVarString)
+        {
+            H5Dvlen_reclaim(variable.memType, space, H5P_DEFAULT, buffer.data());
+        }
+
+        check(status, "Could not write " + variable.path + ".");
+    }
+
+    void IodaConcat::finish()
+    {
+        // Variables missing from the last files are grown here (the new part reads as fill)
+        for (const auto& varPath : variableOrder_)
+        {
+            const auto& variable = variables_.at(varPath);
+            if (!variable->alongDim) continue;
+
+            auto dims = variable->dims;
+            dims[0] = numLocations_;
+            check(H5Dset_extent(variable->dataset, dims.data()),
+                  "Could not extend " + varPath + ".");
+        }
+
+        if (dimIsSequence_ && numLocations_ > 0) renumberDim();
+
+        for (const auto& varPath : variableOrder_)
+        {
+            const auto& variable = variables_.at(varPath);
+            if (variable->scaleName.empty()) continue;
+
+            check(H5DSset_scale(variable->dataset, variable->scaleName.c_str()),
+                  "Could not make " + varPath + " a dimension.");
+        }
+
+        for (const auto& varPath : variableOrder_)
+        {
+            const auto& variable = variables_.at(varPath);
+            if (!variable->scaleName.empty()) continue;
+
+            for (size_t dimIdx = 0; dimIdx < variable->scales.size(); ++dimIdx)
+            {
+                const auto& scale = variable->scales[dimIdx];
+                if (scale.empty() || variables_.find(scale) == variables_.end()) continue;
+
+                check(H5DSattach_scale(variable->dataset, variables_.at(scale)->dataset,
+                                       static_cast<unsigned int>(dimIdx)),
+                      "Could not attach " + scale + " to " + varPath + ".");
+            }
+        }
+    }
+}  // namespace iodaconv
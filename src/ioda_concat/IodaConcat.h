@@ -0,0 +1,133 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <hdf5.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+
+namespace iodaconv
+{
+    /// \brief Options for IodaConcat.
+    struct IodaConcatOptions
+    {
+        /// Name of the dimension the files are concatenated along
+        std::string dimName = "Location";
+
+        /// Number of threads that read ahead the input files
+        size_t numThreads = 4;
+
+        /// Max number of elements copied with each hyperslab read/write
+        size_t blockSize = 1 << 20;
+
+        /// Print each input file as it is merged
+        bool verbose = false;
+    };
+
+    /// \brief Merges IODA (HDF5 or NetCDF4) files along the Location dimension. The variable
+    ///        data is streamed from the inputs to the output one block of locations at a time,
+    ///        so the memory use does not depend on the number or size of the inputs.
+    ///
+    ///        Variables that are missing from some of the inputs get the fill value of the output
+    ///        variable for those locations. Values equal to the fill value of an input variable
+    ///        are rewritten with the output fill value when they differ, and numeric types are
+    ///        converted to the type the variable had in the first input that has it. Variables
+    ///        that are not dimensioned by Location (ex: the Channel dimension) are copied from the
+    ///        first input that has them and must have the same shape in every input.
+    ///
+    ///        When every input numbers its locations with a sequence (ex: 1 to n in each file),
+    ///        the dimension variable of the output continues the sequence of the first input.
+    class IodaConcat
+    {
+     public:
+        /// \brief Counts describing the merged output.
+        struct Summary
+        {
+            size_t numFiles = 0;
+            size_t numLocations = 0;
+            size_t numVariables = 0;
+        };
+
+        explicit IodaConcat(const IodaConcatOptions& options = IodaConcatOptions());
+
+        /// \brief Merge the inputs (in order) into the output file, which is overwritten.
+        /// \param inputs Paths of the input files.
+        /// \param output Path of the output file.
+        Summary concat(const std::vector<std::string>& inputs, const std::string& output);
+
+     private:
+        /// \brief An output variable that has been created.
+        struct Variable
+        {
+            std::string path;
+            bool alongDim = false;  ///< Dimension 0 is the concatenation dimension
+            bool isString = false;
+            bool isVarString = false;
+            hid_t memType = -1;  ///< Type the data is read/written in (owned)
+            std::vector<char> fill;  ///< Fill value as memType (empty for strings)
+            std::vector<hsize_t> dims;  ///< Dimensions in the input (dim 0 is per file)
+            std::vector<std::string> scales;  ///< Path of the dimension scale of each dim
+            std::string scaleName;  ///< Non empty if the variable is a dimension scale
+            hid_t dataset = -1;  ///< The output dataset, kept open so its chunk cache is reused
+
+            ~Variable()
+            {
+                if (dataset >= 0) H5Dclose(dataset);
+                if (memType >= 0) H5Tclose(memType);
+            }
+        };
+
+        const IodaConcatOptions options_;
+        hid_t outFile_ = -1;
+        std::map<std::string, std::shared_ptr<Variable>> variables_;
+        std::vector<std::string> variableOrder_;
+        std::set<std::string> groups_;
+        size_t numLocations_ = 0;
+        bool dimIsSequence_ = true;  ///< All the dimension values read so far are sequences
+        bool hasDimFirstValue_ = false;
+        int64_t dimFirstValue_ = 0;  ///< First value of the dimension in the first input
+
+        /// \brief Merge one input file into the output.
+        void mergeFile(const std::string& path);
+
+        /// \brief Create the group in the output if it is new and add the attributes it does
+        ///        not have yet (the attributes of the first file win on conflicts).
+        void addGroup(hid_t inFile, const std::string& groupPath);
+
+        /// \brief Create the output variable for an input dataset.
+        std::shared_ptr<Variable> addVariable(hid_t inDataset,
+                                              const std::string& varPath,
+                                              bool alongDim);
+
+        /// \brief Copy the locations of an input dataset to the output at numLocations_.
+        void appendData(hid_t inDataset,
+                        const Variable& variable,
+                        const std::string& desc,
+                        hsize_t numLocs);
+
+        /// \brief Check that the dimension values of an input are a sequence which starts at
+        ///        the first value of the first input or continues the values merged so far.
+        void checkDimSequence(hid_t dimDataset, hsize_t numLocs);
+
+        /// \brief Number the output dimension variable from the first value of the first input.
+        void renumberDim();
+
+        /// \brief Copy all the data of a variable that is not along the concatenation dimension.
+        void copyData(hid_t inDataset, const Variable& variable);
+
+        /// \brief Size the variables to the final number of locations and attach the dimension
+        ///        scales.
+        void finish();
+    };
+}  // namespace iodaconv
@@ -0,0 +1,113 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "IodaConcat.h"
+
+
+static void showHelp()
+{
+    std::cerr << "Usage: ioda_concat.x [-j NUM_THREADS] [-d DIM_NAME] [-l LIST_FILE] [-v] "
+              << "-o OUTPUT_FILE [INPUT_FILE ...]\n"
+              << "Options:\n"
+              << "  -h,  Show this help message\n"
+              << "  -o OUTPUT_FILE,  Path of the merged file (overwritten).\n"
+              << "  -l LIST_FILE,  File with the paths of more input files (one per line).\n"
+              << "  -d DIM_NAME,  Dimension to concatenate along (default Location).\n"
+              << "  -j NUM_THREADS,  Threads that read the inputs ahead (default 4).\n"
+              << "  -v,  Print each input file as it is merged."
+              << std::endl;
+}
+
+
+int main(int argc, char **argv)
+{
+    iodaconv::IodaConcatOptions options;
+    std::vector<std::string> inputs;
+    std::string output;
+
+    int argIdx = 1;
+    while (argIdx < argc)
+    {
+        const bool hasValue = argIdx + 1 < argc;
+        if (strcmp(argv[argIdx], "-h") == 0)
+        {
+            showHelp();
+            return 0;
+        }
+        else if (strcmp(argv[argIdx], "-v") == 0)
+        {
+            options.verbose = true;
+            argIdx++;
+        }
+        else if (argv[argIdx][0] == '-' && strlen(argv[argIdx]) == 2 && hasValue &&
+                 strchr("odlj", argv[argIdx][1]) != nullptr)
+        {
+            const std::string value = argv[argIdx + 1];
+            switch (argv[argIdx][1])
+            {
+                case 'o': output = value; break;
+                case 'd': options.dimName = value; break;
+                case 'j': options.numThreads = std::stoul(value); break;
+                case 'l':
+                {
+                    std::ifstream listFile(value);
+                    if (!listFile)
+                    {
+                        std::cerr << "Could not open the list file " << value << std::endl;
+                        return 1;
+                    }
+
+                    for (std::string line; std::getline(listFile, line);)
+                    {
+                        if (!line.empty()) inputs.push_back(line);
+                    }
+
+                    break;
+                }
+            }
+
+            argIdx += 2;
+        }
+        else if (argv[argIdx][0] == '-')
+        {
+            showHelp();
+            return 1;
+        }
+        else
+        {
+            inputs.push_back(argv[argIdx]);
+            argIdx++;
+        }
+    }
+
+    if (output.empty() || inputs.empty())
+    {
+        showHelp();
+        return 1;
+    }
+
+    try
+    {
+        const auto summary = iodaconv::IodaConcat(options).concat(inputs, output);
+        std::cout << "Merged " << summary.numFiles << " files (" << summary.numLocations
+                  << " locations, " << summary.numVariables << " variables) into " << output
+                  << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
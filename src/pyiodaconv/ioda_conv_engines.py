@@ -1,9 +1,18 @@
 #!/usr/bin/env python
 import datetime as dt
+import os
 from pyioda import ioda_obs_space as ioda_os
 import numpy as np
 from collections import OrderedDict
 
+# The compiled writer (built with the bufr python bindings) is opt in: set
+# IODACONV_COMPILED_WRITER to use it. Its files hold the same data as the ObsSpace
+# ones but their compression and chunking differ, so it is not the default.
+try:
+    from pyiodaconv import ioda_writer as _ioda_writer
+except ImportError:
+    _ioda_writer = None
+
 # define vars
 _metagroup = 'MetaData'
 # Names assigned to obs values, error estimates and qc marks
@@ -82,10 +91,17 @@ class IodaWriter(object):
     def __init__(self, Fname, LocKeyList, DimDict, TestKeyList=None):
         # note: loc_key_list does nothing
         self._loc_key_list = LocKeyList
+        self._fname = Fname
         self._dim_dict = DimDict
         self._test_key_list = TestKeyList
-        # open IODA obs backend
-        self.obsspace = ioda_os.ObsSpace(Fname, mode='w', dim_dict=DimDict)
+        self._obsspace = None
+
+    @property
+    def obsspace(self):
+        # open IODA obs backend (only when the python writer is used)
+        if self._obsspace is None:
+            self._obsspace = ioda_os.ObsSpace(self._fname, mode='w', dim_dict=self._dim_dict)
+        return self._obsspace
 
     def WriteGeoVars(self, GeoVars, GeoVarDims, GeoVarAttrs):
         # this method will write out geovals using IODA
@@ -172,6 +188,20 @@ class IodaWriter(object):
 
         return ObsVars
 
+    def WriteIoda(self, ObsVars, VarDims, VarAttrs, GlobalAttrs):
+        # this method will write everything with one call to the compiled writer,
+        # the data conversion (including dateTime) and the file writes are done in C++
+        VarKey = ('dateTime', 'MetaData')
+        if VarKey not in ObsVars.keys():
+            raise KeyError("Required variable 'MetaData/dateTime' does not exist.")
+        # add some default metadata if necessary
+        for (Vname, Gname) in ObsVars.keys():
+            if Vname in _default_units.keys() and (Vname, Gname) in VarAttrs.keys():
+                if 'units' not in VarAttrs[(Vname, Gname)].keys():
+                    VarAttrs[(Vname, Gname)]['units'] = _default_units[Vname]
+        _ioda_writer.write(self._fname, self._dim_dict, ObsVars, VarDims, VarAttrs,
+                           GlobalAttrs)
+
     def WriteGlobalAttrs(self, GlobalAttrs):
         # this method will create global attributes from GlobalAttrs dictionary
         for AttrKey, AttrVal in GlobalAttrs.items():
@@ -179,6 +209,10 @@ class IodaWriter(object):
 
     def BuildIoda(self, ObsVars, VarDims, VarAttrs, GlobalAttrs,
                   TestData=None, geovals=False):
+        use_compiled = 'IODACONV_COMPILED_WRITER' in os.environ
+        if _ioda_writer is not None and use_compiled and not geovals and TestData is None:
+            self.WriteIoda(ObsVars, VarDims, VarAttrs, GlobalAttrs)
+            return
         # check and fix dateTime if necessary
         ObsVars = self.VerifyDateTime(ObsVars)
         if geovals:
@@ -0,0 +1,232 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#define ECKIT_TESTING_SELF_REGISTER_CASES 0
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "eckit/testing/Test.h"
+#include "oops/runs/Test.h"
+#include "oops/util/Expect.h"
+
+#include "DataObject.h"
+#include "ValidityMask.h"
+
+
+namespace Ingester
+{
+    namespace test
+    {
+        /// \brief Check that the validity bitmap of a DataObject agrees with its data.
+        template<typename T>
+        void expectValidityMatchesData(const Ingester::DataObject<T>& dataObject)
+        {
+            const auto& data = dataObject.rawData();
+            const auto& validity = dataObject.getValidity();
+
+            EXPECT_EQUAL(validity.size(), data.size());
+
+            size_t numMissing = 0;
+            for (size_t idx = 0; idx < data.size(); ++idx)
+            {
+                const bool isMissing = data[idx] == Ingester::DataObject<T>::missingValue();
+                EXPECT_EQUAL(dataObject.isMissing(idx), isMissing);
+                EXPECT_EQUAL(validity.isValid(idx), !isMissing);
+                if (isMissing) numMissing++;
+            }
+
+            EXPECT_EQUAL(dataObject.numMissing(), numMissing);
+        }
+
+        /// \brief Make a DataObject with the given data and dimensions.
+        template<typename T>
+        std::shared_ptr<Ingester::DataObject<T>> makeDataObject(const std::vector<T>& data,
+                                                                const Dimensions& dims)
+        {
+            return std::make_shared<Ingester::DataObject<T>>(data,
+                                                             "field",
+                                                             "",
+                                                             dims,
+                                                             "*/FIELD",
+                                                             std::vector<bufr::Query>());
+        }
+
+        void test_validityMask()
+        {
+            // 130 elements span 3 words, the last one partly
+            const size_t size = 130;
+            EXPECT_EQUAL(ValidityMask(size).numValid(), size);
+            EXPECT_EQUAL(ValidityMask(size, false).numValid(), 0u);
+
+            std::vector<int> data(size);
+            for (size_t idx = 0; idx < size; ++idx)
+            {
+                data[idx] = static_cast<int>(idx);
+            }
+
+            auto mask = ValidityMask::fromData(data, [](int val) { return val % 3 != 0; });
+            EXPECT_EQUAL(mask.numMissing(), 44u);  // 0, 3, ..., 129
+
+            mask.set(1, false);
+            mask.set(0, true);
+            EXPECT(!mask.isValid(1));
+            EXPECT(mask.isValid(0));
+
+            std::vector<size_t> validIdxs;
+            mask.forEachValid([&validIdxs](size_t idx) { validIdxs.push_back(idx); });
+            EXPECT_EQUAL(validIdxs.size(), mask.numValid());
+            for (const auto idx : validIdxs)
+            {
+                EXPECT(mask.isValid(idx));
+            }
+
+            std::unique_ptr<bool[]> isMissing(new bool[size]);
+            mask.toMissingFlags(isMissing.get());
+            for (size_t idx = 0; idx < size; ++idx)
+            {
+                EXPECT_EQUAL(isMissing[idx], !mask.isValid(idx));
+            }
+
+            auto both = ValidityMask(size);
+            both.set(128, false);
+            both &= mask;
+            EXPECT(!both.isValid(128));
+            EXPECT(!both.isValid(129));
+            EXPECT(both.isValid(128 - 1) == mask.isValid(128 - 1));
+            EXPECT_EQUAL(both.numValid(), mask.numValid() - 1);
+        }
+
+        void test_setData()
+        {
+            const auto missing = Ingester::DataObject<float>::missingValue();
+            auto dataObject = makeDataObject<float>({1.0f, missing, 3.0f, missing}, {4});
+            expectValidityMatchesData(*dataObject);
+            EXPECT_EQUAL(dataObject->numMissing(), 2u);
+
+            // Typed data replaces the bitmap
+            dataObject->setData(std::vector<float>{missing, 2.0f, 3.0f});
+            expectValidityMatchesData(*dataObject);
+            EXPECT(dataObject->isMissing(0));
+            EXPECT(!dataObject->isMissing(1));
+
+            // Raw BUFR data: the raw missing value (and the missing value of the type) are missing
+            const double rawMissing = 10.0e10;
+            auto intObject = makeDataObject<int>({0}, {1});
+            intObject->setData(std::vector<double>{rawMissing,
+                                                   1.0,
+                                                   Ingester::DataObject<int>::missingValue(),
+                                                   -4.0,
+                                                   rawMissing},
+                               rawMissing);
+            expectValidityMatchesData(*intObject);
+            EXPECT_EQUAL(intObject->numMissing(), 3u);
+            EXPECT_EQUAL(intObject->getAsInt(static_cast<size_t>(3)), -4);
+
+            // A small type whose range doesn't hold the raw missing value
+            auto narrowObject = makeDataObject<int16_t>({0}, {1});
+            narrowObject->setData(std::vector<double>{rawMissing, 7.0}, rawMissing);
+            expectValidityMatchesData(*narrowObject);
+            EXPECT(narrowObject->isMissing(static_cast<size_t>(0)));
+            EXPECT(!narrowObject->isMissing(static_cast<size_t>(1)));
+        }
+
+        void test_slice()
+        {
+            // 3 rows of 70 columns (the rows don't line up with the 64 element words)
+            const int numRows = 3;
+            const int numCols = 70;
+            const auto missing = Ingester::DataObject<double>::missingValue();
+
+            std::vector<double> data(numRows * numCols);
+            for (size_t idx = 0; idx < data.size(); ++idx)
+            {
+                data[idx] = (idx % 5 == 0) ? missing : static_cast<double>(idx);
+            }
+
+            auto dataObject = makeDataObject<double>(data, {numRows, numCols});
+            expectValidityMatchesData(*dataObject);
+
+            const std::vector<size_t> rows = {2, 0};
+            auto sliced = std::dynamic_pointer_cast<Ingester::DataObject<double>>(
+                dataObject->slice(rows));
+            EXPECT(sliced != nullptr);
+            expectValidityMatchesData(*sliced);
+
+            EXPECT_EQUAL(sliced->getDims()[0], static_cast<int>(rows.size()));
+            for (size_t rowIdx = 0; rowIdx < rows.size(); ++rowIdx)
+            {
+                for (size_t colIdx = 0; colIdx < static_cast<size_t>(numCols); ++colIdx)
+                {
+                    EXPECT_EQUAL(sliced->isMissing(rowIdx * numCols + colIdx),
+                                 dataObject->isMissing(rows[rowIdx] * numCols + colIdx));
+                }
+            }
+
+            // Empty slices are valid
+            auto empty = dataObject->slice({});
+            EXPECT_EQUAL(empty->getValidity().size(), 0u);
+            EXPECT_EQUAL(empty->numMissing(), 0u);
+        }
+
+        void test_setRawData()
+        {
+            const auto missing = Ingester::DataObject<int64_t>::missingValue();
+            auto dataObject = makeDataObject<int64_t>({1, 2, 3}, {3});
+            EXPECT_EQUAL(dataObject->numMissing(), 0u);
+
+            dataObject->setRawData({missing, 5, missing, 7, 8});
+            expectValidityMatchesData(*dataObject);
+            EXPECT_EQUAL(dataObject->numMissing(), 2u);
+
+            dataObject->setRawData({});
+            expectValidityMatchesData(*dataObject);
+            EXPECT_EQUAL(dataObject->getValidity().size(), 0u);
+        }
+
+        class DataObject : public oops::Test
+        {
+         public:
+            DataObject() = default;
+            virtual ~DataObject() = default;
+         private:
+            std::string testid() const override { return "ingester::test::DataObject"; }
+            void register_tests() const override
+            {
+                std::vector<eckit::testing::Test>& ts = eckit::testing::specification();
+
+                ts.emplace_back(CASE("ingester/DataObject/testValidityMask")
+                {
+                    test_validityMask();
+                });
+
+                ts.emplace_back(CASE("ingester/DataObject/testSetData")
+                {
+                    test_setData();
+                });
+
+                ts.emplace_back(CASE("ingester/DataObject/testSlice")
+                {
+                    test_slice();
+                });
+
+                ts.emplace_back(CASE("ingester/DataObject/testSetRawData")
+                {
+                    test_setRawData();
+                });
+            }
+
+            void clear() const override
+            {
+            }
+        };
+    }  // namespace test
+}  // namespace Ingester
@@ -0,0 +1,180 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#define ECKIT_TESTING_SELF_REGISTER_CASES 0
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "eckit/testing/Test.h"
+#include "oops/runs/Test.h"
+#include "oops/util/Expect.h"
+
+#include "DataContainer.h"
+#include "DataObject.h"
+#include "IodaEncoder/IodaDescription.h"
+#include "IodaEncoder/ZarrWriter.h"
+#include "MemoryTracker.h"
+
+
+namespace Ingester
+{
+    namespace test
+    {
+        typedef Ingester::MemoryTracker::Subsystem Subsystem;
+
+        inline size_t currentBytes(Subsystem subsystem)
+        {
+            return Ingester::MemoryTracker::instance().usage(subsystem).current;
+        }
+
+        inline size_t peakBytes(Subsystem subsystem)
+        {
+            return Ingester::MemoryTracker::instance().usage(subsystem).peak;
+        }
+
+        inline std::shared_ptr<Ingester::DataObject<float>> makeFloatObject(size_t size)
+        {
+            return std::make_shared<Ingester::DataObject<float>>(
+                std::vector<float>(size, 1.0f),
+                "field",
+                "",
+                Dimensions{static_cast<int>(size)},
+                "*/FIELD",
+                std::vector<bufr::Query>());
+        }
+
+        void test_trackedBytes()
+        {
+            const auto subsystem = Subsystem::ResultSet;
+            const auto baseline = currentBytes(subsystem);
+            {
+                Ingester::TrackedBytes tracked(subsystem, 100);
+                EXPECT_EQUAL(currentBytes(subsystem), baseline + 100);
+
+                tracked.set(40);
+                EXPECT_EQUAL(currentBytes(subsystem), baseline + 40);
+
+                // Copies are counted again, moves are not
+                auto copy = tracked;
+                EXPECT_EQUAL(currentBytes(subsystem), baseline + 80);
+
+                auto moved = std::move(copy);
+                EXPECT_EQUAL(currentBytes(subsystem), baseline + 80);
+                EXPECT_EQUAL(copy.bytes(), 0u);
+                EXPECT_EQUAL(moved.bytes(), 40u);
+            }
+
+            EXPECT_EQUAL(currentBytes(subsystem), baseline);
+        }
+
+        void test_peaks()
+        {
+            const auto subsystem = Subsystem::ResultSet;
+            Ingester::MemoryTracker::instance().resetPeaks();
+            const auto baseline = currentBytes(subsystem);
+            {
+                Ingester::TrackedBytes tracked(subsystem, 1000);
+                tracked.set(10);
+            }
+
+            EXPECT_EQUAL(currentBytes(subsystem), baseline);
+            EXPECT_EQUAL(peakBytes(subsystem), baseline + 1000);
+            EXPECT(Ingester::MemoryTracker::instance().total().peak >= baseline + 1000);
+
+            Ingester::MemoryTracker::instance().resetPeaks();
+            EXPECT_EQUAL(peakBytes(subsystem), baseline);
+        }
+
+        void test_dataContainer()
+        {
+            const auto dataBaseline = currentBytes(Subsystem::DataObject);
+            const auto containerBaseline = currentBytes(Subsystem::DataContainer);
+            {
+                auto dataObject = makeFloatObject(1000);
+                EXPECT(currentBytes(Subsystem::DataObject) >= dataBaseline + 1000 * sizeof(float));
+
+                Ingester::DataContainer container(
+                    Ingester::CategoryMap{{"satId", {"sat_1", "sat_2"}}});
+                const auto emptyBytes = currentBytes(Subsystem::DataContainer);
+                EXPECT(emptyBytes > containerBaseline);
+
+                container.add("variables/field", dataObject, {"sat_1"});
+                EXPECT(currentBytes(Subsystem::DataContainer) > emptyBytes);
+
+                // The data is only counted once (by the DataObject)
+                EXPECT(currentBytes(Subsystem::DataContainer) - containerBaseline <
+                       1000 * sizeof(float));
+            }
+
+            EXPECT_EQUAL(currentBytes(Subsystem::DataObject), dataBaseline);
+            EXPECT_EQUAL(currentBytes(Subsystem::DataContainer), containerBaseline);
+        }
+
+        void test_encoder()
+        {
+            const size_t size = 10000;
+            const auto baseline = currentBytes(Subsystem::Encoder);
+            Ingester::MemoryTracker::instance().resetPeaks();
+
+            Ingester::VariableDescription description;
+            description.name = "ObsValue/field";
+            description.longName = "Field";
+            description.compressionLevel = 4;
+            description.filters = Ingester::FilterPipeline::deflate(4);
+
+            Ingester::ZarrWriter writer("testrun/memory_tracker.zarr");
+            writer.addVariable(description, makeFloatObject(size), {"Location"}, {1000});
+            writer.write();
+
+            // The chunk buffers are counted while the chunks are encoded and freed after
+            EXPECT(peakBytes(Subsystem::Encoder) >= baseline + 1000 * sizeof(float));
+            EXPECT_EQUAL(currentBytes(Subsystem::Encoder), baseline);
+        }
+
+        class MemoryTracker : public oops::Test
+        {
+         public:
+            MemoryTracker() = default;
+            virtual ~MemoryTracker() = default;
+         private:
+            std::string testid() const override { return "ingester::test::MemoryTracker"; }
+            void register_tests() const override
+            {
+                std::vector<eckit::testing::Test>& ts = eckit::testing::specification();
+
+                ts.emplace_back(CASE("ingester/MemoryTracker/testTrackedBytes")
+                {
+                    test_trackedBytes();
+                });
+
+                ts.emplace_back(CASE("ingester/MemoryTracker/testPeaks")
+                {
+                    test_peaks();
+                });
+
+                ts.emplace_back(CASE("ingester/MemoryTracker/testDataContainer")
+                {
+                    test_dataContainer();
+                });
+
+                ts.emplace_back(CASE("ingester/MemoryTracker/testEncoder")
+                {
+                    test_encoder();
+                });
+            }
+
+            void clear() const override
+            {
+            }
+        };
+    }  // namespace test
+}  // namespace Ingester
@@ -0,0 +1,125 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#define ECKIT_TESTING_SELF_REGISTER_CASES 0
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "eckit/testing/Test.h"
+#include "oops/runs/Test.h"
+#include "oops/util/Expect.h"
+
+#include "BufrParser/Query/File.h"
+#include "BufrParser/Query/QuerySet.h"
+#include "BufrParser/Query/ResultSet.h"
+#include "BufrParser/Query/TaskScheduler.h"
+#include "DataObject.h"
+
+
+namespace Ingester
+{
+    namespace test
+    {
+        /// \brief Get a field of the result set with every stage running on a scheduler with
+        ///        the given number of threads (1 runs everything on the calling thread).
+        inline std::shared_ptr<DataObjectBase> getWithThreads(const bufr::ResultSet& resultSet,
+                                                              const std::string& fieldName,
+                                                              const std::string& groupBy,
+                                                              size_t numThreads)
+        {
+            bufr::SchedulerOptions options;
+            options.numThreads = numThreads;
+            bufr::TaskScheduler::Scope scope(std::make_shared<bufr::TaskScheduler>(options));
+
+            return resultSet.get(fieldName, groupBy);
+        }
+
+        /// \brief Check that the parallel getRawValues gives the same field as the serial one.
+        void expectSameAsSerial(const bufr::ResultSet& resultSet,
+                                const std::string& fieldName,
+                                const std::string& groupBy,
+                                size_t expectedNumDims)
+        {
+            const auto serial = getWithThreads(resultSet, fieldName, groupBy, 1);
+            EXPECT_EQUAL(serial->getDims().size(), expectedNumDims);
+
+            for (const size_t numThreads : {2, 4, 8})
+            {
+                const auto parallel = getWithThreads(resultSet, fieldName, groupBy, numThreads);
+
+                EXPECT(parallel->getDims() == serial->getDims());
+
+                const auto serialPaths = serial->getDimPaths();
+                const auto parallelPaths = parallel->getDimPaths();
+                EXPECT_EQUAL(parallelPaths.size(), serialPaths.size());
+                for (size_t pathIdx = 0; pathIdx < serialPaths.size(); ++pathIdx)
+                {
+                    EXPECT_EQUAL(parallelPaths[pathIdx].str(), serialPaths[pathIdx].str());
+                }
+
+                EXPECT_EQUAL(parallel->size(), serial->size());
+                for (size_t idx = 0; idx < serial->size(); ++idx)
+                {
+                    EXPECT_EQUAL(parallel->isMissing(idx), serial->isMissing(idx));
+                    if (!serial->isMissing(idx))
+                    {
+                        EXPECT_EQUAL(parallel->getAsFloat(idx), serial->getAsFloat(idx));
+                    }
+                }
+            }
+        }
+
+        void test_parallelGetRawValues()
+        {
+            bufr::QuerySet querySet;
+            querySet.add("temperature", "*/PRSLEVEL/T___INFO/T__EVENT/TOB");
+            querySet.add("category", "*/PRSLEVEL/CAT");
+            querySet.add("longitude", "*/XOB");
+
+            // ADPUPA has many more subsets than the frames of a parallel task, with a varying
+            // number of levels and events
+            bufr::File file("./testinput/ADPUPA.prepbufr");
+            const auto resultSet = file.execute(querySet);
+            file.close();
+
+            // Levels and events of each subset
+            expectSameAsSerial(resultSet, "temperature", "", 3);
+
+            // Grouped by a field at a lower repetition level than the target (levels, events)
+            expectSameAsSerial(resultSet, "temperature", "category", 2);
+
+            // Grouped by a field at a higher repetition level than the target (levels)
+            expectSameAsSerial(resultSet, "longitude", "category", 1);
+        }
+
+        class ResultSet : public oops::Test
+        {
+         public:
+            ResultSet() = default;
+            virtual ~ResultSet() = default;
+         private:
+            std::string testid() const override { return "ingester::test::ResultSet"; }
+            void register_tests() const override
+            {
+                std::vector<eckit::testing::Test>& ts = eckit::testing::specification();
+
+                ts.emplace_back(CASE("ingester/ResultSet/testParallelGetRawValues")
+                {
+                    test_parallelGetRawValues();
+                });
+            }
+
+            void clear() const override
+            {
+            }
+        };
+    }  // namespace test
+}  // namespace Ingester
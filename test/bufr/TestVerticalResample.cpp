@@ -0,0 +1,17 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include "oops/runs/Run.h"
+
+#include "TestVerticalResample.h"
+
+int main(int argc,  char ** argv)
+{
+    oops::Run run(argc, argv);
+    Ingester::test::VerticalResample tests;
+    return run.execute(tests);
+}
@@ -0,0 +1,180 @@
+/*
+ * (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#define ECKIT_TESTING_SELF_REGISTER_CASES 0
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "eckit/config/LocalConfiguration.h"
+#include "eckit/testing/Test.h"
+#include "oops/runs/Test.h"
+#include "oops/util/Expect.h"
+
+#include "BufrParser/Exports/Variables/VerticalResampleVariable.h"
+#include "DataObject.h"
+#include "IngesterTypes.h"
+
+
+namespace Ingester
+{
+    namespace test
+    {
+        // 2 profiles of 4 levels (the second profile is missing its top level)
+        const Dimensions ProfileDims = {2, 4};
+        const std::vector<double> Pressures = {100000.0, 85000.0, 70000.0, 50000.0,
+                                               100000.0, 85000.0, 70000.0, -1.0};
+
+        // Values that don't fit in a float
+        const std::vector<double> Values = {280.123456789012, 275.987654321098,
+                                            268.000000000001, 255.555555555555,
+                                            281.111111111111, 276.222222222222,
+                                            269.333333333333, -1.0};
+
+        // Targets in a different order than the levels (the output follows the target order)
+        const std::vector<double> Targets = {70000.0, 100000.0, 77500.0, 50000.0};
+
+        /// \brief Make a (profile, level) DataObject of T from the test data (-1 is missing).
+        template<typename T>
+        std::shared_ptr<DataObjectBase> makeProfileObject(const std::vector<double>& data,
+                                                          const std::string& query)
+        {
+            std::vector<T> typedData(data.size());
+            for (size_t idx = 0; idx < data.size(); ++idx)
+            {
+                typedData[idx] = data[idx] < 0 ? DataObject<T>::missingValue()
+                                               : static_cast<T>(data[idx]);
+            }
+
+            return std::make_shared<DataObject<T>>(typedData,
+                                                   query,
+                                                   "",
+                                                   ProfileDims,
+                                                   query,
+                                                   std::vector<bufr::Query>());
+        }
+
+        /// \brief Resample the test profiles (pressure and value of the given types).
+        template<typename CoordT, typename ValueT>
+        std::shared_ptr<DataObjectBase> resampleProfiles()
+        {
+            eckit::LocalConfiguration conf;
+            conf.set("coordinate", std::string("*/PRLC"));
+            conf.set("value", std::string("*/TMDB"));
+            conf.set("levels", Targets);
+            conf.set("method", std::string("linear"));
+
+            VerticalResampleVariable variable("airTemperature", "", conf);
+
+            BufrDataMap map;
+            map["airTemperature_coordinate"] = makeProfileObject<CoordT>(Pressures, "*/PRLC");
+            map["airTemperature_value"] = makeProfileObject<ValueT>(Values, "*/TMDB");
+
+            auto result = variable.exportData(map);
+            EXPECT_EQUAL(result->getDims().size(), 2u);
+            EXPECT_EQUAL(result->getDims()[0], 2);
+            EXPECT_EQUAL(result->getDims()[1], static_cast<int>(Targets.size()));
+
+            return result;
+        }
+
+        /// \brief Check the resampled values of the test profiles.
+        template<typename T>
+        void expectResampledValues(const DataObject<T>& result, double tolerance)
+        {
+            const double midWeight = (77500.0 - 85000.0) / (70000.0 - 85000.0);
+            const std::vector<double> expected =
+                {Values[2], Values[0], Values[1] + midWeight * (Values[2] - Values[1]), Values[3],
+                 Values[6], Values[4], Values[5] + midWeight * (Values[6] - Values[5]), -1.0};
+
+            const auto& data = result.rawData();
+            EXPECT_EQUAL(data.size(), expected.size());
+            for (size_t idx = 0; idx < expected.size(); ++idx)
+            {
+                if (expected[idx] < 0)
+                {
+                    EXPECT(result.isMissing(idx));
+                }
+                else
+                {
+                    EXPECT(std::abs(static_cast<double>(data[idx]) - expected[idx]) <= tolerance);
+                }
+            }
+        }
+
+        void test_doubleValues()
+        {
+            auto result = resampleProfiles<double, double>();
+
+            // Doubles keep their type and precision
+            auto doubleResult = std::dynamic_pointer_cast<DataObject<double>>(result);
+            EXPECT(doubleResult != nullptr);
+            expectResampledValues(*doubleResult, 1e-9);
+
+            // Levels that are on a target are copied exactly
+            EXPECT_EQUAL(doubleResult->rawData()[0], Values[2]);
+            EXPECT_EQUAL(doubleResult->rawData()[1], Values[0]);
+
+            // Float coordinates don't change the type of the values
+            auto floatCoordResult = std::dynamic_pointer_cast<DataObject<double>>(
+                resampleProfiles<float, double>());
+            EXPECT(floatCoordResult != nullptr);
+            expectResampledValues(*floatCoordResult, 1e-9);
+        }
+
+        void test_floatValues()
+        {
+            auto result = std::dynamic_pointer_cast<DataObject<float>>(
+                resampleProfiles<double, float>());
+            EXPECT(result != nullptr);
+            expectResampledValues(*result, 1e-4);
+        }
+
+        void test_integerValues()
+        {
+            // Integers are resampled (interpolated) as floats
+            auto result = resampleProfiles<int, int>();
+            EXPECT(std::dynamic_pointer_cast<DataObject<float>>(result) != nullptr);
+        }
+
+        class VerticalResample : public oops::Test
+        {
+         public:
+            VerticalResample() = default;
+            virtual ~VerticalResample() = default;
+         private:
+            std::string testid() const override { return "ingester::test::VerticalResample"; }
+            void register_tests() const override
+            {
+                std::vector<eckit::testing::Test>& ts = eckit::testing::specification();
+
+                ts.emplace_back(CASE("ingester/VerticalResample/testDoubleValues")
+                {
+                    test_doubleValues();
+                });
+
+                ts.emplace_back(CASE("ingester/VerticalResample/testFloatValues")
+                {
+                    test_floatValues();
+                });
+
+                ts.emplace_back(CASE("ingester/VerticalResample/testIntegerValues")
+                {
+                    test_integerValues();
+                });
+            }
+
+            void clear() const override
+            {
+            }
+        };
+    }  // namespace test
+}  // namespace Ingester
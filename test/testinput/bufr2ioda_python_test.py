@@ -0,0 +1,66 @@
+# (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+#
+# This software is licensed under the terms of the Apache Licence Version 2.0
+# which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+
+import numpy as np
+
+from pyiodaconv import bufr
+from pyiodaconv import bufr2ioda
+
+YAML_PATH = './testinput/bufr_hrs.yaml'
+DATA_PATH = './testinput/gdas.t00z.1bhrs4.tm00.bufr_d'
+
+
+def test_parse_yaml():
+    parser = bufr2ioda.BufrParser(YAML_PATH)
+    data = parser.parse()
+
+    assert data.categories() == [[]]
+    assert sorted(data.fields()) == ['brightnessTemp', 'channel', 'latitude', 'longitude',
+                                     'timestamp']
+
+    lon = data.get('longitude')
+    assert np.allclose(lon[0:3], np.array([166.7977, 166.4078, 165.992]))
+    assert data.size() == lon.shape[0]
+    assert len(data.get('brightnessTemp').shape) == 2
+
+    # The arrays use the data of the container
+    raw_lon = data.get('longitude', masked=False)
+    assert not raw_lon.flags.writeable
+    assert not raw_lon.flags.owndata
+
+    # Same values as the query API
+    q = bufr.QuerySet()
+    q.add('longitude', '*/CLON')
+    with bufr.File(DATA_PATH) as f:
+        r = f.execute(q)
+    assert np.allclose(lon, r.get('longitude'))
+
+
+def test_dict_config():
+    obs_space = {'name': 'bufr',
+                 'obsdatain': DATA_PATH,
+                 'exports': {'variables': {'latitude': {'query': '*/CLAT'},
+                                           'longitude': {'query': '*/CLON'}},
+                             'filters': [{'bounding': {'variable': 'latitude',
+                                                       'lowerBound': 0}}]}}
+
+    data = bufr2ioda.BufrParser(obs_space).parse(5)
+    fields = data.to_dict()[()]
+    assert np.all(fields['latitude'] >= 0)
+    assert fields['latitude'].shape == fields['longitude'].shape
+
+    ioda = {'backend': 'inMemory',
+            'variables': [{'name': 'MetaData/latitude',
+                           'source': 'variables/latitude',
+                           'longName': 'Latitude',
+                           'units': 'degrees_north'}]}
+
+    obs_groups = bufr2ioda.IodaEncoder(ioda).encode(data)
+    assert list(obs_groups.keys()) == [()]
+
+
+if __name__ == '__main__':
+    test_parse_yaml()
+    test_dict_config()
@@ -0,0 +1,67 @@
+# (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+#
+# This software is licensed under the terms of the Apache Licence Version 2.0
+# which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+
+# Converts ADPUPA.prepbufr with narrowIntegers and checks the output against the reference of the
+# default types: the fields must have the expected narrow types (picked by narrowIntegers or set
+# with type: int8 / int16) and the same values and missing values as the reference (valid zeros
+# of the quality markers must not become missing).
+#
+# usage: bufr_narrow_integers_check.py BUFR2IODA_EXE YAML OUTPUT REFERENCE
+
+import subprocess
+import sys
+
+import numpy as np
+from netCDF4 import Dataset
+
+# Variable: (expected type, quality marker with valid zeros)
+NARROW_VARIABLES = {
+    'QualityMarker/airTemperature': (np.int8, True),  # narrowest
+    'QualityMarker/pressure': (np.int8, True),  # type: int8
+    'MetaData/prepbufrReportType': (np.int16, False),  # narrowest
+    'MetaData/dumpReportType': (np.int16, False),  # type: int16
+}
+
+
+def variable_paths(group, prefix=''):
+    paths = [prefix + name for name in group.variables]
+    for name, subgroup in group.groups.items():
+        paths += variable_paths(subgroup, prefix + name + '/')
+
+    return paths
+
+
+def main():
+    exe, yaml_path, output_path, reference_path = sys.argv[1:]
+
+    subprocess.run([exe, yaml_path], check=True)
+
+    with Dataset(output_path) as output, Dataset(reference_path) as reference:
+        assert sorted(variable_paths(output)) == sorted(variable_paths(reference))
+
+        for path, (dtype, has_zeros) in NARROW_VARIABLES.items():
+            assert output[path].dtype == dtype, f'{path} is {output[path].dtype}, not {dtype}.'
+            if has_zeros:
+                values = output[path][:]
+                assert np.count_nonzero(values == 0) > 0, f'{path} should have valid zeros.'
+                assert np.count_nonzero(np.ma.getmaskarray(values)) > 0, \
+                    f'{path} should have missing values.'
+
+        for path in variable_paths(reference):
+            values = output[path][:]
+            reference_values = reference[path][:]
+            assert np.array_equal(np.ma.getmaskarray(values), np.ma.getmaskarray(reference_values)), \
+                f'The missing values of {path} differ from the reference.'
+
+            valid = ~np.ma.getmaskarray(reference_values)
+            assert np.array_equal(np.ma.getdata(values)[valid],
+                                  np.ma.getdata(reference_values)[valid]), \
+                f'The values of {path} differ from the reference.'
+
+    print(f'{len(NARROW_VARIABLES)} narrow fields match the reference.')
+
+
+if __name__ == '__main__':
+    main()
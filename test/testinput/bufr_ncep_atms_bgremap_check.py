@@ -0,0 +1,113 @@
+# (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+#
+# This software is licensed under the terms of the Apache Licence Version 2.0
+# which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+
+# Converts gdas.t00z.atms.tm00.bufr_d with bufr_ncep_atms_bgremap.yaml and checks the
+# backusGilbertRemap exports against a reference remap that finds the window of every location
+# by its (satellite, scan line, field of view) instead of by the order of the locations.
+#
+# usage: bufr_ncep_atms_bgremap_check.py BUFR2IODA_EXE YAML OUTPUT COEFFICIENTS
+
+import subprocess
+import sys
+
+import numpy as np
+from netCDF4 import Dataset
+
+REMAPPED_CHANNELS = [1, 2]
+TOLERANCE = 1e-3
+
+
+def read_windows(coefficients_path):
+    """Window (scan offsets, fov offsets, normalized weights) of every field of view."""
+    with Dataset(coefficients_path) as nc:
+        sizes = np.asarray(nc.variables['windowSize'][:])
+        alpha = np.asarray(nc.variables['alpha'][:], dtype=np.float64)
+        indices = np.asarray(nc.variables['windowIndex'][:])
+        centers = np.asarray(nc.variables['indexSrc'][:]) - 1
+
+    windows = []
+    for fov_idx, size in enumerate(sizes):
+        window = indices[fov_idx, :size] - indices[fov_idx, centers[fov_idx]]
+        weights = alpha[fov_idx, :size] / np.sum(alpha[fov_idx, :size])
+        windows.append((window[:, 0], window[:, 1], weights))
+
+    return windows
+
+
+def reference_remap(bt, keys, windows):
+    """Remap one channel. Locations whose window isn't complete (or whose key isn't unique)
+    are None."""
+    counts = {}
+    for key in keys:
+        counts[key] = counts.get(key, 0) + 1
+    loc_of_key = {key: loc_idx for loc_idx, key in enumerate(keys) if counts[key] == 1}
+
+    remapped = [None] * len(keys)
+    for loc_idx, (sat_id, scan, fov) in enumerate(keys):
+        if counts[(sat_id, scan, fov)] != 1 or fov < 1 or fov > len(windows):
+            continue
+
+        scan_offsets, fov_offsets, weights = windows[fov - 1]
+        src_locs = [loc_of_key.get((sat_id, scan + d_scan, fov + d_fov))
+                    for d_scan, d_fov in zip(scan_offsets, fov_offsets)]
+        if any(src is None or np.ma.is_masked(bt[src]) for src in src_locs):
+            continue
+
+        remapped[loc_idx] = float(np.sum(weights * np.array([bt[src] for src in src_locs])))
+
+    return remapped
+
+
+def compare(name, remapped, reference, allow_missing):
+    num_compared = 0
+    for loc_idx, ref in enumerate(reference):
+        value = remapped[loc_idx]
+        if np.ma.is_masked(value):
+            assert ref is None or allow_missing, f'{name}[{loc_idx}] is missing.'
+            continue
+
+        if ref is None:
+            continue
+
+        assert abs(value - ref) <= TOLERANCE, f'{name}[{loc_idx}] is {value}, expected {ref}.'
+        num_compared += 1
+
+    assert num_compared > 0, f'No remapped values to compare in {name}.'
+
+
+def check(output_path, coefficients_path):
+    with Dataset(output_path) as nc:
+        sat_ids = nc.groups['MetaData'].variables['satelliteIdentifier'][:]
+        scans = nc.groups['MetaData'].variables['scanLineNumber'][:]
+        fovs = nc.groups['MetaData'].variables['sensorScanPosition'][:]
+        channels = list(nc.groups['MetaData'].variables['sensorChannelNumber'][:])
+        bt = nc.groups['ObsValue'].variables['brightnessTemperature'][:]
+        remapped = nc.groups['DerivedObsValue'].variables['brightnessTemperature'][:]
+        from_time = nc.groups['DerivedObsValue'].variables['brightnessTemperatureFromTime'][:]
+
+    keys = [(int(sat_id), int(scan), int(fov)) for sat_id, scan, fov in zip(sat_ids, scans, fovs)]
+    windows = read_windows(coefficients_path)
+
+    for chan_idx, channel in enumerate(channels):
+        if channel not in REMAPPED_CHANNELS:
+            assert np.ma.allequal(remapped[:, chan_idx], bt[:, chan_idx]), \
+                f'Channel {channel} should not be remapped.'
+            assert np.ma.allequal(from_time[:, chan_idx], bt[:, chan_idx]), \
+                f'Channel {channel} should not be remapped (scans from the time).'
+            continue
+
+        reference = reference_remap(bt[:, chan_idx], keys, windows)
+        compare(f'channel {channel}', remapped[:, chan_idx], reference, allow_missing=False)
+
+        # Scans found from the time must give the same values wherever they give one
+        compare(f'channel {channel} (scans from the time)', from_time[:, chan_idx], reference,
+                allow_missing=True)
+
+
+if __name__ == '__main__':
+    exe, yaml_path, output_path, coefficients_path = sys.argv[1:]
+
+    subprocess.run([exe, yaml_path], check=True)
+    check(output_path, coefficients_path)
@@ -0,0 +1,65 @@
+# (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+#
+# This software is licensed under the terms of the Apache Licence Version 2.0
+# which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+
+# Converts gnssro_3prof_2022090100.bufr with bufr_ncep_gnssro.yaml and checks that the levels
+# that pass the gnssroQualityFlags checks (plus the bending angle checks gnssro_bufr2ioda does
+# on top of them) are the levels of the gnssro_bufr2ioda reference, with the same values.
+#
+# usage: bufr_ncep_gnssro_check.py BUFR2IODA_EXE YAML OUTPUT REFERENCE
+
+import subprocess
+import sys
+
+import numpy as np
+from netCDF4 import Dataset
+
+# Variable, absolute tolerance
+COMPARED = [('MetaData/latitude', 1e-4),
+            ('MetaData/longitude', 1e-4),
+            ('MetaData/earthRadiusCurvature', 1.0),
+            ('MetaData/geoidUndulation', 1e-2),
+            ('MetaData/impactParameterRO', 1.0),
+            ('MetaData/impactHeightRO', 1.0),
+            ('MetaData/satelliteAscendingFlag', 0),
+            ('ObsValue/bendingAngle', 1e-9)]
+
+
+def read_variable(nc, name):
+    group, var = name.split('/')
+    return nc.groups[group].variables[var][:]
+
+
+def check(output_path, reference_path):
+    with Dataset(output_path) as nc:
+        data = {name: read_variable(nc, name) for name, _ in COMPARED}
+        pre_qc = read_variable(nc, 'PreQC/bendingAngle')
+        confidence = read_variable(nc, 'MetaData/percentConfidence')
+
+    # gnssro_bufr2ioda also drops profiles with no confidence and invalid bending angles
+    bend = data['ObsValue/bendingAngle']
+    impact = data['MetaData/impactParameterRO']
+    radius = data['MetaData/earthRadiusCurvature']
+    good = np.logical_and.reduce([pre_qc.filled(1) == 0,
+                                  confidence.filled(0) != 0,
+                                  bend.filled(0) > 0,
+                                  ~np.ma.getmaskarray(impact),
+                                  impact.filled(0) >= radius.filled(np.inf)])
+
+    with Dataset(reference_path) as nc:
+        num_locs = nc.dimensions['Location'].size
+        assert np.count_nonzero(good) == num_locs, \
+            f'{np.count_nonzero(good)} good levels, the reference has {num_locs}.'
+
+        for name, tol in COMPARED:
+            ref = read_variable(nc, name)
+            values = data[name][good]
+            assert np.allclose(values, ref, rtol=0, atol=tol), f'{name} differs from the reference.'
+
+
+if __name__ == '__main__':
+    exe, yaml_path, output_path, reference_path = sys.argv[1:]
+
+    subprocess.run([exe, yaml_path], check=True)
+    check(output_path, reference_path)
@@ -3,6 +3,15 @@
 # This software is licensed under the terms of the Apache Licence Version 2.0
 # which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
 
+import bz2
+import gzip
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import threading
+
 from pyiodaconv import bufr
 import numpy as np
 
@@ -85,6 +94,249 @@ def test_type_override():
     assert lat_int.dtype == 'int32'
     assert lat_int.fill_value == 2147483647  # the max int32 value
 
+
+def test_buffer_input():
+    DATA_PATH = './testinput/gdas.t00z.1bhrs4.tm00.bufr_d'
+
+    q = bufr.QuerySet()
+    q.add('latitude', '*/CLAT')
+
+    with bufr.File(DATA_PATH) as f:
+        lat = f.execute(q).get('latitude')
+
+    # The same data read from an in memory buffer
+    with open(DATA_PATH, 'rb') as data_file:
+        data = data_file.read()
+
+    with bufr.File(memoryview(data)) as f:
+        lat_buffer = f.execute(q).get('latitude')
+
+    assert np.allclose(lat, lat_buffer)
+
+
+def test_fd_input():
+    DATA_PATH = './testinput/gdas.t00z.1bhrs4.tm00.bufr_d'
+
+    q = bufr.QuerySet()
+    q.add('latitude', '*/CLAT')
+
+    with bufr.File(DATA_PATH) as f:
+        lat = f.execute(q).get('latitude')
+
+    # A regular file is read in place
+    fd = os.open(DATA_PATH, os.O_RDONLY)
+    try:
+        with bufr.File(fd) as f:
+            assert np.allclose(lat, f.execute(q).get('latitude'))
+    finally:
+        os.close(fd)
+
+    # A pipe is read into memory
+    with open(DATA_PATH, 'rb') as data_file:
+        data = data_file.read()
+
+    read_fd, write_fd = os.pipe()
+
+    def write_data():
+        with os.fdopen(write_fd, 'wb') as pipe:
+            pipe.write(data)
+
+    writer = threading.Thread(target=write_data)
+    writer.start()
+    try:
+        with bufr.File(read_fd) as f:
+            assert np.allclose(lat, f.execute(q).get('latitude'))
+    finally:
+        writer.join()
+        os.close(read_fd)
+
+
+def test_stdin_input():
+    DATA_PATH = './testinput/gdas.t00z.1bhrs4.tm00.bufr_d'
+
+    q = bufr.QuerySet()
+    q.add('latitude', '*/CLAT')
+
+    with bufr.File(DATA_PATH) as f:
+        lat = f.execute(q).get('latitude')
+
+    code = '\n'.join(['import numpy as np',
+                      'from pyiodaconv import bufr',
+                      'q = bufr.QuerySet()',
+                      "q.add('latitude', '*/CLAT')",
+                      "with bufr.File('-') as f:",
+                      "    np.save(sys.stdout.buffer, f.execute(q).get('latitude').filled(0))"])
+
+    # stdin redirected from the file (read in place) and piped (read into memory)
+    with open(DATA_PATH, 'rb') as data_file:
+        from_file = subprocess.run([sys.executable, '-c', 'import sys\n' + code],
+                                   stdin=data_file, stdout=subprocess.PIPE, check=True).stdout
+        data_file.seek(0)
+        from_pipe = subprocess.run([sys.executable, '-c', 'import sys\n' + code],
+                                   input=data_file.read(), stdout=subprocess.PIPE,
+                                   check=True).stdout
+
+    for output in [from_file, from_pipe]:
+        with tempfile.TemporaryFile() as npy_file:
+            npy_file.write(output)
+            npy_file.seek(0)
+            assert np.allclose(lat.filled(0), np.load(npy_file))
+
+
+def test_message_cache():
+    DATA_PATH = './testinput/gdas.t00z.1bhrs4.tm00.bufr_d'
+
+    q = bufr.QuerySet()
+    q.add('latitude', '*/CLAT')
+    q.add('radiance', '*/BRIT/TMBR')
+
+    with bufr.File(DATA_PATH) as f:
+        r = f.execute(q)
+        lat = r.get('latitude')
+        rad = r.get('radiance')
+
+    with tempfile.TemporaryDirectory() as cache_dir:
+        # The first run fills the cache, the second one reads from it
+        for _ in range(2):
+            with bufr.File(DATA_PATH) as f:
+                f.set_message_cache(cache_dir)
+                r = f.execute(q)
+
+            assert np.allclose(lat, r.get('latitude'))
+            assert np.allclose(rad, r.get('radiance'))
+
+        # Entries are keyed by message, table and queries, and no temporary files are left
+        names = os.listdir(cache_dir)
+        assert len(names) > 0
+        assert all(name.endswith('.msg') for name in names)
+        keys = [name[:-len('.msg')].split('_') for name in names]
+        assert all(len(key) == 4 for key in keys)
+        assert len(set(key[1] for key in keys)) == 1
+        assert len(set(key[2] for key in keys)) == 1
+
+
+def test_compressed_input():
+    DATA_PATH = './testinput/gdas.t00z.1bhrs4.tm00.bufr_d'
+
+    q = bufr.QuerySet()
+    q.add('latitude', '*/CLAT')
+    q.add('radiance', '*/BRIT/TMBR')
+
+    with bufr.File(DATA_PATH) as f:
+        r = f.execute(q)
+        lat = r.get('latitude')
+        rad = r.get('radiance')
+
+    with open(DATA_PATH, 'rb') as data_file:
+        data = data_file.read()
+
+    with tempfile.TemporaryDirectory() as tmp_dir:
+        paths = [os.path.join(tmp_dir, 'data.bufr.gz'), os.path.join(tmp_dir, 'data.bufr.bz2')]
+        with open(paths[0], 'wb') as gz_file:
+            gz_file.write(gzip.compress(data))
+        with open(paths[1], 'wb') as bz2_file:
+            bz2_file.write(bz2.compress(data))
+
+        if shutil.which('zstd') is not None:
+            paths.append(os.path.join(tmp_dir, 'data.bufr.zst'))
+            subprocess.run(['zstd', '-q', DATA_PATH, '-o', paths[-1]], check=True)
+
+        for path in paths:
+            try:
+                with bufr.File(path) as f:
+                    r = f.execute(q)
+            except Exception as e:
+                # The compression libraries are optional at build time
+                if 'not supported by this build' in str(e):
+                    continue
+                raise
+
+            assert np.allclose(lat, r.get('latitude')), path
+            assert np.allclose(rad, r.get('radiance')), path
+
+
+def test_prepared_query():
+    DATA_PATHS = ['./testinput/gdas.t12z.1bmhs.tm00.bufr_d',
+                  './testinput/gdas.t18z.1bmhs.tm00.bufr_d']
+
+    q = bufr.QuerySet()
+    q.add('latitude', '*/CLAT')
+    q.add('radiance', '*/BRITCSTC/TMBR')
+
+    expected = []
+    for path in DATA_PATHS:
+        with bufr.File(path) as f:
+            r = f.execute(q)
+            expected.append((r.get('latitude'), r.get('radiance')))
+
+    # One prepared query over both files (twice, the second time every plan is reused)
+    prepared = bufr.PreparedQuery(q)
+    assert prepared.size() == 2
+
+    for run_idx in range(2):
+        for path, (lat, rad) in zip(DATA_PATHS, expected):
+            with bufr.File(path) as f:
+                r = f.execute(prepared)
+
+            assert np.allclose(lat, r.get('latitude')), path
+            assert np.allclose(rad, r.get('radiance')), path
+
+        if run_idx == 0:
+            num_plans = prepared.num_plans()
+            assert 0 < num_plans <= len(DATA_PATHS)
+        else:
+            assert prepared.num_plans() == num_plans
+
+
+def test_event_selectors():
+    DATA_PATH = './testinput/ADPUPA.prepbufr'
+
+    q = bufr.QuerySet()
+    q.add('tob', '*/PRSLEVEL/T___INFO/T__EVENT/TOB')
+    q.add('tpc', '*/PRSLEVEL/T___INFO/T__EVENT/TPC')
+    q.add('tob_first', '*/PRSLEVEL/T___INFO/T__EVENT{first}/TOB')
+    q.add('tob_last', '*/PRSLEVEL/T___INFO/T__EVENT{last}/TOB')
+    q.add('tob_tpc1', '*/PRSLEVEL/T___INFO/T__EVENT{TPC=1}/TOB')
+    q.add('tob_level1_last', '*/PRSLEVEL{1}/T___INFO/T__EVENT{last}/TOB')
+
+    with bufr.File(DATA_PATH) as f:
+        r = f.execute(q)
+
+    # The events of each level are the unmasked program codes (the stacks are padded)
+    tob = r.get('tob')
+    tpc = r.get('tpc')
+    num_events = np.count_nonzero(~np.ma.getmaskarray(tpc), axis=-1)
+    assert np.any(num_events > 1), 'Some levels should have several events.'
+
+    def select(event_idxs):
+        has_event = event_idxs >= 0
+        values = np.take_along_axis(tob, np.maximum(event_idxs, 0)[..., np.newaxis], axis=-1)
+        return np.ma.masked_where(~has_event | np.ma.getmaskarray(values[..., 0]), values[..., 0])
+
+    def check(name, expected):
+        values = r.get(name)
+        assert values.shape == expected.shape, name
+        assert np.array_equal(np.ma.getmaskarray(values), np.ma.getmaskarray(expected)), name
+        assert np.allclose(values.compressed(), expected.compressed()), name
+
+    is_tpc1 = np.ma.filled(tpc == 1, False)
+    expected_last = select(num_events - 1)
+    check('tob_first', select(np.where(num_events > 0, 0, -1)))
+    check('tob_last', expected_last)
+    check('tob_tpc1', select(np.where(is_tpc1.any(axis=-1), is_tpc1.argmax(axis=-1), -1)))
+
+    # The level filter and the event selector are on different sequences
+    check('tob_level1_last', expected_last[:, 0])
+
+    # Codes that don't fit in an int are rejected
+    try:
+        q.add('tob_bad', '*/PRSLEVEL/T___INFO/T__EVENT{TPC=99999999999}/TOB')
+    except Exception:
+        pass
+    else:
+        assert False, "Didn't throw exception for an invalid selector code."
+
+
 def test_invalid_query():
     q = bufr.QuerySet()
 
@@ -101,4 +353,11 @@ if __name__ == '__main__':
     test_basic_query()
     test_string_field()
     test_type_override()
+    test_buffer_input()
+    test_fd_input()
+    test_stdin_input()
+    test_message_cache()
+    test_compressed_input()
+    test_prepared_query()
+    test_event_selectors()
     test_invalid_query()
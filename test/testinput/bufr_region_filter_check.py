@@ -0,0 +1,94 @@
+# (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+#
+# This software is licensed under the terms of the Apache Licence Version 2.0
+# which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+
+# Converts gdas.t00z.1bhrs4.tm00.bufr_d with bufr_region_filter.yaml and checks that the locations
+# kept by the region filter (and by the exclude region filter) are the locations of the unfiltered
+# output that a reference point in polygon test puts inside (and outside) of the region.
+#
+# usage: bufr_region_filter_check.py BUFR2IODA_EXE YAML ALL_OUTPUT INSIDE_OUTPUT OUTSIDE_OUTPUT
+
+import subprocess
+import sys
+
+import numpy as np
+from netCDF4 import Dataset
+
+# The region of bufr_region_filter.yaml (polygons of rings of (longitude, latitude) vertices)
+POLYGONS = [
+    [[(150, -60), (210, -60), (210, 60), (180, 0), (150, 60)]],
+    [[(-100, -30), (-20, -30), (-20, 50), (-100, 50)],
+     [(-80, -10), (-40, -10), (-40, 30), (-80, 30)]],
+]
+
+
+def read_locations(path):
+    """Latitudes and longitudes of an output (missing coordinates are NaN)."""
+    with Dataset(path) as nc:
+        lat = nc['MetaData/latitude'][:]
+        lon = nc['MetaData/longitude'][:]
+
+    return (np.ma.filled(lat.astype(np.float64), np.nan),
+            np.ma.filled(lon.astype(np.float64), np.nan))
+
+
+def in_polygon(lon, lat, polygon):
+    """Even-odd rule over all the rings of a polygon."""
+    inside = np.zeros(lon.shape, dtype=bool)
+    for ring in polygon:
+        for (x0, y0), (x1, y1) in zip(ring, ring[1:] + ring[:1]):
+            if y0 == y1:
+                continue
+            crosses = (y0 > lat) != (y1 > lat)
+            x_cross = x0 + (lat - y0) * (x1 - x0) / (y1 - y0)
+            inside ^= crosses & (lon < x_cross)
+
+    return inside
+
+
+def in_region(lon, lat):
+    # Longitudes are compared modulo 360 from the smallest longitude of the region
+    min_lon = min(x for polygon in POLYGONS for ring in polygon for x, _ in ring)
+    wrapped = min_lon + np.mod(lon - min_lon, 360.0)
+
+    inside = np.zeros(lon.shape, dtype=bool)
+    for polygon in POLYGONS:
+        inside |= in_polygon(wrapped, lat, polygon)
+
+    return inside
+
+
+def sorted_locations(lat, lon):
+    return sorted(zip(lat.tolist(), lon.tolist()))
+
+
+def main():
+    exe, yaml_path, all_path, inside_path, outside_path = sys.argv[1:]
+
+    subprocess.run([exe, yaml_path], check=True)
+
+    all_lat, all_lon = read_locations(all_path)
+    inside_lat, inside_lon = read_locations(inside_path)
+    outside_lat, outside_lon = read_locations(outside_path)
+
+    # Locations with missing coordinates are dropped by both filters
+    valid = ~np.isnan(all_lat) & ~np.isnan(all_lon)
+    with np.errstate(invalid='ignore'):
+        expected_inside = valid & in_region(all_lon, all_lat)
+    expected_outside = valid & ~expected_inside
+
+    assert np.count_nonzero(expected_inside) > 0, 'The region should contain some locations.'
+    assert np.count_nonzero(expected_outside) > 0, 'Some locations should be outside of the region.'
+
+    assert sorted_locations(inside_lat, inside_lon) == \
+        sorted_locations(all_lat[expected_inside], all_lon[expected_inside])
+    assert sorted_locations(outside_lat, outside_lon) == \
+        sorted_locations(all_lat[expected_outside], all_lon[expected_outside])
+
+    print(f'{np.count_nonzero(expected_inside)} locations inside and '
+          f'{np.count_nonzero(expected_outside)} outside of the region.')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,52 @@
+# (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+#
+# This software is licensed under the terms of the Apache Licence Version 2.0
+# which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+
+# Runs bufr2ioda.x with a sharded output and checks the manifest (the order, starts and balanced
+# sizes of the shards and their location counts). Also writes the list of the shards, the data is
+# checked by the ioda_concat test that merges them and compares the result with the reference.
+#
+# usage: bufr_shards_check.py BUFR2IODA_EXE YAML MANIFEST MAX_LOCATIONS SHARD_LIST
+
+import subprocess
+import sys
+
+import yaml
+from netCDF4 import Dataset
+
+
+def check_shards(manifest_path, max_locations, shard_list_path):
+    with open(manifest_path) as f:
+        entries = yaml.safe_load(f)['files']
+
+    assert len(entries) > 1, f'Expected more than one shard, got {len(entries)}.'
+
+    start = 0
+    for idx, entry in enumerate(entries):
+        assert entry['shard'] == idx, f'Shard {entry["shard"]} is out of order.'
+        assert entry['category'] == [], f'Unexpected category {entry["category"]}.'
+        assert entry['start'] == start, f'Shard {idx} starts at {entry["start"]}, not {start}.'
+        assert 0 < entry['locations'] <= max_locations, \
+            f'Shard {idx} has {entry["locations"]} locations.'
+        assert entry['path'].endswith(f'.shard{idx}.nc'), f'Unexpected path {entry["path"]}.'
+
+        with Dataset(entry['path']) as nc:
+            assert nc.dimensions['Location'].size == entry['locations'], \
+                f'{entry["path"]} does not have the locations of the manifest.'
+
+        start += entry['locations']
+
+    # The shard sizes differ by at most one
+    counts = [entry['locations'] for entry in entries]
+    assert max(counts) - min(counts) <= 1, f'Unbalanced shards {counts}.'
+
+    with open(shard_list_path, 'w') as f:
+        f.writelines(entry['path'] + '\n' for entry in entries)
+
+
+if __name__ == '__main__':
+    exe, yaml_path, manifest_path, max_locations, shard_list_path = sys.argv[1:]
+
+    subprocess.run([exe, yaml_path], check=True)
+    check_shards(manifest_path, int(max_locations), shard_list_path)
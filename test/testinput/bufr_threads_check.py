@@ -0,0 +1,58 @@
+# (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+#
+# This software is licensed under the terms of the Apache Licence Version 2.0
+# which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+
+# Converts a YAML with a single thread and then with several threads and checks (with nccmp) that
+# every output is the same. The variables that aren't thread safe (ex: the Fortran ATMS spatial
+# average of remappedBrightnessTemperature) must be exported one at a time whatever the number of
+# threads.
+#
+# usage: bufr_threads_check.py BUFR2IODA_EXE YAML NUM_THREADS OUTPUT_GLOB
+
+import glob
+import os
+import shutil
+import subprocess
+import sys
+
+# The ATMS spatial average opens its beam width table in the working directory
+BEAMWIDTH_PATH = 'testinput/atms_beamwidth.txt'
+
+
+def run(exe, yaml_path, num_threads):
+    subprocess.run([exe, '-t', str(num_threads), yaml_path], check=True)
+
+
+def main():
+    exe, yaml_path, num_threads, output_glob = sys.argv[1:]
+
+    if os.path.exists(BEAMWIDTH_PATH) and not os.path.exists(os.path.basename(BEAMWIDTH_PATH)):
+        os.symlink(BEAMWIDTH_PATH, os.path.basename(BEAMWIDTH_PATH))
+
+    for path in glob.glob(output_glob):
+        os.remove(path)
+
+    run(exe, yaml_path, 1)
+    outputs = sorted(glob.glob(output_glob))
+    assert len(outputs) > 0, f'No output matches {output_glob}.'
+
+    serial_outputs = []
+    for path in outputs:
+        serial_path = path[:-len('.nc')] + '.serial.nc'
+        shutil.move(path, serial_path)
+        serial_outputs.append(serial_path)
+
+    run(exe, yaml_path, num_threads)
+    assert sorted(glob.glob(output_glob)) == outputs
+
+    for path, serial_path in zip(outputs, serial_outputs):
+        subprocess.run(['nccmp', path, serial_path, '-d', '-m', '-g', '-f', '-S', '-T', '0.0'],
+                       check=True)
+        os.remove(serial_path)
+
+    print(f'{len(outputs)} outputs are the same with 1 and {num_threads} threads.')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,36 @@
+# (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+#
+# This software is licensed under the terms of the Apache Licence Version 2.0
+# which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+
+# Converts a YAML with the zarr backend, converts the Zarr store to netCDF with
+# iodaconv_zarr2nc.py and checks (with nccmp) that it matches the netCDF reference.
+#
+# usage: bufr_zarr_check.py BUFR2IODA_EXE ZARR2NC_EXE YAML STORE OUTPUT REFERENCE
+
+import os
+import shutil
+import subprocess
+import sys
+
+
+def main():
+    exe, zarr2nc_exe, yaml_path, store_path, output_path, reference_path = sys.argv[1:]
+
+    if os.path.exists(store_path):
+        shutil.rmtree(store_path)
+    if os.path.exists(output_path):
+        os.remove(output_path)
+
+    subprocess.run([exe, yaml_path], check=True)
+    assert os.path.isdir(store_path), f'{store_path} is not a Zarr store.'
+
+    subprocess.run([sys.executable, zarr2nc_exe, store_path, output_path], check=True)
+    subprocess.run(['nccmp', output_path, reference_path, '-d', '-m', '-g', '-f', '-S', '-T', '0.0'],
+                   check=True)
+
+    print(f'{store_path} matches {reference_path}.')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,63 @@
+# (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+#
+# This software is licensed under the terms of the Apache Licence Version 2.0
+# which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+
+# Converts csv_parser_small.csv with csv_parser.yaml and checks the values of the output
+# (skipped and comment lines, quoted fields, padded numbers, missing values, datetimes).
+#
+# usage: csv_parser_check.py BUFR2IODA_EXE YAML
+
+import calendar
+import subprocess
+import sys
+
+import numpy as np
+from netCDF4 import Dataset
+
+OUTPUT_PATH = './testrun/csv_parser.nc'
+
+
+def seconds(*args):
+    return calendar.timegm((*args, 0, 0, 0, 0))
+
+
+def check_output():
+    with Dataset(OUTPUT_PATH) as nc:
+        meta = nc.groups['MetaData']
+        obs = nc.groups['ObsValue']
+
+        assert nc.dimensions['Location'].size == 4
+
+        assert list(meta.variables['stationIdentification'][:]) == \
+            ['KBOS', 'KJFK', 'KORD', 'KDEN']
+        assert list(meta.variables['stationName'][:]) == \
+            ['Boston, MA', 'New York', 'Chicago', 'Denver']
+
+        lat = meta.variables['latitude'][:]
+        assert lat.dtype == np.float32
+        assert np.allclose(lat, [42.36, 40.64, 41.98, 39.86])
+
+        lon = meta.variables['longitude'][:]
+        assert lon.dtype == np.float64
+        assert np.array_equal(lon, [-71.01, -73.78, -87.90, -104.67])
+
+        times = meta.variables['dateTime'][:]
+        assert np.array_equal(times, [seconds(2020, 10, 1, 6, minute)
+                                      for minute in (0, 15, 30, 45)])
+
+        temp = obs.variables['airTemperature'][:]
+        assert np.array_equal(np.ma.getmaskarray(temp), [False, True, True, False])
+        assert np.array_equal(temp.compressed(), np.array([12.5, -3.25], dtype=np.float32))
+
+        count = obs.variables['count'][:]
+        assert count.dtype == np.int64
+        assert np.array_equal(np.ma.getmaskarray(count), [False, False, True, False])
+        assert np.array_equal(count.compressed(), [1234567890123, 3, -42])
+
+
+if __name__ == '__main__':
+    exe, yaml_path = sys.argv[1:]
+
+    subprocess.run([exe, yaml_path], check=True)
+    check_output()
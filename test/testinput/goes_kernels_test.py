@@ -0,0 +1,141 @@
+# (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+#
+# This software is licensed under the terms of the Apache Licence Version 2.0
+# which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+
+# Checks the compiled goes_kernels against the numpy implementations of goes_latlon.py and
+# goes_converter.py (the bin directory with the GOES scripts must be on the PYTHONPATH).
+
+import datetime
+
+import numpy as np
+
+from pyiodaconv import goes_kernels
+from goes_converter import GoesConverter
+from goes_latlon import GoesLatLon
+
+# GOES-16 fixed grid projection
+R_EQ = 6378137.0
+R_POL = 6356752.31414
+H = 35786023.0 + R_EQ
+LAT_0 = 0.0
+LON_0 = -75.0
+
+# Square grid that covers the full disk and some space around it (radians)
+GRID_SIZE = 301
+X = np.linspace(-0.151872, 0.151872, GRID_SIZE)
+Y = np.linspace(0.151872, -0.151872, GRID_SIZE)
+
+# Degrees (the kernels reorder the floating point operations)
+TOLERANCE = 1e-6
+
+
+def native_fixed_grid(threads=0):
+    size = GRID_SIZE * GRID_SIZE
+    lat = np.empty(size)
+    lon = np.empty(size)
+    scan_angle = np.empty(size)
+    elevation_angle = np.empty(size)
+    goes_kernels.fixed_grid(X, Y, R_EQ, R_POL, H, LON_0, lat, lon, scan_angle, elevation_angle, threads)
+    return lat, lon, scan_angle, elevation_angle
+
+
+def earth_latlon():
+    lat, lon, _, _ = native_fixed_grid()
+    on_earth = ~np.isnan(lat)
+    return lat[on_earth], lon[on_earth]
+
+
+def test_fixed_grid():
+    lat, lon, scan_angle, elevation_angle = native_fixed_grid()
+
+    with np.errstate(invalid='ignore'):
+        numpy_lat, numpy_lon = GoesLatLon._calc_fixed_grid_numpy(X, Y, R_EQ, R_POL, H, LON_0)
+    numpy_lon = np.where(numpy_lon <= -180.0, numpy_lon + 360.0, numpy_lon)
+
+    # Only pixels right on the limb may end up on different sides of it (rounding)
+    off_earth = np.isnan(lat)
+    assert np.any(off_earth) and not np.all(off_earth)
+    assert np.count_nonzero(off_earth != np.isnan(numpy_lat)) <= GRID_SIZE
+    on_earth = ~off_earth & ~np.isnan(numpy_lat)
+    assert np.allclose(lat[on_earth], numpy_lat[on_earth], rtol=0, atol=TOLERANCE)
+    assert np.allclose(lon[on_earth], numpy_lon[on_earth], rtol=0, atol=TOLERANCE)
+
+    grid_x, grid_y = np.meshgrid(X, Y, indexing='xy')
+    assert np.allclose(scan_angle, np.degrees(grid_x).ravel(), rtol=0, atol=1e-12)
+    assert np.allclose(elevation_angle, np.degrees(grid_y).ravel(), rtol=0, atol=1e-12)
+
+
+def test_sensor_angles():
+    lat, lon = earth_latlon()
+    zenith = np.empty(len(lat))
+    azimuth = np.empty(len(lat))
+    view = np.empty(len(lat))
+    goes_kernels.sensor_angles(lat, lon, R_EQ, H, LAT_0, LON_0, zenith, azimuth, view)
+
+    with np.errstate(invalid='ignore'):
+        numpy_zenith, numpy_azimuth, numpy_view = \
+            GoesLatLon._calc_sensor_angles_numpy(lat, lon, R_EQ, H, LAT_0, LON_0)
+
+    assert np.allclose(zenith, numpy_zenith, rtol=0, atol=TOLERANCE)
+    assert np.allclose(view, numpy_view, rtol=0, atol=TOLERANCE)
+    assert np.allclose(azimuth, numpy_azimuth, rtol=0, atol=TOLERANCE)
+
+
+def test_solar_angles():
+    lat, lon = earth_latlon()
+    start_date = datetime.datetime(2023, 7, 4, 17, 30, 15)
+    day_number = start_date.timetuple().tm_yday
+    zenith = np.empty(len(lat))
+    azimuth = np.empty(len(lat))
+    goes_kernels.solar_angles(lat, lon, day_number, start_date.hour, start_date.minute, start_date.second,
+                              zenith, azimuth)
+
+    numpy_zenith, numpy_azimuth = GoesConverter._calc_solar_angles_numpy(lat, lon, day_number, start_date)
+
+    assert np.allclose(zenith, numpy_zenith, rtol=0, atol=TOLERANCE)
+    assert np.allclose(azimuth, numpy_azimuth, rtol=0, atol=TOLERANCE)
+
+
+def test_threads():
+    # The tiles are independent so the number of threads doesn't change the results
+    single = native_fixed_grid(threads=1)
+    multi = native_fixed_grid(threads=4)
+    for single_array, multi_array in zip(single, multi):
+        assert np.array_equal(single_array, multi_array, equal_nan=True)
+
+
+def test_output_not_converted():
+    lat, lon = earth_latlon()
+    size = len(lat)
+
+    # Outputs that would need a conversion are rejected instead of being written to a copy
+    bad_outputs = [np.empty(size, dtype=np.float32),
+                   np.empty(2 * size)[::2],
+                   list(np.empty(size))]
+    for bad_output in bad_outputs:
+        try:
+            goes_kernels.solar_angles(lat, lon, 1, 0, 0, 0, bad_output, np.empty(size))
+        except TypeError:
+            pass
+        else:
+            assert False, 'An output array that needs a conversion was accepted.'
+
+    # Wrong sizes and read only arrays
+    read_only = np.empty(size)
+    read_only.setflags(write=False)
+    for bad_output in [np.empty(size + 1), read_only]:
+        try:
+            goes_kernels.solar_angles(lat, lon, 1, 0, 0, 0, bad_output, np.empty(size))
+        except ValueError:
+            pass
+        else:
+            assert False, 'A bad output array was accepted.'
+
+
+if __name__ == '__main__':
+    test_fixed_grid()
+    test_sensor_angles()
+    test_solar_angles()
+    test_threads()
+    test_output_not_converted()
@@ -0,0 +1,120 @@
+# (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+#
+# This software is licensed under the terms of the Apache Licence Version 2.0
+# which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+
+# Makes a small netCDF file, converts it with the netcdf parser (netcdf_native_types.yaml) and
+# checks that integers keep their type and exact values (int64 values above 2^53 can't be
+# represented by doubles), that the fill values become missing values and that the CF encoding
+# attributes are honoured (packed values are unpacked, values outside of valid_range are missing
+# and _Unsigned bytes are read as unsigned).
+#
+# usage: netcdf_native_types_check.py BUFR2IODA_EXE YAML
+
+import subprocess
+import sys
+
+import numpy as np
+from netCDF4 import Dataset
+
+INPUT_PATH = './testrun/netcdf_native_types_in.nc'
+OUTPUT_PATH = './testrun/netcdf_native_types.nc'
+
+LATITUDE = np.array([10.5, -20.25, np.nan, 45.0, 89.5, -1.0, 0.0], dtype=np.float32)
+SEQUENCE = np.array([2**53 + 1, 2**62 + 7, -2**60 - 3, 0, 1, 2**53 + 3, 9007199254740993],
+                    dtype=np.int64)
+STATIONS = np.array(['A1', 'B22', 'C333', 'D', 'E5', 'F66', 'G777'], dtype=object)
+COUNT_FILL = -999
+COUNT = np.array([1, COUNT_FILL, 3, 2147483646, -7, COUNT_FILL, 0], dtype=np.int32)
+
+# Packed air temperature (int16 * 0.01 + 273.15), the last value is outside of valid_range.
+TEMPERATURE_FILL = -32768
+TEMPERATURE_SCALE = np.float32(0.01)
+TEMPERATURE_OFFSET = np.float32(273.15)
+TEMPERATURE_RANGE = np.array([-5000, 5000], dtype=np.int16)
+TEMPERATURE = np.array([0, -1215, 2500, TEMPERATURE_FILL, 5000, -5000, 6000], dtype=np.int16)
+
+# Quality flags stored as signed bytes flagged with _Unsigned (255 is the fill value).
+FLAG_FILL = np.int8(-1)
+FLAGS = np.array([200, 5, 255, 0, 128, 255, 254], dtype=np.uint8)
+
+
+def make_input():
+    with Dataset(INPUT_PATH, 'w') as nc:
+        nc.createDimension('Location', len(SEQUENCE))
+        meta = nc.createGroup('MetaData')
+        meta.createVariable('latitude', 'f4', ('Location',))[:] = LATITUDE
+        meta.createVariable('sequenceNumber', 'i8', ('Location',))[:] = SEQUENCE
+        meta.createVariable('stationIdentifier', str, ('Location',))[:] = STATIONS
+        obs = nc.createGroup('ObsValue')
+        count = obs.createVariable('count', 'i4', ('Location',), fill_value=COUNT_FILL)
+        count.set_auto_mask(False)
+        count[:] = COUNT
+
+        temp = obs.createVariable('airTemperature', 'i2', ('Location',),
+                                  fill_value=TEMPERATURE_FILL)
+        temp.set_auto_maskandscale(False)
+        temp.scale_factor = TEMPERATURE_SCALE
+        temp.add_offset = TEMPERATURE_OFFSET
+        temp.valid_range = TEMPERATURE_RANGE
+        temp[:] = TEMPERATURE
+
+        flags = meta.createVariable('qualityFlag', 'i1', ('Location',), fill_value=FLAG_FILL)
+        flags.set_auto_maskandscale(False)
+        flags._Unsigned = 'true'
+        flags[:] = FLAGS.view(np.int8)
+
+
+def check_output():
+    with Dataset(OUTPUT_PATH) as nc:
+        meta = nc.groups['MetaData']
+        obs = nc.groups['ObsValue']
+
+        seq = meta.variables['sequenceNumber']
+        assert seq.dtype == np.int64, f'sequenceNumber is {seq.dtype}, not int64.'
+        assert np.array_equal(seq[:].data, SEQUENCE), 'sequenceNumber lost precision.'
+
+        lat = meta.variables['latitude'][:]
+        assert lat.dtype == np.float32, f'latitude is {lat.dtype}, not float32.'
+        assert np.array_equal(np.ma.getmaskarray(lat), np.isnan(LATITUDE)), \
+            'The NaN latitude is not missing.'
+        assert np.array_equal(lat.compressed(), LATITUDE[~np.isnan(LATITUDE)])
+
+        stations = meta.variables['stationIdentifier'][:]
+        assert list(stations) == list(STATIONS), 'stationIdentifier differs.'
+
+        missing = COUNT == COUNT_FILL
+        for name, dtype in [('count', np.int32), ('countAsDouble', np.float64)]:
+            count = obs.variables[name][:]
+            assert count.dtype == dtype, f'{name} is {count.dtype}, not {dtype}.'
+            assert np.array_equal(np.ma.getmaskarray(count), missing), \
+                f'The fill values of {name} are not missing.'
+            assert np.array_equal(count.compressed(), COUNT[~missing].astype(dtype)), \
+                f'{name} differs.'
+
+        temp = obs.variables['airTemperature'][:]
+        assert temp.dtype == np.float32, f'airTemperature is {temp.dtype}, not float32.'
+        missing = (TEMPERATURE == TEMPERATURE_FILL) | (TEMPERATURE < TEMPERATURE_RANGE[0]) | \
+                  (TEMPERATURE > TEMPERATURE_RANGE[1])
+        assert np.array_equal(np.ma.getmaskarray(temp), missing), \
+            'The fill and out of range airTemperature values are not missing.'
+        unpacked = TEMPERATURE[~missing] * np.float64(TEMPERATURE_SCALE) + \
+            np.float64(TEMPERATURE_OFFSET)
+        assert np.allclose(temp.compressed(), unpacked.astype(np.float32)), \
+            'airTemperature is not unpacked.'
+
+        flags = meta.variables['qualityFlag'][:]
+        assert flags.dtype == np.int32, f'qualityFlag is {flags.dtype}, not int32.'
+        missing = FLAGS.view(np.int8) == FLAG_FILL
+        assert np.array_equal(np.ma.getmaskarray(flags), missing), \
+            'The fill values of qualityFlag are not missing.'
+        assert np.array_equal(flags.compressed(), FLAGS[~missing].astype(np.int32)), \
+            'qualityFlag is not read as unsigned.'
+
+
+if __name__ == '__main__':
+    exe, yaml_path = sys.argv[1:]
+
+    make_input()
+    subprocess.run([exe, yaml_path], check=True)
+    check_output()
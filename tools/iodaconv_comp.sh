@@ -5,6 +5,9 @@
 # argument 1: what type of file to compare; netcdf or odb
 # argument 2: the command to run the ioda converter
 # argument 3: the filename to test
+# argument 4: the tolerance (default 0.0)
+# argument 5: verbose (default N)
+# argument 6: the filename of the reference in testoutput (default the filename to test)
 
 set -eu
 
@@ -13,6 +16,7 @@ cmd=$2
 file_name=$3
 tol=${4:-"0.0"}
 verbose=${5:-${VERBOSE:-"N"}}
+ref_name=${6:-$file_name}
 
 [[ $verbose =~ 'yYtT' ]] && set -x
 
@@ -20,17 +24,17 @@ rc="-1"
 case $file_type in
   netcdf)
     $cmd && \
-    nccmp testrun/$file_name testoutput/$file_name -d -m -g -f -S -T ${tol}
+    nccmp testrun/$file_name testoutput/$ref_name -d -m -g -f -S -T ${tol}
     rc=${?}
     ;;
    odb)
     $cmd && \
-    odc compare testrun/$file_name testoutput/$file_name
+    odc compare testrun/$file_name testoutput/$ref_name
     rc=${?}
     ;;
   ascii)
     $cmd && \
-    diff testrun/$file_name testoutput/$file_name
+    diff testrun/$file_name testoutput/$ref_name
     rc=${?}
     ;;
    *)
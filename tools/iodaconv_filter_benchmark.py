@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+
+# (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+#
+# This software is licensed under the terms of the Apache Licence Version 2.0
+# which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+
+"""
+Compare the write throughput and compression ratio of HDF5 filter pipelines on bufr2ioda products.
+
+Each product YAML is run once per pipeline with the pipeline set as the default ioda filters of
+every observations entry (per-variable filters and compressionLevel are removed). Run it from the
+directory the YAML paths are relative to (ex: the build test directory):
+
+    cd build/test
+    ../bin/iodaconv_filter_benchmark.py --bufr2ioda ../bin/bufr2ioda.x testinput/bufr_iasi.yaml
+
+The ratio is the size of the unfiltered output divided by the size of the output, the throughput is
+the unfiltered size divided by the run time and the overhead is the run time minus the unfiltered
+run time (decoding the BUFR data takes the same time for every pipeline).
+"""
+
+import argparse
+import glob
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+import yaml
+
+DEFAULT_PRODUCTS = ['testinput/bufr_iasi.yaml',
+                    'testinput/bufr_cris.yaml',
+                    'testinput/bufr_ncep_atms.yaml',
+                    'testinput/bufr_ncep_adpupa.yaml']
+
+# The first pipeline is the reference for the ratios and overheads.
+PIPELINES = {
+    'none': [],
+    'deflate6': [{'name': 'deflate', 'level': 6}],
+    'shuffle+deflate4': [{'name': 'shuffle'}, {'name': 'deflate', 'level': 4}],
+    'shuffle+zstd3': [{'name': 'shuffle'}, {'name': 'zstd', 'level': 3}],
+    'lz4': [{'name': 'lz4'}],
+    'bitshuffle+lz4': [{'name': 'bitshuffle', 'compressor': 'lz4'}],
+    'blosc-zstd5': [{'name': 'blosc', 'compressor': 'zstd', 'level': 5, 'shuffle': 'bit'}],
+}
+
+FALLBACK_WARNING = 'filter plugin is not available'
+
+
+def make_config(product, filters, out_dir):
+    with open(product) as f:
+        config = yaml.safe_load(f)
+
+    for obs_conf in config['observations']:
+        ioda = obs_conf['ioda']
+        ioda['filters'] = filters
+        for variable in ioda['variables']:
+            variable.pop('filters', None)
+            variable.pop('compressionLevel', None)
+
+        if 'obsdataout' in ioda:
+            ioda['obsdataout'] = os.path.join(out_dir, os.path.basename(ioda['obsdataout']))
+
+        if 'manifest' in ioda:
+            ioda['manifest'] = os.path.join(out_dir, os.path.basename(ioda['manifest']))
+
+    return config
+
+
+def output_size(out_dir):
+    return sum(os.path.getsize(path) for path in glob.glob(os.path.join(out_dir, '*.nc')))
+
+
+def run(bufr2ioda, config, work_dir, repeat):
+    config_path = os.path.join(work_dir, 'config.yaml')
+    with open(config_path, 'w') as f:
+        yaml.safe_dump(config, f)
+
+    best = None
+    fell_back = False
+    for _ in range(repeat):
+        start = time.perf_counter()
+        result = subprocess.run([bufr2ioda, config_path], stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                                universal_newlines=True)
+        elapsed = time.perf_counter() - start
+        if result.returncode != 0:
+            sys.stderr.write(result.stdout)
+            raise RuntimeError('bufr2ioda failed for {}'.format(config_path))
+
+        fell_back = fell_back or FALLBACK_WARNING in result.stdout
+        best = elapsed if best is None else min(best, elapsed)
+
+    return best, fell_back
+
+
+def benchmark(args, product):
+    results = []
+    for name in args.pipelines:
+        work_dir = tempfile.mkdtemp(prefix='filter_benchmark_', dir=args.tmp_dir)
+        try:
+            config = make_config(product, PIPELINES[name], work_dir)
+            elapsed, fell_back = run(args.bufr2ioda, config, work_dir, args.repeat)
+            results.append((name, elapsed, output_size(work_dir), fell_back))
+        finally:
+            shutil.rmtree(work_dir, ignore_errors=True)
+
+    return results
+
+
+def report(product, results):
+    _, ref_time, ref_size, _ = results[0]
+
+    print('\n{}'.format(product))
+    row = '  {:<20} {:>12} {:>8} {:>10} {:>12} {:>12}'
+    print(row.format('pipeline', 'size (MB)', 'ratio', 'time (s)', 'overhead (s)', 'MB/s'))
+    for name, elapsed, size, fell_back in results:
+        label = name + (' *' if fell_back else '')
+        ratio = ref_size / size if size > 0 else 0
+        print(row.format(label, '{:.2f}'.format(size / 1e6), '{:.2f}'.format(ratio), '{:.2f}'.format(elapsed),
+                         '{:.2f}'.format(elapsed - ref_time), '{:.1f}'.format(ref_size / 1e6 / elapsed)))
+
+    if any(result[3] for result in results):
+        print('  * a filter plugin was missing and its fallback was used (see HDF5_PLUGIN_PATH)')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('products', nargs='*', default=DEFAULT_PRODUCTS, help='bufr2ioda YAML files')
+    parser.add_argument('--bufr2ioda', default='bufr2ioda.x', help='path of bufr2ioda.x')
+    parser.add_argument('--pipeline', dest='pipelines', action='append', choices=list(PIPELINES),
+                        help='pipeline to compare, repeat for several (the first one is the reference, default: all)')
+    parser.add_argument('--repeat', type=int, default=3, help='runs per pipeline (the fastest is kept)')
+    parser.add_argument('--tmp-dir', default=None, help='directory for the outputs')
+    args = parser.parse_args()
+    args.pipelines = args.pipelines or list(PIPELINES)
+
+    for product in args.products:
+        report(product, benchmark(args, product))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+
+# (C) Copyright 2023 NOAA/NWS/NCEP/EMC
+#
+# This software is licensed under the terms of the Apache Licence Version 2.0
+# which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+
+"""
+Convert a Zarr store written by bufr2ioda (ioda backend: zarr) into an ioda netCDF file.
+
+    iodaconv_zarr2nc.py gdas.t00z.atms_n20.zarr gdas.t00z.atms_n20.nc
+
+The store keeps the ioda layout: the dimension variables are the arrays at the root (their
+_ARRAY_DIMENSIONS attribute names the dimension), the other variables are in groups (ex: ObsValue)
+and the root attributes are the global attributes. Only the codecs bufr2ioda writes are read
+(shuffle, vlen-utf8, zlib and zstd, zstd needs the zstandard module), so the zarr module isn't
+needed. The variables are written with zlib compression (--level) and the stored fill values.
+"""
+
+import argparse
+import json
+import os
+import sys
+import zlib
+
+import netCDF4
+import numpy as np
+
+
+def read_metadata(store):
+    """Metadata of the store (relative path to JSON), consolidated or not."""
+    consolidated = os.path.join(store, '.zmetadata')
+    if os.path.exists(consolidated):
+        with open(consolidated) as f:
+            return json.load(f)['metadata']
+
+    metadata = {}
+    for root, _, files in os.walk(store):
+        for name in files:
+            if name in ('.zgroup', '.zarray', '.zattrs'):
+                path = os.path.join(root, name)
+                with open(path) as f:
+                    metadata[os.path.relpath(path, store).replace(os.sep, '/')] = json.load(f)
+
+    return metadata
+
+
+def decompress(compressor, data):
+    if compressor is None:
+        return data
+    if compressor['id'] == 'zlib':
+        return zlib.decompress(data)
+    if compressor['id'] == 'zstd':
+        try:
+            import zstandard
+        except ImportError:
+            sys.exit('ERROR: The zstandard module is needed to read zstd compressed arrays.')
+        return zstandard.ZstdDecompressor().decompress(data, max_output_size=1 << 31)
+
+    sys.exit('ERROR: Unsupported compressor {}.'.format(compressor['id']))
+
+
+def unshuffle(data, element_size):
+    count = len(data) // element_size
+    shuffled = np.frombuffer(data, dtype=np.uint8, count=count * element_size)
+    return shuffled.reshape(element_size, count).T.tobytes() + data[count * element_size:]
+
+
+def decode_strings(data, count):
+    items = np.empty(count, dtype=object)
+    num_items = int.from_bytes(data[0:4], 'little')
+    pos = 4
+    for idx in range(num_items):
+        length = int.from_bytes(data[pos:pos + 4], 'little')
+        items[idx] = data[pos + 4:pos + 4 + length].decode('utf-8')
+        pos += 4 + length
+
+    return items
+
+
+def fill_value(array):
+    value = array['fill_value']
+    if array['dtype'] == '|O' or value is None:
+        return None
+    if isinstance(value, str):
+        value = {'NaN': np.nan, 'Infinity': np.inf, '-Infinity': -np.inf}[value]
+
+    return np.array(value, dtype=np.dtype(array['dtype'])).item()
+
+
+def read_array(store, path, array):
+    """Read a whole array (C order) from its chunk files."""
+    shape = array['shape']
+    chunks = array['chunks']
+    is_string = array['dtype'] == '|O'
+    dtype = np.dtype(object) if is_string else np.dtype(array['dtype'])
+    separator = array.get('dimension_separator', '.')
+
+    fill = fill_value(array)
+    data = np.full(shape, '' if is_string else fill, dtype=dtype)
+
+    grid = [(size + chunk - 1) // chunk for size, chunk in zip(shape, chunks)]
+    for chunk_idx in np.ndindex(*grid):
+        key = separator.join(str(idx) for idx in chunk_idx) if chunk_idx else '0'
+        chunk_path = os.path.join(store, path, key)
+        if not os.path.exists(chunk_path):
+            continue
+
+        with open(chunk_path, 'rb') as f:
+            raw = decompress(array['compressor'], f.read())
+
+        for codec in reversed(array['filters'] or []):
+            if codec['id'] == 'shuffle':
+                raw = unshuffle(raw, codec['elementsize'])
+
+        if is_string:
+            chunk = decode_strings(raw, int(np.prod(chunks))).reshape(chunks)
+        else:
+            chunk = np.frombuffer(raw, dtype=dtype).reshape(chunks)
+
+        region = tuple(slice(idx * size, min((idx + 1) * size, dim))
+                       for idx, size, dim in zip(chunk_idx, chunks, shape))
+        data[region] = chunk[tuple(slice(0, r.stop - r.start) for r in region)]
+
+    return data
+
+
+def convert(store, output, level):
+    metadata = read_metadata(store)
+    if '.zgroup' not in metadata:
+        sys.exit('ERROR: {} is not a Zarr store.'.format(store))
+
+    arrays = {key[:-len('/.zarray')]: value for key, value in metadata.items()
+              if key.endswith('/.zarray')}
+
+    with netCDF4.Dataset(output, 'w') as nc:
+        nc.setncatts(metadata.get('.zattrs', {}))
+
+        # Dimensions (and their variables) first, the other variables refer to them
+        dim_paths = sorted(path for path in arrays if '/' not in path)
+        for path in dim_paths:
+            nc.createDimension(path, arrays[path]['shape'][0])
+
+        for path in dim_paths + sorted(path for path in arrays if '/' in path):
+            array = arrays[path]
+            attrs = dict(metadata.get(path + '/.zattrs', {}))
+            dims = attrs.pop('_ARRAY_DIMENSIONS', [])
+
+            group_path, _, name = path.rpartition('/')
+            group = nc
+            for group_name in filter(None, group_path.split('/')):
+                if group_name not in group.groups:
+                    group.createGroup(group_name)
+                group = group.groups[group_name]
+
+            is_string = array['dtype'] == '|O'
+            var = group.createVariable(name,
+                                       str if is_string else np.dtype(array['dtype']),
+                                       dims,
+                                       zlib=level > 0 and not is_string,
+                                       complevel=level if level > 0 else 4,
+                                       chunksizes=None if is_string else array['chunks'],
+                                       fill_value=fill_value(array))
+            var.setncatts(attrs)
+            var[...] = read_array(store, path, array)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('store', help='Zarr store (directory)')
+    parser.add_argument('output', help='netCDF file to write')
+    parser.add_argument('--level', type=int, default=4, help='zlib level of the variables (0 for none)')
+    args = parser.parse_args()
+
+    convert(args.store, args.output, args.level)
+
+
+if __name__ == '__main__':
+    main()